@@ -16,20 +16,19 @@
 #include "application.h"
 
 #include "global.h"
+#include "fileinfo.h"
+#include "modeldiff.h"
 #include "stringhelper.h"
 #include "systemdetection.h"
 
 #include <curses.h>
+#include <algorithm> // max(), min()
+#include <cmath>     // powl()
 #include <iostream> // std::cout
+#include <sstream>
 #include <stdio.h>
 #include <stdlib.h>
 
-#if defined(Q_OS_WIN)
-#  include <windows.h>
-#elif defined(Q_OS_UNIX)
-#  include <limits.h>
-#endif
-
 using namespace std;
 
 static const char STR_ERR_NO_COLORS[]  = "Error: terminal does not support color";
@@ -37,12 +36,30 @@ static const char STR_NO_RESULT[]      = "(no results)";
 
 /*! \class Application
  *  \brief The class Application represents the main window.
+ *
+ * If a second model is given, the window is split in two panes, that show
+ * the results of the same search in both models, or the two sides of their
+ * diff, and scroll together. The two engines share their file cache,
+ * hence an include file common to both models is mapped and indexed once.
+ *
+ * The files of the include trees are watched: when one of them is saved,
+ * the current search is refreshed in place, and only the modified files
+ * are scanned again.
+ *
+ * The key [Enter] opens the first result of the page in its file: the
+ * context view shows the whole card, with the lines around it, and
+ * scrolls through the file.
+ *
+ * The key [t] shows the include tree, with the size, the lines, the hits
+ * and the load and scan times of each file, to find the includes that
+ * dominate the load time, and to jump to their results.
  */
 
 /*! \brief Constructor.
  */
 Application::Application( int argc, char *argv[] )
     : m_mode(Mode::BROWSE)
+    , m_view(View::RESULTS)
     , m_fullFileName("~~~unknown file~~~")
     , m_searchedText(string())
     , m_currentScroll(0)
@@ -51,6 +68,10 @@ Application::Application( int argc, char *argv[] )
     , m_rowResultBox(5)
     , m_rowErrorBox(0)
     , m_rowInfoBox(0)
+    , m_termIndexEnabled(true)
+    , m_termIndexFileName(string())
+    , m_contextLineCount(C_CONTEXT_LINES)
+    , m_resultScroll(0)
 {
     ttytype[0] = 25; // Curses: allow 25 to 90 lines and 80 to 200 columns
     ttytype[1] = 90;
@@ -126,25 +147,79 @@ void Application::resetConfig()
 // Remark: 'filename' can be absolute, canonical or relative...
 void Application::setFilename(const string &filename)
 {
-#if defined(Q_OS_WIN)
-    char fullFilename[MAX_PATH];
-    GetFullPathNameA(filename.c_str(), MAX_PATH, fullFilename, NULL);
-#elif defined(Q_OS_UNIX)
-	char fullFilename[PATH_MAX];
-    char *ret = realpath(filename.c_str(), fullFilename);
-    if (!ret) {
-        std::cout << "Warning: realpath( '" << ret << "'." << std::endl;
+    m_fullFileName = FileInfo::absoluteFilePath(filename);
+    if (m_fullFileName == filename && FileInfo::isRelativePath(filename)) {
+        std::cout << "Warning: cannot resolve the path '" << filename << "'." << std::endl;
     }
-#endif
-    m_fullFileName = fullFilename;
     m_recentFile.prepend(m_fullFileName);
 }
 
+/*! \brief Opens the model \a filename side by side with the first one.
+ */
+void Application::setOtherFilename(const string &filename)
+{
+    m_otherFullFileName = FileInfo::absoluteFilePath(filename);
+    if (m_otherFullFileName == filename && FileInfo::isRelativePath(filename)) {
+        std::cout << "Warning: cannot resolve the path '" << filename << "'." << std::endl;
+    }
+    m_otherEngine.setFileCache(m_engine.fileCache());
+    m_otherEngine.setMemoryBudget(m_engine.memoryBudget());
+    m_otherEngine.setResultLimit(m_engine.resultLimit());
+    m_otherEngine.setCountLimit(m_engine.countLimit());
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Sets the memory budget of the results, in bytes.
+ * Beyond this budget, the results are stored in a temporary file.
+ * A budget of 0 means unlimited.
+ */
+void Application::setMemoryBudget(const std::size_t bytes)
+{
+    m_engine.setMemoryBudget(bytes);
+    m_otherEngine.setMemoryBudget(bytes);
+}
+
+/*! \brief Sets the preview mode: at most \a resultLimit results are shown,
+ *         and the search stops counting beyond \a countLimit occurrences.
+ * A limit of 0 means unlimited.
+ */
+void Application::setPreview(const stringlist::size_type resultLimit,
+                             const stringlist::size_type countLimit)
+{
+    m_engine.setResultLimit(resultLimit);
+    m_engine.setCountLimit(countLimit);
+    m_otherEngine.setResultLimit(resultLimit);
+    m_otherEngine.setCountLimit(countLimit);
+}
+
+/*! \brief Sets the number of lines shown before the card, when a result
+ *         is opened in its file.
+ */
+void Application::setContextLines(const std::size_t count)
+{
+    m_contextLineCount = count;
+}
+
+/*! \brief If \a enabled (default), the searches don't scan the files
+ *         that the term index shows can't contain the searched text.
+ */
+void Application::setTermIndexEnabled(const bool enabled)
+{
+    m_termIndexEnabled = enabled;
+}
+
 /******************************************************************************
  ******************************************************************************/
 int Application::exec()
 {
+    this->loadTermIndex();
     m_engine.find( m_fullFileName, string() );
+    if( isSplit() ){
+        m_otherEngine.find( m_otherFullFileName, string() );
+    }
+    this->saveTermIndex();
+    this->watchFiles();
 
     /* ************************** */
     /*          Main loop         */
@@ -160,7 +235,17 @@ int Application::exec()
         this->showTitle();
         this->showInfo();
         this->showErrors();
-        this->showResults();
+        if (m_view == View::MEMORY) {
+            this->showMemory();
+        } else if (m_view == View::DIFF) {
+            this->showDiff();
+        } else if (m_view == View::CONTEXT) {
+            this->showContext();
+        } else if (m_view == View::TREE) {
+            this->showTree();
+        } else {
+            this->showResults();
+        }
         this->hideCursor();
 
         refresh(); // Curses: print all on real screen
@@ -168,8 +253,16 @@ int Application::exec()
         switch(m_mode){
         case Mode::BROWSE: {
             noecho(); // Curses: Don't echo() while we do getch
-            pressedKey = getch(); // Curses: Wait for user's next action
+            timeout( C_WATCH_PERIOD_MS ); // Curses: getch() returns ERR after this delay
+            do {
+                pressedKey = getch(); // Curses: Wait for user's next action
+            } while( pressedKey == ERR && !this->reloadChangedFiles() );
+            timeout( -1 );
+            const View view = m_view;
             this->onKeyPressed(pressedKey);
+            if( view == View::CONTEXT ){
+                pressedKey = 0; /* [q] closes the context view only */
+            }
             break;
         }
 
@@ -191,9 +284,14 @@ int Application::exec()
             m_searchedText = buffer;
 
             m_engine.find( m_fullFileName, m_searchedText );
+            if( isSplit() ){
+                m_otherEngine.find( m_otherFullFileName, m_searchedText );
+            }
 
             m_currentScroll = 0;
             m_maximumScroll = getMaximumScroll();
+            m_reloadMessage.clear();
+            this->watchFiles();
 
             m_mode = Mode::BROWSE;
             break;
@@ -205,13 +303,138 @@ int Application::exec()
     }
 
     endwin(); // Curses: exit curses
+    this->saveTermIndex();
     return 0;
 }
 
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Loads the term index of the model from the user's preferences
+ *         directory, and shares it with the engines.
+ *
+ * Its records are checked against the content of each include tree, like
+ * in batch mode: a file saved again without change is still skipped.
+ */
+void Application::loadTermIndex()
+{
+    if( !m_termIndexEnabled ) {
+        return;
+    }
+    m_termIndexFileName = RecentFile::configFileName( "index-", m_fullFileName );
+
+    shared_ptr<TermIndex> termIndex(new TermIndex());
+    if( !m_termIndexFileName.empty() ) {
+        termIndex->load( m_termIndexFileName );
+    }
+    m_engine.setTermIndex( termIndex );
+    m_otherEngine.setTermIndex( termIndex );
+
+    if( !m_termIndexFileName.empty() ) {
+        const string statusFileName = RecentFile::configFileName( "termstatus-", m_fullFileName );
+        m_engine.validateTermIndex( m_fullFileName, statusFileName );
+        if( this->isSplit() ) {
+            const string otherFileName = RecentFile::configFileName( "termstatus-", m_otherFullFileName );
+            m_otherEngine.validateTermIndex( m_otherFullFileName, otherFileName );
+        }
+    }
+}
+
+/*! \brief Saves the term index, if the searches updated it. The records of
+ *         the files that are no longer in the include trees are removed.
+ */
+void Application::saveTermIndex()
+{
+    const shared_ptr<TermIndex>& termIndex = m_engine.termIndex();
+    if( !termIndex || m_termIndexFileName.empty() ) {
+        return;
+    }
+    stringlist paths = m_engine.filePaths();
+    paths.insert( paths.end(), m_otherEngine.filePaths().begin(), m_otherEngine.filePaths().end() );
+    termIndex->prune( paths );
+    if( termIndex->isModified() ) {
+        termIndex->save( m_termIndexFileName );
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Watches the files of the include trees of the last search.
+ */
+void Application::watchFiles()
+{
+    stringlist paths = m_engine.filePaths();
+    if( isSplit() ){
+        const stringlist& others = m_otherEngine.filePaths();
+        paths.insert( paths.end(), others.begin(), others.end() );
+    }
+    m_watcher.watch( paths );
+}
+
+/*! \brief Refreshes the current search, if some watched files changed.
+ * Returns true if the screen must be updated.
+ */
+bool Application::reloadChangedFiles()
+{
+    const stringlist changed = m_watcher.changedFiles();
+    if( changed.empty() ){
+        return false;
+    }
+
+    stringlist::size_type scannedCount = m_engine.refresh();
+    if( isSplit() ){
+        scannedCount += m_otherEngine.refresh();
+    }
+    if( m_view == View::DIFF ){
+        this->compareModels();
+    }
+    if( m_view == View::TREE ){
+        this->updateTree();
+    }
+    m_maximumScroll = getMaximumScroll();
+    m_currentScroll = min(m_currentScroll, m_maximumScroll);
+
+    /* A modified file can include other files */
+    this->watchFiles();
+
+    ostringstream message;
+    message << "(reloaded: " << FileInfo::fileName( changed.front() );
+    if( changed.size() > 1 ){
+        message << " and " << changed.size() - 1 << " more";
+    }
+    message << ", " << scannedCount << " file(s) scanned)";
+    m_reloadMessage = message.str();
+    return true;
+}
+
 /******************************************************************************
  ******************************************************************************/
 void Application::onKeyPressed(const int key)
 {
+    if( m_view == View::CONTEXT ){
+        switch(key) {
+        case 'q':
+        case 'Q':
+        case '\033':
+        case '\n':
+        case '\r':
+        case KEY_ENTER:
+        case KEY_BACKSPACE:
+            /* Back to the results */
+            this->closeContext();
+            return;
+
+        case 'f':
+        case 'F':
+        case 'm':
+        case 'M':
+        case 'd':
+        case 'D':
+            return; /* only from the results */
+
+        default: break; /* scroll keys */
+        }
+    }
+
     switch(key) {
 
     case KEY_RESIZE:
@@ -222,6 +445,75 @@ void Application::onKeyPressed(const int key)
     case 'f':
     case 'F':
         m_mode = Mode::SEARCH;
+        m_view = View::RESULTS;
+        break;
+
+    case 'm':
+    case 'M':
+        /* Toggle the memory accounting view */
+        m_view = (m_view == View::MEMORY) ? View::RESULTS : View::MEMORY;
+        m_maximumScroll = getMaximumScroll();
+        m_currentScroll = min(m_currentScroll, m_maximumScroll);
+        break;
+
+    case 'd':
+    case 'D':
+        /* Toggle the diff of the two models, in the split view */
+        if( !isSplit() ){
+            break;
+        }
+        if( m_view == View::DIFF ){
+            m_view = View::RESULTS;
+        } else {
+            this->compareModels();
+            m_view = View::DIFF;
+        }
+        m_currentScroll = 0;
+        m_maximumScroll = getMaximumScroll();
+        break;
+
+    case 't':
+    case 'T':
+        /* Toggle the include tree view */
+        if( m_view == View::TREE ){
+            m_view = View::RESULTS;
+            m_currentScroll = 0;
+        } else {
+            this->updateTree();
+            m_view = View::TREE;
+            m_currentScroll = 0;
+        }
+        m_maximumScroll = getMaximumScroll();
+        break;
+
+    case ' ':
+    case KEY_RIGHT:
+    case KEY_LEFT:
+    case '+':
+    case '-':
+        /* Expand or collapse the selected file of the include tree */
+        if( m_view == View::TREE && m_currentScroll < (int)m_treeRows.size() ){
+            const int file = m_treeRows.at(m_currentScroll).file;
+            if( key == ' ' ){
+                m_includeTree.toggle( file );
+            } else {
+                m_includeTree.setExpanded( file, key == KEY_RIGHT || key == '+' );
+            }
+            m_treeRows = m_includeTree.rows();
+            this->accountUiCaches();
+            m_maximumScroll = getMaximumScroll();
+        }
+        break;
+
+    case '\n':
+    case '\r':
+    case KEY_ENTER:
+        /* Open the first result of the page in its file */
+        if( m_view == View::RESULTS ){
+            this->openContext();
+        } else if( m_view == View::TREE && m_currentScroll < (int)m_treeRows.size() ){
+            this->jumpToResults( m_treeRows.at(m_currentScroll).file );
+        }
         break;
 
         /// \todo case 'p':
@@ -273,6 +565,11 @@ void Application::onKeyPressed(const int key)
 
     default: break; /* other keys */
     }
+
+    if( m_view == View::TREE ){
+        /* The scroll is the selected file */
+        m_currentScroll = max(0, min(m_currentScroll, m_maximumScroll));
+    }
 }
 
 
@@ -293,7 +590,14 @@ void Application::showTitle()
 
     /* File info */
     move(m_rowTitleBox+1,0);
-    printw( "File: %s   (total %i included)", m_fullFileName.c_str(), m_engine.linkCount() );
+    printw( "File: %s   (total %i included)", m_fullFileName.c_str(), (int)m_engine.linkCount() );
+    if( !m_reloadMessage.empty() ){
+        printw( "   %s", m_reloadMessage.c_str() );
+    }
+    if( isSplit() ){
+        move(m_rowTitleBox+2,0);
+        printw( "Other: %s   (total %i included)", m_otherFullFileName.c_str(), (int)m_otherEngine.linkCount() );
+    }
 
     /* SearchBox */
     move(m_rowTitleBox+3,0);
@@ -309,7 +613,7 @@ void Application::showTitle()
 
     printw( ">" );
 
-    move(m_rowTitleBox+3,50);
+    move(m_rowTitleBox+3,C_SEARCH_SIZE+12);
     printw( "(case insensitive)" );
 
 
@@ -318,26 +622,58 @@ void Application::showTitle()
 /******************************************************************************
  ******************************************************************************/
 /*! Displays the results on screen.
+ *
+ * In the split view, the results of the two models are shown side by side,
+ * with the same scroll.
  */
 void Application::showResults()
+{
+    if( !isSplit() ) {
+        this->showResults( m_engine, 0, getmaxx(stdscr) );
+        return;
+    }
+    const int width = paneWidth();
+    this->showResults( m_engine, 0, width );
+    this->showResults( m_otherEngine, width + 1, getmaxx(stdscr) - width - 1 );
+
+    for( int row = m_rowResultBox; row < m_rowErrorBox; ++row ) {
+        mvaddch(row, width, '|');
+    }
+}
+
+/*! Displays the results of the \a engine in the pane that starts at the
+ *  given \a column, and is \a width columns wide.
+ */
+void Application::showResults(const Engine &engine, const int column, const int width)
 {
     int row = m_rowResultBox;
     int first_page_shown = -1;
 
-    move(row,0);
-    printw( "Results: %i occurences in %i files. (scroll %i/%i)",
-            m_engine.occurrenceCountAll(),
-            m_engine.linkCount(),
-            m_currentScroll, m_maximumScroll );
+    char buffer[256];
+    snprintf( buffer, sizeof(buffer), "Results: %s%i occurences in %i files. (scroll %i/%i)",
+              engine.isCountTruncated() ? ">= " : "",
+              (int)engine.occurrenceCountAll(),
+              (int)engine.linkCount(),
+              m_currentScroll, m_maximumScroll );
+    string header = buffer;
+    if( engine.isResultTruncated() ){
+        snprintf( buffer, sizeof(buffer), " (first %i lines shown)", (int)engine.resultCountAll() );
+        header += buffer;
+    }
+    move(row,column);
+    addnstr( header.c_str(), width );
 
-    move(row+1,0);
+    move(row+1,column);
 
-    const string prev = horizontalSeparator();
+    const string prev( width, '=' );
     printw( prev.c_str() );
 
     row += 2; // start
 
-    const stringlist& files = m_engine.files();
+    const stringlist& files = engine.files();
+
+    /* The line number of the result opened by [Enter] is highlighted */
+    bool selected = ( &engine != &m_engine );
 
     for( stringlist::const_iterator it = files.begin(); it != files.end(); ++it ) {
 
@@ -345,27 +681,54 @@ void Application::showResults()
 
         ++first_page_shown;
         if( first_page_shown >= m_currentScroll && row < m_rowErrorBox ) {
-            move(row,0);
+            move(row,column);
             colorize(Color::FILE_NAME);
-            printw( "--- %s ---", file.c_str() );
+            const string title = "--- " + file + " ---";
+            addnstr( title.c_str(), width );
             uncolorize();
             ++row;
         }
 
-        const ResultMap& results = m_engine.results();
-        const Result& res = results.at(file);
-        const stringlist& result = res.occurrences;
+        /* Remark: the occurrences can be stored on disk,    */
+        /* so only the visible ones are fetched. A card with  */
+        /* continuation lines spans several rows: the results */
+        /* above the page are skipped by their line numbers.  */
+        const stringlist::size_type count = engine.resultCount(file);
+
+        if( count > 0 ) {
+
+            const stringlist::size_type lineCount = engine.resultCountLines(file);
+            const stringlist::size_type skipped =
+                    (stringlist::size_type)max(0, m_currentScroll - first_page_shown - 1);
+            stringlist::size_type first = count;
+            if( skipped < lineCount ) {
+                first = engine.resultAtLine(file, skipped);
+                first_page_shown += (int)engine.resultLine(file, first);
+            } else {
+                first_page_shown += (int)lineCount;
+            }
 
-        if( result.size() > 0 ) {
+            for( stringlist::size_type i = first; i < count; ++i ) {
 
-            for( stringlist::const_iterator it2 = result.begin(); it2 != result.end(); ++it2 ) {
+                if( row >= m_rowErrorBox ) {
+                    return; // page full
+                }
 
-                ++first_page_shown;
-                if( first_page_shown >= m_currentScroll && row < m_rowErrorBox ){
-                    const string& result = (*it2);
-                    move(row,0);
-                    this->printwSyntaxColoration( result, row );
-                    ++row;
+                const string result = engine.resultAt(file, i);
+                string::size_type begin = 0;
+                while( begin != string::npos ) {
+                    const string::size_type end = result.find('\n', begin);
+                    ++first_page_shown;
+                    if( first_page_shown >= m_currentScroll && row < m_rowErrorBox ){
+                        move(row,column);
+                        this->printwSyntaxColoration( result.substr(begin, end - begin), row, column, width );
+                        if( !selected && begin == 0 ){
+                            mvchgat( row, column, C_LINE_NUMBER_WIDTH - 2, A_REVERSE, (short)Color::LINE_NUMBER, NULL );
+                            selected = true;
+                        }
+                        ++row;
+                    }
+                    begin = (end == string::npos) ? end : end + 1;
                 }
             }
 
@@ -377,8 +740,8 @@ void Application::showResults()
 
             ++first_page_shown;
             if( first_page_shown >= m_currentScroll && row < m_rowErrorBox ) {
-                move(row,0);
-                this->printwSyntaxColoration( STR_NO_RESULT, row );
+                move(row,column);
+                this->printwSyntaxColoration( STR_NO_RESULT, row, column, width );
                 ++row;
                 ++row;
             }
@@ -386,22 +749,470 @@ void Application::showResults()
     }
 }
 
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns in \a fileIndex and \a lineNumber the first result of
+ *         the page of the \a engine, i.e. the first card whose parent line
+ *         is shown. Returns false if the page shows no result.
+ *
+ * The rows are counted as in showResults(): the results above the page
+ * are skipped by their line numbers, without fetching them.
+ */
+bool Application::selectedResult(const Engine &engine, stringlist::size_type *fileIndex,
+                                 int *lineNumber) const
+{
+    int row = -1;
+    const stringlist& files = engine.files();
+    for( stringlist::size_type f = 0; f < files.size(); ++f ) {
+
+        const string& file = files.at(f);
+        ++row; /* file name */
+
+        const stringlist::size_type count = engine.resultCount(file);
+        const stringlist::size_type lineCount = engine.resultCountLines(file);
+
+        string result;
+        const stringlist::size_type skipped = (stringlist::size_type)max(0, m_currentScroll - row - 1);
+        if( skipped < lineCount ) {
+            /* A card whose parent line is above the page is not selected */
+            stringlist::size_type i = engine.resultAtLine(file, skipped);
+            if( engine.resultLine(file, i) < skipped ) {
+                ++i;
+            }
+            if( i < count ) {
+                result = engine.resultAt(file, i);
+            }
+        }
+        row += (int)lineCount;
+
+        if( !result.empty() ) {
+            /* "line      11: GRID..." */
+            *fileIndex = f;
+            *lineNumber = atoi( result.c_str() + 4 );
+            return *lineNumber > 0;
+        }
+        ++row; /* blank row, or no results */
+    }
+    return false;
+}
+
+/*! \brief Opens the first result of the page in its file.
+ *
+ * The file is already mapped, and its lines indexed by the search,
+ * so the view is opened at once, whatever the size of the file.
+ */
+void Application::openContext()
+{
+    stringlist::size_type fileIndex = 0;
+    int lineNumber = 0;
+    if( !this->selectedResult( m_engine, &fileIndex, &lineNumber ) ){
+        return;
+    }
+    const string& fullFileName = m_engine.filePaths().at(fileIndex);
+    const FileCache::Entry *entry = m_engine.fileCache()->find( fullFileName );
+    if( !entry ){
+        return;
+    }
+    const FileCache::Entry& content = entry->content();
+    const TextBuffer buffer = { content.file.begin(), content.file.end() };
+    m_pager.open( fullFileName, m_engine.files().at(fileIndex),
+                  buffer, content.index.lineIndex, (size_t)lineNumber );
+
+    m_resultScroll = m_currentScroll;
+    m_view = View::CONTEXT;
+    m_maximumScroll = getMaximumScroll();
+    m_currentScroll = (int)m_pager.firstLine( m_contextLineCount ) - 1;
+}
+
+/*! \brief Closes the context view, and goes back to the same page
+ *         of the results.
+ */
+void Application::closeContext()
+{
+    m_pager.close();
+    m_view = View::RESULTS;
+    m_maximumScroll = getMaximumScroll();
+    m_currentScroll = min(m_resultScroll, m_maximumScroll);
+}
+
+/*! \brief Returns the entry of the file of the context view, or NULL.
+ * The entry is looked up for each page, as the file can be reloaded.
+ */
+const FileCache::Entry* Application::contextEntry() const
+{
+    const FileCache::Entry *entry = m_engine.fileCache()->find( m_pager.fullFileName() );
+    return entry ? &entry->content() : NULL;
+}
+
+/*! Displays the lines of the file of the context view on screen, from
+ *  the current scroll. The line numbers of the card are highlighted.
+ *
+ * Only the lines shown are read, from the mapped file.
+ */
+void Application::showContext()
+{
+    int row = m_rowResultBox;
+    const FileCache::Entry *entry = this->contextEntry();
+    const size_t lineCount = entry ? entry->index.lineIndex.lineCount() : 0;
 
+    move(row,0);
+    printw( "Context: %s, card at line %i (%i lines in the file, scroll %i/%i)",
+            m_pager.fileName().c_str(), (int)m_pager.cardFirstLine(),
+            (int)lineCount, m_currentScroll, m_maximumScroll );
+
+    move(row+1,0);
+
+    const string prev = horizontalSeparator();
+    printw( prev.c_str() );
+
+    row += 2; // start
+
+    if( !entry || row >= m_rowErrorBox ) {
+        return;
+    }
+
+    const TextBuffer buffer = { entry->file.begin(), entry->file.end() };
+    const size_t firstLine = (size_t)m_currentScroll + 1;
+    const vector<TextBuffer> lines = Pager::lines( buffer, entry->index.lineIndex,
+                                                   firstLine, (size_t)(m_rowErrorBox - row) );
+
+    const int width = getmaxx(stdscr);
+    char number[ C_LINE_NUMBER_BUFFER_SIZE + 1 ];
+    for( vector<TextBuffer>::size_type i = 0; i < lines.size(); ++i ) {
+        const size_t lineNumber = firstLine + i;
+        if( lineNumber < C_LINE_NUMBER_MAX_NUMBER ) {
+            snprintf( number, sizeof(number), C_LINE_NUMBER_FORMAT_INT, (int)lineNumber );
+        } else {
+            snprintf( number, sizeof(number), C_LINE_NUMBER_FORMAT_CHAR, '.' );
+        }
+        string text = "line";
+        text += number;
+        text += ": ";
+        text.append( lines[i].begin, lines[i].end );
+
+        move(row,0);
+        this->printwSyntaxColoration( text, row, 0, width );
+        if( m_pager.isCardLine(lineNumber) ){
+            mvchgat( row, 0, C_LINE_NUMBER_WIDTH - 2, A_REVERSE, (short)Color::LINE_NUMBER, NULL );
+        }
+        ++row;
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Builds the include tree of the last search of the first model.
+ * The files expanded stay expanded, if the tree is the same.
+ */
+void Application::updateTree()
+{
+    const stringlist& files = m_engine.files();
+    vector<size_t> hitCounts;
+    for( stringlist::const_iterator it = files.begin(); it != files.end(); ++it ) {
+        hitCounts.push_back( m_engine.hitCount(*it) );
+    }
+    m_includeTree.build( m_engine.fileStats(), hitCounts );
+    m_treeRows = m_includeTree.rows();
+    this->accountUiCaches();
+}
+
+/*! \brief Shows the results, scrolled to the results of the \a file.
+ *
+ * The rows are counted as in showResults(): each file takes its title,
+ * the lines of its results, and a blank row.
+ */
+void Application::jumpToResults(const int file)
+{
+    int scroll = 0;
+    const stringlist& files = m_engine.files();
+    for( int i = 0; i < file && i < (int)files.size(); ++i ) {
+        scroll += 2 + (int)m_engine.resultCountLines( files.at(i) );
+    }
+    m_view = View::RESULTS;
+    m_maximumScroll = getMaximumScroll();
+    m_currentScroll = min(scroll, m_maximumScroll);
+}
+
+/*! Displays the include tree on screen: one row per file shown, with its
+ *  size, lines, hits, and load and scan times. A collapsed file shows the
+ *  sum of its subtree. The selected row is highlighted. A file that the
+ *  term index skipped has no times.
+ */
+void Application::showTree()
+{
+    int row = m_rowResultBox;
+
+    const IncludeTree::Row total = m_includeTree.total();
+    move(row,0);
+    printw( "Include tree: %i files (%i skipped), %s, %i lines, %i hits, load %.1f ms, scan %.1f ms (file %i/%i)",
+            total.fileCount,
+            total.skippedCount,
+            MemoryStats::formatBytes(total.stats.size).c_str(),
+            (int)total.stats.lineCount,
+            (int)total.hitCount,
+            total.stats.loadTime * 1000.,
+            total.stats.scanTime * 1000.,
+            m_currentScroll + 1, (int)m_treeRows.size() );
+
+    move(row+1,0);
+
+    const string prev = horizontalSeparator();
+    printw( prev.c_str() );
+
+    row += 2; // start
+
+    /* Columns of the statistics, on the right */
+    const int width = getmaxx(stdscr);
+    const int statsWidth = 52;
+    const int nameWidth = max(8, width - statsWidth);
+
+    move(row,0);
+    colorize(Color::TITLE);
+    printw( "%-*.*s%10s%10s%8s%12s%12s", nameWidth, nameWidth, "File",
+            "Size", "Lines", "Hits", "Load (ms)", "Scan (ms)" );
+    uncolorize();
+    ++row;
+
+    const int visible = m_rowErrorBox - row;
+    if( visible <= 0 ) {
+        return;
+    }
+    const int first = max(0, m_currentScroll - visible + 1);
+    const stringlist& files = m_engine.files();
+
+    for( int i = first; i < (int)m_treeRows.size() && row < m_rowErrorBox; ++i ) {
+        const IncludeTree::Row& node = m_treeRows.at(i);
+
+        string name( 2 * node.depth, ' ' );
+        name += !node.hasChildren ? "    " : node.isExpanded ? "[-] " : "[+] ";
+        name += files.at(node.file);
+        if( node.hasChildren && !node.isExpanded ) {
+            name += " (" + std::to_string(node.fileCount) + " files)";
+        }
+
+        move(row,0);
+        if( node.hitCount > 0 ) {
+            colorize(Color::FILE_NAME);
+        }
+        printw( "%-*.*s", nameWidth, nameWidth, name.c_str() );
+        if( node.hitCount > 0 ) {
+            uncolorize();
+        }
+        printw( "%10s%10i%8i",
+                MemoryStats::formatBytes(node.stats.size).c_str(),
+                (int)node.stats.lineCount,
+                (int)node.hitCount );
+        if( node.fileCount == 1 && node.skippedCount == 1 ) {
+            printw( "%12s%12s", "skipped", "-" );
+        } else {
+            printw( "%12.1f%12.1f", node.stats.loadTime * 1000., node.stats.scanTime * 1000. );
+        }
+
+        if( i == m_currentScroll ) {
+            mvchgat( row, 0, -1, A_REVERSE, 0, NULL );
+        }
+        ++row;
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! Compares the entities of the two models, and builds the rows of the
+ *  two sides of the diff: one row per entity, followed by one row per
+ *  field that changed.
+ *
+ * The files are taken from the file cache shared by the two engines,
+ * so they are not read again.
+ */
+void Application::compareModels()
+{
+    const Engine *engines[2] = { &m_engine, &m_otherEngine };
+    vector<TextBuffer> buffers[2];
+    for( int m = 0; m < 2; ++m ) {
+        const stringlist& paths = engines[m]->filePaths();
+        for( stringlist::const_iterator it = paths.begin(); it != paths.end(); ++it ) {
+            TextBuffer buffer = { NULL, NULL }; /* keep the positions */
+            const FileCache::Entry *entry = m_engine.fileCache()->open( *it );
+            if( entry ) {
+                buffer.begin = entry->content().file.begin();
+                buffer.end = entry->content().file.end();
+            }
+            buffers[m].push_back( buffer );
+        }
+    }
+
+    ModelDiff diff;
+    diff.compare( buffers[0], buffers[1] );
+
+    m_diffRows[0].clear();
+    m_diffRows[1].clear();
+
+    const vector<ModelDiff::Entry>& entries = diff.entries();
+    for( vector<ModelDiff::Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it ) {
+
+        const char symbol = (it->change == ModelDiff::Change::REMOVED) ? '-'
+                          : (it->change == ModelDiff::Change::ADDED) ? '+' : '~';
+        const int files[2] = { it->firstFile, it->secondFile };
+        const EntityLocation locations[2] = { it->first, it->second };
+        for( int m = 0; m < 2; ++m ) {
+            ostringstream row;
+            if( files[m] >= 0 ) {
+                row << symbol << " " << it->card << " " << it->id << ": "
+                    << engines[m]->files().at(files[m]) << ", line " << locations[m].lineNumber;
+            }
+            m_diffRows[m].push_back( row.str() );
+        }
+
+        if( it->change != ModelDiff::Change::CHANGED ) {
+            continue;
+        }
+        const TextBuffer& first = buffers[0].at(it->firstFile);
+        const TextBuffer& second = buffers[1].at(it->secondFile);
+        const vector<ModelDiff::FieldChange> changes = ModelDiff::fieldChanges(
+                    first.begin + it->first.offset, first.end,
+                    second.begin + it->second.offset, second.end );
+        for( vector<ModelDiff::FieldChange>::const_iterator c = changes.begin(); c != changes.end(); ++c ) {
+            ostringstream before;
+            ostringstream after;
+            before << "    field " << c->number << ": " << c->before;
+            after  << "    field " << c->number << ": " << c->after;
+            m_diffRows[0].push_back( before.str() );
+            m_diffRows[1].push_back( after.str() );
+        }
+    }
+
+    ostringstream summary;
+    summary << "Diff: " << diff.count(ModelDiff::Change::REMOVED) << " removed, "
+            << diff.count(ModelDiff::Change::ADDED) << " added, "
+            << diff.count(ModelDiff::Change::CHANGED) << " changed.";
+    m_diffSummary = summary.str();
+    this->accountUiCaches();
+}
+
+/*! Accounts the rows of the include tree and of the diff, kept between
+ *  two refreshes of the screen, as the UI caches.
+ */
+void Application::accountUiCaches()
+{
+    size_t bytes = m_treeRows.capacity() * sizeof(IncludeTree::Row);
+    for( int m = 0; m < 2; ++m ) {
+        for( stringlist::const_iterator it = m_diffRows[m].begin(); it != m_diffRows[m].end(); ++it ) {
+            bytes += MemoryStats::sizeOf( *it );
+        }
+    }
+    MemoryStats& stats = m_engine.memoryStats();
+    stats.reset( MemoryStats::Subsystem::UI_CACHES );
+    stats.allocate( MemoryStats::Subsystem::UI_CACHES, bytes );
+}
+
+/*! Displays the two sides of the diff on screen, side by side.
+ */
+void Application::showDiff()
+{
+    int row = m_rowResultBox;
+
+    move(row,0);
+    printw( "%s (scroll %i/%i)", m_diffSummary.c_str(), m_currentScroll, m_maximumScroll );
+
+    move(row+1,0);
+
+    const string prev = horizontalSeparator();
+    printw( prev.c_str() );
+
+    row += 2; // start
+
+    const int width = paneWidth();
+    const int columns[2] = { 0, width + 1 };
+    const int widths[2] = { width, getmaxx(stdscr) - width - 1 };
+
+    for( stringlist::size_type i = (stringlist::size_type)m_currentScroll;
+         i < m_diffRows[0].size() && row < m_rowErrorBox; ++i ) {
+        for( int m = 0; m < 2; ++m ) {
+            const string& text = m_diffRows[m].at(i);
+            move(row, columns[m]);
+            if( !text.empty() && text[0] != ' ' ) {
+                colorize(Color::FILE_NAME);
+                addnstr( text.c_str(), widths[m] );
+                uncolorize();
+            } else {
+                addnstr( text.c_str(), widths[m] );
+            }
+        }
+        mvaddch(row, width, '|');
+        ++row;
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! Displays the memory used by each subsystem on screen.
+ */
+void Application::showMemory()
+{
+    int row = m_rowResultBox;
+
+    move(row,0);
+    printw( "Memory: %i occurences in %i files.",
+            (int)m_engine.occurrenceCountAll(),
+            (int)m_engine.linkCount() );
+
+    move(row+1,0);
+
+    const string prev = horizontalSeparator();
+    printw( prev.c_str() );
+
+    row += 2; // start
+
+    const stringlist lines = m_engine.memoryStats().report();
+    for( stringlist::const_iterator it = lines.begin(); it != lines.end(); ++it ) {
+        if( row >= m_rowErrorBox ) {
+            break;
+        }
+        move(row,0);
+        printw( "%s", (*it).c_str() );
+        ++row;
+    }
+
+    if( isSplit() && row + 1 < m_rowErrorBox ) {
+        const FileCache& cache = *m_engine.fileCache();
+        move(row + 1,0);
+        printw( "Shared file cache: %i files (%i unique), %s mapped, %s of indexes.",
+                (int)cache.fileCount(),
+                (int)cache.contentCount(),
+                MemoryStats::formatBytes(cache.mappedSize()).c_str(),
+                MemoryStats::formatBytes(cache.memoryUsage()).c_str() );
+    }
+}
 
 /******************************************************************************
  ******************************************************************************/
 /*! \brief Prints the given \a text at the given screen's \a row
  *         with a basic syntax coloration.
  *
+ * The result lines are split into fields by the Tokenizer, so that
+ * each field of a fixed format card is colored separately, even when
+ * it's not separated from its neighbour by a blank.
+ *
  * \example
  * \code
  *  |------------|--------------------|
  *  line      11: $ SIDE PANEL SPCs
  *  ^^^^^blue^^^^ ^^^^^^green^^^^^^
  * \endcode
+ *
+ * The continuation lines of a card start with a blank line number.
+ *
+ * In the split view, the text is printed at the given \a column, and
+ * clipped to the \a width of its pane (0 means not clipped).
  */
-void Application::printwSyntaxColoration(const string &text, const int row )
+void Application::printwSyntaxColoration(const string &text, const int row,
+                                         const int column, const int width)
 {
+    if( width > 0 && text.length() > (string::size_type)width ) {
+        this->printwSyntaxColoration( text.substr(0, width), row, column, 0 );
+        return;
+    }
+
     /* str.substr(i, string::npos) */
     /*               ^^^^^^^^^^^  */
     /* --> Returns all char from 'i' to the string end. */
@@ -422,7 +1233,8 @@ void Application::printwSyntaxColoration(const string &text, const int row )
         printw( "%s", text.c_str() );
         uncolorize();
 
-    } else if( text.length() >= C_LINE_NUMBER_WIDTH && text.substr(0,4) == "line" ) {
+    } else if( text.length() >= C_LINE_NUMBER_WIDTH
+               && ( text.substr(0,4) == "line" || text.substr(0,4) == "    " ) ) {
         /* ***************************** */
         /* Results                       */
         /* ***************************** */
@@ -430,81 +1242,99 @@ void Application::printwSyntaxColoration(const string &text, const int row )
         printw( "%s", text.substr(0, C_LINE_NUMBER_WIDTH).c_str() );
         uncolorize();
 
-        Symbol symbol = Symbol::UNKNOWN;
+        /* Each field is colored according to its kind */
+        const char *line = text.c_str() + C_LINE_NUMBER_WIDTH;
+        const size_t length = text.length() - C_LINE_NUMBER_WIDTH;
+        m_tokenizer.tokenize(line, length);
+
+        const size_t commentPosition = m_tokenizer.commentPosition();
+        int field = 0;
+        char quote = '\0';
 
-        //int type = -1;
+        size_t i = 0;
+        while( i < length ){
 
-        auto p = text.begin() + C_LINE_NUMBER_WIDTH;
-        while( p < text.end() ){
+            const char ch = line[i];
 
-            char ch = (*p);
-            switch(ch) {
-            case '$':
+            if( quote != '\0' || ch == '\"' || ch == '\'' ) {
+                /* Quotes text, e.g. the filepath of an INCLUDE */
+                if( quote == '\0' ) {
+                    quote = ch;
+                } else if( ch == quote ) {
+                    quote = '\0';
+                }
+                colorize(Color::NASTRAN_QUOTE);
+                printw( "%c", ch );
+                uncolorize();
+                ++i;
+                continue;
+            }
+
+            if( i >= commentPosition ) {
                 colorize(Color::NASTRAN_COMMENT);
-                printw( "%s", p);
+                printw( "%s", line + i );
                 uncolorize();
-                p = text.end();
                 break;
+            }
 
-            case ' ':
-            case '=':
-            case ',':
-                if (symbol != Symbol::QUOTE) {
-                    symbol = Symbol::UNKNOWN;
-                    printw( "%c", ch );
+            /* Find the field containing the char */
+            while( field < m_tokenizer.fieldCount() ) {
+                const FieldSpan &span = m_tokenizer.fieldAt(field);
+                if( i < span.position + span.length ) {
+                    break;
                 }
-                break;
+                ++field;
+            }
+            const FieldSpan &span = m_tokenizer.fieldAt(field);
+            const size_t spanEnd = span.position + span.length;
+
+            if( field >= m_tokenizer.fieldCount() || i < span.position
+                    || ch == ' ' || ch == '\t' || ch == '=' ) {
+                printw( "%c", ch );
+                ++i;
+                continue;
+            }
 
-            default:
-                if( (symbol == Symbol::UNKNOWN && isalpha( ch ))
-                        || symbol == Symbol::ALPHA ) {
-
-                    /* Deck Card */
-                    symbol = Symbol::ALPHA;
-                    colorize(Color::NASTRAN_CARD);
-                    printw( "%c", ch );
-                    uncolorize();
-
-                } else if( (symbol == Symbol::UNKNOWN && isdigit( ch ))
-                           || symbol == Symbol::DIGIT ) {
-
-                    /* Digit 0..9 */
-                    symbol = Symbol::DIGIT;
-                    colorize(Color::NASTRAN_DIGIT);
-                    printw( "%c", ch );
-                    uncolorize();
-
-                } else if( (symbol == Symbol::UNKNOWN && ( ch =='\"' ||  ch =='\'') )
-                           || symbol == Symbol::QUOTE )  {
-
-                    /* Quotes text */
-                    symbol = Symbol::QUOTE;
-                    colorize(Color::NASTRAN_QUOTE);
-                    printw( "%c", ch );
-                    uncolorize();
-
-                } else {
-                    /* Other char like +, ., etc. */
-                    colorize(Color::NASTRAN_SYMBOL);
-                    printw( "%c", ch );
-                    uncolorize();
-                }
+            /* Word inside the field: non-fixed lines (e.g. 'SOL 101') */
+            /* can have several words in the same span                 */
+            size_t wordEnd = i;
+            while( wordEnd < spanEnd
+                   && line[wordEnd] != ' ' && line[wordEnd] != '\t' && line[wordEnd] != '='
+                   && line[wordEnd] != '\"' && line[wordEnd] != '\'' ) {
+                ++wordEnd;
+            }
 
+            switch( Tokenizer::kindOf(line + i, wordEnd - i) ) {
+            case Tokenizer::Kind::WORD:
+                colorize(Color::NASTRAN_CARD);
+                break;
+            case Tokenizer::Kind::INTEGER:
+            case Tokenizer::Kind::REAL:
+                colorize(Color::NASTRAN_DIGIT);
+                break;
+            default:
+                /* Other field like +A1, *, etc. */
+                colorize(Color::NASTRAN_SYMBOL);
                 break;
             }
-            ++p;
+            printw( "%.*s", (int)(wordEnd - i), line + i );
+            uncolorize();
+            i = wordEnd;
         }
 
         /* ***************************** */
         /* Highlight the occurences      */
         /* ***************************** */
-        if ( !StringHelper::hasSpaces(m_searchedText) ) {
-            int len = m_searchedText.length();
-            int loc = StringHelper::findNext(text, m_searchedText, C_LINE_NUMBER_WIDTH );
+        const Query& query = m_engine.query();
+        const string& highlighted = ( query.type() == Query::Type::TEXT ) ? m_searchedText
+                                                                          : query.value();
+        if ( !StringHelper::hasSpaces(highlighted) ) {
+            const int len = highlighted.length();
+            int loc = StringHelper::findNext(text, highlighted, C_LINE_NUMBER_WIDTH );
             while( loc >= 0 ){
-                move(row, loc);
-                text_in_a_box( text.c_str() + loc, len );
-                loc = StringHelper::findNext(text, m_searchedText, loc+1 );
+                move(row, column + loc);
+                text_in_a_box( text.c_str() + loc, min(len, (int)text.length() - loc) );
+                loc = StringHelper::findNext(text, highlighted, loc+1 );
             }
         }
 
@@ -564,9 +1394,25 @@ void Application::showInfo()
     printw( prev.c_str() );
 
     move(m_rowInfoBox+1,0);
-    printw("[q]:Exit      "
-           "[f]:New Search      "
-           "Key Up/Down,Page Up/Down,[a][s],[z][x]:Previous/Next page");
+    if( m_view == View::CONTEXT ){
+        printw("[q],[Enter]:Back to the results    "
+               "Key Up/Down,Page Up/Down,[a][s],[z][x]:Previous/Next lines");
+        return;
+    }
+    if( m_view == View::TREE ){
+        printw("[q]:Exit    [t]:Results    [Enter]:Go to the results    "
+               "[Space],Left/Right:Collapse/Expand    Key Up/Down:Select");
+        return;
+    }
+    printw("[q]:Exit    "
+           "[f]:New Search    "
+           "[m]:Memory    "
+           "[t]:Tree    "
+           "[Enter]:Open    ");
+    if( isSplit() ){
+        printw("[d]:Diff    ");
+    }
+    printw("Key Up/Down,Page Up/Down,[a][s],[z][x]:Previous/Next page");
 }
 
 /******************************************************************************
@@ -583,14 +1429,43 @@ inline string Application::horizontalSeparator(const char c) const
     return ret;
 }
 
+/*! \brief Returns the width of the left pane of the split view.
+ * The right pane takes the remaining columns, but the separator.
+ */
+inline int Application::paneWidth() const
+{
+    return (getmaxx(stdscr) - 1) / 2;
+}
+
 inline stringlist::size_type Application::getMaximumScroll() const
+{
+    if( m_view == View::DIFF ) {
+        return m_diffRows[0].size();
+    }
+    if( m_view == View::TREE ) {
+        return m_treeRows.empty() ? 0 : m_treeRows.size() - 1;
+    }
+    if( m_view == View::CONTEXT ) {
+        const FileCache::Entry *entry = contextEntry();
+        const size_t lineCount = entry ? entry->index.lineIndex.lineCount() : 0;
+        return (lineCount > 0) ? lineCount - 1 : 0;
+    }
+    stringlist::size_type value = getMaximumScroll( m_engine );
+    if( isSplit() ) {
+        /* The two panes scroll together, up to the end of the longest */
+        value = max( value, getMaximumScroll( m_otherEngine ) );
+    }
+    return value;
+}
+
+stringlist::size_type Application::getMaximumScroll(const Engine &engine)
 {
     auto value = 0;
-    const stringlist& files = m_engine.files();
+    const stringlist& files = engine.files();
     for( stringlist::const_iterator it = files.begin(); it != files.end(); ++it ) {
         const string& file = (*it);
         value += 3;
-        value += m_engine.resultCountLines( file );
+        value += engine.resultCountLines( file );
     }
     return value;
 }
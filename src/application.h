@@ -18,6 +18,10 @@
 
 #include "recentfile.h"
 #include "engine.h"
+#include "filewatcher.h"
+#include "includetree.h"
+#include "pager.h"
+#include "tokenizer.h"
 
 #include <string>
 #include <list>
@@ -40,16 +44,17 @@ class Application
         NASTRAN_SYMBOL
     };
 
-    enum class Symbol {
-        UNKNOWN  ,
-        ALPHA    ,
-        DIGIT    ,
-        QUOTE
-    };
     enum class Mode {
         BROWSE,     ///< Mode when using the keys to scroll the results
         SEARCH      ///< Mode when using the keys to write a new search string
     };
+    enum class View {
+        RESULTS,    ///< Shows the search results
+        MEMORY,     ///< Shows the memory accounting
+        DIFF,       ///< Shows the entities that differ between the two models
+        CONTEXT,    ///< Shows the lines of a file around a result
+        TREE        ///< Shows the include tree, with the statistics of each file
+    };
 
 public:
     explicit Application( int argc, char *argv[] );
@@ -58,10 +63,18 @@ public:
 
     void resetConfig();
     void setFilename(const std::string &filename);
+    void setOtherFilename(const std::string &filename);
+    void setMemoryBudget(const std::size_t bytes);
+    void setPreview(const stringlist::size_type resultLimit,
+                    const stringlist::size_type countLimit);
+    void setContextLines(const std::size_t count);
+    void setTermIndexEnabled(const bool enabled);
 
 private:
     Mode m_mode;
+    View m_view;
     std::string m_fullFileName;
+    std::string m_otherFullFileName;
     std::string m_searchedText;
     int m_currentScroll;
     int m_maximumScroll;
@@ -72,19 +85,65 @@ private:
 
     RecentFile m_recentFile;
     Engine m_engine;
+    Engine m_otherEngine;
+    Tokenizer m_tokenizer;
+
+    /* Term index of the model, kept between two runs, and shared by the engines */
+    bool m_termIndexEnabled;
+    std::string m_termIndexFileName;
+
+    /* Live reload: the files of the include trees, watched while browsing */
+    FileWatcher m_watcher;
+    std::string m_reloadMessage;
+
+    /* Split view: rows of the left and right panes of the diff */
+    stringlist m_diffRows[2];
+    std::string m_diffSummary;
+
+    /* Context view: the file around the result selected in the results */
+    Pager m_pager;
+    std::size_t m_contextLineCount;
+    int m_resultScroll;
+
+    /* Include tree view: the current scroll is the selected row */
+    IncludeTree m_includeTree;
+    std::vector<IncludeTree::Row> m_treeRows;
 
     void initialize();
     void onKeyPressed(const int key);
+    void loadTermIndex();
+    void saveTermIndex();
+    void watchFiles();
+    bool reloadChangedFiles();
+    bool selectedResult(const Engine &engine, stringlist::size_type *fileIndex,
+                        int *lineNumber) const;
+    void openContext();
+    void closeContext();
+    const FileCache::Entry* contextEntry() const;
+    void updateTree();
+    void jumpToResults(const int file);
 
     void showTitle();
     void showResults();
+    void showResults(const Engine &engine, const int column, const int width);
+    void showDiff();
+    void showContext();
+    void showTree();
+    void showMemory();
     void showErrors();
     void showInfo();
 
-    void printwSyntaxColoration(const std::string &text, const int row);
+    void printwSyntaxColoration(const std::string &text, const int row,
+                                const int column = 0, const int width = 0);
+
+    void compareModels();
+    void accountUiCaches();
+    inline bool isSplit() const { return !m_otherFullFileName.empty(); }
+    inline int paneWidth() const;
 
     inline std::string horizontalSeparator(const char c = '=') const;
     inline stringlist::size_type getMaximumScroll() const;
+    static stringlist::size_type getMaximumScroll(const Engine &engine);
     inline void hideCursor();
 
 
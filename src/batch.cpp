@@ -0,0 +1,550 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "batch.h"
+
+#include "fileinfo.h"
+#include "modeldiff.h"
+#include "recentfile.h"
+
+#include <iostream> // std::cout, std::cerr
+
+using namespace std;
+
+static const char STR_NO_RESULT[] = "(no results)";
+static const char STR_NOT_FOUND[] = "not defined.";
+
+/*! \class Batch
+ *  \brief The class Batch performs a single search without the Curses
+ *         interface, and prints the results on the standard output.
+ *
+ * It's intended for scripts, and for very large models where the user
+ * only needs the output of one search.
+ */
+
+/*! \brief Constructor.
+ */
+Batch::Batch()
+    : m_fullFileName(string())
+    , m_searchedText(string())
+    , m_statisticsEnabled(false)
+    , m_countOnly(false)
+    , m_locateCard(string())
+    , m_locateId(0)
+    , m_xrefName(string())
+    , m_xrefId(0)
+    , m_checkDuplicates(false)
+    , m_checkReferences(false)
+    , m_otherFullFileName(string())
+    , m_fingerprint(false)
+    , m_termIndexEnabled(true)
+{
+}
+
+/******************************************************************************
+ ******************************************************************************/
+// Remark: 'filename' can be absolute, canonical or relative...
+void Batch::setFilename(const string &filename)
+{
+    m_fullFileName = FileInfo::absoluteFilePath(filename);
+}
+
+void Batch::setSearchedText(const string &searchedText)
+{
+    m_searchedText = searchedText;
+}
+
+/*! \brief If \a enabled, prints the memory statistics after the results.
+ */
+void Batch::setStatisticsEnabled(const bool enabled)
+{
+    m_statisticsEnabled = enabled;
+}
+
+/*! \brief Sets the memory budget of the results, in bytes.
+ * A budget of 0 means unlimited.
+ */
+void Batch::setMemoryBudget(const std::size_t bytes)
+{
+    m_engine.setMemoryBudget(bytes);
+}
+
+/*! \brief Sets the preview mode: at most \a resultLimit results are printed,
+ *         and the search stops counting beyond \a countLimit occurrences.
+ * A limit of 0 means unlimited.
+ */
+void Batch::setPreview(const stringlist::size_type resultLimit,
+                       const stringlist::size_type countLimit)
+{
+    m_engine.setResultLimit(resultLimit);
+    m_engine.setCountLimit(countLimit);
+}
+
+/*! \brief If \a countOnly, prints only the number of occurrences and lines
+ *         found in each file, without building the results.
+ */
+void Batch::setCountOnly(const bool countOnly)
+{
+    m_countOnly = countOnly;
+}
+
+/*! \brief Prints where the entity \a id of the \a card family is defined,
+ *         e.g. GRID 123456, instead of searching a text.
+ */
+void Batch::setLocate(const string &card, const long long id)
+{
+    m_locateCard = card;
+    m_locateId = id;
+}
+
+/*! \brief Prints the entities that reference the entity \a id, e.g. the
+ *         elements connected to the GRID 1001, instead of searching a text.
+ * The \a name is 'GRID', 'PID' or 'MID'.
+ */
+void Batch::setCrossReference(const string &name, const long long id)
+{
+    m_xrefName = name;
+    m_xrefId = id;
+}
+
+/*! \brief If \a enabled, prints the IDs defined more than once in the
+ *         include tree, instead of searching a text.
+ */
+void Batch::setCheckDuplicates(const bool enabled)
+{
+    m_checkDuplicates = enabled;
+}
+
+/*! \brief If \a enabled, prints the references to the grids, properties and
+ *         materials that are not defined, instead of searching a text.
+ */
+void Batch::setCheckReferences(const bool enabled)
+{
+    m_checkReferences = enabled;
+}
+
+/*! \brief Prints the entities added, removed or changed in the model
+ *         \a otherFilename, compared to the model of setFilename().
+ */
+void Batch::setDiff(const string &otherFilename)
+{
+    m_otherFullFileName = FileInfo::absoluteFilePath(otherFilename);
+}
+
+/*! \brief If \a enabled, prints the fingerprint of the include tree, and
+ *         tells if the model changed since the last run.
+ */
+void Batch::setFingerprint(const bool enabled)
+{
+    m_fingerprint = enabled;
+}
+
+/*! \brief If \a enabled (default), the files that can't contain the searched
+ *         text are not loaded, thanks to the term index of the model, kept
+ *         between two runs.
+ */
+void Batch::setTermIndexEnabled(const bool enabled)
+{
+    m_termIndexEnabled = enabled;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Performs the search and prints the results.
+ * Returns 0 if no error occurred, otherwise returns 1.
+ */
+int Batch::exec()
+{
+    if (m_fingerprint) {
+        const bool changed = this->showFingerprint();
+        return changed ? 1 : 0;
+    }
+
+    if (!m_locateCard.empty()) {
+        /* Load the files, to build the indexes */
+        m_engine.find( m_fullFileName, string() );
+        const bool found = this->showLocation();
+        this->showErrors();
+        return (found && m_engine.errorCount() == 0) ? 0 : 1;
+    }
+
+    if (m_checkDuplicates) {
+        m_engine.find( m_fullFileName, string() );
+        const bool found = this->showDuplicates();
+        this->showErrors();
+        if (m_statisticsEnabled) {
+            this->showStatistics();
+        }
+        return (!found && m_engine.errorCount() == 0) ? 0 : 1;
+    }
+
+    if (!m_otherFullFileName.empty()) {
+        const bool found = this->showDiff();
+        if (m_statisticsEnabled) {
+            this->showStatistics();
+        }
+        return (!found && m_engine.errorCount() == 0) ? 0 : 1;
+    }
+
+    if (m_checkReferences) {
+        m_engine.find( m_fullFileName, string() );
+        m_engine.buildCrossReference();
+        const bool found = this->showUndefinedReferences();
+        this->showErrors();
+        if (m_statisticsEnabled) {
+            this->showStatistics();
+        }
+        return (!found && m_engine.errorCount() == 0) ? 0 : 1;
+    }
+
+    if (!m_xrefName.empty()) {
+        m_engine.find( m_fullFileName, string() );
+        m_engine.buildCrossReference();
+        const bool found = this->showCrossReference();
+        this->showErrors();
+        if (m_statisticsEnabled) {
+            this->showStatistics();
+        }
+        return (found && m_engine.errorCount() == 0) ? 0 : 1;
+    }
+
+    /* The term index of the model, kept between two runs */
+    const string indexFileName = m_termIndexEnabled
+            ? RecentFile::configFileName("index-", m_fullFileName) : string();
+    if (m_termIndexEnabled) {
+        shared_ptr<TermIndex> termIndex(new TermIndex());
+        if( !indexFileName.empty() ) {
+            termIndex->load( indexFileName );
+        }
+        m_engine.setTermIndex( termIndex );
+
+        /* The status of the files has its own records: the ones of */
+        /* --fingerprint are the baseline of the next --fingerprint  */
+        const string statusFileName = RecentFile::configFileName("termstatus-", m_fullFileName);
+        if( !indexFileName.empty() && !m_engine.validateTermIndex( m_fullFileName, statusFileName ) ) {
+            cerr << "Warning: Cannot write in the file '" << statusFileName << "'." << endl;
+        }
+    }
+
+    if (m_countOnly) {
+        m_engine.count( m_fullFileName, m_searchedText );
+        this->showCounts();
+    } else {
+        m_engine.find( m_fullFileName, m_searchedText );
+        this->showResults();
+    }
+    this->showErrors();
+
+    if( !indexFileName.empty() ) {
+        m_engine.termIndex()->prune( m_engine.filePaths() );
+        if( m_engine.termIndex()->isModified() && !m_engine.termIndex()->save( indexFileName ) ) {
+            cerr << "Warning: Cannot write in the file '" << indexFileName << "'." << endl;
+        }
+    }
+
+    if (m_statisticsEnabled) {
+        this->showStatistics();
+    }
+    return (m_engine.errorCount() == 0) ? 0 : 1;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void Batch::showResults()
+{
+    const stringlist& files = m_engine.files();
+
+    for( stringlist::const_iterator it = files.begin(); it != files.end(); ++it ) {
+
+        const string& file = (*it);
+        cout << "--- " << file << " ---" << endl;
+
+        const stringlist::size_type count = m_engine.resultCount(file);
+        if( count > 0 ) {
+            for( stringlist::size_type i = 0; i < count; ++i ) {
+                cout << m_engine.resultAt(file, i) << endl;
+            }
+        } else {
+            cout << STR_NO_RESULT << endl;
+        }
+        cout << endl;
+    }
+
+    cout << "Results: " << (m_engine.isCountTruncated() ? ">= " : "")
+         << m_engine.occurrenceCountAll() << " occurences in "
+         << m_engine.linkCount() << " files." << endl;
+    if( m_engine.isResultTruncated() ){
+        cout << "Only the first " << m_engine.resultCountAll() << " lines are shown." << endl;
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void Batch::showCounts()
+{
+    const stringlist& files = m_engine.files();
+
+    for( stringlist::const_iterator it = files.begin(); it != files.end(); ++it ) {
+        const string& file = (*it);
+        cout << file << ": "
+             << m_engine.occurrenceCount(file) << " occurences in "
+             << m_engine.hitCount(file) << " lines." << endl;
+    }
+    cout << endl;
+
+    cout << "Results: " << m_engine.occurrenceCountAll() << " occurences in "
+         << m_engine.hitCountAll() << " lines, in "
+         << m_engine.linkCount() << " files." << endl;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+bool Batch::showLocation()
+{
+    string file;
+    EntityLocation location;
+    const bool found = m_engine.locate( m_locateCard, m_locateId, &file, &location );
+
+    cout << m_locateCard << " " << m_locateId << ": ";
+    if( found ) {
+        cout << file << ", line " << location.lineNumber << endl;
+    } else {
+        cout << STR_NOT_FOUND << endl;
+    }
+    return found;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+bool Batch::showCrossReference()
+{
+    CrossReference::Relation relation;
+    if( !CrossReference::relationOf(m_xrefName, &relation) ) {
+        cout << "Error: Expected GRID, PID or MID, but got '" << m_xrefName << "'." << endl;
+        return false;
+    }
+    const EntityIndex::Family family = CrossReference::sourceFamily(relation);
+
+    const vector<long long> references =
+            m_engine.crossReference().referencesOf(relation, m_xrefId);
+
+    cout << m_xrefName << " " << m_xrefId << ": " << references.size() << " "
+         << CrossReference::relationName(relation) << "." << endl;
+
+    for( vector<long long>::const_iterator it = references.begin(); it != references.end(); ++it ) {
+        string file;
+        EntityLocation location;
+        cout << EntityIndex::familyName(family) << " " << (*it) << ": ";
+        if( m_engine.locate( family, (*it), &file, &location ) ) {
+            cout << file << ", line " << location.lineNumber << endl;
+        } else {
+            cout << STR_NOT_FOUND << endl;
+        }
+    }
+    return !references.empty();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+bool Batch::showDuplicates()
+{
+    const vector<EntityIndex::Duplicate> duplicates = m_engine.findDuplicates();
+    const stringlist& files = m_engine.files();
+
+    for( vector<EntityIndex::Duplicate>::const_iterator it = duplicates.begin(); it != duplicates.end(); ++it ) {
+        cout << EntityIndex::familyName(it->family) << " " << it->id << ": "
+             << files.at(it->firstIndex) << ", line " << it->first.lineNumber << " and "
+             << files.at(it->secondIndex) << ", line " << it->second.lineNumber << endl;
+    }
+    cout << "Duplicates: " << duplicates.size() << " redefinitions, in "
+         << m_engine.linkCount() << " files." << endl;
+    return !duplicates.empty();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+bool Batch::showUndefinedReferences()
+{
+    static const CrossReference::Relation relations[] = {
+        CrossReference::Relation::GRID_ELEMENTS,
+        CrossReference::Relation::PROPERTY_ELEMENTS,
+        CrossReference::Relation::MATERIAL_PROPERTIES
+    };
+    size_t count = 0;
+    for( int r = 0; r < CrossReference::RELATION_COUNT; ++r ) {
+        const CrossReference::Relation relation = relations[r];
+        const EntityIndex::Family target = CrossReference::targetFamily(relation);
+        const EntityIndex::Family source = CrossReference::sourceFamily(relation);
+
+        const vector<CrossReference::Reference> references =
+                m_engine.findUndefinedReferences(relation);
+
+        for( vector<CrossReference::Reference>::const_iterator it = references.begin(); it != references.end(); ++it ) {
+            string file;
+            EntityLocation location;
+            cout << EntityIndex::familyName(target) << " " << it->target << " " << STR_NOT_FOUND
+                 << " Referenced by " << EntityIndex::familyName(source) << " " << it->source;
+            if( m_engine.locate( source, it->source, &file, &location ) ) {
+                cout << ": " << file << ", line " << location.lineNumber;
+            }
+            cout << endl;
+        }
+        count += references.size();
+    }
+    cout << "Undefined references: " << count << ", in "
+         << m_engine.linkCount() << " files." << endl;
+    return count > 0;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+static const char* changeSymbol(const ModelDiff::Change change)
+{
+    switch (change) {
+    case ModelDiff::Change::REMOVED: return "-";
+    case ModelDiff::Change::ADDED:   return "+";
+    case ModelDiff::Change::CHANGED: return "~";
+    default:
+        break;
+    }
+    return "?";
+}
+
+bool Batch::showDiff()
+{
+    /* Load both include trees, in the same file cache */
+    Engine other;
+    other.setFileCache( m_engine.fileCache() );
+    m_engine.find( m_fullFileName, string() );
+    other.find( m_otherFullFileName, string() );
+
+    const Engine *engines[2] = { &m_engine, &other };
+    vector<TextBuffer> buffers[2];
+    for( int m = 0; m < 2; ++m ) {
+        const stringlist& paths = engines[m]->filePaths();
+        for( stringlist::const_iterator it = paths.begin(); it != paths.end(); ++it ) {
+            TextBuffer buffer = { NULL, NULL }; /* keep the positions */
+            const FileCache::Entry *entry = m_engine.fileCache()->find( *it );
+            if( entry ) {
+                buffer.begin = entry->content().file.begin();
+                buffer.end = entry->content().file.end();
+            }
+            buffers[m].push_back( buffer );
+        }
+    }
+
+    ModelDiff diff;
+    diff.compare( buffers[0], buffers[1] );
+
+    const stringlist& firstFiles = m_engine.files();
+    const stringlist& secondFiles = other.files();
+    cout << "--- " << FileInfo::fileName(m_fullFileName) << endl;
+    cout << "+++ " << FileInfo::fileName(m_otherFullFileName) << endl;
+
+    const vector<ModelDiff::Entry>& entries = diff.entries();
+    for( vector<ModelDiff::Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it ) {
+        cout << changeSymbol(it->change) << " " << it->card << " " << it->id << ": ";
+        if( it->firstFile >= 0 ) {
+            cout << firstFiles.at(it->firstFile) << ", line " << it->first.lineNumber;
+        }
+        if( it->firstFile >= 0 && it->secondFile >= 0 ) {
+            cout << " / ";
+        }
+        if( it->secondFile >= 0 ) {
+            cout << secondFiles.at(it->secondFile) << ", line " << it->second.lineNumber;
+        }
+        cout << endl;
+
+        if( it->change == ModelDiff::Change::CHANGED ) {
+            const TextBuffer& first = buffers[0].at(it->firstFile);
+            const TextBuffer& second = buffers[1].at(it->secondFile);
+            const vector<ModelDiff::FieldChange> changes = ModelDiff::fieldChanges(
+                        first.begin + it->first.offset, first.end,
+                        second.begin + it->second.offset, second.end );
+            for( vector<ModelDiff::FieldChange>::const_iterator c = changes.begin(); c != changes.end(); ++c ) {
+                cout << "    field " << c->number << ": "
+                     << (c->before.empty() ? "(blank)" : c->before) << " -> "
+                     << (c->after.empty() ? "(blank)" : c->after) << endl;
+            }
+        }
+    }
+    cout << "Differences: "
+         << diff.count(ModelDiff::Change::REMOVED) << " removed, "
+         << diff.count(ModelDiff::Change::ADDED) << " added, "
+         << diff.count(ModelDiff::Change::CHANGED) << " changed, in "
+         << diff.cardCount(0) << " and " << diff.cardCount(1) << " cards." << endl;
+
+    this->showErrors();
+    for (string::size_type i = 0; i < other.errorCount(); ++i) {
+        cout << "/!\\:" << other.errorAt(i) << endl;
+    }
+    return !entries.empty() || other.errorCount() > 0;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Prints the fingerprint of the include tree.
+ *
+ * The records of the files are kept in the user's preferences directory,
+ * one file per model. Hence the files that didn't change since the last
+ * run are checked with a stat only.
+ * Returns true if the model changed since the last run.
+ */
+bool Batch::showFingerprint()
+{
+    const string recordsFileName = RecentFile::configFileName("fingerprint-", m_fullFileName);
+
+    Fingerprint fingerprint;
+    if( !recordsFileName.empty() ) {
+        fingerprint.load( recordsFileName );
+    }
+    const uint64_t previous = fingerprint.value();
+    const uint64_t value = m_engine.fingerprint( m_fullFileName, &fingerprint );
+    if( !recordsFileName.empty() && !fingerprint.save( recordsFileName ) ) {
+        cerr << "Warning: Cannot write in the file '" << recordsFileName << "'." << endl;
+    }
+
+    const bool changed = (value != previous);
+    cout << "Fingerprint: " << Fingerprint::toHex(value)
+         << (changed ? " (changed since the last run)" : " (unchanged since the last run)") << endl;
+    cout << "Files: " << fingerprint.fileCount() << ", read: " << fingerprint.readCount()
+         << ", checked with a stat only: " << fingerprint.fileCount() - fingerprint.readCount()
+         << "." << endl;
+    return changed;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void Batch::showErrors()
+{
+    for (string::size_type i = 0; i < m_engine.errorCount(); ++i) {
+        cout << "/!\\:" << m_engine.errorAt(i) << endl;
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void Batch::showStatistics()
+{
+    cout << endl;
+    const stringlist lines = m_engine.memoryStats().report();
+    for( stringlist::const_iterator it = lines.begin(); it != lines.end(); ++it ) {
+        cout << (*it) << endl;
+    }
+    if( m_engine.termIndex() ) {
+        cout << "Term index: " << m_engine.skippedCount() << " of " << m_engine.linkCount()
+             << " files skipped." << endl;
+    }
+}
@@ -0,0 +1,74 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "engine.h"
+
+#include <string>
+
+class Batch
+{
+public:
+    explicit Batch();
+
+    int exec();
+
+    void setFilename(const std::string &filename);
+    void setSearchedText(const std::string &searchedText);
+    void setStatisticsEnabled(const bool enabled);
+    void setMemoryBudget(const std::size_t bytes);
+    void setPreview(const stringlist::size_type resultLimit,
+                    const stringlist::size_type countLimit);
+    void setCountOnly(const bool countOnly);
+    void setLocate(const std::string &card, const long long id);
+    void setCrossReference(const std::string &name, const long long id);
+    void setCheckDuplicates(const bool enabled);
+    void setCheckReferences(const bool enabled);
+    void setDiff(const std::string &otherFilename);
+    void setFingerprint(const bool enabled);
+    void setTermIndexEnabled(const bool enabled);
+
+private:
+    std::string m_fullFileName;
+    std::string m_searchedText;
+    bool m_statisticsEnabled;
+    bool m_countOnly;
+    std::string m_locateCard;
+    long long m_locateId;
+    std::string m_xrefName;
+    long long m_xrefId;
+    bool m_checkDuplicates;
+    bool m_checkReferences;
+    std::string m_otherFullFileName;
+    bool m_fingerprint;
+    bool m_termIndexEnabled;
+
+    Engine m_engine;
+
+    void showResults();
+    void showCounts();
+    bool showLocation();
+    bool showCrossReference();
+    bool showDuplicates();
+    bool showUndefinedReferences();
+    bool showDiff();
+    bool showFingerprint();
+    void showErrors();
+    void showStatistics();
+};
+
+#endif  // BATCH_H
@@ -0,0 +1,88 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compression.h"
+
+#include <vector>
+
+#include <zlib.h>
+
+using namespace std;
+
+/* Size of the chunks decompressed at once */
+static const unsigned int C_CHUNK_SIZE = 256 * 1024;
+
+/*! \class Compression
+ *  \brief The class Compression decompresses the archived decks.
+ *
+ * The content is decompressed by chunks, and written to a stream,
+ * usually a temporary file: the whole decompressed content is never
+ * held in memory.
+ */
+
+/*! \brief Returns true if the \a fileName has the '.gz' extension,
+ *         whatever its case.
+ */
+bool Compression::isGzip(const string &fileName)
+{
+    const string::size_type length = fileName.size();
+    return length > 3
+            && fileName[length - 3] == '.'
+            && (fileName[length - 2] == 'g' || fileName[length - 2] == 'G')
+            && (fileName[length - 1] == 'z' || fileName[length - 1] == 'Z');
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Decompresses the gzip file \a fullFileName, and appends the
+ *         decompressed content to the \a output stream.
+ * Returns false if the file cannot be read, or is corrupted.
+ *
+ * \remark The concatenated gzip members are decompressed one after the other,
+ * and a file that is not compressed is copied as is.
+ */
+bool Compression::gunzip(const string &fullFileName, FILE *output)
+{
+    gzFile file = gzopen(fullFileName.c_str(), "rb");
+    if (file == NULL) {
+        return false;
+    }
+    gzbuffer(file, C_CHUNK_SIZE);
+
+    vector<char> chunk(C_CHUNK_SIZE);
+    bool ok = true;
+    for (;;) {
+        const int length = gzread(file, chunk.data(), C_CHUNK_SIZE);
+        if (length < 0) {
+            ok = false;
+            break;
+        }
+        if (length == 0) {
+            break;
+        }
+        if (fwrite(chunk.data(), 1, (size_t)length, output) != (size_t)length) {
+            ok = false;
+            break;
+        }
+    }
+    int error = Z_OK;
+    gzerror(file, &error);
+    if (error != Z_OK) {
+        ok = false; // e.g. truncated file
+    }
+    gzclose(file);
+    return ok;
+}
@@ -0,0 +1,36 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <stdio.h>
+#include <string>
+
+class Compression
+{
+public:
+    /* Gzip-compressed file, e.g. 'model.dat.gz' or 'model.bdf.gz' */
+    static bool isGzip(const std::string &fileName);
+
+    /* Decompress the file at the end of the stream 'output' */
+    static bool gunzip(const std::string &fullFileName, FILE *output);
+
+private:
+    Compression();
+};
+
+#endif // COMPRESSION_H
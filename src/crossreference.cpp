@@ -0,0 +1,725 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "crossreference.h"
+
+#include "query.h"
+#include "scanner.h"
+#include "tokenizer.h"
+
+#include <algorithm> // sort(), merge(), lower_bound(), upper_bound()
+#include <atomic>
+#include <thread>
+
+using namespace std;
+
+/*! \class CrossReference
+ *  \brief The class CrossReference answers "who references this entity",
+ *         e.g. all the elements connected to the GRID 1001, all the
+ *         elements with the PID 20, or all the properties using the MID 3.
+ *
+ * The connectivity of the element cards, and the material IDs of the
+ * property cards, are parsed into one adjacency per relation, in the
+ * compressed sparse row format: the sorted IDs of the referenced entities,
+ * and for each of them, the range of the sorted IDs that reference it.
+ * Hence a lookup is a binary search, and the references are contiguous.
+ *
+ * The buffers are split into chunks of complete cards, that are parsed
+ * in parallel. Each thread sorts its own references, that are merged
+ * at the end, one relation per thread.
+ *
+ * Example:
+ * \code
+ *   CrossReference xref;
+ *   xref.build(buffers);
+ *   vector<long long> elements = xref.referencesOf(
+ *               CrossReference::Relation::GRID_ELEMENTS, 1001);
+ * \endcode
+ *
+ * The scalar points (SPOINT, EPOINT) are collected as sorted ranges of
+ * IDs: the grid fields of the scalar elements (CELAS2, CDAMP2...) can
+ * reference them instead of a GRID.
+ *
+ * \remark The IDs are between 1 and 4294967295. Only the element cards
+ * listed below are parsed. The rigid elements (RBE2...) are not handled.
+ */
+
+static const size_t C_CHUNK_SIZE = 1024 * 1024;
+
+/*! \brief Returns the mask of the fields \a first to \a last, except the
+ *         fields 1 and 10 of each line (card name and continuation).
+ */
+static constexpr unsigned int fields(const int first, const int last)
+{
+    return (first > last) ? 0u
+                          : ((first % 10 < 2 ? 0u : (1u << first)) | fields(first + 1, last));
+}
+
+static constexpr unsigned int field(const int number)
+{
+    return 1u << number;
+}
+
+/*! \brief Fields of a card that reference another entity, as in the small
+ *         field format (1 is the card name, 2 its ID, 11 the first field
+ *         of the first continuation line, etc.)
+ */
+struct CardSpec
+{
+    const char *name;
+    int property;           ///< Field of the PID, or 0
+    unsigned int grids;     ///< Mask of the GRID fields
+    unsigned int materials; ///< Mask of the MID fields
+    unsigned int plies;     ///< Mask of the MID fields, modulo 10, of each
+                            ///< continuation line (plies of a composite)
+};
+
+/* Sorted by name, for a binary search */
+static const CardSpec CARD_SPECS[] = {
+    { "CBAR",    3, fields(4, 5),   0, 0 },
+    { "CBEAM",   3, fields(4, 5),   0, 0 },
+    { "CBEND",   3, fields(4, 5),   0, 0 },
+    { "CBUSH",   3, fields(4, 5),   0, 0 },
+    { "CBUSH1D", 3, fields(4, 5),   0, 0 },
+    { "CDAMP1",  3, field(4) | field(6), 0, 0 },
+    { "CDAMP2",  0, field(4) | field(6), 0, 0 },
+    { "CELAS1",  3, field(4) | field(6), 0, 0 },
+    { "CELAS2",  0, field(4) | field(6), 0, 0 },
+    { "CGAP",    3, fields(4, 5),   0, 0 },
+    { "CHEXA",   3, fields(4, 27),  0, 0 },
+    { "CMASS1",  3, field(4) | field(6), 0, 0 },
+    { "CMASS2",  0, field(4) | field(6), 0, 0 },
+    { "CONM1",   0, field(3),       0, 0 },
+    { "CONM2",   0, field(3),       0, 0 },
+    { "CONROD",  0, fields(3, 4),   0, 0 },
+    { "CPENTA",  3, fields(4, 22),  0, 0 },
+    { "CPYRAM",  3, fields(4, 18),  0, 0 },
+    { "CQUAD",   3, fields(4, 14),  0, 0 },
+    { "CQUAD4",  3, fields(4, 7),   0, 0 },
+    { "CQUAD8",  3, fields(4, 13),  0, 0 },
+    { "CQUADR",  3, fields(4, 7),   0, 0 },
+    { "CROD",    3, fields(4, 5),   0, 0 },
+    { "CSHEAR",  3, fields(4, 7),   0, 0 },
+    { "CTETRA",  3, fields(4, 15),  0, 0 },
+    { "CTRIA3",  3, fields(4, 6),   0, 0 },
+    { "CTRIA6",  3, fields(4, 9),   0, 0 },
+    { "CTRIAR",  3, fields(4, 6),   0, 0 },
+    { "CTUBE",   3, fields(4, 5),   0, 0 },
+    { "CVISC",   3, fields(4, 5),   0, 0 },
+    { "PBAR",    0, 0, field(3), 0 },
+    { "PBARL",   0, 0, field(3), 0 },
+    { "PBEAM",   0, 0, field(3), 0 },
+    { "PBEAML",  0, 0, field(3), 0 },
+    { "PBEND",   0, 0, field(3), 0 },
+    { "PCOMP",   0, 0, 0, field(2) | field(6) },
+    { "PCOMPG",  0, 0, 0, field(3) },
+    { "PROD",    0, 0, field(3), 0 },
+    { "PSHEAR",  0, 0, field(3), 0 },
+    { "PSHELL",  0, 0, field(3) | field(5) | field(7) | field(14), 0 },
+    { "PSOLID",  0, 0, field(3), 0 },
+    { "PTUBE",   0, 0, field(3), 0 }
+};
+static const int CARD_SPEC_COUNT = (int)(sizeof(CARD_SPECS) / sizeof(CARD_SPECS[0]));
+
+/*! \brief Returns the spec of the card at the start of the \a line,
+ *         or NULL if the card doesn't reference any entity.
+ */
+static const CardSpec* specOf(const char *line, const size_t length)
+{
+    if (length == 0 || (Scanner::toUpper(line[0]) != 'C' && Scanner::toUpper(line[0]) != 'P')) {
+        return NULL; // fast rejection of most of the lines
+    }
+    size_t n = 0;
+    while (n < length && n < 8 && line[n] != ' ' && line[n] != '\t'
+           && line[n] != ',' && line[n] != '*') {
+        ++n;
+    }
+    int low = 0;
+    int high = CARD_SPEC_COUNT - 1;
+    while (low <= high) {
+        const int middle = (low + high) / 2;
+        const char *other = CARD_SPECS[middle].name;
+        int cmp = 0;
+        size_t i = 0;
+        for (; i < n && other[i] != '\0'; ++i) {
+            const char c = Scanner::toUpper(line[i]);
+            if (c != other[i]) {
+                cmp = (unsigned char)c < (unsigned char)other[i] ? -1 : 1;
+                break;
+            }
+        }
+        if (cmp == 0) {
+            if (i < n) {
+                cmp = 1;
+            } else if (other[i] != '\0') {
+                cmp = -1;
+            } else {
+                return &CARD_SPECS[middle];
+            }
+        }
+        if (cmp < 0) {
+            high = middle - 1;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return NULL;
+}
+
+/*! \brief Returns the relation of the field \a number of a card,
+ *         or -1 if the field doesn't reference an entity.
+ */
+static inline int relationOfField(const CardSpec &spec, const int number)
+{
+    if (number < 32) {
+        if (spec.grids & (1u << number)) {
+            return (int)CrossReference::Relation::GRID_ELEMENTS;
+        }
+        if (spec.materials & (1u << number)) {
+            return (int)CrossReference::Relation::MATERIAL_PROPERTIES;
+        }
+    }
+    if (number == spec.property) {
+        return (int)CrossReference::Relation::PROPERTY_ELEMENTS;
+    }
+    if (number > 10 && (spec.plies & (1u << (number % 10)))) {
+        return (int)CrossReference::Relation::MATERIAL_PROPERTIES;
+    }
+    return -1;
+}
+
+/*! \brief Returns the start of the line after the one at \a p.
+ */
+static inline const char* nextLine(const char *p, const char *end)
+{
+    const char *lineEnd = Scanner::findLineEnd(p, end);
+    return (lineEnd < end) ? lineEnd + 1 : end;
+}
+
+/*! \brief Returns the length of the line at \a p, without the end of line.
+ */
+static inline size_t lineLength(const char *p, const char *end)
+{
+    const char *lineEnd = Scanner::findLineEnd(p, end);
+    if (lineEnd > p && *(lineEnd - 1) == '\r') {
+        --lineEnd;
+    }
+    return (size_t)(lineEnd - p);
+}
+
+/*! \brief Returns the ID in the \a text, or 0 if it's not a valid ID.
+ */
+static inline unsigned int idOf(const char *text, const size_t length)
+{
+    long long value;
+    if (length == 0 || !Query::parseInteger(text, length, &value)
+            || value <= 0 || value > 0xFFFFFFFFLL) {
+        return 0;
+    }
+    return (unsigned int)value;
+}
+
+/*! \brief Returns true if the \a line starts with a SPOINT or an EPOINT card.
+ */
+static bool isScalarPointCard(const char *line, const size_t length)
+{
+    static const char STR_POINT[] = "POINT";
+    if (length < 6 || (Scanner::toUpper(line[0]) != 'S' && Scanner::toUpper(line[0]) != 'E')) {
+        return false;
+    }
+    for (size_t i = 1; i < 6; ++i) {
+        if (Scanner::toUpper(line[i]) != STR_POINT[i - 1]) {
+            return false;
+        }
+    }
+    return length == 6 || line[6] == ' ' || line[6] == '\t' || line[6] == ',' || line[6] == '*';
+}
+
+static inline bool isThru(const char *text, const size_t length)
+{
+    return length == 4
+            && Scanner::toUpper(text[0]) == 'T' && Scanner::toUpper(text[1]) == 'H'
+            && Scanner::toUpper(text[2]) == 'R' && Scanner::toUpper(text[3]) == 'U';
+}
+
+/*! \brief Appends to \a points the ranges of IDs of the scalar point card
+ *         at \a p, e.g. 'SPOINT 1 THRU 100', and returns the start of the
+ *         line after the card.
+ */
+static const char* parseScalarPoints(const char *p, const size_t length, const char *bufferEnd,
+                                     Tokenizer &tokenizer, vector<CrossReference::Range> *points)
+{
+    unsigned int previous = 0;
+    bool thru = false;
+    int lineIndex = 0;
+    const char *line = p;
+    size_t lineSize = length;
+    while (true) {
+        tokenizer.tokenize(line, lineSize);
+        for (int j = 0; j < tokenizer.fieldCount(); ++j) {
+            const int number = Query::fieldNumber(lineIndex, j, tokenizer.isLargeField());
+            const FieldSpan &span = tokenizer.fieldAt(j);
+            if (number % 10 < 2 || span.length == 0) {
+                continue;
+            }
+            if (isThru(line + span.position, span.length)) {
+                thru = (previous != 0);
+                continue;
+            }
+            const unsigned int id = idOf(line + span.position, span.length);
+            if (id == 0) {
+                thru = false;
+                continue;
+            }
+            if (thru && id >= previous) {
+                points->back().second = id;
+            } else {
+                points->push_back(make_pair(id, id));
+            }
+            previous = id;
+            thru = false;
+        }
+        line = nextLine(line, bufferEnd);
+        if (line >= bufferEnd) {
+            break;
+        }
+        lineSize = lineLength(line, bufferEnd);
+        if (!Tokenizer::isContinuation(line, lineSize)) {
+            break;
+        }
+        ++lineIndex;
+    }
+    return line;
+}
+
+/*! \brief Appends to the \a edges the references of the cards starting
+ *         in the chunk. An edge is the referenced ID in the high 32 bits,
+ *         and the referencing ID in the low 32 bits. The scalar points
+ *         are appended to \a points.
+ */
+static void parseChunk(const TextBuffer &chunk, const char *bufferEnd, Tokenizer &tokenizer,
+                       vector<unsigned long long> *edges, vector<CrossReference::Range> *points)
+{
+    const char *p = chunk.begin;
+    while (p < chunk.end) {
+        const size_t length = lineLength(p, bufferEnd);
+        const CardSpec *spec = specOf(p, length);
+        if (!spec && isScalarPointCard(p, length)) {
+            p = parseScalarPoints(p, length, bufferEnd, tokenizer, points);
+            continue;
+        }
+        if (!spec) {
+            p = nextLine(p, bufferEnd);
+            continue;
+        }
+
+        /* Parse the parent line and its continuation lines */
+        unsigned long long source = 0;
+        int lineIndex = 0;
+        const char *line = p;
+        size_t lineSize = length;
+        while (true) {
+            tokenizer.tokenize(line, lineSize);
+            for (int j = 0; j < tokenizer.fieldCount(); ++j) {
+                const int number = Query::fieldNumber(lineIndex, j, tokenizer.isLargeField());
+                if (number % 10 < 2) {
+                    continue; // card name, or continuation field
+                }
+                const FieldSpan &span = tokenizer.fieldAt(j);
+                const unsigned int id = idOf(line + span.position, span.length);
+                if (number == 2) {
+                    source = id;
+                    continue;
+                }
+                if (source == 0 || id == 0) {
+                    continue;
+                }
+                const int relation = relationOfField(*spec, number);
+                if (relation >= 0) {
+                    edges[relation].push_back((unsigned long long)id << 32 | source);
+                }
+            }
+            line = nextLine(line, bufferEnd);
+            if (line >= bufferEnd) {
+                break;
+            }
+            lineSize = lineLength(line, bufferEnd);
+            if (!Tokenizer::isContinuation(line, lineSize)) {
+                break;
+            }
+            ++lineIndex;
+        }
+        p = line;
+    }
+}
+
+/*! \brief Splits the \a buffer into chunks of about C_CHUNK_SIZE bytes,
+ *         that start with a parent line.
+ */
+static void splitBuffer(const TextBuffer &buffer, vector<TextBuffer> *chunks,
+                        vector<const char*> *ends)
+{
+    const char *p = buffer.begin;
+    while (p < buffer.end) {
+        const char *q = ((size_t)(buffer.end - p) > C_CHUNK_SIZE) ? p + C_CHUNK_SIZE : buffer.end;
+        if (q < buffer.end) {
+            q = nextLine(q, buffer.end);
+            while (q < buffer.end && Tokenizer::isContinuation(q, lineLength(q, buffer.end))) {
+                q = nextLine(q, buffer.end);
+            }
+        }
+        TextBuffer chunk = { p, q };
+        chunks->push_back(chunk);
+        ends->push_back(buffer.end);
+        p = q;
+    }
+}
+
+/*! \brief Constructor.
+ */
+CrossReference::CrossReference()
+    : m_isBuilt(false)
+{
+}
+
+void CrossReference::clear()
+{
+    /* Release the memory */
+    for (int r = 0; r < RELATION_COUNT; ++r) {
+        Adjacency &adjacency = m_adjacencies[r];
+        vector<unsigned int>().swap(adjacency.targets);
+        vector<size_t>().swap(adjacency.offsets);
+        vector<unsigned int>().swap(adjacency.sources);
+    }
+    vector<Range>().swap(m_scalarPoints);
+    m_isBuilt = false;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Builds the cross-references of the cards of the \a buffers,
+ *         with \a threadCount threads (0 means one per processor).
+ */
+void CrossReference::build(const vector<TextBuffer> &buffers, int threadCount)
+{
+    this->clear();
+
+    vector<TextBuffer> chunks;
+    vector<const char*> ends;
+    for (vector<TextBuffer>::const_iterator it = buffers.begin(); it != buffers.end(); ++it) {
+        splitBuffer(*it, &chunks, &ends);
+    }
+
+    if (threadCount <= 0) {
+        threadCount = (int)thread::hardware_concurrency();
+    }
+    threadCount = max(1, min(threadCount, (int)chunks.size()));
+
+    /* Parse the chunks, and sort the references of each thread */
+    vector< vector<unsigned long long> > edges((size_t)threadCount * RELATION_COUNT);
+    vector< vector<Range> > points((size_t)threadCount);
+    atomic<size_t> nextChunk(0);
+    auto parse = [&](const int t) {
+        Tokenizer tokenizer;
+        vector<unsigned long long> *threadEdges = &edges[(size_t)t * RELATION_COUNT];
+        for (size_t i = nextChunk++; i < chunks.size(); i = nextChunk++) {
+            parseChunk(chunks[i], ends[i], tokenizer, threadEdges, &points[(size_t)t]);
+        }
+        for (int r = 0; r < RELATION_COUNT; ++r) {
+            sort(threadEdges[r].begin(), threadEdges[r].end());
+        }
+    };
+
+    /* Merge the sorted references, then compress them */
+    auto compress = [&](const int r) {
+        vector<unsigned long long> merged;
+        for (int t = 0; t < threadCount; ++t) {
+            vector<unsigned long long> &part = edges[(size_t)t * RELATION_COUNT + r];
+            if (merged.empty()) {
+                merged.swap(part);
+            } else {
+                vector<unsigned long long> result(merged.size() + part.size());
+                merge(merged.begin(), merged.end(), part.begin(), part.end(), result.begin());
+                merged.swap(result);
+                vector<unsigned long long>().swap(part);
+            }
+        }
+
+        Adjacency &adjacency = m_adjacencies[r];
+        adjacency.sources.reserve(merged.size());
+        for (size_t i = 0; i < merged.size(); ++i) {
+            if (i > 0 && merged[i] == merged[i - 1]) {
+                continue; // e.g. a grid twice in the same element
+            }
+            const unsigned int target = (unsigned int)(merged[i] >> 32);
+            if (adjacency.targets.empty() || adjacency.targets.back() != target) {
+                adjacency.targets.push_back(target);
+                adjacency.offsets.push_back(adjacency.sources.size());
+            }
+            adjacency.sources.push_back((unsigned int)merged[i]);
+        }
+        adjacency.offsets.push_back(adjacency.sources.size());
+        adjacency.targets.shrink_to_fit();
+        adjacency.offsets.shrink_to_fit();
+        adjacency.sources.shrink_to_fit();
+    };
+
+    vector<thread> workers;
+    for (int t = 1; t < threadCount; ++t) {
+        workers.push_back(thread(parse, t));
+    }
+    parse(0);
+    for (vector<thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+        it->join();
+    }
+    workers.clear();
+
+    if (threadCount > 1) {
+        for (int r = 1; r < RELATION_COUNT; ++r) {
+            workers.push_back(thread(compress, r));
+        }
+        compress(0);
+        for (vector<thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+            it->join();
+        }
+    } else {
+        for (int r = 0; r < RELATION_COUNT; ++r) {
+            compress(r);
+        }
+    }
+
+    /* Sort the ranges of scalar points, and join the overlapping ones */
+    vector<Range> ranges;
+    for (size_t t = 0; t < points.size(); ++t) {
+        ranges.insert(ranges.end(), points[t].begin(), points[t].end());
+    }
+    sort(ranges.begin(), ranges.end());
+    for (vector<Range>::const_iterator it = ranges.begin(); it != ranges.end(); ++it) {
+        if (!m_scalarPoints.empty() && it->first <= (unsigned long long)m_scalarPoints.back().second + 1) {
+            m_scalarPoints.back().second = max(m_scalarPoints.back().second, it->second);
+        } else {
+            m_scalarPoints.push_back(*it);
+        }
+    }
+    m_scalarPoints.shrink_to_fit();
+    m_isBuilt = true;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the number of entities that reference the entity \a id,
+ *         e.g. the number of elements connected to a GRID.
+ */
+size_t CrossReference::referenceCount(const Relation relation, const long long id) const
+{
+    size_t first;
+    size_t last;
+    if (!rangeOf(relation, id, &first, &last)) {
+        return 0;
+    }
+    return last - first;
+}
+
+/*! \brief Returns the sorted IDs of the entities that reference
+ *         the entity \a id, e.g. the elements connected to a GRID.
+ */
+vector<long long> CrossReference::referencesOf(const Relation relation, const long long id) const
+{
+    vector<long long> references;
+    size_t first;
+    size_t last;
+    if (rangeOf(relation, id, &first, &last)) {
+        const vector<unsigned int> &sources = m_adjacencies[(int)relation].sources;
+        references.assign(sources.begin() + first, sources.begin() + last);
+    }
+    return references;
+}
+
+/*! \brief Returns the references of the \a relation to the entities that
+ *         are not defined, i.e. for which \a isDefined returns false, sorted
+ *         by target then source. The \a threadCount threads (0 means one per
+ *         processor) probe distinct ranges of the referenced IDs.
+ *
+ * Example:
+ * \code
+ *   vector<CrossReference::Reference> dangling = xref.findUndefined(
+ *               CrossReference::Relation::GRID_ELEMENTS,
+ *               [&](long long id) { return index.find(EntityIndex::Family::GRID, id, NULL); });
+ * \endcode
+ */
+vector<CrossReference::Reference> CrossReference::findUndefined(const Relation relation,
+                                                                const function<bool(long long)> &isDefined,
+                                                                int threadCount) const
+{
+    const Adjacency &adjacency = m_adjacencies[(int)relation];
+    const size_t count = adjacency.targets.size();
+
+    if (threadCount <= 0) {
+        threadCount = (int)thread::hardware_concurrency();
+    }
+    threadCount = max(1, min(threadCount, (int)(count / 1024) + 1));
+
+    vector< vector<Reference> > found((size_t)threadCount);
+    auto probe = [&](const int t) {
+        const size_t first = count * (size_t)t / (size_t)threadCount;
+        const size_t last = count * (size_t)(t + 1) / (size_t)threadCount;
+        for (size_t i = first; i < last; ++i) {
+            const long long target = (long long)adjacency.targets[i];
+            if (isDefined(target)) {
+                continue;
+            }
+            for (size_t j = adjacency.offsets[i]; j < adjacency.offsets[i + 1]; ++j) {
+                Reference reference;
+                reference.target = target;
+                reference.source = (long long)adjacency.sources[j];
+                found[(size_t)t].push_back(reference);
+            }
+        }
+    };
+
+    vector<thread> workers;
+    for (int t = 1; t < threadCount; ++t) {
+        workers.push_back(thread(probe, t));
+    }
+    probe(0);
+    for (vector<thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+        it->join();
+    }
+
+    vector<Reference> references;
+    for (size_t t = 0; t < found.size(); ++t) {
+        references.insert(references.end(), found[t].begin(), found[t].end());
+    }
+    return references;
+}
+
+/*! \brief Returns true if the \a id is a scalar point (SPOINT or EPOINT).
+ */
+bool CrossReference::isScalarPoint(const long long id) const
+{
+    if (id <= 0 || id > 0xFFFFFFFFLL) {
+        return false;
+    }
+    const vector<Range>::const_iterator it = upper_bound(
+                m_scalarPoints.begin(), m_scalarPoints.end(),
+                make_pair((unsigned int)id, 0xFFFFFFFFu));
+    return it != m_scalarPoints.begin() && (it - 1)->second >= (unsigned int)id;
+}
+
+/*! \brief Returns the number of references of the \a relation.
+ */
+size_t CrossReference::edgeCount(const Relation relation) const
+{
+    return m_adjacencies[(int)relation].sources.size();
+}
+
+/*! \brief Returns the memory used by the cross-references, in bytes.
+ */
+size_t CrossReference::memoryUsage() const
+{
+    size_t bytes = sizeof(CrossReference);
+    for (int r = 0; r < RELATION_COUNT; ++r) {
+        const Adjacency &adjacency = m_adjacencies[r];
+        bytes += adjacency.targets.capacity() * sizeof(unsigned int)
+                + adjacency.offsets.capacity() * sizeof(size_t)
+                + adjacency.sources.capacity() * sizeof(unsigned int);
+    }
+    bytes += m_scalarPoints.capacity() * sizeof(Range);
+    return bytes;
+}
+
+bool CrossReference::rangeOf(const Relation relation, const long long id,
+                             size_t *first, size_t *last) const
+{
+    if (id <= 0 || id > 0xFFFFFFFFLL) {
+        return false;
+    }
+    const Adjacency &adjacency = m_adjacencies[(int)relation];
+    const vector<unsigned int>::const_iterator it =
+            lower_bound(adjacency.targets.begin(), adjacency.targets.end(), (unsigned int)id);
+    if (it == adjacency.targets.end() || (*it) != (unsigned int)id) {
+        return false;
+    }
+    const size_t index = (size_t)(it - adjacency.targets.begin());
+    (*first) = adjacency.offsets[index];
+    (*last) = adjacency.offsets[index + 1];
+    return true;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns in \a relation the relation of the referenced entity
+ *         \a name, i.e. 'GRID', 'PID' or 'MID' (case insensitive).
+ */
+bool CrossReference::relationOf(const string &name, Relation *relation)
+{
+    string upper(name);
+    for (string::iterator it = upper.begin(); it != upper.end(); ++it) {
+        (*it) = Scanner::toUpper(*it);
+    }
+    if (upper == "GRID") {
+        (*relation) = Relation::GRID_ELEMENTS;
+    } else if (upper == "PID") {
+        (*relation) = Relation::PROPERTY_ELEMENTS;
+    } else if (upper == "MID") {
+        (*relation) = Relation::MATERIAL_PROPERTIES;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/*! \brief Returns the name of the referencing entities, e.g. 'elements'.
+ */
+const char* CrossReference::relationName(const Relation relation)
+{
+    switch (relation) {
+    case Relation::GRID_ELEMENTS:       return "elements";
+    case Relation::PROPERTY_ELEMENTS:   return "elements";
+    case Relation::MATERIAL_PROPERTIES: return "properties";
+    default:
+        break;
+    }
+    return "entities";
+}
+
+/*! \brief Returns the family of the referenced entities, e.g. GRID.
+ */
+EntityIndex::Family CrossReference::targetFamily(const Relation relation)
+{
+    switch (relation) {
+    case Relation::GRID_ELEMENTS:       return EntityIndex::Family::GRID;
+    case Relation::PROPERTY_ELEMENTS:   return EntityIndex::Family::PROPERTY;
+    case Relation::MATERIAL_PROPERTIES: return EntityIndex::Family::MATERIAL;
+    default:
+        break;
+    }
+    return EntityIndex::Family::UNKNOWN;
+}
+
+/*! \brief Returns the family of the referencing entities, e.g. ELEMENT.
+ */
+EntityIndex::Family CrossReference::sourceFamily(const Relation relation)
+{
+    switch (relation) {
+    case Relation::GRID_ELEMENTS:       return EntityIndex::Family::ELEMENT;
+    case Relation::PROPERTY_ELEMENTS:   return EntityIndex::Family::ELEMENT;
+    case Relation::MATERIAL_PROPERTIES: return EntityIndex::Family::PROPERTY;
+    default:
+        break;
+    }
+    return EntityIndex::Family::UNKNOWN;
+}
@@ -0,0 +1,94 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CROSS_REFERENCE_H
+#define CROSS_REFERENCE_H
+
+#include "entityindex.h"
+#include "scanner.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+class CrossReference
+{
+public:
+    enum class Relation {
+        GRID_ELEMENTS,          ///< Elements connected to a GRID
+        PROPERTY_ELEMENTS,      ///< Elements with a PID
+        MATERIAL_PROPERTIES     ///< Properties using a MID
+    };
+    static const int RELATION_COUNT = 3;
+
+    /* The entity source references the entity target, */
+    /* e.g. the element 12 references the GRID 1001    */
+    struct Reference
+    {
+        long long target;
+        long long source;
+    };
+
+    /* IDs from first to second, included */
+    typedef std::pair<unsigned int, unsigned int> Range;
+
+    explicit CrossReference();
+
+    void clear();
+    void build(const std::vector<TextBuffer> &buffers, int threadCount = 0);
+
+    bool isBuilt() const { return m_isBuilt; }
+
+    /* IDs of the entities that reference the entity \a id, sorted */
+    std::size_t referenceCount(const Relation relation, const long long id) const;
+    std::vector<long long> referencesOf(const Relation relation, const long long id) const;
+
+    /* References to the entities for which \a isDefined returns false */
+    std::vector<Reference> findUndefined(const Relation relation,
+                                         const std::function<bool(long long)> &isDefined,
+                                         int threadCount = 0) const;
+
+    /* Scalar points (SPOINT, EPOINT), that a grid field can reference */
+    bool isScalarPoint(const long long id) const;
+
+    std::size_t edgeCount(const Relation relation) const;
+    std::size_t memoryUsage() const;
+
+    static bool relationOf(const std::string &name, Relation *relation);
+    static const char* relationName(const Relation relation);
+    static EntityIndex::Family targetFamily(const Relation relation);
+    static EntityIndex::Family sourceFamily(const Relation relation);
+
+private:
+    /* Compressed sparse rows: the references of m_targets[i] */
+    /* are m_sources[m_offsets[i]] to m_sources[m_offsets[i+1]-1] */
+    struct Adjacency
+    {
+        std::vector<unsigned int> targets;
+        std::vector<std::size_t> offsets;
+        std::vector<unsigned int> sources;
+    };
+    Adjacency m_adjacencies[RELATION_COUNT];
+    std::vector<Range> m_scalarPoints; ///< Sorted, without overlap
+    bool m_isBuilt;
+
+    bool rangeOf(const Relation relation, const long long id,
+                 std::size_t *first, std::size_t *last) const;
+};
+
+#endif // CROSS_REFERENCE_H
@@ -18,12 +18,20 @@
 
 #include "global.h"
 #include "fileinfo.h"
+#include "mappedfile.h"
+#include "query.h"
+#include "scanner.h"
 #include "stringhelper.h"
 #include "systemdetection.h"
+#include "tokenizer.h"
 
-#include <algorithm> // transform(), powl()
+#include <algorithm> // transform(), min(), count()
+#include <chrono>
+#include <cmath>     // powl()
+#include <memory>    // shared_ptr
 #include <sstream>
 #include <stdio.h>
+#include <string.h>  // memchr()
 
 #if defined(Q_OS_WIN)
 #  include <windows.h>
@@ -41,15 +49,60 @@ using namespace std;
 /*! \brief Constructor.
  */
 Engine::Engine()
+    : m_memoryBudget(0)
+    , m_countOnly(false)
+    , m_fileCache(new FileCache())
+    , m_resultLimit(0)
+    , m_countLimit(0)
 {
     this->clear();
 }
 
+/*! \brief Shares the \a fileCache with the other engines that use it.
+ *
+ * The files included by several models are then mapped and indexed once.
+ * The previous search is cleared.
+ */
+void Engine::setFileCache(const shared_ptr<FileCache> &fileCache)
+{
+    this->clear();
+    m_fileCache = fileCache;
+    this->accountLoadedText();
+}
+
 void Engine::clear()
 {
     m_files.clear();
+    m_filePaths.clear();
+    m_fileStats.clear();
+    m_fileStatus.clear();
     m_results.clear();
     m_errors.clear();
+    m_spillFile.clear();
+
+    if( m_crossReference.isBuilt() ) {
+        m_memoryStats.release( MemoryStats::Subsystem::INDEXES, m_crossReference.memoryUsage() );
+        m_crossReference.clear();
+    }
+
+    m_resultTotal = 0;
+    m_occurrenceTotal = 0;
+    m_skippedCount = 0;
+    m_resultTruncated = false;
+    m_countTruncated = false;
+
+    /* Peak values are kept, to report the high-water mark of the session. */
+    /* The loaded text is the one of the file cache, that is kept.         */
+    m_memoryStats.reset( MemoryStats::Subsystem::RESULT_STORAGE );
+}
+
+/*! \brief Accounts the content held by the file cache, i.e. the files mapped
+ *         or decompressed, as the loaded text.
+ */
+void Engine::accountLoadedText()
+{
+    m_memoryStats.reset( MemoryStats::Subsystem::LOADED_TEXT );
+    m_memoryStats.allocate( MemoryStats::Subsystem::LOADED_TEXT, m_fileCache->mappedSize() );
 }
 
 /*****************************************************************************
@@ -58,12 +111,48 @@ void Engine::clear()
  *        in the given \a fullFileName and all the INCLUDE files.
  */
 void Engine::find(const string &fullFileName, const string &searchedText )
+{
+    this->search(fullFileName, searchedText, false);
+}
+
+/*!  \brief Count the occurences of the given \a searchedText, and the lines
+ *        that contain them, in the given \a fullFileName and all the INCLUDE files.
+ *
+ * Contrary to find(), no result is built: each file is scanned at once,
+ * without splitting it into lines. Then, only occurrenceCount() and hitCount()
+ * are meaningful. The preview limits don't apply.
+ */
+void Engine::count(const string &fullFileName, const string &searchedText )
+{
+    this->search(fullFileName, searchedText, true);
+}
+
+/*! \brief Searches the \a searchedText in the include tree of \a fullFileName.
+ *
+ * When the search is refreshed, the \a previousResults of the files whose
+ * \a previousStatus is unchanged are kept, and their INCLUDE statements are
+ * taken from their index. Returns the number of files kept.
+ *
+ * If the term index shows that a file can't contain the \a searchedText,
+ * the file isn't loaded: its INCLUDE statements are taken from the term
+ * index, and the files it includes are searched as usual.
+ */
+stringlist::size_type Engine::search(const string &fullFileName,
+                                     const string &searchedText,
+                                     const bool countOnly,
+                                     ResultMap *previousResults,
+                                     const FileStatusMap *previousStatus)
 {
     this->clear();
+    m_query.parse(searchedText);
+    m_countOnly = countOnly;
+    m_fullFileName = fullFileName;
+    m_searchedText = searchedText;
+    stringlist::size_type keptCount = 0;
 
     if( fullFileName.empty() ){
-        m_errors.push_back( STR_ERR_EMPTY_FILENAME );
-        return;
+        appendError( STR_ERR_EMPTY_FILENAME );
+        return keptCount;
     }
 
     /* **************************** */
@@ -74,54 +163,213 @@ void Engine::find(const string &fullFileName, const string &searchedText )
 
     appendFileName(filename, string(), -1);
 
+    /* contents already scanned, and the name of their first file */
+    map<const FileCache::Entry*, string> scannedContents;
+
+    /* files whose compressed version is already decompressed */
+    stringlist::size_type prefetchedCount = 0;
+
+    /* texts that a file must contain to match, and the records of the */
+    /* files that can't match, decided once per file with a stat        */
+    const vector<string> terms = m_termIndex ? m_query.terms() : vector<string>();
+    vector<const TermIndex::Record*> skippedRecords;
+
     /* **************************** */
     /* For each INCLUDE file        */
     /* **************************** */
     for (stringlist::size_type i = 0; i < m_files.size() ; ++i) {
 
         const string currentFileName = m_files.at(i);
+        const string current_fullfilename = FileInfo::resolvePath(pwd, currentFileName);
+        m_filePaths.push_back( current_fullfilename );
 
-        string current_fullfilename;
-        if (FileInfo::isRelativePath(currentFileName)) {
-            current_fullfilename = FileInfo::concat(pwd, currentFileName);
-        } else {
-            current_fullfilename = currentFileName;
+        /* The compressed files of the next level are decompressed in parallel */
+        if( i == prefetchedCount ){
+            stringlist paths;
+            skippedRecords.resize( m_files.size(), NULL );
+            for (stringlist::size_type j = i; j < m_files.size(); ++j) {
+                const string path = FileInfo::resolvePath(pwd, m_files.at(j));
+                skippedRecords[j] = skippable(path, terms);
+                if( !skippedRecords[j] ) {
+                    paths.push_back( path );
+                }
+            }
+            m_fileCache->prefetch( paths );
+            prefetchedCount = m_files.size();
+        }
+
+        /* The term index shows that the file can't match: it's not */
+        /* loaded, and its includes are taken from the index         */
+        const TermIndex::Record *record = skippedRecords.at(i);
+        if( record ) {
+            m_fileStatus[ current_fullfilename ] = FileStatus( record->size, record->modificationTime );
+            for (vector<pair<int, string> >::const_iterator it = record->includes.begin();
+                 it != record->includes.end(); ++it) {
+                appendFileName( it->second, currentFileName, it->first );
+            }
+            FileStats& stats = m_fileStats.at(i);
+            stats.size = record->size;
+            stats.lineCount = record->lineCount;
+            stats.isSkipped = true;
+            ++m_skippedCount;
+            continue;
         }
 
-        FILE *fp = fopen( currentFileName.c_str(), "rb" ); // read as binary
-        if (fp==NULL) {
+        FileCache::Entry *entry = m_fileCache->open(current_fullfilename);
+        if (!entry) {
             string error_msg;
             error_msg += STR_ERR_CANNOT_OPEN + currentFileName + STR_ERR_QUOTE_END;
-            m_errors.push_back( error_msg );
+            appendError( error_msg );
 
             Result& result = m_results[ currentFileName ];
             stringlist& occurrences = result.occurrences;
             occurrences.push_back( STR_ERR_MISSING_FILE );
+            result.lineCount++;
+            m_memoryStats.allocate( MemoryStats::Subsystem::RESULT_STORAGE,
+                                    MemoryStats::sizeOf( occurrences.back() ) );
 
         } else {
 
-            const size_t blockSize = 1024;
-            char data[blockSize];
-            size_t lenFile = 0;
-            std::string wholeFileContent = "";
-            do {
-                lenFile = fread(data, 1, blockSize - 1, fp);
-                if (lenFile <= 0) break;
+            /* The content is mapped, not copied */
+            FileCache::Entry& content = entry->content();
+            const MappedFile& file = content.file;
+            const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            const FileStatus status( entry->size, entry->modificationTime );
+            m_fileStatus[ current_fullfilename ] = status;
+
+            /* Refresh: the file didn't change since the previous search */
+            const bool kept = previousResults && previousStatus
+                    && content.index.zoneMap.isBuiltFor(file.size(), file.modificationTime())
+                    && previousStatus->count(current_fullfilename) > 0
+                    && previousStatus->at(current_fullfilename) == status
+                    && previousResults->count(currentFileName) > 0;
+
+            /* The same content, under another name: its results are copied. */
+            /* The content must not include other files, so that the include */
+            /* tree and its errors stay the same, whatever the file scanned.  */
+            const map<const FileCache::Entry*, string>::const_iterator scanned = scannedContents.find(&content);
+            const bool copied = scanned != scannedContents.end()
+                    && m_resultLimit == 0 && m_countLimit == 0
+                    && content.index.zoneMap.isBuiltFor(file.size(), file.modificationTime())
+                    && !content.index.zoneMap.hasInclude();
+
+            bool rebuilt = false;
+            if (kept) {
+                keepResults( (*previousResults)[currentFileName], currentFileName, content.index );
+                ++keptCount;
+            } else if (copied) {
+                copyResults( scanned->second, currentFileName );
+            } else if (countOnly && m_query.type() != Query::Type::FIELD) {
+                scanCount( file.begin(), file.end(), searchedText, currentFileName );
+            } else {
+                /* The indexes are (re)built by the first scan of the file */
+                FileIndex& fileIndex = content.index;
+                const bool rebuild = !fileIndex.zoneMap.isBuiltFor(file.size(), file.modificationTime());
+                if( rebuild ) {
+                    m_memoryStats.release( MemoryStats::Subsystem::INDEXES,
+                                           fileIndex.zoneMap.memoryUsage()
+                                           + fileIndex.entityIndex.memoryUsage()
+                                           + fileIndex.lineIndex.memoryUsage() );
+                    fileIndex.zoneMap.reset(file.size(), file.modificationTime());
+                    fileIndex.entityIndex.clear();
+                    fileIndex.lineIndex.clear();
+                    fileIndex.includes.clear();
+                }
+                scan( file.begin(), file.end(), searchedText, currentFileName, &fileIndex );
+                rebuilt = rebuild;
+                if( rebuild ) {
+                    m_memoryStats.allocate( MemoryStats::Subsystem::INDEXES,
+                                            fileIndex.zoneMap.memoryUsage()
+                                            + fileIndex.entityIndex.memoryUsage()
+                                            + fileIndex.lineIndex.memoryUsage() );
+                }
+            }
+            scannedContents.insert( make_pair(&content, currentFileName) );
+
+            /* The term index is updated by the scan that built the indexes */
+            if( m_termIndex && rebuilt
+                    && !m_termIndex->find(current_fullfilename, entry->size, entry->modificationTime) ) {
+                vector<pair<int, string> > includes;
+                for (vector<FileIndex::Include>::const_iterator it = content.index.includes.begin();
+                     it != content.index.includes.end(); ++it) {
+                    includes.push_back( make_pair(it->lineNumber, it->fileName) );
+                }
+                if( content.contentHash == 0 ) {
+                    content.contentHash = FileCache::hash( file.begin(), file.end() );
+                }
+                m_termIndex->update( current_fullfilename, entry->size, entry->modificationTime,
+                                     content.contentHash,
+                                     file.begin(), file.end(), m_joins,
+                                     content.index.lineIndex.lineCount(), includes );
+            }
+
+            FileStats& stats = m_fileStats.at(i);
+            stats.size = file.size();
+            stats.lineCount = content.index.lineIndex.lineCount();
+            stats.loadTime = entry->loadTime;
+            stats.scanTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        }
+    }
+    this->accountLoadedText();
+    return keptCount;
+}
+
+/*! \brief Returns the record of the file \a fullFileName in the term index,
+ *         if it's up to date and shows that the file can't contain all the
+ *         \a terms. Otherwise, returns NULL: the file must be scanned.
+ */
+const TermIndex::Record* Engine::skippable(const string &fullFileName,
+                                           const vector<string> &terms) const
+{
+    if( !m_termIndex || terms.empty() )
+        return NULL;
 
-                if (lenFile >= blockSize - 1)
-                    data[blockSize - 1] = '\0';
-                else
-                    data[lenFile - 1] = '\0';
+    size_t size = 0;
+    long long modificationTime = 0;
+    if( !MappedFile::status(fullFileName, &size, &modificationTime) )
+        return NULL;
 
-                wholeFileContent += data;
+    const TermIndex::Record *record = m_termIndex->find(fullFileName, size, modificationTime);
+    return ( record && !TermIndex::mayContain(*record, terms) ) ? record : NULL;
+}
 
-            } while (lenFile > 0);
+/*****************************************************************************
+ *****************************************************************************/
+/*!  \brief Searches again the text of the last find() or count(), after
+ *         some files of the include tree changed.
+ *
+ * Only the files that changed are scanned again: the results of the other
+ * files are kept, and their INCLUDE statements are taken from their index,
+ * so the include tree is patched if a changed file adds or removes one.
+ * Returns the number of files scanned again.
+ *
+ * \remark If the preview mode is enabled, or if results are stored on disk,
+ * the whole tree is searched again; the unchanged files are still not
+ * mapped again, and their indexes are kept.
+ */
+stringlist::size_type Engine::refresh()
+{
+    const string fullFileName = m_fullFileName;
+    const string searchedText = m_searchedText;
 
-            fclose(fp);
-            istringstream infile(wholeFileContent);
-            find( &infile, searchedText, currentFileName );
+    bool incremental = ( m_resultLimit == 0 && m_countLimit == 0 );
+    for (ResultMap::const_iterator it = m_results.begin(); it != m_results.end(); ++it) {
+        if( it->second.spilledCount > 0 ) {
+            incremental = false;
         }
     }
+    if( !incremental ) {
+        this->search( fullFileName, searchedText, m_countOnly );
+        return m_files.size();
+    }
+
+    ResultMap previousResults;
+    FileStatusMap previousStatus;
+    previousResults.swap( m_results );
+    previousStatus.swap( m_fileStatus );
+    const stringlist::size_type keptCount =
+            this->search( fullFileName, searchedText, m_countOnly, &previousResults, &previousStatus );
+    return m_files.size() - keptCount;
 }
 
 /*****************************************************************************
@@ -129,20 +377,419 @@ void Engine::find(const string &fullFileName, const string &searchedText )
 void Engine::find(istream * const iodevice,
                   const string &searchedText ,
                   const string &currentFileName)
+{
+    m_query.parse(searchedText);
+    m_countOnly = false;
+
+    const string content = readAll(iodevice);
+    scan( content.data(), content.data() + content.size(), searchedText, currentFileName );
+}
+
+void Engine::count(istream * const iodevice,
+                   const string &searchedText ,
+                   const string &currentFileName)
+{
+    m_query.parse(searchedText);
+    m_countOnly = true;
+
+    const string content = readAll(iodevice);
+    if (m_query.type() != Query::Type::FIELD) {
+        scanCount( content.data(), content.data() + content.size(), searchedText, currentFileName );
+    } else {
+        scan( content.data(), content.data() + content.size(), searchedText, currentFileName );
+    }
+}
+
+string Engine::readAll(istream * const iodevice)
+{
+    ostringstream content;
+    content << iodevice->rdbuf();
+    return content.str();
+}
+
+/*****************************************************************************
+ *****************************************************************************/
+/*! \brief Returns in [\a data, \a data + \a dataLength) the data of the \a line,
+ *         i.e. without its continuation fields.
+ *
+ * Joined together, the data of a parent line and of its continuation lines
+ * give the logical card, where an occurrence can cross a line boundary.
+ */
+static void lineData(const char *line, const size_t length, const bool isContinuation,
+                     const char **data, size_t *dataLength, size_t *padding)
+{
+    size_t first = 0;
+    size_t last = length;
+    (*padding) = 0;
+
+    if( memchr(line, ',', length) ) {
+        /* Free field: drop the first field of a continuation, and */
+        /* the 10th field, but keep the commas as separators.      */
+        size_t commas = 0;
+        for( size_t i = 0; i < length; ++i ) {
+            if( line[i] != ',' )
+                continue;
+            if( commas == 0 && isContinuation ) {
+                first = i;
+            }
+            ++commas;
+            if( commas == 9 ) {
+                last = i;
+                break;
+            }
+        }
+    } else {
+        /* Fixed format: the columns 1-8 of a continuation, and 73-80. */
+        /* A short line is padded with blanks up to the column 72.     */
+        if( isContinuation ) {
+            first = Tokenizer::columnOffset(line, length, 8);
+        }
+        last = Tokenizer::columnOffset(line, length, 72);
+        if( last == length ) {
+            size_t column = 0;
+            for( size_t i = 0; i < length; ++i ) {
+                column = (line[i] == '\t') ? (column / 8 + 1) * 8 : column + 1;
+            }
+            (*padding) = (column < 72) ? 72 - column : 0;
+        }
+    }
+    (*data) = line + first;
+    (*dataLength) = (last > first) ? last - first : 0;
+}
+
+/*! \brief Appends to the \a joins the end of the data of the \a previous line,
+ *         the blanks added up to the column 72, and the start of the data of
+ *         its continuation \a line, i.e. the trigrams of an occurrence that
+ *         crosses the boundary.
+ */
+static void appendJoin(string &joins,
+                       const char *previous, const size_t previousLength,
+                       const bool isPreviousContinuation,
+                       const char *line, const size_t length)
+{
+    const char *tail;
+    size_t tailLength;
+    size_t padding;
+    lineData(previous, previousLength, isPreviousContinuation, &tail, &tailLength, &padding);
+
+    const char *head;
+    size_t headLength;
+    size_t headPadding;
+    lineData(line, length, true, &head, &headLength, &headPadding);
+
+    const size_t n = std::min<size_t>(2, tailLength);
+    joins.append( tail + tailLength - n, n );
+    joins.append( std::min<size_t>(3, padding), ' ' );
+    joins.append( head, std::min<size_t>(2, headLength) );
+    joins.push_back( '\n' );
+}
+
+static inline bool isBlankOrComment(const char *line, const size_t length)
+{
+    size_t i = 0;
+    while( i < length && (line[i] == ' ' || line[i] == '\t') ) {
+        ++i;
+    }
+    return i == length || line[i] == '$';
+}
+
+static inline size_t lineLength(const char *line, const char *lineEnd)
+{
+    /* Remove the CR of the Windows line endings */
+    return (lineEnd > line && lineEnd[-1] == '\r') ? (size_t)(lineEnd - line - 1)
+                                                   : (size_t)(lineEnd - line);
+}
+
+/*****************************************************************************
+ *****************************************************************************/
+/*! \brief Scans the buffer [\a begin, \a end) line by line, and builds
+ *         the results.
+ *
+ * In the Bulk Data section, the continuation lines are appended to their
+ * parent line, and the whole logical card is searched and reported as one
+ * result. The lines are still read once: the card is a range of the buffer,
+ * that is searched when its last line is found.
+ *
+ * If the indexes of the \a fileIndex are not built yet, they're built
+ * during the scan. Otherwise, an ID range query skips the blocks where
+ * no card can match.
+ *
+ * While the indexes are built, the boundaries between the lines and their
+ * continuations are also kept for the term index.
+ */
+void Engine::scan(const char *begin, const char *end,
+                  const string &searchedText,
+                  const string &currentFileName,
+                  FileIndex *fileIndex)
 {
     int currentLineNumber = 0;
-    string line;
+    bool bulk = true; /* An included file often contains Bulk Data only */
 
-    do {
-        searchText(line, searchedText, currentFileName, currentLineNumber);
-        ++currentLineNumber;
+    Card card;
+    card.begin = NULL;
 
-        string childFileName = searchInclude(iodevice);
+    ZoneMap *zoneMap = fileIndex ? &fileIndex->zoneMap : NULL;
+    const bool building = zoneMap && !zoneMap->isBuilt();
+    const bool skipping = zoneMap && zoneMap->isBuilt()
+            && m_query.comparison() == Query::Comparison::RANGE;
+    const long long minimum = m_query.minimum();
+    const long long maximum = m_query.maximum();
+
+    const bool joining = building && m_termIndex;
+    const char *previous = NULL;
+    size_t previousLength = 0;
+    bool isPreviousContinuation = false;
+    if( joining ) {
+        m_joins.clear();
+    }
+
+    if( skipping && !zoneMap->hasInclude() && !zoneMap->overlaps(minimum, maximum) )
+        return; /* nothing to find in this file */
+
+    int zoneIndex = skipping ? zoneMap->nextZone(0) : 0;
+    size_t zoneOffset = ( skipping && zoneIndex < zoneMap->zoneCount() )
+            ? zoneMap->zoneAt(zoneIndex).offset : ZoneMap::NO_CARD;
+
+    const char *p = begin;
+    while (p < end) {
+
+        /* Skip the blocks where no card can match */
+        if( (size_t)(p - begin) == zoneOffset ) {
+            const int next = zoneMap->nextZone(zoneIndex, minimum, maximum);
+            if( next != zoneIndex ) {
+                searchCard(card, searchedText, currentFileName);
+                if( next == zoneMap->zoneCount() )
+                    return;
+                const Zone& zone = zoneMap->zoneAt(next);
+                p = begin + zone.offset;
+                currentLineNumber = zone.lineNumber - 1;
+                bulk = zone.isBulk;
+            }
+            zoneIndex = zoneMap->nextZone(next + 1);
+            zoneOffset = ( zoneIndex < zoneMap->zoneCount() )
+                    ? zoneMap->zoneAt(zoneIndex).offset : ZoneMap::NO_CARD;
+        }
+
+        ++currentLineNumber;
+        if( building ) {
+            fileIndex->lineIndex.append( (size_t)(p - begin) );
+        }
 
+        string childFileName = searchInclude(p, (size_t)(end - p));
         if( !childFileName.empty() ){
             appendFileName(childFileName, currentFileName, currentLineNumber);
+            if( building ) {
+                zoneMap->appendInclude( (size_t)(p - begin) );
+                const FileIndex::Include include = { currentLineNumber, childFileName };
+                fileIndex->includes.push_back( include );
+            }
+        }
+
+        const char *lineEnd = Scanner::findLineEnd(p, end);
+        const size_t length = lineLength(p, lineEnd);
+
+        if( card.begin && card.isOpen && Tokenizer::isContinuation(p, length) ) {
+            if( joining ) {
+                appendJoin(m_joins, previous, previousLength, isPreviousContinuation, p, length);
+            }
+            continueCard(card, p, length, searchedText);
+            isPreviousContinuation = true;
+
+        } else {
+            searchCard(card, searchedText, currentFileName);
+
+            if( Tokenizer::isBeginBulk(p, length) ) {
+                bulk = true;
+            } else if( Tokenizer::isControlStatement(p, length) ) {
+                bulk = false;
+            }
+            startCard(card, p, length, currentLineNumber, searchedText);
+
+            /* Only a Bulk Data entry can be continued */
+            card.isOpen = bulk && !isBlankOrComment(p, length);
+
+            if( building ) {
+                zoneMap->appendCard( (size_t)(p - begin), currentLineNumber, bulk );
+                long long id;
+                if( card.isOpen && cardId(p, length, &id) ) {
+                    zoneMap->appendId(id);
+
+                    const EntityIndex::Family family =
+                            EntityIndex::familyOf(p, cardNameLength(p, length));
+                    if( family != EntityIndex::Family::UNKNOWN ) {
+                        fileIndex->entityIndex.insert(family, id, (size_t)(p - begin),
+                                                      currentLineNumber);
+                    }
+                }
+            }
+            isPreviousContinuation = false;
+        }
+        previous = p;
+        previousLength = length;
+
+        if (lineEnd == end) {
+            break;
+        }
+        p = lineEnd + 1;
+    }
+    searchCard(card, searchedText, currentFileName);
+
+    if( building ) {
+        zoneMap->finish();
+    }
+}
+
+/*! \brief Returns in \a id the ID of the Bulk Data entry starting with
+ *         the given \a line, i.e. the integer in its field 2.
+ * Returns false if the field 2 is not an integer, e.g. 'PARAM,POST,-1'.
+ *
+ * \remark Only the field 2 is located, without tokenizing the whole line,
+ * because it's called for each card of every scan.
+ */
+bool Engine::cardId(const char *line, const size_t length, long long *id)
+{
+    size_t first;
+    size_t last;
+    const char *comma = static_cast<const char*>( memchr(line, ',', length) );
+    if( comma ) {
+        first = (size_t)(comma - line) + 1;
+        const char *next = static_cast<const char*>( memchr(comma + 1, ',', length - first) );
+        last = next ? (size_t)(next - line) : length;
+    } else {
+        first = Tokenizer::columnOffset(line, length, 8);
+        const bool isLargeField = memchr(line, '*', first) != NULL;
+        last = Tokenizer::columnOffset(line, length, isLargeField ? 24 : 16);
+    }
+    while( first < last && (line[first] == ' ' || line[first] == '\t') ) {
+        ++first;
+    }
+    while( last > first && (line[last - 1] == ' ' || line[last - 1] == '\t') ) {
+        --last;
+    }
+    return Query::parseInteger(line + first, last - first, id);
+}
+
+/*! \brief Returns the length of the card name at the start of the \a line,
+ *         e.g. 5 for 'GRID*   1'.
+ */
+size_t Engine::cardNameLength(const char *line, const size_t length)
+{
+    size_t i = 0;
+    while( i < length && i < 8 && line[i] != ' ' && line[i] != '\t' && line[i] != ',' ) {
+        ++i;
+    }
+    return i;
+}
+
+/*! \brief Starts a new logical card with the given parent \a line.
+ */
+void Engine::startCard(Card &card, const char *line, const size_t length,
+                       const int lineNumber, const string &searchedText)
+{
+    card.begin = line;
+    card.end = line + length;
+    card.lineNumber = lineNumber;
+    card.occurrenceCount = 0;
+
+    /* The field queries are matched once the card is complete */
+    if( m_countTruncated || searchedText.empty() || m_query.type() != Query::Type::TEXT )
+        return;
+
+    card.occurrenceCount = Scanner::count(line, line + length,
+                                          searchedText.data(), searchedText.size());
+    lineData(line, length, false, &card.data, &card.dataLength, &card.padding);
+}
+
+/*! \brief Appends the continuation \a line to the given \a card.
+ *
+ * The occurrences crossing the line boundary are found in a small window,
+ * made of the end of the previous line's data and the start of this one's.
+ */
+void Engine::continueCard(Card &card, const char *line, const size_t length,
+                          const string &searchedText)
+{
+    card.end = line + length;
+
+    if( m_countTruncated || searchedText.empty() || m_query.type() != Query::Type::TEXT )
+        return;
+
+    card.occurrenceCount += Scanner::count(line, line + length,
+                                           searchedText.data(), searchedText.size());
+
+    const char *data;
+    size_t dataLength;
+    size_t padding;
+    lineData(line, length, true, &data, &dataLength, &padding);
+
+    const size_t overlap = searchedText.size() - 1;
+    if( overlap > 0 ) {
+        const size_t tailPadding = std::min(overlap, card.padding);
+        const size_t tail = std::min(overlap - tailPadding, card.dataLength);
+        const size_t head = std::min(overlap, dataLength);
+        m_window.assign( card.data + card.dataLength - tail, tail );
+        m_window.append( tailPadding, ' ' );
+        m_window.append( data, head );
+        card.occurrenceCount += Scanner::count(m_window.data(), m_window.data() + m_window.size(),
+                                               searchedText.data(), searchedText.size());
+    }
+    card.data = data;
+    card.dataLength = dataLength;
+    card.padding = padding;
+}
+
+/*! \brief Counts the occurrences in the buffer [\a begin, \a end), without
+ *         splitting it into lines.
+ *
+ * Only the lines starting with 'INCLUDE' are located, to continue
+ * the search through the INCLUDE file tree. An integer query counts
+ * its tokens the same way.
+ */
+void Engine::scanCount(const char *begin, const char *end,
+                       const string &searchedText,
+                       const string &currentFileName)
+{
+    static const char keyword[] = "INCLUDE";
+    static const size_t keywordLength = sizeof(keyword) - 1;
+
+    /* INCLUDE statements */
+    int currentLineNumber = 1;
+    const char *lineBegin = begin;
+    const char *p = begin;
+    while ((p = Scanner::find(p, end, keyword, keywordLength)) != NULL) {
+        if (p == begin || p[-1] == '\n') {
+            currentLineNumber += (int)Scanner::countLines(lineBegin, p);
+            lineBegin = p;
+
+            string childFileName = searchInclude(p, (size_t)(end - p));
+            if( !childFileName.empty() ){
+                appendFileName(childFileName, currentFileName, currentLineNumber);
+            }
         }
-    } while( std::getline((*iodevice), line) );
+        p += keywordLength;
+    }
+
+    /* Occurrences */
+    if( searchedText.empty() || currentFileName.empty() )
+        return;
+
+    const bool isText = ( m_query.type() == Query::Type::TEXT );
+    size_t lines = 0;
+    const size_t found = isText
+            ? Scanner::count(begin, end, searchedText.data(), searchedText.size(), &lines)
+            : m_query.countIntegers(begin, end, &lines);
+
+    if( isText && StringHelper::hasSpaces(searchedText) ) {
+        /* Like searchText(), each line is a hit */
+        lines = Scanner::countLines(begin, end);
+        if (begin < end && end[-1] != '\n') {
+            ++lines;
+        }
+    }
+
+    Result& result = m_results[ currentFileName ];
+    result.occurrenceCount += found;
+    result.hitCount += lines;
+    m_occurrenceTotal += found;
 }
 
 /******************************************************************************
@@ -158,14 +805,36 @@ const string Engine::searchInclude(istream * const iodevice) const
 {
     const streampos oldpos = iodevice->tellg();  // stores the position
 
-    {
-        string keyword( 7, '\0');
-        iodevice->read(&keyword[0], 7 );
+    /* Magic Number 10:                                           */
+    /*  -> increases buffer to store quotes and trimming space(s) */
+#if defined(Q_OS_WIN)
+    string text(7 + MAX_PATH + 10, '\0');
+#else
+    string text(7 + PATH_MAX + 10, '\0');
+#endif
+
+    iodevice->read( &text[0], text.length() );
+    text.resize( (string::size_type)iodevice->gcount() );
+    iodevice->clear();
+    iodevice->seekg(oldpos);
+
+    return searchInclude( text.data(), text.size() );
+}
 
+/*! \brief Return the filepath of the 'INCLUDE' statement, if the buffer
+ *         \a data of \a size bytes starts with an 'INCLUDE' statement.
+ * Otherwise returns an empty string.
+ */
+const string Engine::searchInclude(const char *data, const size_t size) const
+{
+    /* Fast rejection: most of the lines are not INCLUDE statements */
+    if( size < 7 || Scanner::toUpper(data[0]) != 'I' ) {
+        return string();
+    }
+    {
+        string keyword( data, 7 );
         std::transform( keyword.begin(), keyword.end(), keyword.begin(), ::toupper );
         if( keyword != "INCLUDE" ) {
-            iodevice->clear();
-            iodevice->seekg(oldpos);
             return string();
         }
     }
@@ -173,14 +842,11 @@ const string Engine::searchInclude(istream * const iodevice) const
     /* Magic Number 10:                                           */
     /*  -> increases buffer to store quotes and trimming space(s) */
 #if defined(Q_OS_WIN)
-	string text(MAX_PATH + 10, '\0');
+    const size_t maxLength = MAX_PATH + 10;
 #else
-	string text(PATH_MAX + 10, '\0');
+    const size_t maxLength = PATH_MAX + 10;
 #endif
-
-    iodevice->read( &text[0], text.length() );
-    iodevice->clear();
-    iodevice->seekg(oldpos);
+    string text( data + 7, std::min(size - 7, maxLength) );
 
     /* Remove all the CR and LF */
     StringHelper::removeCharsFromString( text, "\r\n" );
@@ -188,14 +854,14 @@ const string Engine::searchInclude(istream * const iodevice) const
     auto p = text.begin(); // + 7;
 
     /* The first char must be a white space */
-    if ( (*p) != ' ' && (*p) != '\t')
+    if ( p == text.end() || ((*p) != ' ' && (*p) != '\t') )
         return string();
 
-    while( ((*p) == ' ' || (*p) == '\t') && p != text.end() ){
+    while( p != text.end() && ((*p) == ' ' || (*p) == '\t') ){
         ++p;
     }
 
-    if( ((*p) == '\'' || (*p) == '\"') && p != text.end() ) {
+    if( p != text.end() && ((*p) == '\'' || (*p) == '\"') ) {
         /* Read the buffer until reaching the ending quote */
         auto quoteBegin = p;
         ++p;
@@ -216,24 +882,61 @@ const string Engine::searchInclude(istream * const iodevice) const
 
 /******************************************************************************
  ******************************************************************************/
-/*! \brief Returns true if the given \a searchedText is found in the given \a text.
+/*! \brief Appends the given \a card to the results, if the \a searchedText
+ *         is found in it. Then the card is closed.
+ *
+ * A card of several lines is reported with one line of text per physical
+ * line, the continuation lines being prefixed by a blank line number.
  */
-void Engine::searchText(const string &text,
+void Engine::searchCard(Card &card,
                         const string &searchedText,
-                        const string &currentFileName,
-                        const int currentLineNumber)
+                        const string &currentFileName)
 {
+    if( !card.begin )
+        return;
+
+    const char *begin = card.begin;
+    const char *end = card.end;
+    const int currentLineNumber = card.lineNumber;
+    card.begin = NULL;
+
     if( currentLineNumber < 1)
         return;
 
+    /* Preview mode: stop counting once the threshold is reached */
+    if( m_countTruncated )
+        return;
+
     if( !searchedText.empty() && !currentFileName.empty()) {
 
         /* Remark : RegExp is not used here, to avoid unwanted RegExp injection */
         /* instead use of a string literal comparison, with a conversion        */
         /* to Upper Case to compare strings in a case insensitivity manner.     */
 
-        int found = StringHelper::count(text, searchedText);
-        if ( (found > 0) || StringHelper::hasSpaces(searchedText)) {
+        const bool isText = ( m_query.type() == Query::Type::TEXT );
+        const size_t found = isText ? card.occurrenceCount
+                                    : m_query.match(begin, end, m_tokenizer);
+
+        if ( (found > 0) || (isText && StringHelper::hasSpaces(searchedText)) ) {
+
+            Result& result = m_results[ currentFileName ];
+            result.occurrenceCount += found;
+            result.hitCount++;
+
+            m_occurrenceTotal += found;
+            if( m_countLimit > 0 && m_occurrenceTotal >= m_countLimit ) {
+                m_countTruncated = true;
+            }
+
+            /* Count-only mode */
+            if( m_countOnly )
+                return;
+
+            /* Preview mode: count the hit, but don't build it */
+            if( m_resultLimit > 0 && m_resultTotal >= m_resultLimit ) {
+                m_resultTruncated = true;
+                return;
+            }
 
             /* Convert an integer into a length-fixed string */
             char buffer[ C_LINE_NUMBER_BUFFER_SIZE + 1 ];       // 8 digits + 1 '\0'
@@ -242,18 +945,139 @@ void Engine::searchText(const string &text,
             } else {
                 sprintf( buffer, C_LINE_NUMBER_FORMAT_CHAR, '.');
             }
-            string str = string("line")
-                    + string(buffer)
-                    + string(": ")
-                    + text;
+            string str;
+            str.reserve( C_LINE_NUMBER_WIDTH + (size_t)(end - begin) );
+            str.append( "line" );
+            str.append( buffer );
+            str.append( ": " );
 
-            Result& result = m_results[ currentFileName ];
-            stringlist& occurrences = result.occurrences;
-            occurrences.push_back( std::move(str) );
+            /* Continuation lines */
+            const char *p = begin;
+            while( true ) {
+                const char *lineEnd = Scanner::findLineEnd(p, end);
+                str.append( p, lineLength(p, lineEnd) );
+                if( lineEnd == end ) {
+                    break;
+                }
+                str.append( "\n" );
+                str.append( C_LINE_NUMBER_WIDTH - 2, ' ' );
+                str.append( ": " );
+                p = lineEnd + 1;
+            }
 
-            result.occurrenceCount += found;
+            appendOccurrence( result, std::move(str) );
+            m_resultTotal++;
+        }
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void Engine::appendError(const string &message)
+{
+    m_errors.push_back( message );
+    m_memoryStats.allocate( MemoryStats::Subsystem::RESULT_STORAGE,
+                            MemoryStats::sizeOf( m_errors.back() ) );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Appends the given \a text to the occurrences of the given \a result.
+ *
+ * When the result storage exceeds the memory budget, the text is written
+ * in the spill file instead. Each file is scanned entirely before the next
+ * one, hence the spilled occurrences of a given file are contiguous in the
+ * spill file, and always follow its occurrences kept in memory.
+ */
+void Engine::appendOccurrence(Result &result, string &&text)
+{
+    const stringlist::size_type continuationLines = std::count(text.begin(), text.end(), '\n');
+    result.lineCount += 1 + continuationLines;
+    if( continuationLines > 0 ) {
+        const stringlist::size_type previous =
+                result.continuations.empty() ? 0 : result.continuations.back().second;
+        const stringlist::size_type index = result.occurrences.size() + result.spilledCount;
+        result.continuations.push_back( make_pair( index, previous + continuationLines ) );
+        m_memoryStats.allocate( MemoryStats::Subsystem::RESULT_STORAGE,
+                                sizeof(result.continuations.back()) );
+    }
+
+    const size_t bytes = MemoryStats::sizeOf(text);
+    const bool overBudget =
+            m_memoryBudget > 0
+            && m_memoryStats.current(MemoryStats::Subsystem::RESULT_STORAGE) + bytes > m_memoryBudget;
+
+    if( result.spilledCount > 0 || overBudget ) {
+
+        if( result.spilledCount == 0 ) {
+            result.spilledFirst = m_spillFile.count();
+        }
+        if( m_spillFile.append(text) ) {
+            result.spilledCount++;
+            m_memoryStats.allocate( MemoryStats::Subsystem::RESULT_STORAGE,
+                                    sizeof(SpillFile::offset_type) );
+            return;
         }
+
+        /* The file cannot be written: disable the budget */
+        m_memoryBudget = 0;
+        appendError( STR_ERR_SPILL );
+        if( result.spilledCount > 0 ) {
+            /* Preserve the order: read back the occurrences already spilled */
+            for( stringlist::size_type i = 0; i < result.spilledCount; ++i ) {
+                string spilled = m_spillFile.at(result.spilledFirst + i);
+                m_memoryStats.allocate( MemoryStats::Subsystem::RESULT_STORAGE,
+                                        MemoryStats::sizeOf(spilled) );
+                result.occurrences.push_back( std::move(spilled) );
+            }
+            result.spilledCount = 0;
+        }
+    }
+
+    m_memoryStats.allocate( MemoryStats::Subsystem::RESULT_STORAGE, bytes );
+    result.occurrences.push_back( std::move(text) );
+}
+
+/*! \brief Keeps the \a previous results of the file \a currentFileName,
+ *         that didn't change, and appends the files it includes.
+ */
+void Engine::keepResults(Result &previous, const string &currentFileName,
+                         const FileIndex &fileIndex)
+{
+    Result& result = m_results[ currentFileName ];
+    result = std::move( previous );
+
+    for (stringlist::const_iterator it = result.occurrences.begin(); it != result.occurrences.end(); ++it) {
+        m_memoryStats.allocate( MemoryStats::Subsystem::RESULT_STORAGE, MemoryStats::sizeOf(*it) );
+    }
+    m_memoryStats.allocate( MemoryStats::Subsystem::RESULT_STORAGE,
+                            result.continuations.size() * sizeof(result.continuations.front()) );
+    m_occurrenceTotal += result.occurrenceCount;
+    m_resultTotal += result.occurrences.size();
+
+    for (vector<FileIndex::Include>::const_iterator it = fileIndex.includes.begin();
+         it != fileIndex.includes.end(); ++it) {
+        appendFileName( it->fileName, currentFileName, it->lineNumber );
+    }
+}
+
+/*! \brief Copies the results of the file \a sourceFileName to the file
+ *         \a currentFileName, that has the same content.
+ */
+void Engine::copyResults(const string &sourceFileName, const string &currentFileName)
+{
+    Result& result = m_results[ currentFileName ];
+    const Result& source = m_results[ sourceFileName ];
+
+    const stringlist::size_type count = resultCount( sourceFileName );
+    for( stringlist::size_type i = 0; i < count; ++i ) {
+        appendOccurrence( result, string(resultAt(sourceFileName, i)) );
     }
+    result.occurrenceCount += source.occurrenceCount;
+    result.hitCount += source.hitCount;
+
+    m_occurrenceTotal += source.occurrenceCount;
+    m_resultTotal += count;
 }
 
 /******************************************************************************
@@ -263,7 +1087,11 @@ void Engine::appendFileName(const string &filenameToBeInserted,
                             const int currentLineNumber)
 {
     /* Check if the filename is not already referenced */
+    int parent = -1;
     for( stringlist::const_iterator it = m_files.begin(); it != m_files.end(); ++it )  {
+        if ( currentFileName == (*it) ) {
+            parent = (int)(it - m_files.begin());
+        }
         if ( filenameToBeInserted == (*it) ) {
 
             string lineNumber = std::to_string(currentLineNumber) ;
@@ -274,13 +1102,15 @@ void Engine::appendFileName(const string &filenameToBeInserted,
                     + lineNumber
                     + STR_ERR_END;
 
-            m_errors.push_back( error_msg );
+            appendError( error_msg );
             return;
         }
     }
 
     /* Append the file to the file list */
     m_files.push_back( filenameToBeInserted );
+    const FileStats stats = { parent, currentLineNumber, 0, 0, 0., 0., false };
+    m_fileStats.push_back( stats );
     Result emptyResult;
     m_results[ filenameToBeInserted ] = emptyResult;
 }
@@ -328,8 +1158,11 @@ stringlist::size_type Engine::resultCountAll() const
  */
 stringlist::size_type Engine::resultCountLines(const string &filename) const
 {
-    /// \todo resultCountLines( ) to be implemented
-    return resultCount(filename);
+    if( m_results.count(filename) > 0 ) {
+        const Result& result = m_results.at(filename);
+        return result.lineCount;
+    }
+    return 0;
 }
 
 
@@ -341,12 +1174,14 @@ stringlist::size_type Engine::resultCount(const string &filename) const
     if( m_results.count(filename) > 0 ) {
         const Result& result = m_results.at(filename);
         const stringlist& occurrences = result.occurrences;
-        return occurrences.size();
+        return occurrences.size() + result.spilledCount;
     }
     return 0;
 }
 
 /*! \brief Returns the occurence at the given \a index, for the given \a filename.
+ *
+ * If the occurence has been spilled to disk, it's read back from the spill file.
  */
 const string Engine::resultAt(const string &filename, const stringlist::size_type index) const
 {
@@ -356,10 +1191,62 @@ const string Engine::resultAt(const string &filename, const stringlist::size_typ
         if (index < occurrences.size()) {
             return occurrences.at(index);
         }
+        if (index < occurrences.size() + result.spilledCount) {
+            return m_spillFile.at( result.spilledFirst + index - occurrences.size() );
+        }
     }
     return string();
 }
 
+/*! \brief Returns the line of the occurence at the given \a index, among
+ *         the resultCountLines() lines of the given \a filename.
+ *
+ * The occurence is not read, even if it has been spilled to disk.
+ */
+stringlist::size_type Engine::resultLine(const string &filename, const stringlist::size_type index) const
+{
+    if( m_results.count(filename) > 0 ) {
+        const Result& result = m_results.at(filename);
+        typedef vector<pair<stringlist::size_type, stringlist::size_type> >::const_iterator Iterator;
+        const Iterator it = lower_bound( result.continuations.begin(), result.continuations.end(),
+                                         make_pair(index, (stringlist::size_type)0) );
+        return index + ( it == result.continuations.begin() ? 0 : (it - 1)->second );
+    }
+    return 0;
+}
+
+/*! \brief Returns the index of the occurence shown at the given \a line,
+ *         among the resultCountLines() lines of the given \a filename.
+ *
+ * The occurences are not read, even if they have been spilled to disk.
+ */
+stringlist::size_type Engine::resultAtLine(const string &filename, const stringlist::size_type line) const
+{
+    if( m_results.count(filename) > 0 ) {
+        const Result& result = m_results.at(filename);
+
+        /* Last occurence with continuation lines that starts at or before the line */
+        stringlist::size_type first = 0;
+        stringlist::size_type last = result.continuations.size();
+        while( first < last ) {
+            const stringlist::size_type middle = first + (last - first) / 2;
+            const stringlist::size_type previous = (middle == 0) ? 0 : result.continuations[middle - 1].second;
+            if( result.continuations[middle].first + previous <= line ) {
+                first = middle + 1;
+            } else {
+                last = middle;
+            }
+        }
+        if( first == 0 ) {
+            return line;
+        }
+        const pair<stringlist::size_type, stringlist::size_type>& found = result.continuations[first - 1];
+        const stringlist::size_type end = found.first + found.second + 1; /* line after it */
+        return (line < end) ? found.first : line - found.second;
+    }
+    return 0;
+}
+
 /******************************************************************************
  ******************************************************************************/
 stringlist::size_type Engine::occurrenceCountAll() const
@@ -381,3 +1268,197 @@ stringlist::size_type Engine::occurrenceCount(const string &filename) const
     }
     return 0;
 }
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the number of lines found, in the file and all its includes,
+ *         including the lines that are counted but not built in preview mode.
+ * \sa hitCount(), resultCountAll()
+ */
+stringlist::size_type Engine::hitCountAll() const
+{
+    auto value = 0;
+    for( stringlist::const_iterator it = m_files.begin(); it != m_files.end(); ++it ) {
+        const string& file = (*it);
+        value += hitCount(file);
+    }
+    return value;
+}
+
+stringlist::size_type Engine::hitCount(const string &filename) const
+{
+    if( m_results.count(filename) > 0 ) {
+        const Result& result = m_results.at(filename);
+        return result.hitCount;
+    }
+    return 0;
+}
+
+/*****************************************************************************
+ *****************************************************************************/
+/*! \brief Returns in \a fileName and \a location where the entity \a id
+ *         of the family of the given \a card is defined, e.g. GRID 123456,
+ *         or the property 12 for 'PSHELL' (or any other property card).
+ *
+ * The entity indexes are built during the first find() in each file,
+ * so the lookup doesn't scan the files again.
+ * Returns false if the entity is not defined in the files of the last search.
+ */
+bool Engine::locate(const string &card, const long long id,
+                    string *fileName, EntityLocation *location) const
+{
+    const EntityIndex::Family family = EntityIndex::familyOf(card.data(), card.size());
+    return locate(family, id, fileName, location);
+}
+
+/*! \brief Returns in \a fileName and \a location where the entity \a id
+ *         of the given \a family is defined.
+ */
+bool Engine::locate(const EntityIndex::Family family, const long long id,
+                    string *fileName, EntityLocation *location) const
+{
+    if( family == EntityIndex::Family::UNKNOWN )
+        return false;
+
+    for (stringlist::size_type i = 0; i < m_filePaths.size(); ++i) {
+        const FileCache::Entry *entry = m_fileCache->find( m_filePaths.at(i) );
+        if( !entry || !entry->content().index.zoneMap.isBuilt() )
+            continue;
+        if( entry->content().index.entityIndex.find(family, id, location) ) {
+            if( fileName ) {
+                (*fileName) = m_files.at(i);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/*! \brief Returns the IDs defined more than once in the files of the last
+ *         search, with \a threadCount threads (0 means one per processor).
+ *
+ * The firstIndex and secondIndex of each duplicate are positions in files(),
+ * and the first definition is the one of the file loaded first.
+ */
+vector<EntityIndex::Duplicate> Engine::findDuplicates(const int threadCount) const
+{
+    vector<const EntityIndex*> indexes;
+    vector<int> positions;
+    for (stringlist::size_type i = 0; i < m_filePaths.size(); ++i) {
+        const FileCache::Entry *entry = m_fileCache->find( m_filePaths.at(i) );
+        if( !entry || !entry->content().index.zoneMap.isBuilt() )
+            continue;
+        indexes.push_back( &entry->content().index.entityIndex );
+        positions.push_back( (int)i );
+    }
+
+    vector<EntityIndex::Duplicate> duplicates = EntityIndex::findDuplicates( indexes, threadCount );
+    for (vector<EntityIndex::Duplicate>::iterator it = duplicates.begin(); it != duplicates.end(); ++it) {
+        it->firstIndex = positions.at( it->firstIndex );
+        it->secondIndex = positions.at( it->secondIndex );
+    }
+    return duplicates;
+}
+
+/*****************************************************************************
+ *****************************************************************************/
+/*! \brief Computes the \a fingerprint of the include tree of \a fullFileName,
+ *         and returns its value.
+ *
+ * Only the files that changed since the records of the \a fingerprint are
+ * read, to hash their content and find their INCLUDE statements.
+ */
+uint64_t Engine::fingerprint(const string &fullFileName, Fingerprint *fingerprint) const
+{
+    auto parser = [this](const char *begin, const char *end, vector<string> *includes) {
+        const char *p = begin;
+        while( p < end ) {
+            const string childFileName = searchInclude(p, (size_t)(end - p));
+            if( !childFileName.empty() ) {
+                includes->push_back( childFileName );
+            }
+            p = Scanner::findLineEnd(p, end);
+            if( p < end ) {
+                ++p;
+            }
+        }
+    };
+    return fingerprint->compute( fullFileName, parser );
+}
+
+/*! \brief Checks the records of the term index against the content hash of
+ *         the files of the include tree of \a fullFileName.
+ *
+ * The status of the files is kept in the file \a recordsFileName, like the
+ * records of a Fingerprint, so the files that didn't change since are checked
+ * with a stat only. Returns false if the records cannot be saved.
+ */
+bool Engine::validateTermIndex(const string &fullFileName, const string &recordsFileName)
+{
+    if( !m_termIndex || m_termIndex->recordCount() == 0 ) {
+        return true;
+    }
+    Fingerprint records;
+    records.load( recordsFileName );
+    this->fingerprint( fullFileName, &records );
+    m_termIndex->validate( records );
+    return records.save( recordsFileName );
+}
+
+/*****************************************************************************
+ *****************************************************************************/
+/*! \brief Builds the cross-references of the files of the last search,
+ *         with \a threadCount threads (0 means one per processor).
+ *
+ * The files are taken from the file cache, and parsed in parallel.
+ * Then, crossReference() tells which elements are connected to a GRID,
+ * which elements have a PID, and which properties use a MID.
+ */
+void Engine::buildCrossReference(const int threadCount)
+{
+    if( m_crossReference.isBuilt() ) {
+        m_memoryStats.release( MemoryStats::Subsystem::INDEXES, m_crossReference.memoryUsage() );
+    }
+
+    vector<TextBuffer> buffers;
+    for (stringlist::size_type i = 0; i < m_filePaths.size(); ++i) {
+        const FileCache::Entry *entry = m_fileCache->open( m_filePaths.at(i) );
+        if( entry ) {
+            TextBuffer buffer = { entry->content().file.begin(), entry->content().file.end() };
+            buffers.push_back( buffer );
+        }
+    }
+    m_crossReference.build( buffers, threadCount );
+
+    m_memoryStats.allocate( MemoryStats::Subsystem::INDEXES, m_crossReference.memoryUsage() );
+}
+
+/*! \brief Returns the references of the \a relation to the entities that
+ *         are not defined in the files of the last search, e.g. the elements
+ *         connected to a GRID that doesn't exist.
+ *
+ * The references of the cross-reference are joined with the entity
+ * indexes of the files, with \a threadCount threads (0 means one per
+ * processor). Hence buildCrossReference() must be called before.
+ */
+vector<CrossReference::Reference> Engine::findUndefinedReferences(
+        const CrossReference::Relation relation, const int threadCount) const
+{
+    /* The IDs of all the files, merged once in one set */
+    const EntityIndex::Family family = CrossReference::targetFamily(relation);
+    EntityIndex defined;
+    for (stringlist::size_type i = 0; i < m_filePaths.size(); ++i) {
+        const FileCache::Entry *entry = m_fileCache->find( m_filePaths.at(i) );
+        if( entry && entry->content().index.zoneMap.isBuilt() ) {
+            defined.merge( entry->content().index.entityIndex, family );
+        }
+    }
+
+    /* A grid field can also reference a scalar point */
+    const bool scalar = (relation == CrossReference::Relation::GRID_ELEMENTS);
+    auto isDefined = [&](long long id) {
+        return defined.find(family, id, NULL)
+                || (scalar && m_crossReference.isScalarPoint(id));
+    };
+    return m_crossReference.findUndefined( relation, isDefined, threadCount );
+}
@@ -17,7 +17,21 @@
 #ifndef ENGINE_H
 #define ENGINE_H
 
+#include "crossreference.h"
+#include "entityindex.h"
+#include "filecache.h"
+#include "filestats.h"
+#include "fingerprint.h"
+#include "memorystats.h"
+#include "query.h"
 #include "result.h"
+#include "spillfile.h"
+#include "termindex.h"
+#include "tokenizer.h"
+#include "zonemap.h"
+
+#include <map>
+#include <memory>
 
 /* **************************************************************** */
 /* Messages stored in header file is required for testing           */
@@ -25,6 +39,7 @@ static const char STR_ERR_EMPTY_FILENAME[] = "Error: empty filename. Need a vali
 static const char STR_ERR_CANNOT_OPEN[]    = "Error: cannot open the file '";
 static const char STR_ERR_CYCLIC[]         = "Error: cyclic reference in '";
 static const char STR_ERR_MISSING_FILE[]   = "Error: no such file. Verify INCLUDE card?";
+static const char STR_ERR_SPILL[]          = "Error: cannot write the temporary file. The results are kept in memory.";
 /// \todo static const char STR_ERR_DUPLICATE[]      = "Error: duplicate reference in '";
 static const char STR_ERR_AT_LINE[]    = "' at line ";
 static const char STR_ERR_QUOTE_END[]  = "'.";
@@ -39,17 +54,41 @@ public:
     /* Clear the previous search */
     void clear();
 
+    /* Memory budget of the results, in bytes (0 means unlimited) */
+    void setMemoryBudget(const std::size_t bytes) { m_memoryBudget = bytes; }
+    std::size_t memoryBudget() const { return m_memoryBudget; }
+
+    /* Preview mode: maximum number of results built, and maximum */
+    /* number of occurrences counted (0 means unlimited)           */
+    void setResultLimit(const stringlist::size_type limit) { m_resultLimit = limit; }
+    stringlist::size_type resultLimit() const { return m_resultLimit; }
+    void setCountLimit(const stringlist::size_type limit) { m_countLimit = limit; }
+    stringlist::size_type countLimit() const { return m_countLimit; }
+
     /* Do a search */
     void find(const std::string &fullFileName, const std::string &searchedText );
     void find(std::istream * const iodevice,
               const std::string &searchedText,
               const std::string &currentFileName );
 
+    /* Search again, after some files changed: only they are scanned */
+    stringlist::size_type refresh();
+
+    /* Count the occurrences only, without building the results */
+    void count(const std::string &fullFileName, const std::string &searchedText );
+    void count(std::istream * const iodevice,
+               const std::string &searchedText,
+               const std::string &currentFileName );
+
     /* Getters -> return the file hierarchy */
     const stringlist& files() const { return m_files; }
+    const stringlist& filePaths() const { return m_filePaths; }
     std::string::size_type linkCount() const { return m_files.size(); }
     const std::string linkAt(const std::string::size_type index) const;
 
+    /* Getters -> return the include tree: the statistics of each file of files() */
+    const std::vector<FileStats>& fileStats() const { return m_fileStats; }
+
     /* Getters -> return the errors, if so */
     std::string::size_type errorCount() const { return m_errors.size(); }
     const std::string errorAt(const std::string::size_type index) const;
@@ -60,22 +99,100 @@ public:
     stringlist::size_type resultCountLines(const std::string &filename) const;
     stringlist::size_type resultCount(const std::string &filename) const;
     const std::string resultAt(const std::string &filename, const stringlist::size_type index) const;
+    stringlist::size_type resultLine(const std::string &filename, const stringlist::size_type index) const;
+    stringlist::size_type resultAtLine(const std::string &filename, const stringlist::size_type line) const;
 
     stringlist::size_type occurrenceCountAll() const;
     stringlist::size_type occurrenceCount(const std::string &filename) const;
 
+    stringlist::size_type hitCountAll() const;
+    stringlist::size_type hitCount(const std::string &filename) const;
+
+    /* Getters -> return true if the preview mode stopped the search */
+    bool isResultTruncated() const { return m_resultTruncated; }
+    bool isCountTruncated() const { return m_countTruncated; }
+
+    /* Getters -> return the parsed searched text */
+    const Query& query() const { return m_query; }
+
+    /* Getters -> return where an entity is defined, in the files of the last search */
+    bool locate(const std::string &card, const long long id,
+                std::string *fileName, EntityLocation *location) const;
+    bool locate(const EntityIndex::Family family, const long long id,
+                std::string *fileName, EntityLocation *location) const;
+
+    /* Getters -> return the IDs defined more than once in the files of the last search */
+    std::vector<EntityIndex::Duplicate> findDuplicates(const int threadCount = 0) const;
+
+    /* Cross-references of the files of the last search, built on demand */
+    void buildCrossReference(const int threadCount = 0);
+    const CrossReference& crossReference() const { return m_crossReference; }
+    std::vector<CrossReference::Reference> findUndefinedReferences(
+            const CrossReference::Relation relation, const int threadCount = 0) const;
+
+    /* Cache of the mapped files and of their indexes, that can be shared */
+    /* with another engine, e.g. to compare two models                    */
+    void setFileCache(const std::shared_ptr<FileCache> &fileCache);
+    const std::shared_ptr<FileCache>& fileCache() const { return m_fileCache; }
+
+    /* Index of the terms of each file, that can be shared and saved: the   */
+    /* files that can't contain the searched text are neither loaded nor   */
+    /* scanned (disabled if null)                                           */
+    void setTermIndex(const std::shared_ptr<TermIndex> &termIndex) { m_termIndex = termIndex; }
+    const std::shared_ptr<TermIndex>& termIndex() const { return m_termIndex; }
+    stringlist::size_type skippedCount() const { return m_skippedCount; }
+
+    /* Fingerprint of an include tree: the files that didn't change */
+    /* since the records of the fingerprint are checked with a stat */
+    std::uint64_t fingerprint(const std::string &fullFileName, Fingerprint *fingerprint) const;
+
+    /* Check the records of the term index against the content of the include tree */
+    bool validateTermIndex(const std::string &fullFileName, const std::string &recordsFileName);
+
+    /* Getters -> return the memory accounting */
+    const MemoryStats& memoryStats() const { return m_memoryStats; }
+    MemoryStats& memoryStats() { return m_memoryStats; }
+
 
 protected:
     const std::string searchInclude(std::istream * const iodevice) const;
+    const std::string searchInclude(const char *data, const std::size_t size) const;
 
-    void searchText(const std::string &text,
+    /* Logical card: a parent line followed by its continuation lines */
+    struct Card
+    {
+        const char *begin;              ///< First char of the parent line, or NULL
+        const char *end;                ///< End of the last line
+        int lineNumber;                 ///< Line number of the parent line
+        bool isOpen;                    ///< True if a continuation line can follow
+        std::size_t occurrenceCount;
+        const char *data;               ///< Data of the last line, without the
+        std::size_t dataLength;         ///< continuation fields, and the blanks
+        std::size_t padding;            ///< missing up to the column 72
+    };
+
+    void startCard(Card &card, const char *line, const std::size_t length,
+                   const int lineNumber, const std::string &searchedText);
+    void continueCard(Card &card, const char *line, const std::size_t length,
+                      const std::string &searchedText);
+    void searchCard(Card &card,
                     const std::string &searchedText,
-                    const std::string &currentFileName,
-                    const int currentLineNumber);
+                    const std::string &currentFileName);
 
 private:
     /* list of the filename + all included files */
     stringlist m_files;
+    stringlist m_filePaths;
+    std::vector<FileStats> m_fileStats;
+
+    /* size and modification time of the files, when they were scanned */
+    typedef std::pair<std::size_t, long long> FileStatus;
+    typedef std::map<std::string, FileStatus> FileStatusMap;
+    FileStatusMap m_fileStatus;
+
+    /* last search, to refresh it */
+    std::string m_fullFileName;
+    std::string m_searchedText;
 
     /* list of error messages */
     stringlist m_errors;
@@ -83,6 +200,65 @@ private:
     /* map containing the occurences for each file */
     ResultMap m_results;
 
+    /* memory accounting per subsystem */
+    MemoryStats m_memoryStats;
+
+    /* results exceeding the memory budget are stored on disk */
+    std::size_t m_memoryBudget;
+    SpillFile m_spillFile;
+
+    /* parsed searched text */
+    Query m_query;
+    bool m_countOnly;
+
+    /* reused while scanning, to avoid allocations */
+    Tokenizer m_tokenizer;
+    std::string m_window;
+    std::string m_joins;
+
+    /* mapped files and their indexes, kept between the searches */
+    std::shared_ptr<FileCache> m_fileCache;
+
+    /* files skipped, thanks to the term index */
+    std::shared_ptr<TermIndex> m_termIndex;
+    stringlist::size_type m_skippedCount;
+
+    /* who references an entity, in the files of the last search */
+    CrossReference m_crossReference;
+
+    /* preview mode */
+    stringlist::size_type m_resultLimit;
+    stringlist::size_type m_countLimit;
+    stringlist::size_type m_resultTotal;
+    stringlist::size_type m_occurrenceTotal;
+    bool m_resultTruncated;
+    bool m_countTruncated;
+
+    stringlist::size_type search(const std::string &fullFileName,
+                                 const std::string &searchedText,
+                                 const bool countOnly,
+                                 ResultMap *previousResults = NULL,
+                                 const FileStatusMap *previousStatus = NULL);
+    void scan(const char *begin, const char *end,
+              const std::string &searchedText,
+              const std::string &currentFileName,
+              FileIndex *fileIndex = NULL);
+    void scanCount(const char *begin, const char *end,
+                   const std::string &searchedText,
+                   const std::string &currentFileName);
+    const TermIndex::Record* skippable(const std::string &fullFileName,
+                                       const std::vector<std::string> &terms) const;
+    void accountLoadedText();
+    static std::string readAll(std::istream * const iodevice);
+    static bool cardId(const char *line, const std::size_t length, long long *id);
+    static std::size_t cardNameLength(const char *line, const std::size_t length);
+
+    void appendError(const std::string &message);
+    void appendOccurrence(Result &result, std::string &&text);
+    void keepResults(Result &previous, const std::string &currentFileName,
+                     const FileIndex &fileIndex);
+    void copyResults(const std::string &sourceFileName,
+                     const std::string &currentFileName);
     void appendFileName(const std::string &filenameToBeInserted,
                         const std::string &currentFileName,
                         const int currentLineNumber);
@@ -0,0 +1,523 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "entityindex.h"
+
+#include "scanner.h"
+
+#include <algorithm> // sort()
+#include <thread>
+
+using namespace std;
+
+/*! \class EntityIndex
+ *  \brief The class EntityIndex maps the ID of an entity (a grid,
+ *         an element, a property...) to the card that defines it.
+ *
+ * The IDs are grouped by family, as a property and an element can share
+ * the same ID, but two element cards can't (e.g. CQUAD4 12 and CBAR 12).
+ *
+ * The index is a hash table with open addressing and linear probing,
+ * stored in flat arrays: a slot takes 20 bytes, and the table is kept
+ * less than 75% full. Hence tens of millions of IDs can be indexed,
+ * without the memory overhead of the nodes of a std::map.
+ *
+ * Example:
+ * \code
+ *   EntityIndex index;
+ *   index.insert(EntityIndex::Family::GRID, 123456, offset, lineNumber);
+ *   EntityLocation location;
+ *   if (index.find(EntityIndex::Family::GRID, 123456, &location)) {
+ *       // location.lineNumber == lineNumber
+ *   }
+ * \endcode
+ *
+ * \remark Only the first definition of an ID is kept. The other ones
+ * are listed in duplicates(), except in the SET family, where the cards
+ * of a set (e.g. MPC 10) share the same ID.
+ */
+
+static const size_t C_INITIAL_CAPACITY = 1024;          // power of 2
+static const unsigned long long C_MAX_ID = (1ULL << 56) - 1;
+
+struct CardFamily
+{
+    const char *name;
+    EntityIndex::Family family;
+};
+
+/* Sorted by name, for a binary search */
+static const CardFamily CARD_FAMILIES[] = {
+    { "CBAR",    EntityIndex::Family::ELEMENT },
+    { "CBEAM",   EntityIndex::Family::ELEMENT },
+    { "CBEND",   EntityIndex::Family::ELEMENT },
+    { "CBUSH",   EntityIndex::Family::ELEMENT },
+    { "CBUSH1D", EntityIndex::Family::ELEMENT },
+    { "CDAMP1",  EntityIndex::Family::ELEMENT },
+    { "CDAMP2",  EntityIndex::Family::ELEMENT },
+    { "CDAMP3",  EntityIndex::Family::ELEMENT },
+    { "CDAMP4",  EntityIndex::Family::ELEMENT },
+    { "CELAS1",  EntityIndex::Family::ELEMENT },
+    { "CELAS2",  EntityIndex::Family::ELEMENT },
+    { "CELAS3",  EntityIndex::Family::ELEMENT },
+    { "CELAS4",  EntityIndex::Family::ELEMENT },
+    { "CFAST",   EntityIndex::Family::ELEMENT },
+    { "CGAP",    EntityIndex::Family::ELEMENT },
+    { "CHEXA",   EntityIndex::Family::ELEMENT },
+    { "CMASS1",  EntityIndex::Family::ELEMENT },
+    { "CMASS2",  EntityIndex::Family::ELEMENT },
+    { "CMASS3",  EntityIndex::Family::ELEMENT },
+    { "CMASS4",  EntityIndex::Family::ELEMENT },
+    { "CONM1",   EntityIndex::Family::ELEMENT },
+    { "CONM2",   EntityIndex::Family::ELEMENT },
+    { "CONROD",  EntityIndex::Family::ELEMENT },
+    { "CORD1C",  EntityIndex::Family::COORDINATE_SYSTEM },
+    { "CORD1R",  EntityIndex::Family::COORDINATE_SYSTEM },
+    { "CORD1S",  EntityIndex::Family::COORDINATE_SYSTEM },
+    { "CORD2C",  EntityIndex::Family::COORDINATE_SYSTEM },
+    { "CORD2R",  EntityIndex::Family::COORDINATE_SYSTEM },
+    { "CORD2S",  EntityIndex::Family::COORDINATE_SYSTEM },
+    { "CORD3G",  EntityIndex::Family::COORDINATE_SYSTEM },
+    { "CPENTA",  EntityIndex::Family::ELEMENT },
+    { "CPYRAM",  EntityIndex::Family::ELEMENT },
+    { "CQUAD",   EntityIndex::Family::ELEMENT },
+    { "CQUAD4",  EntityIndex::Family::ELEMENT },
+    { "CQUAD8",  EntityIndex::Family::ELEMENT },
+    { "CQUADR",  EntityIndex::Family::ELEMENT },
+    { "CROD",    EntityIndex::Family::ELEMENT },
+    { "CSHEAR",  EntityIndex::Family::ELEMENT },
+    { "CTETRA",  EntityIndex::Family::ELEMENT },
+    { "CTRIA3",  EntityIndex::Family::ELEMENT },
+    { "CTRIA6",  EntityIndex::Family::ELEMENT },
+    { "CTRIAR",  EntityIndex::Family::ELEMENT },
+    { "CTRIAX6", EntityIndex::Family::ELEMENT },
+    { "CTUBE",   EntityIndex::Family::ELEMENT },
+    { "CVISC",   EntityIndex::Family::ELEMENT },
+    { "CWELD",   EntityIndex::Family::ELEMENT },
+    { "GRID",    EntityIndex::Family::GRID },
+    { "MAT1",    EntityIndex::Family::MATERIAL },
+    { "MAT10",   EntityIndex::Family::MATERIAL },
+    { "MAT11",   EntityIndex::Family::MATERIAL },
+    { "MAT2",    EntityIndex::Family::MATERIAL },
+    { "MAT3",    EntityIndex::Family::MATERIAL },
+    { "MAT4",    EntityIndex::Family::MATERIAL },
+    { "MAT5",    EntityIndex::Family::MATERIAL },
+    { "MAT8",    EntityIndex::Family::MATERIAL },
+    { "MAT9",    EntityIndex::Family::MATERIAL },
+    { "MPC",     EntityIndex::Family::SET },
+    { "PBAR",    EntityIndex::Family::PROPERTY },
+    { "PBARL",   EntityIndex::Family::PROPERTY },
+    { "PBEAM",   EntityIndex::Family::PROPERTY },
+    { "PBEAML",  EntityIndex::Family::PROPERTY },
+    { "PBEND",   EntityIndex::Family::PROPERTY },
+    { "PBUSH",   EntityIndex::Family::PROPERTY },
+    { "PBUSH1D", EntityIndex::Family::PROPERTY },
+    { "PCOMP",   EntityIndex::Family::PROPERTY },
+    { "PCOMPG",  EntityIndex::Family::PROPERTY },
+    { "PDAMP",   EntityIndex::Family::PROPERTY },
+    { "PELAS",   EntityIndex::Family::PROPERTY },
+    { "PFAST",   EntityIndex::Family::PROPERTY },
+    { "PGAP",    EntityIndex::Family::PROPERTY },
+    { "PMASS",   EntityIndex::Family::PROPERTY },
+    { "PROD",    EntityIndex::Family::PROPERTY },
+    { "PSHEAR",  EntityIndex::Family::PROPERTY },
+    { "PSHELL",  EntityIndex::Family::PROPERTY },
+    { "PSOLID",  EntityIndex::Family::PROPERTY },
+    { "PTUBE",   EntityIndex::Family::PROPERTY },
+    { "PVISC",   EntityIndex::Family::PROPERTY },
+    { "PWELD",   EntityIndex::Family::PROPERTY },
+    { "RBAR",    EntityIndex::Family::CONSTRAINT },
+    { "RBAR1",   EntityIndex::Family::CONSTRAINT },
+    { "RBE1",    EntityIndex::Family::CONSTRAINT },
+    { "RBE2",    EntityIndex::Family::CONSTRAINT },
+    { "RBE3",    EntityIndex::Family::CONSTRAINT },
+    { "RROD",    EntityIndex::Family::CONSTRAINT },
+    { "RSPLINE", EntityIndex::Family::CONSTRAINT },
+    { "RTRPLT",  EntityIndex::Family::CONSTRAINT }
+};
+static const int CARD_FAMILY_COUNT = (int)(sizeof(CARD_FAMILIES) / sizeof(CARD_FAMILIES[0]));
+
+/*! \brief Compares the \a name of the given \a length (case insensitive)
+ *         with the upper case \a other, like strcmp().
+ */
+static inline int compareName(const char *name, const size_t length, const char *other)
+{
+    size_t i = 0;
+    for (; i < length && other[i] != '\0'; ++i) {
+        const char c = Scanner::toUpper(name[i]);
+        if (c != other[i]) {
+            return (unsigned char)c < (unsigned char)other[i] ? -1 : 1;
+        }
+    }
+    if (i < length) {
+        return 1;
+    }
+    return (other[i] == '\0') ? 0 : -1;
+}
+
+/*! \brief Returns the hash of the \a key (finalizer of SplitMix64).
+ */
+static inline unsigned long long hashOf(unsigned long long key)
+{
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return key;
+}
+
+/*! \brief Returns the key of the \a id in the \a family, or 0 if the ID
+ *         can't be indexed (negative or too large).
+ */
+static inline unsigned long long keyOf(const EntityIndex::Family family, const long long id)
+{
+    if (id < 0 || (unsigned long long)id > C_MAX_ID) {
+        return 0;
+    }
+    return ((unsigned long long)family + 1) << 56 | (unsigned long long)id;
+}
+
+/*! \brief Returns true if the \a key is the one of an ID of the SET family.
+ */
+static inline bool isSetKey(const unsigned long long key)
+{
+    return (key >> 56) == (unsigned long long)EntityIndex::Family::SET + 1;
+}
+
+/*! \brief Constructor.
+ */
+EntityIndex::EntityIndex()
+    : m_size(0)
+{
+}
+
+void EntityIndex::clear()
+{
+    /* Release the memory */
+    vector<unsigned long long>().swap(m_keys);
+    vector<unsigned long long>().swap(m_offsets);
+    vector<unsigned int>().swap(m_lineNumbers);
+    vector<Duplicate>().swap(m_duplicates);
+    m_size = 0;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Inserts the entity \a id of the \a family, defined by the card at
+ *         the given \a offset and \a lineNumber.
+ * Returns false if the ID is already defined, or can't be indexed.
+ */
+bool EntityIndex::insert(const Family family, const long long id,
+                         const size_t offset, const int lineNumber)
+{
+    const unsigned long long key = keyOf(family, id);
+    if (key == 0 || family == Family::UNKNOWN) {
+        return false;
+    }
+    /* Keep the load factor below 75% */
+    if ((m_size + 1) * 4 > m_keys.size() * 3) {
+        grow();
+    }
+    const size_t slot = slotOf(key);
+    if (m_keys[slot] == key && family == Family::SET) {
+        return false;
+    }
+    if (m_keys[slot] == key) {
+        Duplicate duplicate;
+        duplicate.family = family;
+        duplicate.id = id;
+        duplicate.firstIndex = 0;
+        duplicate.first.offset = (size_t)m_offsets[slot];
+        duplicate.first.lineNumber = (int)m_lineNumbers[slot];
+        duplicate.secondIndex = 0;
+        duplicate.second.offset = offset;
+        duplicate.second.lineNumber = lineNumber;
+        m_duplicates.push_back(duplicate);
+        return false;
+    }
+    m_keys[slot] = key;
+    m_offsets[slot] = offset;
+    m_lineNumbers[slot] = (unsigned int)lineNumber;
+    ++m_size;
+    return true;
+}
+
+/*! \brief Returns in \a location where the entity \a id of the \a family
+ *         is defined. Returns false if the ID is not indexed.
+ */
+bool EntityIndex::find(const Family family, const long long id, EntityLocation *location) const
+{
+    const unsigned long long key = keyOf(family, id);
+    if (key == 0 || m_size == 0) {
+        return false;
+    }
+    const size_t slot = slotOf(key);
+    if (m_keys[slot] != key) {
+        return false;
+    }
+    if (location) {
+        location->offset = (size_t)m_offsets[slot];
+        location->lineNumber = (int)m_lineNumbers[slot];
+    }
+    return true;
+}
+
+/*! \brief Inserts the IDs of the \a family of the \a other index, with
+ *         their locations in the other file.
+ *
+ * The IDs already in this index are skipped, without being reported as
+ * duplicates: the merged index is a set of all the IDs of the family in
+ * several files, that is probed once per ID.
+ */
+void EntityIndex::merge(const EntityIndex &other, const Family family)
+{
+    const unsigned long long tag = (unsigned long long)family + 1;
+    for (size_t i = 0; i < other.m_keys.size(); ++i) {
+        const unsigned long long key = other.m_keys[i];
+        if (key == 0 || (key >> 56) != tag) {
+            continue;
+        }
+        if ((m_size + 1) * 4 > m_keys.size() * 3) {
+            grow();
+        }
+        const size_t slot = slotOf(key);
+        if (m_keys[slot] == key) {
+            continue;
+        }
+        m_keys[slot] = key;
+        m_offsets[slot] = other.m_offsets[i];
+        m_lineNumbers[slot] = other.m_lineNumbers[i];
+        ++m_size;
+    }
+}
+
+/*! \brief Returns the memory used by the index, in bytes.
+ */
+size_t EntityIndex::memoryUsage() const
+{
+    return sizeof(EntityIndex)
+            + m_keys.capacity() * sizeof(unsigned long long)
+            + m_offsets.capacity() * sizeof(unsigned long long)
+            + m_lineNumbers.capacity() * sizeof(unsigned int)
+            + m_duplicates.capacity() * sizeof(Duplicate);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the slot of the \a key, or the empty slot where
+ *         it would be inserted.
+ */
+size_t EntityIndex::slotOf(const unsigned long long key) const
+{
+    const size_t mask = m_keys.size() - 1;
+    size_t slot = (size_t)hashOf(key) & mask;
+    while (m_keys[slot] != 0 && m_keys[slot] != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void EntityIndex::grow()
+{
+    const size_t capacity = m_keys.empty() ? C_INITIAL_CAPACITY : m_keys.size() * 2;
+
+    vector<unsigned long long> keys(capacity, 0);
+    vector<unsigned long long> offsets(capacity, 0);
+    vector<unsigned int> lineNumbers(capacity, 0);
+    m_keys.swap(keys);
+    m_offsets.swap(offsets);
+    m_lineNumbers.swap(lineNumbers);
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (keys[i] != 0) {
+            const size_t slot = slotOf(keys[i]);
+            m_keys[slot] = keys[i];
+            m_offsets[slot] = offsets[i];
+            m_lineNumbers[slot] = lineNumbers[i];
+        }
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+static bool lessThan(const EntityIndex::Duplicate &a, const EntityIndex::Duplicate &b)
+{
+    if (a.family != b.family) {
+        return a.family < b.family;
+    }
+    if (a.id != b.id) {
+        return a.id < b.id;
+    }
+    if (a.secondIndex != b.secondIndex) {
+        return a.secondIndex < b.secondIndex;
+    }
+    return a.second.offset < b.second.offset;
+}
+
+/*! \brief Returns the IDs defined more than once in the \a indexes, e.g.
+ *         the indexes of the files of an include tree, sorted by family and ID.
+ *
+ * The first definition is the one of the first index in the list, and
+ * firstIndex and secondIndex are positions in the list. The duplicates
+ * within each index are included. The IDs of the SET family are not
+ * duplicates: a set is made of several cards, possibly in several files.
+ *
+ * The keys are split into one partition per thread by their hash, then
+ * each thread joins the keys of its partition, from all the indexes,
+ * in its own hash table. Hence the threads don't share any state.
+ */
+vector<EntityIndex::Duplicate> EntityIndex::findDuplicates(const vector<const EntityIndex*> &indexes,
+                                                           int threadCount)
+{
+    if (threadCount <= 0) {
+        threadCount = (int)thread::hardware_concurrency();
+    }
+    threadCount = max(1, threadCount);
+    const unsigned long long partitionCount = (unsigned long long)threadCount;
+
+    vector< vector<Duplicate> > found((size_t)threadCount);
+
+    auto join = [&](const int partition) {
+        /* Count the keys of the partition, to size the table once */
+        size_t count = 0;
+        for (size_t i = 0; i < indexes.size(); ++i) {
+            const vector<unsigned long long> &keys = indexes[i]->m_keys;
+            for (size_t slot = 0; slot < keys.size(); ++slot) {
+                if (keys[slot] != 0 && !isSetKey(keys[slot])
+                        && (hashOf(keys[slot]) >> 40) % partitionCount
+                        == (unsigned long long)partition) {
+                    ++count;
+                }
+            }
+        }
+        size_t capacity = C_INITIAL_CAPACITY;
+        while (capacity * 3 < count * 4) {
+            capacity *= 2;
+        }
+        const size_t mask = capacity - 1;
+        vector<unsigned long long> table(capacity, 0);
+        vector<unsigned int> owners(capacity, 0); // position of the index in the list
+        vector<size_t> slots(capacity, 0);        // slot in this index
+
+        for (size_t i = 0; i < indexes.size(); ++i) {
+            const EntityIndex *index = indexes[i];
+            for (size_t slot = 0; slot < index->m_keys.size(); ++slot) {
+                const unsigned long long key = index->m_keys[slot];
+                if (key == 0 || isSetKey(key)) {
+                    continue;
+                }
+                const unsigned long long hash = hashOf(key);
+                if ((hash >> 40) % partitionCount != (unsigned long long)partition) {
+                    continue;
+                }
+                size_t t = (size_t)hash & mask;
+                while (table[t] != 0 && table[t] != key) {
+                    t = (t + 1) & mask;
+                }
+                if (table[t] == 0) {
+                    table[t] = key;
+                    owners[t] = (unsigned int)i;
+                    slots[t] = slot;
+                    continue;
+                }
+                const EntityIndex *owner = indexes[owners[t]];
+                Duplicate duplicate;
+                duplicate.family = (Family)((key >> 56) - 1);
+                duplicate.id = (long long)(key & C_MAX_ID);
+                duplicate.firstIndex = (int)owners[t];
+                duplicate.first.offset = (size_t)owner->m_offsets[slots[t]];
+                duplicate.first.lineNumber = (int)owner->m_lineNumbers[slots[t]];
+                duplicate.secondIndex = (int)i;
+                duplicate.second.offset = (size_t)index->m_offsets[slot];
+                duplicate.second.lineNumber = (int)index->m_lineNumbers[slot];
+                found[(size_t)partition].push_back(duplicate);
+            }
+        }
+    };
+
+    vector<thread> workers;
+    for (int t = 1; t < threadCount; ++t) {
+        workers.push_back(thread(join, t));
+    }
+    join(0);
+    for (vector<thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+        it->join();
+    }
+
+    vector<Duplicate> duplicates;
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        const vector<Duplicate> &local = indexes[i]->m_duplicates;
+        for (vector<Duplicate>::const_iterator it = local.begin(); it != local.end(); ++it) {
+            Duplicate duplicate = (*it);
+            duplicate.firstIndex = (int)i;
+            duplicate.secondIndex = (int)i;
+            duplicates.push_back(duplicate);
+        }
+    }
+    for (size_t p = 0; p < found.size(); ++p) {
+        duplicates.insert(duplicates.end(), found[p].begin(), found[p].end());
+    }
+    sort(duplicates.begin(), duplicates.end(), lessThan);
+    return duplicates;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the family of the card \a name, e.g. ELEMENT for 'CQUAD4'.
+ *
+ * The name can be in any case, and can end with the '*' of the large
+ * field format.
+ */
+EntityIndex::Family EntityIndex::familyOf(const char *name, const size_t length)
+{
+    size_t n = length;
+    if (n > 0 && name[n - 1] == '*') {
+        --n;
+    }
+    int low = 0;
+    int high = CARD_FAMILY_COUNT - 1;
+    while (low <= high) {
+        const int middle = (low + high) / 2;
+        const int cmp = compareName(name, n, CARD_FAMILIES[middle].name);
+        if (cmp == 0) {
+            return CARD_FAMILIES[middle].family;
+        }
+        if (cmp < 0) {
+            high = middle - 1;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return Family::UNKNOWN;
+}
+
+const char* EntityIndex::familyName(const Family family)
+{
+    switch (family) {
+    case Family::GRID:              return "grid";
+    case Family::ELEMENT:           return "element";
+    case Family::PROPERTY:          return "property";
+    case Family::MATERIAL:          return "material";
+    case Family::COORDINATE_SYSTEM: return "coordinate system";
+    case Family::CONSTRAINT:        return "constraint";
+    case Family::SET:               return "set";
+    case Family::UNKNOWN:
+    default:
+        break;
+    }
+    return "unknown";
+}
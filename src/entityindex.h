@@ -0,0 +1,92 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENTITY_INDEX_H
+#define ENTITY_INDEX_H
+
+#include <cstddef>
+#include <vector>
+
+/*! \brief Where an entity is defined in a file.
+ */
+struct EntityLocation
+{
+    std::size_t offset;     ///< Offset of the parent line of the card
+    int lineNumber;         ///< Line number of the parent line
+};
+
+class EntityIndex
+{
+public:
+    enum class Family {
+        GRID,               ///< GRID
+        ELEMENT,            ///< CQUAD4, CBAR, CHEXA, CONM2...
+        PROPERTY,           ///< PSHELL, PCOMP, PBARL...
+        MATERIAL,           ///< MAT1, MAT8...
+        COORDINATE_SYSTEM,  ///< CORD2R, CORD1C...
+        CONSTRAINT,         ///< RBE2, RBE3, RBAR...
+        SET,                ///< MPC, an ID shared by the cards of a set
+        UNKNOWN             ///< Not indexed
+    };
+
+    /* Two definitions of the same ID, in the indexes at firstIndex */
+    /* and secondIndex of a list (or in the same index)             */
+    struct Duplicate
+    {
+        Family family;
+        long long id;
+        int firstIndex;
+        EntityLocation first;
+        int secondIndex;
+        EntityLocation second;
+    };
+
+    explicit EntityIndex();
+
+    void clear();
+
+    bool insert(const Family family, const long long id,
+                const std::size_t offset, const int lineNumber);
+    bool find(const Family family, const long long id, EntityLocation *location) const;
+
+    /* Inserts the IDs of the family of another index, e.g. of another file */
+    void merge(const EntityIndex &other, const Family family);
+
+    std::size_t size() const { return m_size; }
+    std::size_t capacity() const { return m_keys.size(); }
+    std::size_t memoryUsage() const;
+
+    /* IDs defined more than once in the indexed file */
+    const std::vector<Duplicate>& duplicates() const { return m_duplicates; }
+
+    static std::vector<Duplicate> findDuplicates(const std::vector<const EntityIndex*> &indexes,
+                                                 int threadCount = 0);
+
+    static Family familyOf(const char *name, const std::size_t length);
+    static const char* familyName(const Family family);
+
+private:
+    std::vector<unsigned long long> m_keys;     ///< 0 means an empty slot
+    std::vector<unsigned long long> m_offsets;
+    std::vector<unsigned int> m_lineNumbers;
+    std::size_t m_size;
+    std::vector<Duplicate> m_duplicates;
+
+    std::size_t slotOf(const unsigned long long key) const;
+    void grow();
+};
+
+#endif // ENTITY_INDEX_H
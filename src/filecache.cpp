@@ -0,0 +1,330 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "filecache.h"
+
+#include <algorithm> // find(), min()
+#include <atomic>
+#include <chrono>
+#include <string.h> // memcmp(), memcpy()
+#include <thread>
+
+using namespace std;
+
+/*! \class FileCache
+ *  \brief The class FileCache keeps the files of the include trees mapped,
+ *         with their indexes, between the searches.
+ *
+ * Several engines can share the same cache, e.g. to compare two models:
+ * an include file used by both models is then mapped and indexed once.
+ *
+ * The files are keyed by their full path. Before reusing a mapping,
+ * open() compares the size and the modification time of the file
+ * with the mapped ones, and maps the file again if it changed.
+ *
+ * Each content is stored once: when a file has the same content as a file
+ * already open, e.g. the same file included through another relative path,
+ * or a copy in another directory, it's unmapped, and its entry refers to
+ * the original one. Only the files of the same size are hashed, then
+ * compared byte by byte if their hashes are equal.
+ *
+ * The compressed files are decompressed when they're open. prefetch()
+ * decompresses several of them in parallel, e.g. the files included
+ * by the same file, before the caller opens them one after the other.
+ *
+ * \remark The indexes are not reset when the file is mapped again:
+ * ZoneMap::isBuiltFor() tells the caller that they are out of date.
+ */
+
+/*! \brief Returns the time elapsed since \a start, in seconds.
+ */
+static double secondsSince(const chrono::steady_clock::time_point &start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/*! \brief Constructor.
+ */
+FileCache::FileCache()
+{
+}
+
+/*! \brief Unmaps all the files, and drops their indexes.
+ */
+void FileCache::clear()
+{
+    m_contents.clear();
+    m_entries.clear();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the entry of the file \a fullFileName, mapped in memory.
+ * Returns NULL if the file cannot be opened.
+ *
+ * The content and the indexes of the file are the ones of Entry::content().
+ */
+FileCache::Entry* FileCache::open(const string &fullFileName)
+{
+    Entry *entry = this->entry(fullFileName);
+    if (this->isUpToDate(entry)) {
+        return entry;
+    }
+
+    this->detach(entry);
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    if (!entry->file.open(fullFileName)) {
+        /* Keep the indexes: the file can come back unchanged */
+        return NULL;
+    }
+    this->attach(entry);
+    entry->loadTime = secondsSince(start);
+    return entry;
+}
+
+/*! \brief Decompresses in parallel the compressed files among \a fullFileNames,
+ *         that are not open yet, or changed since.
+ * Then, open() returns them without decompressing them again.
+ */
+void FileCache::prefetch(const vector<string> &fullFileNames)
+{
+    vector<Entry*> entries;
+    vector<const string*> names;
+    for (vector<string>::const_iterator it = fullFileNames.begin(); it != fullFileNames.end(); ++it) {
+        if (!MappedFile::isCompressed(*it)) {
+            continue;
+        }
+        Entry *entry = this->entry(*it);
+        if (this->isUpToDate(entry)
+                || std::find(entries.begin(), entries.end(), entry) != entries.end()) {
+            continue;
+        }
+        this->detach(entry);
+        entry->file.close();
+        entries.push_back(entry);
+        names.push_back(&(*it));
+    }
+    if (entries.size() < 2) {
+        return; /* open() will do it */
+    }
+
+    /* Each thread takes the next file to decompress */
+    const int threadCount = max(1, min((int)thread::hardware_concurrency(), (int)entries.size()));
+    atomic<size_t> next(0);
+    vector<thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.push_back(thread([&entries, &names, &next]() {
+            for (size_t i = next++; i < entries.size(); i = next++) {
+                const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                entries[i]->file.open(*names[i]);
+                entries[i]->loadTime = secondsSince(start);
+            }
+        }));
+    }
+    for (vector<thread>::iterator it = threads.begin(); it != threads.end(); ++it) {
+        it->join();
+    }
+
+    for (vector<Entry*>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+        if ((*it)->file.isOpen()) {
+            this->attach(*it);
+        }
+    }
+}
+
+/*! \brief Returns the entry of the file \a fullFileName, if it has been
+ *         open before, or NULL. The file is not read.
+ */
+const FileCache::Entry* FileCache::find(const string &fullFileName) const
+{
+    const map<string, unique_ptr<Entry> >::const_iterator it = m_entries.find(fullFileName);
+    if (it == m_entries.end() || !(it->second->file.isOpen() || it->second->original)) {
+        return NULL;
+    }
+    return it->second.get();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the entry of the file \a fullFileName, created if needed.
+ */
+FileCache::Entry* FileCache::entry(const string &fullFileName)
+{
+    unique_ptr<Entry>& entry = m_entries[fullFileName];
+    if (!entry) {
+        entry.reset(new Entry());
+        entry->fullFileName = fullFileName;
+        entry->size = 0;
+        entry->modificationTime = 0;
+        entry->contentHash = 0;
+        entry->loadTime = 0;
+        entry->original = NULL;
+    }
+    return entry.get();
+}
+
+/*! \brief Returns true if the \a entry is open, and its file didn't change.
+ *
+ * If the entry refers to an original content whose file changed, the
+ * entries that refer to it are detached, and the entry is not up to date:
+ * its own file is open again.
+ */
+bool FileCache::isUpToDate(Entry *entry)
+{
+    if (!entry->file.isOpen() && !entry->original) {
+        return false;
+    }
+    size_t size = 0;
+    long long modificationTime = 0;
+    if (entry->original) {
+        const Entry *original = entry->original;
+        if (!MappedFile::status(original->fullFileName, &size, &modificationTime)
+                || size != original->size
+                || modificationTime != original->modificationTime) {
+            this->detach(entry->original);
+            return false;
+        }
+    }
+    return MappedFile::status(entry->fullFileName, &size, &modificationTime)
+            && size == entry->size
+            && modificationTime == entry->modificationTime;
+}
+
+/*! \brief Records the status of the \a entry, just mapped, and refers
+ *         to the original content if the same content is already open.
+ */
+void FileCache::attach(Entry *entry)
+{
+    entry->size = entry->file.fileSize();
+    entry->modificationTime = entry->file.modificationTime();
+
+    Entry *original = this->findContent(entry);
+    if (original) {
+        entry->file.close();
+        entry->index.zoneMap.clear();
+        entry->index.entityIndex.clear();
+        entry->index.lineIndex.clear();
+        entry->index.includes.clear();
+        entry->original = original;
+    } else {
+        m_contents.insert(make_pair(entry->file.size(), entry));
+    }
+}
+
+/*! \brief Returns the entry of a unique content, equal to the content
+ *         of the mapped \a entry, or NULL.
+ */
+FileCache::Entry* FileCache::findContent(Entry *entry)
+{
+    const size_t size = entry->file.size();
+    if (size == 0) {
+        return NULL;
+    }
+    typedef multimap<size_t, Entry*>::iterator Iterator;
+    const pair<Iterator, Iterator> range = m_contents.equal_range(size);
+    for (Iterator it = range.first; it != range.second; ++it) {
+        Entry *other = it->second;
+        if (entry->contentHash == 0) {
+            entry->contentHash = hash(entry->file.begin(), entry->file.end());
+        }
+        if (other->contentHash == 0) {
+            other->contentHash = hash(other->file.begin(), other->file.end());
+        }
+        if (entry->contentHash == other->contentHash
+                && memcmp(entry->file.begin(), other->file.begin(), size) == 0) {
+            return other;
+        }
+    }
+    return NULL;
+}
+
+/*! \brief Detaches the \a entry from the original content it refers to,
+ *         or, if the entry has a unique content, detaches the entries
+ *         that refer to it. Then, they will be open again.
+ */
+void FileCache::detach(Entry *entry)
+{
+    if (entry->original) {
+        entry->original = NULL;
+        return;
+    }
+    typedef multimap<size_t, Entry*>::iterator Iterator;
+    const pair<Iterator, Iterator> range = m_contents.equal_range(entry->file.size());
+    for (Iterator it = range.first; it != range.second; ++it) {
+        if (it->second == entry) {
+            m_contents.erase(it);
+            break;
+        }
+    }
+    for (map<string, unique_ptr<Entry> >::iterator it = m_entries.begin();
+         it != m_entries.end(); ++it) {
+        if (it->second->original == entry) {
+            it->second->original = NULL;
+        }
+    }
+    entry->contentHash = 0;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns a fast, non-cryptographic, 64-bit hash of [\a begin, \a end).
+ * Never returns 0, that means "not computed".
+ */
+uint64_t FileCache::hash(const char *begin, const char *end)
+{
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ (uint64_t)(end - begin);
+    const char *p = begin;
+    for (; p + 8 <= end; p += 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        h = (h ^ word) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+    }
+    for (; p < end; ++p) {
+        h = (h ^ (unsigned char)(*p)) * 0xC4CEB9FE1A85EC53ULL;
+    }
+    h ^= h >> 29;
+    return (h != 0) ? h : 1;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the size of the mapped content, in bytes.
+ * The pages are loaded by the system only when they're read.
+ */
+size_t FileCache::mappedSize() const
+{
+    size_t size = 0;
+    for (map<string, unique_ptr<Entry> >::const_iterator it = m_entries.begin();
+         it != m_entries.end(); ++it) {
+        size += it->second->file.size();
+    }
+    return size;
+}
+
+/*! \brief Returns the memory used by the indexes of the files, in bytes.
+ */
+size_t FileCache::memoryUsage() const
+{
+    size_t bytes = 0;
+    for (map<string, unique_ptr<Entry> >::const_iterator it = m_entries.begin();
+         it != m_entries.end(); ++it) {
+        bytes += it->second->index.zoneMap.memoryUsage()
+                + it->second->index.entityIndex.memoryUsage()
+                + it->second->index.lineIndex.memoryUsage();
+    }
+    return bytes;
+}
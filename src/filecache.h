@@ -0,0 +1,104 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILE_CACHE_H
+#define FILE_CACHE_H
+
+#include "entityindex.h"
+#include "lineindex.h"
+#include "mappedfile.h"
+#include "zonemap.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*! \brief Indexes of a file, built during its first scan.
+ */
+struct FileIndex
+{
+    /* INCLUDE statement of the file */
+    struct Include
+    {
+        int lineNumber;
+        std::string fileName;
+    };
+
+    ZoneMap zoneMap;
+    EntityIndex entityIndex;
+    LineIndex lineIndex;
+    std::vector<Include> includes;
+};
+
+class FileCache
+{
+public:
+    /* Content and indexes of a file */
+    struct Entry
+    {
+        std::string fullFileName;   ///< Key of the entry in the cache
+        MappedFile file;            ///< Not open if the content is the original's
+        FileIndex index;
+        std::size_t size;           ///< Status of the file on the disk when it was open
+        long long modificationTime;
+        std::uint64_t contentHash;  ///< 0 if not computed yet
+        double loadTime;            ///< Time to map (or decompress) the file, in seconds
+        Entry *original;            ///< Entry with the same content, or NULL
+
+        Entry& content() { return original ? *original : *this; }
+        const Entry& content() const { return original ? *original : *this; }
+    };
+
+    explicit FileCache();
+
+    void clear();
+
+    /* Map the file, or reuse its mapping if the file didn't change */
+    Entry* open(const std::string &fullFileName);
+
+    /* Decompress the compressed files in parallel, before opening them */
+    void prefetch(const std::vector<std::string> &fullFileNames);
+
+    /* Getters -> return the entry of a file already open, or NULL */
+    const Entry* find(const std::string &fullFileName) const;
+
+    std::size_t fileCount() const { return m_entries.size(); }
+    std::size_t contentCount() const { return m_contents.size(); }
+    std::size_t mappedSize() const;
+    std::size_t memoryUsage() const;
+
+    static std::uint64_t hash(const char *begin, const char *end);
+
+private:
+    std::map<std::string, std::unique_ptr<Entry> > m_entries;
+
+    /* entries with a unique content, by size */
+    std::multimap<std::size_t, Entry*> m_contents;
+
+    Entry* entry(const std::string &fullFileName);
+    bool isUpToDate(Entry *entry);
+    void attach(Entry *entry);
+    Entry* findContent(Entry *entry);
+    void detach(Entry *entry);
+
+    FileCache(const FileCache &);            // not copyable
+    FileCache& operator=(const FileCache &); // not copyable
+};
+
+#endif // FILE_CACHE_H
@@ -17,9 +17,17 @@
 
 #include "systemdetection.h"
 
+#include <ctype.h> // tolower()
 #include <string>
 #include <vector>
 
+#if defined(Q_OS_WIN)
+#  include <windows.h>
+#elif defined(Q_OS_UNIX)
+#  include <limits.h>
+#  include <stdlib.h>
+#endif
+
 using namespace std;
 
 /*! \class FileInfo
@@ -40,6 +48,12 @@ using namespace std;
  */
 std::string FileInfo::fileName(const std::string &fullFileName)
 {
+    string archive;
+    string member;
+    if (splitArchivePath(fullFileName, &archive, &member)) {
+        return FileInfo::fileName(member);
+    }
+
     string fn = FileInfo::fromNativeSeparators(fullFileName);
     std::string ret;
     char ch;
@@ -69,11 +83,17 @@ std::string FileInfo::fileName(const std::string &fullFileName)
  *
  * If the file does not exist, returns an empty string.
  *
+ * For a member of a zip archive, returns the canonical path of the archive,
+ * followed by the directory of the member in the archive.
+ *
  * Example:
  * \code
  *   std::string filename = "c:/usr/project/ussue/1sd2/file.dat";
  *   std::string path = FileInfo::canonicalFilePath(filename);
  *   cout << path;      // "C:/usr/project/ussue/1sd2"
+ *
+ *   path = FileInfo::canonicalFilePath("/home/model.zip:bulk/grid.dat");
+ *   cout << path;      // "/home/model.zip:bulk"
  * \endcode
  *
  */
@@ -83,6 +103,19 @@ std::string FileInfo::canonicalFilePath(const std::string &fullFileName)
         return std::string();
     }
 
+    string archive;
+    string member;
+    if (splitArchivePath(fullFileName, &archive, &member)) {
+        const string path = canonicalFilePath(archive);
+        if (path.empty()) {
+            return std::string();
+        }
+        member = fromNativeSeparators(member);
+        const string::size_type slash = member.find_last_of('/');
+        member = (slash == string::npos) ? string() : member.substr(0, slash);
+        return path + '/' + fileName(archive) + ':' + member;
+    }
+
     if( isRelativePath(fullFileName) ){
         return std::string();
     }
@@ -153,6 +186,38 @@ std::string FileInfo::canonicalFilePath(const std::string &fullFileName)
     return ret;
 }
 
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the absolute path of the given \a fileName, including the file name.
+ *
+ * The \a fileName can be absolute, canonical or relative to the current directory.
+ *
+ * If the path cannot be resolved, returns the \a fileName unchanged.
+ */
+std::string FileInfo::absoluteFilePath(const std::string &fileName)
+{
+    string archive;
+    string member;
+    if (splitArchivePath(fileName, &archive, &member)) {
+        return absoluteFilePath(archive) + ':' + member;
+    }
+
+#if defined(Q_OS_WIN)
+    char fullFilename[MAX_PATH];
+    if (GetFullPathNameA(fileName.c_str(), MAX_PATH, fullFilename, NULL) == 0) {
+        return fileName;
+    }
+    return std::string(fullFilename);
+#elif defined(Q_OS_UNIX)
+    char fullFilename[PATH_MAX];
+    char *ret = realpath(fileName.c_str(), fullFilename);
+    if (!ret) {
+        return fileName;
+    }
+    return std::string(fullFilename);
+#endif
+}
+
 /******************************************************************************
  ******************************************************************************/
 /*! \brief Returns \a true if the file path name is relative, otherwise returns
@@ -178,6 +243,64 @@ std::string FileInfo::concat(const std::string &var1, const std::string &var2)
 }
 
 
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the path to open the file \a path, found in an INCLUDE
+ *         statement, relative to the directory \a dir.
+ *
+ * Decks are often written under Windows: under Unix, the '\\' separators
+ * are converted to '/'.
+ *
+ * Example:
+ * \code
+ *   std::string path = FileInfo::resolvePath("/home/project", ".\\bulk\\grid.dat");
+ *   // path == "/home/project/./bulk/grid.dat" (under Unix)
+ * \endcode
+ */
+std::string FileInfo::resolvePath(const std::string &dir, const std::string &path)
+{
+    string ret(path);
+#if defined(Q_OS_UNIX)
+    for (string::size_type i = 0; i < ret.length(); ++i) {
+        if (ret[i] == '\\') {
+            ret[i] = '/';
+        }
+    }
+#endif
+    if (isRelativePath(ret)) {
+        return concat(dir, ret);
+    }
+    return ret;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Splits the \a path of a file in a zip archive, e.g.
+ *         "/home/model.zip:bulk/grid.dat", into the path of the \a archive
+ *         and the name of the \a member in the archive.
+ * Returns false if the path doesn't name a file in a zip archive.
+ *
+ * The extension '.zip' is not case-sensitive.
+ */
+bool FileInfo::splitArchivePath(const std::string &path,
+                                std::string *archive, std::string *member)
+{
+    static const char extension[] = ".zip:";
+    const string::size_type length = sizeof(extension) - 1;
+    for (string::size_type i = 0; i + length <= path.size(); ++i) {
+        string::size_type j = 0;
+        while (j < length && tolower(path[i + j]) == extension[j]) {
+            ++j;
+        }
+        if (j == length) {
+            (*archive) = path.substr(0, i + length - 1);
+            (*member) = path.substr(i + length);
+            return true;
+        }
+    }
+    return false;
+}
+
 /******************************************************************************
  ******************************************************************************/
 /*! \brief Returns the native directory separator,
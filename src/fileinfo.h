@@ -23,11 +23,17 @@ class FileInfo
 public:
     static std::string fileName(const std::string &fullFileName);
     static std::string canonicalFilePath(const std::string &fullFileName);
+    static std::string absoluteFilePath(const std::string &fileName);
 
     static bool isRelativePath(const std::string &path);
     static inline bool isAbsolutePath(const std::string &path) { return !isRelativePath(path); }
 
     static std::string concat(const std::string &var1, const std::string &var2);
+    static std::string resolvePath(const std::string &dir, const std::string &path);
+
+    /* File in a zip archive, e.g. "model.zip:bulk/grid.dat" */
+    static bool splitArchivePath(const std::string &path,
+                                 std::string *archive, std::string *member);
 
 private:
     static inline std::string toNativeSeparators(const std::string &pathName);
@@ -0,0 +1,35 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILE_STATS_H
+#define FILE_STATS_H
+
+#include <cstddef>
+
+/*! \brief Statistics of a file of the include tree, in the last search.
+ */
+struct FileStats
+{
+    int parent;                 ///< Index of the including file, or -1 for the main file
+    int lineNumber;             ///< Line of the INCLUDE statement in the parent
+    std::size_t size;           ///< Size of the content, in bytes (0 if not open)
+    std::size_t lineCount;      ///< Number of lines, if indexed (0 otherwise)
+    double loadTime;            ///< Time to map, or to decompress, the file (seconds)
+    double scanTime;            ///< Time to scan the file (seconds)
+    bool isSkipped;             ///< Not loaded: the term index shows it can't match
+};
+
+#endif // FILE_STATS_H
@@ -0,0 +1,200 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "filewatcher.h"
+
+#include "compression.h"
+#include "fileinfo.h"
+#include "mappedfile.h"
+
+#include <set>
+
+#if defined(Q_OS_LINUX)
+#  include <sys/inotify.h> // inotify_init1(), inotify_add_watch()
+#  include <unistd.h>      // read(), close()
+#endif
+
+using namespace std;
+
+/*! \class FileWatcher
+ *  \brief The class FileWatcher tells which files of a list were modified,
+ *         created or removed since the last time it was asked.
+ *
+ * On Linux, the directories of the files are watched with inotify: only the
+ * files named by the notifications are checked again. Elsewhere, or if the
+ * notifications overflow, the size and the modification time of all the
+ * files are compared.
+ *
+ * A file is reported only if its size or its modification time changed,
+ * so that an editor that saves a file without modifying it doesn't trigger
+ * a new search.
+ *
+ * A member of a zip archive changes when the archive is written.
+ *
+ * \remark An editor that saves a file by renaming a temporary file over it
+ * is supported, as the directory is watched rather than the file itself.
+ */
+
+/*! \brief Constructor.
+ */
+FileWatcher::FileWatcher()
+    : m_descriptor(-1)
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+    this->clear();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Watches the given \a fullFileNames, instead of the previous ones.
+ */
+void FileWatcher::watch(const vector<string> &fullFileNames)
+{
+    this->clear();
+
+    for (vector<string>::const_iterator it = fullFileNames.begin(); it != fullFileNames.end(); ++it) {
+        m_status[*it] = statusOf(*it);
+    }
+
+#if defined(Q_OS_LINUX)
+    m_descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_descriptor < 0) {
+        return; // Fallback to the polling
+    }
+    set<string> directories;
+    for (map<string, Status>::const_iterator it = m_status.begin(); it != m_status.end(); ++it) {
+        const string diskPath = diskPathOf(it->first);
+        const string::size_type slash = diskPath.find_last_of('/');
+        const string directory = (slash == string::npos) ? string() : diskPath.substr(0, slash + 1);
+        if (!directories.insert(directory).second) {
+            continue;
+        }
+        const char *path = directory.empty() ? "." : directory.c_str();
+        const int watch = inotify_add_watch(m_descriptor, path,
+                                            IN_CLOSE_WRITE | IN_CREATE | IN_DELETE
+                                            | IN_MOVED_FROM | IN_MOVED_TO);
+        if (watch < 0) {
+            /* Cannot watch a directory: poll all the files */
+            this->clear();
+            for (vector<string>::const_iterator it2 = fullFileNames.begin(); it2 != fullFileNames.end(); ++it2) {
+                m_status[*it2] = statusOf(*it2);
+            }
+            return;
+        }
+        /* The same directory can be named differently, and then watched once */
+        m_directories[watch].push_back(directory);
+    }
+#endif
+}
+
+void FileWatcher::clear()
+{
+    m_status.clear();
+    m_directories.clear();
+#if defined(Q_OS_LINUX)
+    if (m_descriptor >= 0) {
+        ::close(m_descriptor);
+    }
+#endif
+    m_descriptor = -1;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the watched files that changed since the last call.
+ * Doesn't wait: returns an empty list if nothing changed.
+ */
+vector<string> FileWatcher::changedFiles()
+{
+    vector<string> changed;
+    if (m_status.empty()) {
+        return changed;
+    }
+
+    /* files to check again */
+    bool all = (m_descriptor < 0);
+    set<string> named;
+
+#if defined(Q_OS_LINUX)
+    if (m_descriptor >= 0) {
+        char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+        for (;;) {
+            const ssize_t length = ::read(m_descriptor, buffer, sizeof(buffer));
+            if (length <= 0) {
+                break; // EAGAIN: no more notification
+            }
+            for (const char *ptr = buffer; ptr < buffer + length; ) {
+                const struct inotify_event *event = (const struct inotify_event *) ptr;
+                if (event->mask & IN_Q_OVERFLOW) {
+                    all = true;
+                } else if (event->len > 0) {
+                    map<int, vector<string> >::const_iterator found = m_directories.find(event->wd);
+                    if (found != m_directories.end()) {
+                        for (vector<string>::const_iterator it = found->second.begin();
+                             it != found->second.end(); ++it) {
+                            named.insert(*it + event->name);
+                            /* 'name.gz' stands for 'name', if the latter doesn't exist */
+                            const string name(event->name);
+                            if (Compression::isGzip(name)) {
+                                named.insert(*it + name.substr(0, name.size() - 3));
+                            }
+                        }
+                    }
+                }
+                ptr += sizeof(struct inotify_event) + event->len;
+            }
+        }
+    }
+#endif
+
+    for (map<string, Status>::iterator it = m_status.begin(); it != m_status.end(); ++it) {
+        if (!all && named.count(diskPathOf(it->first)) == 0) {
+            continue;
+        }
+        const Status status = statusOf(it->first);
+        if (status != it->second) {
+            it->second = status;
+            changed.push_back(it->first);
+        }
+    }
+    return changed;
+}
+
+/*! \brief Returns the path of the file on the disk: the archive,
+ *         for a member of a zip archive.
+ */
+string FileWatcher::diskPathOf(const string &fullFileName)
+{
+    string archive;
+    string member;
+    if (FileInfo::splitArchivePath(fullFileName, &archive, &member)) {
+        return archive;
+    }
+    return fullFileName;
+}
+
+/*! \brief Returns the size and the modification time of the file,
+ *         or (0, -1) if the file doesn't exist.
+ */
+FileWatcher::Status FileWatcher::statusOf(const string &fullFileName)
+{
+    Status status(0, -1);
+    MappedFile::status(fullFileName, &status.first, &status.second);
+    return status;
+}
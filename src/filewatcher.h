@@ -0,0 +1,58 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include "systemdetection.h"
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+class FileWatcher
+{
+public:
+    explicit FileWatcher();
+    ~FileWatcher();
+
+    void watch(const std::vector<std::string> &fullFileNames);
+    void clear();
+
+    /* Files modified, created or removed since the last call, without waiting */
+    std::vector<std::string> changedFiles();
+
+    bool isNotified() const { return m_descriptor >= 0; }
+
+private:
+    /* size and modification time of the watched files */
+    typedef std::pair<std::size_t, long long> Status;
+    std::map<std::string, Status> m_status;
+
+    /* inotify instance and its watched directories, on Linux */
+    int m_descriptor;
+    std::map<int, std::vector<std::string> > m_directories;
+
+    static std::string diskPathOf(const std::string &fullFileName);
+    static Status statusOf(const std::string &fullFileName);
+
+    FileWatcher(const FileWatcher &);            // not copyable
+    FileWatcher& operator=(const FileWatcher &); // not copyable
+};
+
+#endif // FILE_WATCHER_H
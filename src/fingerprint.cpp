@@ -0,0 +1,286 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fingerprint.h"
+
+#include "filecache.h"
+#include "fileinfo.h"
+#include "mappedfile.h"
+
+#include <fstream>
+#include <stdio.h>  // snprintf()
+#include <stdlib.h> // strtoull()
+
+using namespace std;
+
+static const char STR_HEADER[] = "# NASTRANFIND fingerprints 1";
+
+/*! \class Fingerprint
+ *  \brief The class Fingerprint summarizes an include tree in a 64-bit value,
+ *         that changes as soon as one of its files changes.
+ *
+ * The fingerprint is a Merkle hash: the value of a file combines the hash
+ * of its content with the values of the files it includes, in order.
+ * Hence the value of the main file covers the whole tree.
+ *
+ * The size, the modification time, the content hash and the included names
+ * of each file are kept in records, that can be saved and loaded between
+ * two runs. A file whose size and modification time match its record is
+ * checked with a stat only: reopening a model that didn't change costs one
+ * stat per file, instead of a full read.
+ *
+ * \code
+ *   Fingerprint fingerprint;
+ *   fingerprint.load(cacheFileName);
+ *   if (fingerprint.compute(fullFileName, parser) != lastValue) {
+ *       // the cached indexes and results are out of date
+ *   }
+ *   fingerprint.save(cacheFileName);
+ * \endcode
+ */
+
+/*! \brief Constructor.
+ */
+Fingerprint::Fingerprint()
+{
+    this->clear();
+}
+
+void Fingerprint::clear()
+{
+    m_records.clear();
+    m_value = 0;
+    m_fileCount = 0;
+    m_readCount = 0;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+static inline uint64_t combine(uint64_t h, const uint64_t value)
+{
+    h = (h ^ value) * 0xFF51AFD7ED558CCDULL;
+    return h ^ (h >> 32);
+}
+
+static inline uint64_t nameHash(const string &name)
+{
+    return FileCache::hash(name.data(), name.data() + name.size());
+}
+
+/*! \brief Returns the fingerprint of the include tree of \a fullFileName.
+ *
+ * The INCLUDE statements of the files that are read are found by the
+ * given \a parser. The paths are resolved like Engine::find() does,
+ * i.e. relative to the directory of the main file. The records of the
+ * files that are no longer in the tree are removed.
+ */
+uint64_t Fingerprint::compute(const string &fullFileName, const IncludeParser &parser)
+{
+    m_fileCount = 0;
+    m_readCount = 0;
+
+    const string pwd = FileInfo::canonicalFilePath(fullFileName);
+    const string path = FileInfo::resolvePath(pwd, FileInfo::fileName(fullFileName));
+
+    map<string, uint64_t> visited;
+    m_value = computeFile(pwd, path, parser, visited);
+
+    /* The files no longer in the tree */
+    map<string, Record>::iterator it = m_records.begin();
+    while (it != m_records.end()) {
+        if (visited.count(it->first) == 0) {
+            it = m_records.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return m_value;
+}
+
+uint64_t Fingerprint::computeFile(const string &pwd,
+                                  const string &fullFileName,
+                                  const IncludeParser &parser,
+                                  map<string, uint64_t> &visited)
+{
+    /* A file included twice has the same value, and a cycle is cut */
+    const map<string, uint64_t>::const_iterator it = visited.find(fullFileName);
+    if (it != visited.end()) {
+        return (it->second != 0) ? it->second : nameHash(fullFileName);
+    }
+    visited[fullFileName] = 0; /* in progress */
+
+    const Record *record = this->update(fullFileName, parser);
+    if (!record) {
+        /* Missing file: the value changes when it's created */
+        const uint64_t value = combine(nameHash(fullFileName), 0);
+        visited[fullFileName] = value;
+        return value;
+    }
+    ++m_fileCount;
+
+    uint64_t value = combine(record->contentHash, record->size);
+    const vector<string>& includes = record->includes;
+    for (vector<string>::const_iterator child = includes.begin(); child != includes.end(); ++child) {
+        value = combine(value, nameHash(*child));
+        value = combine(value, computeFile(pwd, FileInfo::resolvePath(pwd, *child), parser, visited));
+    }
+    if (value == 0) {
+        value = 1;
+    }
+    visited[fullFileName] = value;
+    return value;
+}
+
+/*! \brief Returns the record of \a fullFileName, updated if the file changed,
+ *         or NULL if the file cannot be read.
+ */
+const Fingerprint::Record* Fingerprint::update(const string &fullFileName,
+                                               const IncludeParser &parser)
+{
+    size_t size = 0;
+    long long modificationTime = 0;
+    if (!MappedFile::status(fullFileName, &size, &modificationTime)) {
+        m_records.erase(fullFileName);
+        return NULL;
+    }
+
+    const map<string, Record>::const_iterator it = m_records.find(fullFileName);
+    if (it != m_records.end()
+            && it->second.size == size
+            && it->second.modificationTime == modificationTime) {
+        return &it->second; /* stat only */
+    }
+
+    MappedFile file;
+    if (!file.open(fullFileName)) {
+        m_records.erase(fullFileName);
+        return NULL;
+    }
+    ++m_readCount;
+
+    Record& record = m_records[fullFileName];
+    record.size = file.fileSize();
+    record.modificationTime = file.modificationTime();
+    record.contentHash = FileCache::hash(file.begin(), file.end());
+    record.includes.clear();
+    parser(file.begin(), file.end(), &record.includes);
+    return &record;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Reads the records saved by save(). Returns false if the \a stream
+ *         doesn't contain records; then, the records are empty.
+ *
+ * Format: a header line, the value of the last compute(), then for each file,
+ * its path, a line with its size,
+ * modification time, content hash and number of includes, and one line per
+ * included name.
+ */
+bool Fingerprint::load(istream &stream)
+{
+    m_records.clear();
+    m_value = 0;
+
+    string line;
+    if (!getline(stream, line) || line != STR_HEADER || !getline(stream, line)) {
+        return false;
+    }
+    m_value = strtoull(line.c_str(), NULL, 16);
+    string path;
+    while (getline(stream, path)) {
+        if (!getline(stream, line)) {
+            break;
+        }
+        Record record;
+        unsigned long long size = 0;
+        long long modificationTime = 0;
+        unsigned long long contentHash = 0;
+        unsigned int includeCount = 0;
+        if (sscanf(line.c_str(), "%llu %lld %llx %u",
+                   &size, &modificationTime, &contentHash, &includeCount) != 4) {
+            m_records.clear();
+            m_value = 0;
+            return false;
+        }
+        record.size = (size_t)size;
+        record.modificationTime = modificationTime;
+        record.contentHash = contentHash;
+        for (unsigned int i = 0; i < includeCount; ++i) {
+            string name;
+            if (!getline(stream, name)) {
+                m_records.clear();
+                m_value = 0;
+                return false;
+            }
+            record.includes.push_back(name);
+        }
+        m_records[path] = record;
+    }
+    return true;
+}
+
+/*! \brief Writes the records in the \a stream.
+ */
+void Fingerprint::save(ostream &stream) const
+{
+    stream << STR_HEADER << '\n'
+           << toHex(m_value) << '\n';
+    for (map<string, Record>::const_iterator it = m_records.begin(); it != m_records.end(); ++it) {
+        const Record& record = it->second;
+        stream << it->first << '\n'
+               << (unsigned long long)record.size << ' '
+               << record.modificationTime << ' '
+               << toHex(record.contentHash) << ' '
+               << record.includes.size() << '\n';
+        for (vector<string>::const_iterator name = record.includes.begin();
+             name != record.includes.end(); ++name) {
+            stream << (*name) << '\n';
+        }
+    }
+}
+
+bool Fingerprint::load(const string &fileName)
+{
+    ifstream stream(fileName.c_str());
+    if (!stream.is_open()) {
+        m_records.clear();
+        m_value = 0;
+        return false;
+    }
+    return load(stream);
+}
+
+bool Fingerprint::save(const string &fileName) const
+{
+    ofstream stream(fileName.c_str());
+    if (!stream.is_open()) {
+        return false;
+    }
+    save(stream);
+    return stream.good();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the \a value in 16 hexadecimal digits.
+ */
+string Fingerprint::toHex(const uint64_t value)
+{
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long)value);
+    return string(buffer);
+}
@@ -0,0 +1,78 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+class Fingerprint
+{
+public:
+    /* Status and content of a file, when it was read for the last time */
+    struct Record
+    {
+        std::size_t size;
+        long long modificationTime;
+        std::uint64_t contentHash;
+        std::vector<std::string> includes;  ///< Names found in the INCLUDE statements
+    };
+
+    /* Appends to 'includes' the names of the files included by [begin, end) */
+    typedef std::function<void(const char *begin, const char *end,
+                               std::vector<std::string> *includes)> IncludeParser;
+
+    explicit Fingerprint();
+
+    void clear();
+
+    /* Fingerprint of the include tree of the given file */
+    std::uint64_t compute(const std::string &fullFileName, const IncludeParser &parser);
+
+    /* Value of the last compute(), or of the records loaded */
+    std::uint64_t value() const { return m_value; }
+    std::size_t fileCount() const { return m_fileCount; }
+    std::size_t readCount() const { return m_readCount; }
+
+    /* Records of the files, kept between two runs */
+    const std::map<std::string, Record>& records() const { return m_records; }
+    bool load(std::istream &stream);
+    void save(std::ostream &stream) const;
+    bool load(const std::string &fileName);
+    bool save(const std::string &fileName) const;
+
+    static std::string toHex(const std::uint64_t value);
+
+private:
+    std::map<std::string, Record> m_records;
+    std::uint64_t m_value;
+    std::size_t m_fileCount;
+    std::size_t m_readCount;
+
+    std::uint64_t computeFile(const std::string &pwd,
+                              const std::string &fullFileName,
+                              const IncludeParser &parser,
+                              std::map<std::string, std::uint64_t> &visited);
+    const Record* update(const std::string &fullFileName, const IncludeParser &parser);
+};
+
+#endif // FINGERPRINT_H
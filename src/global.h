@@ -21,7 +21,18 @@
 #define C_APPLICATION_SUBTITLE  " - An Interactive Search Engine for Nastran"
 
 /* Search Box Size */
-#define C_SEARCH_SIZE 32 // characters
+#define C_SEARCH_SIZE 48 // characters, e.g. "CARD=CQUAD4 FIELD=2 VALUE=123456"
+
+/* Default memory budget of the results. Beyond, the results are */
+/* stored in a temporary file. Change it with '--memory-budget'.  */
+#define C_MEMORY_BUDGET_DEFAULT 1024 // megabytes
+
+/* Period of the check for modified files, while waiting for a key */
+#define C_WATCH_PERIOD_MS 500 // milliseconds
+
+/* Lines shown before the card, when a result is opened in its file. */
+/* Change it with '--context'.                                       */
+#define C_CONTEXT_LINES 5
 
 /*                                                                */
 /* Here we make an assumption:                                    */
@@ -39,7 +50,7 @@
 #define C_LINE_NUMBER_FORMAT_INT  "%8i"
 #define C_LINE_NUMBER_FORMAT_CHAR "%8c"
 #define C_LINE_NUMBER_MAX_NUMBER powl(10, C_LINE_NUMBER_BUFFER_SIZE )-1 /* == 10^8-1 */
-#define C_LINE_NUMBER_WIDTH C_LINE_NUMBER_BUFFER_SIZE + 6  /* Keep as is: 6 == len("line") + len(": ") */
+#define C_LINE_NUMBER_WIDTH (C_LINE_NUMBER_BUFFER_SIZE + 6) /* Keep as is: 6 == len("line") + len(": ") */
 
 
 #endif  // GLOBAL_H
@@ -0,0 +1,181 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "includetree.h"
+
+using namespace std;
+
+/*! \class IncludeTree
+ *  \brief The class IncludeTree shows the files of the include tree
+ *         as a hierarchy, that can be expanded or collapsed.
+ *
+ * Each row shows the size, the number of lines, the number of hits and
+ * the load and scan times of a file. A collapsed file shows the sum of
+ * its whole subtree, so the subtrees that dominate the load time are
+ * found from the top, without expanding everything.
+ *
+ * The main file is expanded when the tree is built, its includes are
+ * collapsed.
+ */
+
+/*! \brief Constructor.
+ */
+IncludeTree::IncludeTree()
+{
+}
+
+void IncludeTree::clear()
+{
+    m_stats.clear();
+    m_hitCounts.clear();
+    m_children.clear();
+    m_expanded.clear();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Builds the tree from the \a stats of the files, i.e. their parent,
+ *         and their \a hitCounts.
+ *
+ * If the tree has the same number of files as before, e.g. when the search
+ * is refreshed, the files expanded stay expanded.
+ */
+void IncludeTree::build(const vector<FileStats> &stats, const vector<size_t> &hitCounts)
+{
+    const bool keepExpanded = ( stats.size() == m_stats.size() );
+
+    m_stats = stats;
+    m_hitCounts = hitCounts;
+    m_hitCounts.resize(m_stats.size(), 0);
+
+    m_children.assign(m_stats.size(), vector<int>());
+    for (size_t i = 0; i < m_stats.size(); ++i) {
+        const int parent = m_stats[i].parent;
+        if (parent >= 0 && parent < (int)i) {
+            m_children[parent].push_back((int)i);
+        }
+    }
+
+    if (!keepExpanded) {
+        m_expanded.assign(m_stats.size(), false);
+        if (!m_expanded.empty()) {
+            m_expanded[0] = true;
+        }
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+bool IncludeTree::isExpanded(const int file) const
+{
+    return file >= 0 && file < (int)m_expanded.size() && m_expanded[file];
+}
+
+void IncludeTree::setExpanded(const int file, const bool expanded)
+{
+    if (file >= 0 && file < (int)m_expanded.size()) {
+        m_expanded[file] = expanded;
+    }
+}
+
+void IncludeTree::toggle(const int file)
+{
+    this->setExpanded(file, !this->isExpanded(file));
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the files shown: the main file, and the includes of
+ *         the expanded files, depth first.
+ */
+vector<IncludeTree::Row> IncludeTree::rows() const
+{
+    vector<Row> rows;
+    if (!m_stats.empty()) {
+        this->appendRows(0, 0, &rows);
+    }
+    return rows;
+}
+
+/*! \brief Returns the sum of the statistics of all the files.
+ */
+IncludeTree::Row IncludeTree::total() const
+{
+    Row total = this->row(-1, 0);
+    if (!m_stats.empty()) {
+        this->addSubtree(0, &total);
+    }
+    return total;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+IncludeTree::Row IncludeTree::row(const int file, const int depth) const
+{
+    const FileStats empty = { -1, -1, 0, 0, 0., 0., false };
+    Row row;
+    row.file = file;
+    row.depth = depth;
+    row.hasChildren = (file >= 0) && !m_children[file].empty();
+    row.isExpanded = this->isExpanded(file);
+    row.fileCount = 0;
+    row.stats = empty;
+    row.hitCount = 0;
+    row.skippedCount = 0;
+    return row;
+}
+
+void IncludeTree::appendRows(const int file, const int depth, vector<Row> *rows) const
+{
+    Row row = this->row(file, depth);
+    if (row.isExpanded || !row.hasChildren) {
+        row.fileCount = 1;
+        row.stats = m_stats[file];
+        row.hitCount = m_hitCounts[file];
+        row.skippedCount = m_stats[file].isSkipped ? 1 : 0;
+    } else {
+        this->addSubtree(file, &row);
+    }
+    row.stats.parent = m_stats[file].parent;
+    row.stats.lineNumber = m_stats[file].lineNumber;
+    rows->push_back(row);
+
+    if (row.isExpanded) {
+        const vector<int>& children = m_children[file];
+        for (vector<int>::const_iterator it = children.begin(); it != children.end(); ++it) {
+            this->appendRows(*it, depth + 1, rows);
+        }
+    }
+}
+
+/*! \brief Adds the statistics of the \a file and of all its includes
+ *         to the \a row.
+ */
+void IncludeTree::addSubtree(const int file, Row *row) const
+{
+    const FileStats& stats = m_stats[file];
+    row->fileCount++;
+    row->stats.size += stats.size;
+    row->stats.lineCount += stats.lineCount;
+    row->stats.loadTime += stats.loadTime;
+    row->stats.scanTime += stats.scanTime;
+    row->hitCount += m_hitCounts[file];
+    row->skippedCount += stats.isSkipped ? 1 : 0;
+
+    const vector<int>& children = m_children[file];
+    for (vector<int>::const_iterator it = children.begin(); it != children.end(); ++it) {
+        this->addSubtree(*it, row);
+    }
+}
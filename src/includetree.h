@@ -0,0 +1,71 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDE_TREE_H
+#define INCLUDE_TREE_H
+
+#include "filestats.h"
+
+#include <cstddef>
+#include <vector>
+
+class IncludeTree
+{
+public:
+    /* File shown in the tree */
+    struct Row
+    {
+        int file;                   ///< Index of the file in Engine::files()
+        int depth;                  ///< 0 for the main file
+        bool hasChildren;
+        bool isExpanded;
+        int fileCount;              ///< 1, or the number of files of the collapsed subtree
+        FileStats stats;            ///< Statistics of the file, or sum of its collapsed subtree
+        std::size_t hitCount;       ///< Likewise
+        int skippedCount;           ///< Likewise, the files not loaded by the search
+    };
+
+    explicit IncludeTree();
+
+    void clear();
+
+    /* Build the tree from the statistics and the hit count of each file */
+    void build(const std::vector<FileStats> &stats, const std::vector<std::size_t> &hitCounts);
+
+    int fileCount() const { return (int)m_stats.size(); }
+
+    bool isExpanded(const int file) const;
+    void setExpanded(const int file, const bool expanded);
+    void toggle(const int file);
+
+    /* Files shown, in the order of the INCLUDE statements */
+    std::vector<Row> rows() const;
+
+    /* Sum of the whole tree */
+    Row total() const;
+
+private:
+    std::vector<FileStats> m_stats;
+    std::vector<std::size_t> m_hitCounts;
+    std::vector<std::vector<int> > m_children;
+    std::vector<bool> m_expanded;
+
+    Row row(const int file, const int depth) const;
+    void appendRows(const int file, const int depth, std::vector<Row> *rows) const;
+    void addSubtree(const int file, Row *row) const;
+};
+
+#endif // INCLUDE_TREE_H
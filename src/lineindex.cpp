@@ -0,0 +1,170 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lineindex.h"
+
+#include "scanner.h"
+
+#include <algorithm> // upper_bound()
+
+using namespace std;
+
+static const unsigned int C_FAR_BLOCK = 0xFFFFFFFF;
+
+/*! \class LineIndex
+ *  \brief The class LineIndex gives the offset of any line of a file,
+ *         and the line of any offset, in about half a byte per line.
+ *
+ * A vector of the offsets of all the lines would cost 8 bytes per line,
+ * i.e. 800 MB for a file of 100 million lines. Instead, the offsets are
+ * sampled:
+ * \li the absolute offset of every SUPERBLOCK_LINES-th line (64 bits),
+ * \li the offset of every BLOCK_LINES-th line, relative to its superblock
+ *     (32 bits).
+ *
+ * The other lines are found by counting the line feeds from the start of
+ * their block: at most BLOCK_LINES - 1 lines are read, with a memchr() or
+ * the SSE2 line counting of the Scanner. Hence lineOffset() is O(1) and
+ * lineAt() is O(log n), both reading a few hundred bytes at most.
+ *
+ * The lines are numbered from 1, as in the results. A line feed at the end
+ * of the file doesn't start a line.
+ */
+
+/*! \brief Constructor.
+ */
+LineIndex::LineIndex()
+    : m_lineCount(0)
+{
+}
+
+void LineIndex::clear()
+{
+    m_lineCount = 0;
+    m_superblocks.clear();
+    m_blocks.clear();
+    m_farBlocks.clear();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Builds the index of the content [\a begin, \a end).
+ */
+void LineIndex::build(const char *begin, const char *end)
+{
+    this->clear();
+    const char *p = begin;
+    while (p < end) {
+        this->append((size_t)(p - begin));
+        p = Scanner::findLineEnd(p, end) + 1;
+    }
+}
+
+/*! \brief Appends the line that starts at \a offset.
+ * The lines must be appended in order.
+ */
+void LineIndex::append(const size_t offset)
+{
+    if (m_lineCount % SUPERBLOCK_LINES == 0) {
+        m_superblocks.push_back(offset);
+    }
+    if (m_lineCount % BLOCK_LINES == 0) {
+        const unsigned long long relative = offset - m_superblocks.back();
+        if (relative < C_FAR_BLOCK) {
+            m_blocks.push_back((unsigned int)relative);
+        } else {
+            m_farBlocks[m_blocks.size()] = offset;
+            m_blocks.push_back(C_FAR_BLOCK);
+        }
+    }
+    ++m_lineCount;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the offset of the start of the block of lines \a block.
+ */
+unsigned long long LineIndex::blockOffset(const size_t block) const
+{
+    const unsigned int relative = m_blocks[block];
+    if (relative == C_FAR_BLOCK) {
+        return m_farBlocks.find(block)->second;
+    }
+    const size_t superblock = block / (SUPERBLOCK_LINES / BLOCK_LINES);
+    return m_superblocks[superblock] + relative;
+}
+
+/*! \brief Returns the offset of the line \a lineNumber (from 1) in the
+ *         content [\a begin, \a end), that the index was built for.
+ * Returns the size of the content if the line doesn't exist.
+ */
+size_t LineIndex::lineOffset(const char *begin, const char *end, const size_t lineNumber) const
+{
+    if (lineNumber == 0 || lineNumber > m_lineCount) {
+        return (size_t)(end - begin);
+    }
+    const size_t line = lineNumber - 1;
+    const char *p = begin + blockOffset(line / BLOCK_LINES);
+    for (size_t i = 0; i < line % BLOCK_LINES; ++i) {
+        p = Scanner::findLineEnd(p, end) + 1;
+    }
+    return (size_t)(p - begin);
+}
+
+/*! \brief Returns the number (from 1) of the line that contains the
+ *         \a offset of the content [\a begin, \a end), or 0 if the content
+ *         is empty.
+ */
+size_t LineIndex::lineAt(const char *begin, const char *end, const size_t offset) const
+{
+    if (m_blocks.empty()) {
+        return 0;
+    }
+
+    /* The last superblock that starts before the offset... */
+    const vector<unsigned long long>::const_iterator superblock =
+            upper_bound(m_superblocks.begin(), m_superblocks.end(), (unsigned long long)offset);
+    const size_t blocksPerSuperblock = SUPERBLOCK_LINES / BLOCK_LINES;
+    size_t first = (size_t)(superblock - m_superblocks.begin());
+    first = (first > 0) ? (first - 1) * blocksPerSuperblock : 0;
+    size_t last = min(first + blocksPerSuperblock, m_blocks.size());
+
+    /* ...then its last block that starts before the offset */
+    while (last - first > 1) {
+        const size_t middle = first + (last - first) / 2;
+        if (blockOffset(middle) <= offset) {
+            first = middle;
+        } else {
+            last = middle;
+        }
+    }
+
+    const size_t position = min(offset, (size_t)(end - begin));
+    const char *p = begin + blockOffset(first);
+    const size_t lines = (begin + position > p) ? Scanner::countLines(p, begin + position) : 0;
+    return min(first * BLOCK_LINES + lines + 1, m_lineCount);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the memory used by the index, in bytes.
+ */
+size_t LineIndex::memoryUsage() const
+{
+    return m_superblocks.capacity() * sizeof(unsigned long long)
+            + m_blocks.capacity() * sizeof(unsigned int)
+            + m_farBlocks.size() * (sizeof(size_t) + sizeof(unsigned long long) + 4 * sizeof(void*));
+}
@@ -0,0 +1,60 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+class LineIndex
+{
+public:
+    /* One offset per block of lines, relative to its superblock */
+    static const std::size_t BLOCK_LINES = 8;
+    static const std::size_t SUPERBLOCK_LINES = 512;
+
+    explicit LineIndex();
+
+    void clear();
+
+    /* Building, in one pass over the content */
+    void build(const char *begin, const char *end);
+
+    /* Building, while the file is scanned: the start of the next line */
+    void append(const std::size_t offset);
+
+    std::size_t lineCount() const { return m_lineCount; }
+
+    /* Queries: the content is needed to count the lines within a block */
+    std::size_t lineOffset(const char *begin, const char *end, const std::size_t lineNumber) const;
+    std::size_t lineAt(const char *begin, const char *end, const std::size_t offset) const;
+
+    std::size_t memoryUsage() const;
+
+private:
+    std::size_t m_lineCount;
+    std::vector<unsigned long long> m_superblocks;
+    std::vector<unsigned int> m_blocks;
+
+    /* blocks too far from their superblock, for 32 bits */
+    std::map<std::size_t, unsigned long long> m_farBlocks;
+
+    unsigned long long blockOffset(const std::size_t block) const;
+};
+
+#endif // LINE_INDEX_H
@@ -17,8 +17,10 @@
 #include "global.h"
 #include "version.h"
 #include "application.h"
+#include "batch.h"
 
 #include <iostream>
+#include <stdlib.h> // strtoul(), strtoll()
 #include <string>
 
 using namespace std;
@@ -43,11 +45,33 @@ void usage()
     cout << endl;
     cout << " [USAGE] " << endl;
     cout << "    nastranfind [options] filename" << endl;
+    cout << "    nastranfind [options] archive.zip:filename" << endl;
     cout << endl;
     cout << " [OPTIONS]" << endl;
     cout << "    -h or --help     Displays this help." << endl;
     cout << "    -v or --version  Displays the version. " << endl;
     cout << "    --reset-config    Clears the saved preference parameters." << endl;
+    cout << "    --find=TEXT      Searches TEXT and prints the results, without the GUI." << endl;
+    cout << "    --count=TEXT     Counts TEXT in each file, without building the results." << endl;
+    cout << "    --stats          Prints the memory statistics after the results (with --find)." << endl;
+    cout << "    --memory-budget=MB  Stores the results in a temporary file beyond MB megabytes" << endl;
+    cout << "                     (default: " << C_MEMORY_BUDGET_DEFAULT << ", 0 for unlimited)." << endl;
+    cout << "    --preview=N      Shows only the first N results, but counts all the occurrences." << endl;
+    cout << "    --max-count=N    Stops counting the occurrences beyond N." << endl;
+    cout << "    --locate=CARD,ID Prints where the entity is defined, e.g. --locate=GRID,123456." << endl;
+    cout << "    --xref=NAME,ID   Prints the entities that reference the GRID, PID or MID," << endl;
+    cout << "                     e.g. --xref=GRID,1001 prints the elements connected to it." << endl;
+    cout << "    --duplicates     Prints the IDs defined more than once in the include tree." << endl;
+    cout << "    --missing        Prints the references to the grids, properties and materials" << endl;
+    cout << "                     that are not defined in the include tree." << endl;
+    cout << "    --diff=OTHER     Prints the entities removed, added or changed in the model OTHER." << endl;
+    cout << "    --fingerprint    Prints the fingerprint of the include tree, and tells if" << endl;
+    cout << "                     the model changed since the last run (exit code 1)." << endl;
+    cout << "    --no-index       Loads and scans every file, even the ones that the term index" << endl;
+    cout << "                     shows can't contain the searched text." << endl;
+    cout << "    --compare=OTHER  Shows the model OTHER side by side with the model, in the GUI." << endl;
+    cout << "    --context=N      Shows N lines before the card, when a result is opened" << endl;
+    cout << "                     in its file with [Enter], in the GUI (default: " << C_CONTEXT_LINES << ")." << endl;
     cout << endl;
 }
 
@@ -74,13 +98,107 @@ void version()
 
 int main( int argc, char *argv[] )
 {
+    static const string OPTION_FIND("--find=");
+    static const string OPTION_COUNT("--count=");
+    static const string OPTION_MEMORY_BUDGET("--memory-budget=");
+    static const string OPTION_PREVIEW("--preview=");
+    static const string OPTION_MAX_COUNT("--max-count=");
+    static const string OPTION_LOCATE("--locate=");
+    static const string OPTION_XREF("--xref=");
+    static const string OPTION_DIFF("--diff=");
+    static const string OPTION_COMPARE("--compare=");
+    static const string OPTION_CONTEXT("--context=");
+
     bool forceResetConfig = false;
+    bool batchMode = false;
+    bool countOnly = false;
+    bool statistics = false;
+    size_t memoryBudget = (size_t)C_MEMORY_BUDGET_DEFAULT * 1024 * 1024;
+    stringlist::size_type resultLimit = 0;
+    stringlist::size_type countLimit = 0;
     string filename;
+    string searchedText;
+    string locateCard;
+    long long locateId = 0;
+    string xrefName;
+    long long xrefId = 0;
+    bool checkDuplicates = false;
+    bool checkReferences = false;
+    string otherFilename;
+    string compareFilename;
+    bool fingerprint = false;
+    bool termIndexEnabled = true;
+    size_t contextLineCount = C_CONTEXT_LINES;
     for( int i = 1; i < argc; ++i ){
         string arg(argv[i]);
 
         if ( arg == "--reset-config" ) {
             forceResetConfig = true;
+        } else if ( arg.compare(0, OPTION_FIND.length(), OPTION_FIND) == 0 ) {
+            batchMode = true;
+            searchedText = arg.substr(OPTION_FIND.length());
+        } else if ( arg.compare(0, OPTION_COUNT.length(), OPTION_COUNT) == 0 ) {
+            batchMode = true;
+            countOnly = true;
+            searchedText = arg.substr(OPTION_COUNT.length());
+        } else if ( arg == "--stats" ) {
+            statistics = true;
+        } else if ( arg.compare(0, OPTION_MEMORY_BUDGET.length(), OPTION_MEMORY_BUDGET) == 0 ) {
+            const string value = arg.substr(OPTION_MEMORY_BUDGET.length());
+            memoryBudget = (size_t)strtoul(value.c_str(), NULL, 10) * 1024 * 1024;
+        } else if ( arg.compare(0, OPTION_PREVIEW.length(), OPTION_PREVIEW) == 0 ) {
+            const string value = arg.substr(OPTION_PREVIEW.length());
+            resultLimit = (stringlist::size_type)strtoul(value.c_str(), NULL, 10);
+        } else if ( arg.compare(0, OPTION_MAX_COUNT.length(), OPTION_MAX_COUNT) == 0 ) {
+            const string value = arg.substr(OPTION_MAX_COUNT.length());
+            countLimit = (stringlist::size_type)strtoul(value.c_str(), NULL, 10);
+        } else if ( arg.compare(0, OPTION_LOCATE.length(), OPTION_LOCATE) == 0 ) {
+            const string value = arg.substr(OPTION_LOCATE.length());
+            const string::size_type comma = value.find(',');
+            if( comma == string::npos || comma == 0 ) {
+                cout << "Error: Expected --locate=CARD,ID; type '-h' for details." << endl;
+                return 1;
+            }
+            batchMode = true;
+            locateCard = value.substr(0, comma);
+            locateId = strtoll(value.c_str() + comma + 1, NULL, 10);
+        } else if ( arg.compare(0, OPTION_XREF.length(), OPTION_XREF) == 0 ) {
+            const string value = arg.substr(OPTION_XREF.length());
+            const string::size_type comma = value.find(',');
+            if( comma == string::npos || comma == 0 ) {
+                cout << "Error: Expected --xref=NAME,ID; type '-h' for details." << endl;
+                return 1;
+            }
+            batchMode = true;
+            xrefName = value.substr(0, comma);
+            xrefId = strtoll(value.c_str() + comma + 1, NULL, 10);
+        } else if ( arg.compare(0, OPTION_DIFF.length(), OPTION_DIFF) == 0 ) {
+            batchMode = true;
+            otherFilename = arg.substr(OPTION_DIFF.length());
+            if( otherFilename.empty() ) {
+                cout << "Error: Expected --diff=OTHER; type '-h' for details." << endl;
+                return 1;
+            }
+        } else if ( arg.compare(0, OPTION_COMPARE.length(), OPTION_COMPARE) == 0 ) {
+            compareFilename = arg.substr(OPTION_COMPARE.length());
+            if( compareFilename.empty() ) {
+                cout << "Error: Expected --compare=OTHER; type '-h' for details." << endl;
+                return 1;
+            }
+        } else if ( arg.compare(0, OPTION_CONTEXT.length(), OPTION_CONTEXT) == 0 ) {
+            const string value = arg.substr(OPTION_CONTEXT.length());
+            contextLineCount = (size_t)strtoul(value.c_str(), NULL, 10);
+        } else if ( arg == "--fingerprint" ) {
+            batchMode = true;
+            fingerprint = true;
+        } else if ( arg == "--no-index" ) {
+            termIndexEnabled = false;
+        } else if ( arg == "--duplicates" ) {
+            batchMode = true;
+            checkDuplicates = true;
+        } else if ( arg == "--missing" ) {
+            batchMode = true;
+            checkReferences = true;
         } else if (arg == "--help" || arg == "-h") {
             usage();
             return 0;
@@ -88,11 +206,40 @@ int main( int argc, char *argv[] )
             version();
             return 0;
         } else {
-            intro();
             filename = arg;
         }
     }
 
+    if( batchMode ){
+        if( filename.empty() ){
+            cout << "Error: Need an argument; type '-h' for details." << endl;
+            return 1;
+        }
+        Batch batch;
+        batch.setFilename( filename );
+        batch.setSearchedText( searchedText );
+        batch.setStatisticsEnabled( statistics );
+        batch.setMemoryBudget( memoryBudget );
+        batch.setPreview( resultLimit, countLimit );
+        batch.setCountOnly( countOnly );
+        if( !locateCard.empty() ){
+            batch.setLocate( locateCard, locateId );
+        }
+        if( !xrefName.empty() ){
+            batch.setCrossReference( xrefName, xrefId );
+        }
+        batch.setCheckDuplicates( checkDuplicates );
+        batch.setCheckReferences( checkReferences );
+        if( !otherFilename.empty() ){
+            batch.setDiff( otherFilename );
+        }
+        batch.setFingerprint( fingerprint );
+        batch.setTermIndexEnabled( termIndexEnabled );
+        return batch.exec();
+    }
+
+    intro();
+
     Application app(argc, argv);
 
     if( forceResetConfig ){
@@ -105,5 +252,12 @@ int main( int argc, char *argv[] )
     }
 
     app.setFilename( filename );
+    app.setMemoryBudget( memoryBudget );
+    app.setPreview( resultLimit, countLimit );
+    app.setContextLines( contextLineCount );
+    app.setTermIndexEnabled( termIndexEnabled );
+    if( !compareFilename.empty() ){
+        app.setOtherFilename( compareFilename );
+    }
     return app.exec();
 }
@@ -0,0 +1,407 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mappedfile.h"
+
+#include "compression.h"
+#include "fileinfo.h"
+#include "ziparchive.h"
+
+#include <memory>
+#include <stdio.h> // tmpfile()
+
+#if defined(Q_OS_WIN)
+#  include <windows.h>
+#  include <io.h>       // _get_osfhandle()
+#elif defined(Q_OS_UNIX)
+#  include <fcntl.h>    // open()
+#  include <sys/mman.h> // mmap(), munmap()
+#  include <sys/stat.h> // fstat(), stat()
+#  include <unistd.h>   // close()
+#endif
+
+using namespace std;
+
+#if defined(Q_OS_UNIX)
+/* In nanoseconds where available: a file rewritten with the same size */
+/* within the same second is still seen as modified.                   */
+static inline long long modificationTimeOf(const struct stat &info)
+{
+#  if defined(Q_OS_LINUX)
+    return (long long)info.st_mtim.tv_sec * 1000000000LL + (long long)info.st_mtim.tv_nsec;
+#  else
+    return (long long)info.st_mtime;
+#  endif
+}
+#endif
+
+/*! \class MappedFile
+ *  \brief The class MappedFile gives a read-only access to the content
+ *         of a file, through a memory-mapped view.
+ *
+ * The content is not copied: the pages are loaded by the system
+ * when they are read, and shared with the system file cache.
+ *
+ * A gzip-compressed file ('.gz') is decompressed by chunks in an anonymous
+ * temporary file, that is mapped instead: the decompressed content is not
+ * held in memory, but paged by the system like any other mapped file.
+ * If the file doesn't exist, but its compressed version 'name.gz' does,
+ * the latter is open, so that the INCLUDE statements of an archived
+ * include tree don't need to be edited.
+ *
+ * A member of a zip archive, named "archive.zip:member", is decompressed
+ * the same way, without extracting the archive.
+ *
+ * \remark An empty file is open, but begin() == end().
+ * \remark The content is *not* null-terminated.
+ * \remark size() is the size of the decompressed content, whereas status()
+ * returns the size of the file on the disk.
+ */
+
+/*! \brief Constructor.
+ */
+MappedFile::MappedFile()
+    : m_data(NULL)
+    , m_size(0)
+    , m_fileSize(0)
+    , m_modificationTime(0)
+    , m_isOpen(false)
+#if defined(Q_OS_WIN)
+    , m_file(INVALID_HANDLE_VALUE)
+    , m_mapping(NULL)
+    , m_temporary(NULL)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    this->close();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Maps the file \a fullFileName in memory.
+ * Returns false if the file cannot be opened.
+ */
+bool MappedFile::open(const string &fullFileName)
+{
+    this->close();
+
+    string archive;
+    string member;
+    if (FileInfo::splitArchivePath(fullFileName, &archive, &member)) {
+        return this->openArchived(archive, member);
+    }
+    if (Compression::isGzip(fullFileName)) {
+        return this->openCompressed(fullFileName);
+    }
+    if (this->openMapped(fullFileName)) {
+        return true;
+    }
+    /* An archived include tree: 'part.dat' stands for 'part.dat.gz' */
+    const string compressedFileName = fullFileName + ".gz";
+    size_t size = 0;
+    long long modificationTime = 0;
+    if (fileStatus(compressedFileName, &size, &modificationTime)) {
+        return this->openCompressed(compressedFileName);
+    }
+    return false;
+}
+
+bool MappedFile::openMapped(const string &fullFileName)
+{
+#if defined(Q_OS_WIN)
+    /* The mapping can be kept open: don't prevent the user from editing the file */
+    HANDLE file = CreateFileA(fullFileName.c_str(), GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+    FILETIME lastWrite;
+    if (GetFileTime(file, NULL, NULL, &lastWrite)) {
+        m_modificationTime = ((long long)lastWrite.dwHighDateTime << 32)
+                | (long long)lastWrite.dwLowDateTime;
+    }
+    m_file = file;
+    m_isOpen = true;
+    if (size.QuadPart == 0) {
+        return true;
+    }
+    m_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_mapping == NULL) {
+        this->close();
+        return false;
+    }
+    void *address = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (address == NULL) {
+        this->close();
+        return false;
+    }
+    m_data = static_cast<const char*>(address);
+    m_size = (size_t)size.QuadPart;
+    m_fileSize = m_size;
+    return true;
+
+#elif defined(Q_OS_UNIX)
+    const int fd = ::open(fullFileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || S_ISDIR(info.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+    m_modificationTime = modificationTimeOf(info);
+    m_isOpen = true;
+    if (info.st_size == 0) {
+        ::close(fd);
+        return true;
+    }
+    void *address = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps a reference to the file
+    if (address == MAP_FAILED) {
+        m_isOpen = false;
+        return false;
+    }
+#  if defined(MADV_SEQUENTIAL)
+    madvise(address, (size_t)info.st_size, MADV_SEQUENTIAL);
+#  endif
+    m_data = static_cast<const char*>(address);
+    m_size = (size_t)info.st_size;
+    m_fileSize = m_size;
+    return true;
+#endif
+}
+
+/*! \brief Returns true if the file \a fullFileName is compressed,
+ *         or stands for its compressed version 'fullFileName.gz'.
+ */
+bool MappedFile::isCompressed(const string &fullFileName)
+{
+    string archive;
+    string member;
+    if (Compression::isGzip(fullFileName)
+            || FileInfo::splitArchivePath(fullFileName, &archive, &member)) {
+        return true;
+    }
+    size_t size = 0;
+    long long modificationTime = 0;
+    return !fileStatus(fullFileName, &size, &modificationTime)
+            && fileStatus(fullFileName + ".gz", &size, &modificationTime);
+}
+
+/*! \brief Decompresses the gzip file \a fullFileName in a temporary file,
+ *         and maps the latter in memory.
+ * Returns false if the file cannot be opened or decompressed.
+ */
+bool MappedFile::openCompressed(const string &fullFileName)
+{
+    size_t compressedSize = 0;
+    long long modificationTime = 0;
+    if (!fileStatus(fullFileName, &compressedSize, &modificationTime)) {
+        return false;
+    }
+    FILE *temporary = tmpfile();
+    if (!temporary) {
+        return false;
+    }
+    if (!Compression::gunzip(fullFileName, temporary)) {
+        fclose(temporary);
+        return false;
+    }
+    return this->mapTemporary(temporary, compressedSize, modificationTime);
+}
+
+/*! \brief Decompresses the \a member of the zip archive \a archiveFileName
+ *         in a temporary file, and maps the latter in memory.
+ * Returns false if the archive cannot be read, or has no such member.
+ *
+ * The modification time is the one of the archive.
+ */
+bool MappedFile::openArchived(const string &archiveFileName, const string &member)
+{
+    const shared_ptr<const ZipArchive> archive = ZipArchive::cached(archiveFileName);
+    const ZipArchive::Member *found = archive ? archive->find(member) : NULL;
+    if (!found) {
+        return false;
+    }
+    FILE *temporary = tmpfile();
+    if (!temporary) {
+        return false;
+    }
+    if (!archive->extract(*found, temporary)) {
+        fclose(temporary);
+        return false;
+    }
+    return this->mapTemporary(temporary, (size_t)found->size, archive->modificationTime());
+}
+
+/*! \brief Maps the content written in the \a temporary file, that is closed
+ *         when the mapping is closed. \a fileSize and \a modificationTime
+ *         are the status of the original file.
+ */
+bool MappedFile::mapTemporary(FILE *temporary, const size_t fileSize,
+                              const long long modificationTime)
+{
+    if (fflush(temporary) != 0) {
+        fclose(temporary);
+        return false;
+    }
+#if defined(Q_OS_WIN)
+    const long long size = _ftelli64(temporary);
+#else
+    const long long size = (long long)ftello(temporary);
+#endif
+    if (size < 0) {
+        fclose(temporary);
+        return false;
+    }
+    m_fileSize = fileSize;
+    m_modificationTime = modificationTime;
+    m_isOpen = true;
+    if (size == 0) {
+        fclose(temporary);
+        return true;
+    }
+
+#if defined(Q_OS_WIN)
+    /* The temporary file is deleted when closed: keep it open while mapped */
+    m_temporary = temporary;
+    HANDLE file = (HANDLE)_get_osfhandle(_fileno(temporary));
+    m_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_mapping == NULL) {
+        this->close();
+        return false;
+    }
+    void *address = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (address == NULL) {
+        this->close();
+        return false;
+    }
+#elif defined(Q_OS_UNIX)
+    void *address = mmap(NULL, (size_t)size, PROT_READ, MAP_PRIVATE, fileno(temporary), 0);
+    fclose(temporary); // the mapping keeps a reference to the file
+    if (address == MAP_FAILED) {
+        m_isOpen = false;
+        return false;
+    }
+#  if defined(MADV_SEQUENTIAL)
+    madvise(address, (size_t)size, MADV_SEQUENTIAL);
+#  endif
+#endif
+    m_data = static_cast<const char*>(address);
+    m_size = (size_t)size;
+    return true;
+}
+
+/*! \brief Unmaps the file.
+ */
+void MappedFile::close()
+{
+#if defined(Q_OS_WIN)
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = NULL;
+    }
+    if (m_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+    if (m_temporary) {
+        fclose(m_temporary);
+        m_temporary = NULL;
+    }
+#elif defined(Q_OS_UNIX)
+    if (m_data) {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+#endif
+    m_data = NULL;
+    m_size = 0;
+    m_fileSize = 0;
+    m_modificationTime = 0;
+    m_isOpen = false;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns in \a size and \a modificationTime the status of the file
+ *         \a fullFileName, in the same units as size() and modificationTime().
+ * Returns false if the file doesn't exist, or is a directory.
+ *
+ * As open(), returns the status of 'fullFileName.gz' if the file doesn't
+ * exist. The size of a compressed file is its size on the disk.
+ * The size of a member of a zip archive is its decompressed size, and its
+ * modification time the one of the archive.
+ */
+bool MappedFile::status(const string &fullFileName,
+                        size_t *size, long long *modificationTime)
+{
+    string archiveFileName;
+    string member;
+    if (FileInfo::splitArchivePath(fullFileName, &archiveFileName, &member)) {
+        const shared_ptr<const ZipArchive> archive = ZipArchive::cached(archiveFileName);
+        const ZipArchive::Member *found = archive ? archive->find(member) : NULL;
+        if (!found) {
+            return false;
+        }
+        (*size) = (size_t)found->size;
+        (*modificationTime) = archive->modificationTime();
+        return true;
+    }
+    if (fileStatus(fullFileName, size, modificationTime)) {
+        return true;
+    }
+    return !Compression::isGzip(fullFileName)
+            && fileStatus(fullFileName + ".gz", size, modificationTime);
+}
+
+bool MappedFile::fileStatus(const string &fullFileName,
+                            size_t *size, long long *modificationTime)
+{
+#if defined(Q_OS_WIN)
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(fullFileName.c_str(), GetFileExInfoStandard, &data)
+            || (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+        return false;
+    }
+    (*size) = (size_t)(((unsigned long long)data.nFileSizeHigh << 32)
+                       | (unsigned long long)data.nFileSizeLow);
+    (*modificationTime) = ((long long)data.ftLastWriteTime.dwHighDateTime << 32)
+            | (long long)data.ftLastWriteTime.dwLowDateTime;
+    return true;
+
+#elif defined(Q_OS_UNIX)
+    struct stat info;
+    if (stat(fullFileName.c_str(), &info) != 0 || S_ISDIR(info.st_mode)) {
+        return false;
+    }
+    (*size) = (size_t)info.st_size;
+    (*modificationTime) = modificationTimeOf(info);
+    return true;
+#endif
+}
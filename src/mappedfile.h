@@ -0,0 +1,79 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include "systemdetection.h"
+
+#include <cstddef>
+#include <stdio.h>
+#include <string>
+
+class MappedFile
+{
+public:
+    explicit MappedFile();
+    ~MappedFile();
+
+    bool open(const std::string &fullFileName);
+    void close();
+
+    /* The file is decompressed when open */
+    static bool isCompressed(const std::string &fullFileName);
+
+    /* Size and modification time of a file on the disk, without mapping it */
+    static bool status(const std::string &fullFileName,
+                       std::size_t *size, long long *modificationTime);
+
+    bool isOpen() const { return m_isOpen; }
+
+    const char* begin() const { return m_data; }
+    const char* end() const { return m_data + m_size; }
+    std::size_t size() const { return m_size; }
+
+    /* Size of the file on the disk: the compressed size, if compressed */
+    std::size_t fileSize() const { return m_fileSize; }
+
+    /* Last modification time, in a system-dependent unit */
+    long long modificationTime() const { return m_modificationTime; }
+
+private:
+    const char *m_data;
+    std::size_t m_size;
+    std::size_t m_fileSize;
+    long long m_modificationTime;
+    bool m_isOpen;
+
+#if defined(Q_OS_WIN)
+    void *m_file;
+    void *m_mapping;
+    FILE *m_temporary; // decompressed content
+#endif
+
+    bool openMapped(const std::string &fullFileName);
+    bool openCompressed(const std::string &fullFileName);
+    bool openArchived(const std::string &archiveFileName, const std::string &member);
+    bool mapTemporary(FILE *temporary, const std::size_t fileSize,
+                      const long long modificationTime);
+    static bool fileStatus(const std::string &fullFileName,
+                           std::size_t *size, long long *modificationTime);
+
+    MappedFile(const MappedFile &);            // not copyable
+    MappedFile& operator=(const MappedFile &); // not copyable
+};
+
+#endif // MAPPED_FILE_H
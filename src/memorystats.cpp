@@ -0,0 +1,232 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "memorystats.h"
+
+#include "systemdetection.h"
+
+#include <stdio.h>
+
+#if defined(Q_OS_WIN)
+#  include <windows.h>
+#  include <psapi.h>        // GetProcessMemoryInfo()
+#elif defined(Q_OS_UNIX)
+#  include <sys/resource.h> // getrusage()
+#endif
+
+using namespace std;
+
+/*! \class MemoryStats
+ *  \brief The class MemoryStats accounts for the memory allocated
+ *         by each subsystem of the application.
+ *
+ * The accounting is declarative: each subsystem reports the bytes it
+ * allocates and releases. The class keeps the current value and the peak
+ * value for each subsystem, so that the user can see which part of the
+ * application is responsible for the memory consumption.
+ */
+
+/*! \brief Constructor.
+ */
+MemoryStats::MemoryStats()
+{
+    this->clear();
+}
+
+/*! \brief Resets the current values and the peak values of all the subsystems.
+ */
+void MemoryStats::clear()
+{
+    for (int i = 0; i < SUBSYSTEM_COUNT; ++i) {
+        m_current[i] = 0;
+        m_peak[i] = 0;
+    }
+    m_peakTotal = 0;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Accounts for \a bytes allocated by the given \a subsystem.
+ */
+void MemoryStats::allocate(const Subsystem subsystem, const size_t bytes)
+{
+    const int i = (int)subsystem;
+    m_current[i] += bytes;
+    if (m_current[i] > m_peak[i]) {
+        m_peak[i] = m_current[i];
+    }
+    const size_t total = currentTotal();
+    if (total > m_peakTotal) {
+        m_peakTotal = total;
+    }
+}
+
+/*! \brief Accounts for \a bytes released by the given \a subsystem.
+ */
+void MemoryStats::release(const Subsystem subsystem, const size_t bytes)
+{
+    const int i = (int)subsystem;
+    m_current[i] = (bytes < m_current[i]) ? m_current[i] - bytes : 0;
+}
+
+/*! \brief Releases all the bytes of the given \a subsystem.
+ * The peak value is kept.
+ */
+void MemoryStats::reset(const Subsystem subsystem)
+{
+    m_current[(int)subsystem] = 0;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+size_t MemoryStats::current(const Subsystem subsystem) const
+{
+    return m_current[(int)subsystem];
+}
+
+size_t MemoryStats::peak(const Subsystem subsystem) const
+{
+    return m_peak[(int)subsystem];
+}
+
+size_t MemoryStats::currentTotal() const
+{
+    size_t total = 0;
+    for (int i = 0; i < SUBSYSTEM_COUNT; ++i) {
+        total += m_current[i];
+    }
+    return total;
+}
+
+/*! \brief Returns the peak of the sum of all the subsystems.
+ * It's lower or equal to the sum of the peaks, because
+ * the subsystems don't reach their peak at the same time.
+ */
+size_t MemoryStats::peakTotal() const
+{
+    return m_peakTotal;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns a human readable report, one line per subsystem,
+ *         followed by the peak resident set size of the process.
+ *
+ * \code
+ *   Memory                current       peak
+ *   loaded text    :     0.0 KB    12.4 MB
+ *   result storage :     1.2 MB     1.2 MB
+ *   ...
+ * \endcode
+ */
+vector<string> MemoryStats::report() const
+{
+    vector<string> lines;
+    char buffer[128];
+
+    sprintf(buffer, "%-18s %12s %12s", "Memory", "current", "peak");
+    lines.push_back(buffer);
+
+    for (int i = 0; i < SUBSYSTEM_COUNT; ++i) {
+        const Subsystem subsystem = (Subsystem)i;
+        sprintf(buffer, "%-16s : %12s %12s", name(subsystem),
+                formatBytes(m_current[i]).c_str(),
+                formatBytes(m_peak[i]).c_str());
+        lines.push_back(buffer);
+    }
+
+    sprintf(buffer, "%-16s : %12s %12s", "total",
+            formatBytes(currentTotal()).c_str(),
+            formatBytes(peakTotal()).c_str());
+    lines.push_back(buffer);
+
+    sprintf(buffer, "%-16s : %12s %12s", "process (RSS)", "",
+            formatBytes(peakResidentSetSize()).c_str());
+    lines.push_back(buffer);
+
+    return lines;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+const char* MemoryStats::name(const Subsystem subsystem)
+{
+    switch (subsystem) {
+    case Subsystem::LOADED_TEXT:    return "loaded text";
+    case Subsystem::RESULT_STORAGE: return "result storage";
+    case Subsystem::INDEXES:        return "indexes";
+    case Subsystem::UI_CACHES:      return "UI caches";
+    default: break;
+    }
+    return "";
+}
+
+/*! \brief Returns an estimation of the memory used by the given \a text,
+ *         including the string object itself.
+ */
+size_t MemoryStats::sizeOf(const string &text)
+{
+    return sizeof(string) + text.capacity();
+}
+
+/*! \brief Returns the peak resident set size of the process, in bytes.
+ * Returns 0 if the platform doesn't provide this information.
+ */
+size_t MemoryStats::peakResidentSetSize()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return (size_t)counters.PeakWorkingSetSize;
+    }
+    return 0;
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#  if defined(Q_OS_MAC)
+    return (size_t)usage.ru_maxrss;         /* in bytes on Mac OS X */
+#  else
+    return (size_t)usage.ru_maxrss * 1024;  /* in kilobytes on Linux */
+#  endif
+#else
+    return 0;
+#endif
+}
+
+/*! \brief Returns the given amount of \a bytes as a human readable string.
+ *
+ * \code
+ *   MemoryStats::formatBytes(1536);        // "1.5 KB"
+ *   MemoryStats::formatBytes(3221225472);  // "3.0 GB"
+ * \endcode
+ */
+string MemoryStats::formatBytes(const size_t bytes)
+{
+    char buffer[32];
+    const double value = (double)bytes;
+    if (bytes < 1024) {
+        sprintf(buffer, "%i B", (int)bytes);
+    } else if (bytes < 1024 * 1024) {
+        sprintf(buffer, "%.1f KB", value / 1024.0);
+    } else if (bytes < 1024 * 1024 * 1024) {
+        sprintf(buffer, "%.1f MB", value / (1024.0 * 1024.0));
+    } else {
+        sprintf(buffer, "%.1f GB", value / (1024.0 * 1024.0 * 1024.0));
+    }
+    return string(buffer);
+}
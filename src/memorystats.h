@@ -0,0 +1,61 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MEMORY_STATS_H
+#define MEMORY_STATS_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class MemoryStats
+{
+public:
+    enum class Subsystem {
+        LOADED_TEXT    = 0, ///< Content of the files held by the file cache
+        RESULT_STORAGE    , ///< Occurrence strings and error messages
+        INDEXES           , ///< Indexes built while loading the files
+        UI_CACHES           ///< Rows of the views of the user interface
+    };
+    static const int SUBSYSTEM_COUNT = 4;
+
+    explicit MemoryStats();
+
+    void clear();
+
+    void allocate(const Subsystem subsystem, const std::size_t bytes);
+    void release(const Subsystem subsystem, const std::size_t bytes);
+    void reset(const Subsystem subsystem);
+
+    std::size_t current(const Subsystem subsystem) const;
+    std::size_t peak(const Subsystem subsystem) const;
+    std::size_t currentTotal() const;
+    std::size_t peakTotal() const;
+
+    std::vector<std::string> report() const;
+
+    static const char* name(const Subsystem subsystem);
+    static std::size_t sizeOf(const std::string &text);
+    static std::size_t peakResidentSetSize();
+    static std::string formatBytes(const std::size_t bytes);
+
+private:
+    std::size_t m_current[SUBSYSTEM_COUNT];
+    std::size_t m_peak[SUBSYSTEM_COUNT];
+    std::size_t m_peakTotal;
+};
+
+#endif // MEMORY_STATS_H
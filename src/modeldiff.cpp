@@ -0,0 +1,509 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "modeldiff.h"
+
+#include "query.h"
+#include "tokenizer.h"
+
+#include <algorithm> // sort(), max(), min()
+#include <atomic>
+#include <string.h>  // memcpy()
+#include <thread>
+
+using namespace std;
+
+/*! \class ModelDiff
+ *  \brief The class ModelDiff compares two models, entity by entity.
+ *
+ * The Bulk Data entries of both include trees are matched by card name
+ * and ID (field 2), e.g. CQUAD4 12, whatever the file where they are
+ * defined. Then, the entities only in the first model are REMOVED, the
+ * ones only in the second model are ADDED, and the ones whose fields
+ * differ are CHANGED.
+ *
+ * The fields are compared by value, not by text: an integer, a real or
+ * a word is normalized the same way in the small field, large field and
+ * free field formats, and the equivalent notations of a real (1., 1.0E0,
+ * 1+0...) are equal. Each card is reduced to a 64-bit fingerprint of its
+ * normalized fields, so only the name, the ID and the fingerprint of each
+ * card are kept in memory, and the cards are matched by sorting. The
+ * cards that share a name and an ID, like the ones of a set (SPC1 10,
+ * FORCE 5...), are paired with an identical card first, so a set whose
+ * cards are reordered is unchanged.
+ *
+ * The buffers are parsed in parallel, then the fields of a changed entity
+ * can be detailed with fieldChanges().
+ *
+ * \remark The cards without an integer ID (PARAM, INCLUDE...) and the
+ * Executive and Case Control sections are not compared. A card name
+ * has at most 8 characters.
+ */
+
+/*! \brief Normalized field of a card.
+ */
+struct NormalizedField
+{
+    int number;                 ///< As in the small field format
+    Tokenizer::Kind kind;       ///< INTEGER, REAL or WORD (any text)
+    unsigned long long value;   ///< Integer, bits of the real, or hash of the text
+    const char *text;           ///< Raw text, to report the changes
+    size_t length;
+};
+
+/*! \brief Card of a model, reduced to its fingerprint.
+ */
+struct CardRecord
+{
+    unsigned long long name;        ///< Card name, packed in 8 bytes
+    long long id;
+    unsigned long long fingerprint; ///< Hash of the normalized fields
+    size_t offset;
+    unsigned int buffer;            ///< Position of the buffer in the list
+    unsigned int lineNumber;
+};
+
+/*! \brief Returns true if the card \a a is before the card \a b in the model.
+ */
+static bool isBefore(const CardRecord &a, const CardRecord &b)
+{
+    if (a.buffer != b.buffer) {
+        return a.buffer < b.buffer;
+    }
+    return a.offset < b.offset;
+}
+
+static bool lessThan(const CardRecord &a, const CardRecord &b)
+{
+    if (a.name != b.name) {
+        return a.name < b.name;
+    }
+    if (a.id != b.id) {
+        return a.id < b.id;
+    }
+    if (a.fingerprint != b.fingerprint) {
+        return a.fingerprint < b.fingerprint;
+    }
+    return isBefore(a, b);
+}
+
+/*! \brief Returns true if the name and ID of \a a are before the ones of \a b.
+ */
+static inline bool isKeyLess(const CardRecord &a, const CardRecord &b)
+{
+    return a.name < b.name || (a.name == b.name && a.id < b.id);
+}
+
+/*! \brief Returns the mix of the bits of \a key (finalizer of SplitMix64).
+ */
+static inline unsigned long long mix(unsigned long long key)
+{
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return key;
+}
+
+/*! \brief Returns the hash of the \a text in upper case (FNV-1a).
+ */
+static inline unsigned long long hashText(const char *text, const size_t length)
+{
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= (unsigned char)Scanner::toUpper(text[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/*! \brief Returns the card name at the start of the \a line, in upper case,
+ *         packed in 8 bytes so that the packed names sort alphabetically.
+ *         Returns 0 if the line doesn't start with a name.
+ */
+static unsigned long long packName(const char *line, const size_t length)
+{
+    unsigned long long name = 0;
+    size_t i = 0;
+    for (; i < length && i < 8; ++i) {
+        const char c = line[i];
+        if (c == ' ' || c == '\t' || c == ',' || c == '*' || c == '\r') {
+            break;
+        }
+        name |= (unsigned long long)(unsigned char)Scanner::toUpper(c) << (56 - 8 * i);
+    }
+    return name;
+}
+
+static string unpackName(const unsigned long long name)
+{
+    string text;
+    for (int i = 0; i < 8; ++i) {
+        const char c = (char)(name >> (56 - 8 * i));
+        if (c == '\0') {
+            break;
+        }
+        text += c;
+    }
+    return text;
+}
+
+static inline const char* nextLine(const char *p, const char *end)
+{
+    const char *lineEnd = Scanner::findLineEnd(p, end);
+    return (lineEnd < end) ? lineEnd + 1 : end;
+}
+
+static inline size_t lineLength(const char *p, const char *end)
+{
+    const char *lineEnd = Scanner::findLineEnd(p, end);
+    if (lineEnd > p && *(lineEnd - 1) == '\r') {
+        --lineEnd;
+    }
+    return (size_t)(lineEnd - p);
+}
+
+/*! \brief Appends to \a fields the normalized fields of the card that starts
+ *         at \a begin, and returns the start of the line after the card.
+ *         The blank fields, the name and the continuation fields are skipped.
+ */
+static const char* normalizeCard(const char *begin, const char *end, Tokenizer &tokenizer,
+                                 vector<NormalizedField> *fields, int *lineCount)
+{
+    fields->clear();
+    int lineIndex = 0;
+    const char *line = begin;
+    size_t length = lineLength(line, end);
+    while (true) {
+        tokenizer.tokenize(line, length);
+        for (int j = 0; j < tokenizer.fieldCount(); ++j) {
+            const int number = Query::fieldNumber(lineIndex, j, tokenizer.isLargeField());
+            const FieldSpan &span = tokenizer.fieldAt(j);
+            if (number % 10 < 2 || span.length == 0) {
+                continue;
+            }
+            NormalizedField field;
+            field.number = number;
+            field.text = line + span.position;
+            field.length = span.length;
+            field.kind = Tokenizer::kindOf(field.text, field.length);
+
+            long long integer;
+            double real;
+            if (field.kind == Tokenizer::Kind::INTEGER
+                    && Query::parseInteger(field.text, field.length, &integer)) {
+                field.value = (unsigned long long)integer;
+            } else if (field.kind == Tokenizer::Kind::REAL
+                       && Tokenizer::parseNumber(field.text, field.length, &real)) {
+                if (real == 0.) {
+                    real = 0.; // -0.0 == 0.0
+                }
+                memcpy(&field.value, &real, sizeof(real));
+            } else {
+                field.kind = Tokenizer::Kind::WORD;
+                field.value = hashText(field.text, field.length);
+            }
+            fields->push_back(field);
+        }
+        ++lineIndex;
+        line = nextLine(line, end);
+        if (line >= end) {
+            break;
+        }
+        length = lineLength(line, end);
+        if (!Tokenizer::isContinuation(line, length)) {
+            break;
+        }
+    }
+    if (lineCount) {
+        (*lineCount) = lineIndex;
+    }
+    return line;
+}
+
+/*! \brief Appends to \a records the Bulk Data entries of the \a buffer,
+ *         that has the given \a position in its list.
+ */
+static void parseBuffer(const TextBuffer &buffer, const unsigned int position,
+                        Tokenizer &tokenizer, vector<NormalizedField> &fields,
+                        vector<CardRecord> *records)
+{
+    bool bulk = true; /* An included file often contains Bulk Data only */
+    int lineNumber = 1;
+    const char *p = buffer.begin;
+    while (p < buffer.end) {
+        const size_t length = lineLength(p, buffer.end);
+
+        if (Tokenizer::isBeginBulk(p, length)) {
+            bulk = true;
+        } else if (Tokenizer::isControlStatement(p, length)) {
+            bulk = false;
+        }
+        const unsigned long long name = (bulk && length > 0 && p[0] != '$')
+                ? packName(p, length) : 0;
+        if (name == 0 || Tokenizer::isContinuation(p, length)) {
+            p = nextLine(p, buffer.end);
+            ++lineNumber;
+            continue;
+        }
+
+        int lineCount = 1;
+        const char *next = normalizeCard(p, buffer.end, tokenizer, &fields, &lineCount);
+
+        if (!fields.empty() && fields.front().number == 2
+                && fields.front().kind == Tokenizer::Kind::INTEGER) {
+            CardRecord record;
+            record.name = name;
+            record.id = (long long)fields.front().value;
+            record.offset = (size_t)(p - buffer.begin);
+            record.buffer = position;
+            record.lineNumber = (unsigned int)lineNumber;
+
+            unsigned long long fingerprint = name;
+            for (size_t i = 1; i < fields.size(); ++i) {
+                const NormalizedField &field = fields[i];
+                fingerprint = mix(fingerprint ^ ((unsigned long long)field.number << 2
+                                                 | (unsigned long long)field.kind));
+                fingerprint = mix(fingerprint ^ field.value);
+            }
+            record.fingerprint = fingerprint;
+            records->push_back(record);
+        }
+        p = next;
+        lineNumber += lineCount;
+    }
+}
+
+/*! \brief Returns the entry of the card \a first of the first model and
+ *         the card \a second of the second model. One of them can be NULL.
+ */
+static ModelDiff::Entry makeEntry(const ModelDiff::Change change,
+                                  const CardRecord *first, const CardRecord *second)
+{
+    const CardRecord *record = first ? first : second;
+    ModelDiff::Entry entry;
+    entry.change = change;
+    entry.card = unpackName(record->name);
+    entry.id = record->id;
+    entry.firstFile = first ? (int)first->buffer : -1;
+    entry.first.offset = first ? first->offset : 0;
+    entry.first.lineNumber = first ? (int)first->lineNumber : 0;
+    entry.secondFile = second ? (int)second->buffer : -1;
+    entry.second.offset = second ? second->offset : 0;
+    entry.second.lineNumber = second ? (int)second->lineNumber : 0;
+    return entry;
+}
+
+/*! \brief Returns true if both normalized fields have the same value.
+ */
+static inline bool isEqual(const NormalizedField &a, const NormalizedField &b)
+{
+    return a.kind == b.kind && a.value == b.value;
+}
+
+/*! \brief Constructor.
+ */
+ModelDiff::ModelDiff()
+{
+    this->clear();
+}
+
+void ModelDiff::clear()
+{
+    vector<Entry>().swap(m_entries);
+    m_cardCounts[0] = 0;
+    m_cardCounts[1] = 0;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Compares the entities of the \a firstBuffers and the \a secondBuffers,
+ *         with \a threadCount threads (0 means one per processor).
+ */
+void ModelDiff::compare(const vector<TextBuffer> &firstBuffers,
+                        const vector<TextBuffer> &secondBuffers,
+                        int threadCount)
+{
+    this->clear();
+
+    /* Parse all the buffers of both models in parallel */
+    const size_t firstCount = firstBuffers.size();
+    const size_t bufferCount = firstCount + secondBuffers.size();
+    vector< vector<CardRecord> > parsed(bufferCount);
+
+    if (threadCount <= 0) {
+        threadCount = (int)thread::hardware_concurrency();
+    }
+    threadCount = max(1, min(threadCount, (int)bufferCount));
+
+    atomic<size_t> nextBuffer(0);
+    auto parse = [&]() {
+        Tokenizer tokenizer;
+        vector<NormalizedField> fields;
+        for (size_t i = nextBuffer++; i < bufferCount; i = nextBuffer++) {
+            const bool isFirst = i < firstCount;
+            const TextBuffer &buffer = isFirst ? firstBuffers[i] : secondBuffers[i - firstCount];
+            const unsigned int position = (unsigned int)(isFirst ? i : i - firstCount);
+            parseBuffer(buffer, position, tokenizer, fields, &parsed[i]);
+        }
+    };
+    vector<thread> workers;
+    for (int t = 1; t < threadCount; ++t) {
+        workers.push_back(thread(parse));
+    }
+    parse();
+    for (vector<thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+        it->join();
+    }
+    workers.clear();
+
+    /* Sort the cards of each model by name and ID */
+    vector<CardRecord> records[2];
+    auto gather = [&](const int m) {
+        const size_t first = (m == 0) ? 0 : firstCount;
+        const size_t last = (m == 0) ? firstCount : bufferCount;
+        size_t size = 0;
+        for (size_t i = first; i < last; ++i) {
+            size += parsed[i].size();
+        }
+        records[m].reserve(size);
+        for (size_t i = first; i < last; ++i) {
+            records[m].insert(records[m].end(), parsed[i].begin(), parsed[i].end());
+            vector<CardRecord>().swap(parsed[i]);
+        }
+        sort(records[m].begin(), records[m].end(), lessThan);
+    };
+    if (threadCount > 1) {
+        workers.push_back(thread(gather, 1));
+        gather(0);
+        workers.back().join();
+    } else {
+        gather(0);
+        gather(1);
+    }
+    m_cardCounts[0] = records[0].size();
+    m_cardCounts[1] = records[1].size();
+
+    /* Merge the cards by name and ID. The cards with the same name and ID
+       (e.g. the SPC1 or the FORCE of a set) are first paired when they are
+       identical, whatever their order. The others are paired in the order
+       of the models, and the remaining ones are REMOVED or ADDED. */
+    const vector<CardRecord> &a = records[0];
+    const vector<CardRecord> &b = records[1];
+    vector<CardRecord> removed;
+    vector<CardRecord> added;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.size() || j < b.size()) {
+        removed.clear();
+        added.clear();
+        if (j == b.size() || (i < a.size() && isKeyLess(a[i], b[j]))) {
+            removed.push_back(a[i]);
+            ++i;
+        } else if (i == a.size() || isKeyLess(b[j], a[i])) {
+            added.push_back(b[j]);
+            ++j;
+        } else {
+            /* Same key, sorted by fingerprint in both models */
+            const CardRecord key = a[i];
+            while (true) {
+                const bool hasFirst = (i < a.size() && !isKeyLess(key, a[i]));
+                const bool hasSecond = (j < b.size() && !isKeyLess(key, b[j]));
+                if (hasFirst && hasSecond && a[i].fingerprint == b[j].fingerprint) {
+                    ++i;
+                    ++j;
+                } else if (hasFirst && (!hasSecond || a[i].fingerprint < b[j].fingerprint)) {
+                    removed.push_back(a[i]);
+                    ++i;
+                } else if (hasSecond) {
+                    added.push_back(b[j]);
+                    ++j;
+                } else {
+                    break;
+                }
+            }
+            sort(removed.begin(), removed.end(), isBefore);
+            sort(added.begin(), added.end(), isBefore);
+        }
+        const size_t pairCount = min(removed.size(), added.size());
+        for (size_t k = 0; k < removed.size(); ++k) {
+            m_entries.push_back(k < pairCount
+                                ? makeEntry(Change::CHANGED, &removed[k], &added[k])
+                                : makeEntry(Change::REMOVED, &removed[k], NULL));
+        }
+        for (size_t k = pairCount; k < added.size(); ++k) {
+            m_entries.push_back(makeEntry(Change::ADDED, NULL, &added[k]));
+        }
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the number of entities with the given \a change.
+ */
+size_t ModelDiff::count(const Change change) const
+{
+    size_t n = 0;
+    for (vector<Entry>::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (it->change == change) {
+            ++n;
+        }
+    }
+    return n;
+}
+
+/*! \brief Returns the fields that differ between the card that starts at
+ *         \a first and the one that starts at \a second.
+ * The \a firstEnd and \a secondEnd are the ends of their buffers.
+ */
+vector<ModelDiff::FieldChange> ModelDiff::fieldChanges(const char *first, const char *firstEnd,
+                                                       const char *second, const char *secondEnd)
+{
+    Tokenizer tokenizer;
+    vector<NormalizedField> a;
+    vector<NormalizedField> b;
+    normalizeCard(first, firstEnd, tokenizer, &a, NULL);
+    normalizeCard(second, secondEnd, tokenizer, &b, NULL);
+
+    vector<FieldChange> changes;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.size() || j < b.size()) {
+        FieldChange change;
+        if (j == b.size() || (i < a.size() && a[i].number < b[j].number)) {
+            change.number = a[i].number;
+            change.before.assign(a[i].text, a[i].length);
+            ++i;
+        } else if (i == a.size() || b[j].number < a[i].number) {
+            change.number = b[j].number;
+            change.after.assign(b[j].text, b[j].length);
+            ++j;
+        } else {
+            const bool equal = isEqual(a[i], b[j]);
+            change.number = a[i].number;
+            change.before.assign(a[i].text, a[i].length);
+            change.after.assign(b[j].text, b[j].length);
+            ++i;
+            ++j;
+            if (equal) {
+                continue;
+            }
+        }
+        changes.push_back(change);
+    }
+    return changes;
+}
@@ -0,0 +1,78 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MODEL_DIFF_H
+#define MODEL_DIFF_H
+
+#include "entityindex.h"
+#include "scanner.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class ModelDiff
+{
+public:
+    enum class Change {
+        REMOVED,    ///< Only in the first model
+        ADDED,      ///< Only in the second model
+        CHANGED     ///< In both models, with different values
+    };
+
+    /* An entity, identified by its card name and its ID, e.g. CQUAD4 12 */
+    struct Entry
+    {
+        Change change;
+        std::string card;
+        long long id;
+        int firstFile;              ///< Position in the first list, or -1
+        EntityLocation first;
+        int secondFile;             ///< Position in the second list, or -1
+        EntityLocation second;
+    };
+
+    /* A field of a changed entity, numbered as in the small field format */
+    struct FieldChange
+    {
+        int number;
+        std::string before;         ///< Empty if the field is blank
+        std::string after;
+    };
+
+    explicit ModelDiff();
+
+    void clear();
+
+    /* Compare the buffers of the files of two include trees */
+    void compare(const std::vector<TextBuffer> &firstBuffers,
+                 const std::vector<TextBuffer> &secondBuffers,
+                 int threadCount = 0);
+
+    const std::vector<Entry>& entries() const { return m_entries; }
+    std::size_t count(const Change change) const;
+    std::size_t cardCount(const int model) const { return m_cardCounts[model]; }
+
+    /* Fields that differ, between the first and the second definition */
+    static std::vector<FieldChange> fieldChanges(const char *first, const char *firstEnd,
+                                                 const char *second, const char *secondEnd);
+
+private:
+    std::vector<Entry> m_entries;
+    std::size_t m_cardCounts[2];
+};
+
+#endif // MODEL_DIFF_H
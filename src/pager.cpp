@@ -0,0 +1,145 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "pager.h"
+
+#include "tokenizer.h"
+
+#include <algorithm> // min()
+
+using namespace std;
+
+/*! \class Pager
+ *  \brief The class Pager shows the lines of a file around a result:
+ *         the card found, with its continuation lines, and the lines
+ *         before and after it.
+ *
+ * The lines are read from the mapped file, at the offsets given by the
+ * line index built during the scan. Hence a page of a huge file is shown
+ * at once, whatever its position, without copying or reading the file
+ * again.
+ *
+ * The pager keeps the name of the file only, not the mapped buffer:
+ * the buffer is given again for each page, because the file can be
+ * reloaded in the meantime.
+ */
+
+/*! \brief Constructor.
+ */
+Pager::Pager()
+    : m_cardFirstLine(0)
+    , m_cardLastLine(0)
+{
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Opens the card that starts at the line \a lineNumber (from 1)
+ *         of the \a buffer of the file \a fullFileName.
+ *
+ * The card ends at its last continuation line. A comment or a blank line
+ * has no continuation.
+ */
+void Pager::open(const string &fullFileName, const string &fileName,
+                 const TextBuffer &buffer, const LineIndex &index,
+                 const size_t lineNumber)
+{
+    m_fullFileName = fullFileName;
+    m_fileName = fileName;
+    m_cardFirstLine = lineNumber;
+    m_cardLastLine = lineNumber;
+
+    const vector<TextBuffer> parent = lines(buffer, index, lineNumber, 1);
+    if (parent.empty()) {
+        return;
+    }
+    const TextBuffer& line = parent.front();
+    if (line.begin == line.end || line.begin[0] == '$') {
+        return;
+    }
+
+    const char *p = line.end;
+    while (p < buffer.end) {
+        p = Scanner::findLineEnd(p, buffer.end) + 1; /* next line */
+        if (p >= buffer.end) {
+            break;
+        }
+        const char *lineEnd = Scanner::findLineEnd(p, buffer.end);
+        size_t length = (size_t)(lineEnd - p);
+        if (length > 0 && p[length - 1] == '\r') {
+            --length;
+        }
+        if (!Tokenizer::isContinuation(p, length)) {
+            break;
+        }
+        ++m_cardLastLine;
+        p = lineEnd;
+    }
+}
+
+void Pager::close()
+{
+    m_fullFileName.clear();
+    m_fileName.clear();
+    m_cardFirstLine = 0;
+    m_cardLastLine = 0;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+bool Pager::isCardLine(const size_t lineNumber) const
+{
+    return lineNumber >= m_cardFirstLine && lineNumber <= m_cardLastLine;
+}
+
+/*! \brief Returns the first line to show, i.e. \a contextLineCount lines
+ *         before the card, but not before the first line of the file.
+ */
+size_t Pager::firstLine(const size_t contextLineCount) const
+{
+    return (m_cardFirstLine > contextLineCount) ? m_cardFirstLine - contextLineCount : 1;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns at most \a count lines of the \a buffer, from the line
+ *         \a firstLine (from 1).
+ *
+ * The lines point into the buffer, without their line ending (LF or CRLF).
+ * Only the offset of the first line is looked up in the \a index, the
+ * following ones are found while walking the buffer.
+ */
+vector<TextBuffer> Pager::lines(const TextBuffer &buffer, const LineIndex &index,
+                                const size_t firstLine, const size_t count)
+{
+    vector<TextBuffer> lines;
+    if (firstLine == 0 || firstLine > index.lineCount()) {
+        return lines;
+    }
+    const size_t lineCount = min(count, index.lineCount() - firstLine + 1);
+    lines.reserve(lineCount);
+
+    const char *p = buffer.begin + index.lineOffset(buffer.begin, buffer.end, firstLine);
+    while (lines.size() < lineCount && p < buffer.end) {
+        const char *lineEnd = Scanner::findLineEnd(p, buffer.end);
+        TextBuffer line = { p, lineEnd };
+        if (line.end > line.begin && line.end[-1] == '\r') {
+            --line.end;
+        }
+        lines.push_back(line);
+        p = lineEnd + 1;
+    }
+    return lines;
+}
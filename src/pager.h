@@ -0,0 +1,62 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PAGER_H
+#define PAGER_H
+
+#include "lineindex.h"
+#include "scanner.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class Pager
+{
+public:
+    explicit Pager();
+
+    /* Open the card of the line \a lineNumber of a mapped file */
+    void open(const std::string &fullFileName, const std::string &fileName,
+              const TextBuffer &buffer, const LineIndex &index,
+              const std::size_t lineNumber);
+    void close();
+
+    bool isOpen() const { return !m_fullFileName.empty(); }
+
+    const std::string& fullFileName() const { return m_fullFileName; }
+    const std::string& fileName() const { return m_fileName; }
+
+    /* Parent line and last continuation line of the card */
+    std::size_t cardFirstLine() const { return m_cardFirstLine; }
+    std::size_t cardLastLine() const { return m_cardLastLine; }
+    bool isCardLine(const std::size_t lineNumber) const;
+
+    /* First line shown, to show the card with some lines before it */
+    std::size_t firstLine(const std::size_t contextLineCount) const;
+
+    /* Lines of the buffer, without their line ending, not copied */
+    static std::vector<TextBuffer> lines(const TextBuffer &buffer, const LineIndex &index,
+                                         const std::size_t firstLine, const std::size_t count);
+
+private:
+    std::string m_fullFileName;
+    std::string m_fileName;
+    std::size_t m_cardFirstLine;
+    std::size_t m_cardLastLine;
+};
+
+#endif // PAGER_H
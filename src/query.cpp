@@ -0,0 +1,540 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "query.h"
+
+#include "scanner.h"
+#include "tokenizer.h"
+
+#include <math.h>   // fabs()
+#include <stdlib.h> // strtol()
+#include <string.h> // memchr()
+
+using namespace std;
+
+/*! \class Query
+ *  \brief The class Query parses the text typed in the search box.
+ *
+ * By default, the text is searched as is, anywhere in the lines.
+ *
+ * If the text is only made of KEY=VALUE terms, the search is restricted
+ * to the fields of the cards:
+ *  \li CARD=name  : only the cards of the given name, e.g. CQUAD4
+ *  \li FIELD=n    : only the field n, where 1 is the card name, 2..9 are
+ *                   the data fields of the first line, 12..19 the data
+ *                   fields of the first continuation, etc.
+ *  \li VALUE=text : the field is exactly the given text (case insensitive).
+ *                   Without FIELD, any data field can match.
+ *  \li INT=n      : the field is the integer n, e.g. '1001', '01001' or '+1001'
+ *                   but not '10010' or '1001.'.
+ *  \li REAL=x     : the field is a real equal to x, in any notation, e.g.
+ *                   REAL=1.0 matches '1.', '1.0E0', '1+0', '.1+1' or '1.0D0'.
+ *  \li TOL=t      : with REAL, the absolute tolerance of the comparison.
+ *  \li ID=a..b    : the ID of the card, i.e. its field 2, is between a and b
+ *                   (included). ID=a is the same as ID=a..a.
+ *
+ * Alone, INT=n matches the integer n as a whole token anywhere in the lines,
+ * i.e. not inside a longer number, a word or a real number.
+ *
+ * Example:
+ * \code
+ *   CARD=CQUAD4 FIELD=2 VALUE=1001   // the element CQUAD4 1001
+ *   VALUE=1001                       // every field equal to 1001
+ *   CARD=PSHELL                      // every PSHELL card
+ *   INT=1001                         // 1001, but not 10010 or 21001
+ *   CARD=MAT1 FIELD=3 REAL=2.1E5     // the Young modulus 2.1+5
+ *   REAL=0.5 TOL=1e-6                // every real field equal to 0.5
+ *   CARD=CQUAD4 ID=2000000..2099999  // the CQUAD4 of a subassembly
+ * \endcode
+ *
+ * A large field card is addressed like the equivalent small field card.
+ */
+
+static inline bool iequals(const char *text, const size_t length, const string &other)
+{
+    if (length != other.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        if (Scanner::toUpper(text[i]) != Scanner::toUpper(other[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*! \brief Returns true if the char \a c can be part of a number or a word.
+ */
+static inline bool isTokenChar(const char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')
+            || c == '.' || c == '+' || c == '-';
+}
+
+/*! \brief Returns true if \a pos is on a field boundary of the fixed format
+ *         line that contains it, e.g. '1001' in '    1001-1.5    '.
+ */
+static bool isFieldBoundary(const char *begin, const char *end, const char *pos)
+{
+    const char *line = pos;
+    while (line > begin && line[-1] != '\n') {
+        --line;
+    }
+    const size_t length = (size_t)(Scanner::findLineEnd(pos, end) - line);
+    if (memchr(line, ',', length)) {
+        return false; /* free field: the commas are the only delimiters */
+    }
+    const size_t nameLength = Tokenizer::columnOffset(line, length, 8);
+    const bool isLargeField = memchr(line, '*', nameLength) != NULL;
+
+    size_t column = 0;
+    for (const char *p = line; p < pos; ++p) {
+        column = (*p == '\t') ? (column / 8 + 1) * 8 : column + 1;
+    }
+    if (column < 8 || column > 72) {
+        return column == 8 || column == 72;
+    }
+    return (column - 8) % (isLargeField ? 16 : 8) == 0;
+}
+
+static inline string toUpper(const string &text)
+{
+    string ret(text);
+    for (string::size_type i = 0; i < ret.size(); ++i) {
+        ret[i] = Scanner::toUpper(ret[i]);
+    }
+    return ret;
+}
+
+/*! \brief Constructor.
+ */
+Query::Query()
+    : m_type(Type::TEXT)
+    , m_field(0)
+    , m_comparison(Comparison::TEXT)
+    , m_integer(0)
+    , m_real(0.)
+    , m_tolerance(0.)
+    , m_minimum(0)
+    , m_maximum(0)
+{
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Parses the given \a text.
+ *
+ * If the text is not a valid field query, the query is a plain text query.
+ */
+void Query::parse(const string &text)
+{
+    m_type = Type::TEXT;
+    m_text = text;
+    m_card.clear();
+    m_field = 0;
+    m_value.clear();
+    m_comparison = Comparison::TEXT;
+    m_integer = 0;
+    m_real = 0.;
+    m_tolerance = 0.;
+    m_minimum = 0;
+    m_maximum = 0;
+
+    string card;
+    int field = 0;
+    string value;
+    bool hasValue = false;
+    bool hasInteger = false;
+    long long integer = 0;
+    bool hasReal = false;
+    double real = 0.;
+    bool hasTolerance = false;
+    double tolerance = 0.;
+    bool hasRange = false;
+    long long minimum = 0;
+    long long maximum = 0;
+    bool hasTerm = false;
+
+    string::size_type pos = 0;
+    while (pos < text.size()) {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t')) {
+            ++pos;
+        }
+        if (pos >= text.size()) {
+            break;
+        }
+        string::size_type next = pos;
+        while (next < text.size() && text[next] != ' ' && text[next] != '\t') {
+            ++next;
+        }
+        const string term = text.substr(pos, next - pos);
+        pos = next;
+
+        const string::size_type equal = term.find('=');
+        if (equal == string::npos || equal == 0 || equal + 1 == term.size()) {
+            return; // not a KEY=VALUE term
+        }
+        const string key = toUpper(term.substr(0, equal));
+        const string arg = term.substr(equal + 1);
+
+        if (key == "CARD") {
+            card = toUpper(arg);
+        } else if (key == "FIELD") {
+            char *end = NULL;
+            const long number = strtol(arg.c_str(), &end, 10);
+            if (*end != '\0' || number < 1 || number > 1000000) {
+                return;
+            }
+            field = (int)number;
+        } else if (key == "VALUE") {
+            value = arg;
+            hasValue = true;
+        } else if (key == "INT") {
+            if (!parseInteger(arg.data(), arg.size(), &integer)) {
+                return;
+            }
+            hasInteger = true;
+        } else if (key == "REAL") {
+            if (!Tokenizer::parseNumber(arg.data(), arg.size(), &real)) {
+                return;
+            }
+            value = arg;
+            hasReal = true;
+        } else if (key == "TOL") {
+            if (!Tokenizer::parseNumber(arg.data(), arg.size(), &tolerance) || tolerance < 0.) {
+                return;
+            }
+            hasTolerance = true;
+        } else if (key == "ID") {
+            const string::size_type dots = arg.find("..");
+            const string first = arg.substr(0, dots);
+            const string last = (dots == string::npos) ? first : arg.substr(dots + 2);
+            if (!parseInteger(first.data(), first.size(), &minimum)
+                    || !parseInteger(last.data(), last.size(), &maximum)
+                    || minimum > maximum) {
+                return;
+            }
+            hasRange = true;
+        } else {
+            return; // unknown key, e.g. 'DISP=ALL'
+        }
+        hasTerm = true;
+    }
+
+    const int valueCount = (hasValue ? 1 : 0) + (hasInteger ? 1 : 0) + (hasReal ? 1 : 0);
+    if (!hasTerm || valueCount > 1 || (field > 0 && valueCount == 0)
+            || (hasTolerance && !hasReal)) {
+        return;
+    }
+    if (hasRange) {
+        if (valueCount > 0 || field > 0) {
+            return; // the range is the value of the field 2
+        }
+        field = 2;
+    }
+    if (hasInteger) {
+        const unsigned long long magnitude = integer < 0
+                ? 0ULL - (unsigned long long)integer
+                : (unsigned long long)integer;
+        value = to_string(magnitude);
+    }
+    const bool isTokenSearch = hasInteger && card.empty() && field == 0;
+    m_type = isTokenSearch ? Type::INTEGER : Type::FIELD;
+    m_card = card;
+    m_field = field;
+    m_value = value;
+    m_comparison = hasInteger ? Comparison::INTEGER
+                              : hasReal ? Comparison::REAL
+                                        : hasRange ? Comparison::RANGE : Comparison::TEXT;
+    m_integer = integer;
+    m_real = real;
+    m_tolerance = tolerance;
+    m_minimum = minimum;
+    m_maximum = maximum;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the texts, in upper case, that a file must contain
+ *         to match the query, e.g. the card name and the value of a field.
+ *
+ * A real can be written in many ways, and an ID range is not a text:
+ * they don't give any term. A blank text matches every line.
+ */
+vector<string> Query::terms() const
+{
+    vector<string> terms;
+    switch (m_type) {
+    case Type::TEXT:
+        if (m_text.find_first_not_of(" \t") != string::npos) {
+            terms.push_back(toUpper(m_text));
+        }
+        break;
+    case Type::INTEGER:
+        terms.push_back(m_value);
+        break;
+    case Type::FIELD:
+        if (!m_card.empty()) {
+            terms.push_back(m_card);
+        }
+        if (!m_value.empty()
+                && (m_comparison == Comparison::TEXT || m_comparison == Comparison::INTEGER)) {
+            terms.push_back(toUpper(m_value));
+        }
+        break;
+    default:
+        break;
+    }
+    return terms;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the number of fields of the card [\a begin, \a end)
+ *         that match the query.
+ *
+ * The card is made of a parent line, followed by its continuation lines.
+ * The \a tokenizer is only used as a buffer.
+ *
+ * A query without VALUE returns 1 if the card has the given name.
+ * An INT query alone returns the number of integer tokens in the card.
+ */
+size_t Query::match(const char *begin, const char *end, Tokenizer &tokenizer) const
+{
+    if (m_type == Type::TEXT || begin >= end) {
+        return 0;
+    }
+    if (m_type == Type::INTEGER) {
+        return countIntegers(begin, end);
+    }
+    if (!m_card.empty() && !matchesCard(begin, (size_t)(Scanner::findLineEnd(begin, end) - begin))) {
+        return 0;
+    }
+    if (m_comparison == Comparison::TEXT && m_value.empty()) {
+        return 1;
+    }
+
+    /* Fast rejection, before splitting the fields */
+    /* (a real can be written in many ways)        */
+    if (!m_value.empty() && m_comparison != Comparison::REAL
+            && !Scanner::find(begin, end, m_value.data(), m_value.size())) {
+        return 0;
+    }
+
+    size_t count = 0;
+    int lineIndex = 0;
+    const char *p = begin;
+    while (true) {
+        const char *lineEnd = Scanner::findLineEnd(p, end);
+        tokenizer.tokenize(p, (size_t)(lineEnd - p));
+
+        for (int j = 0; j < tokenizer.fieldCount(); ++j) {
+            const int number = fieldNumber(lineIndex, j, tokenizer.isLargeField());
+            if (m_field > 0) {
+                if (number != m_field) {
+                    continue;
+                }
+            } else if (number % 10 < 2) {
+                continue; // card name, or continuation field
+            }
+            const FieldSpan &span = tokenizer.fieldAt(j);
+            if (matchesValue(p + span.position, span.length)) {
+                ++count;
+            }
+        }
+        if (lineEnd == end) {
+            break;
+        }
+        /* The next lines can't contain the queried field */
+        const int nextLine = tokenizer.isLargeField() ? (lineIndex + 1) / 2 : lineIndex + 1;
+        if (m_field > 0 && nextLine * 10 + 1 > m_field) {
+            break;
+        }
+        p = lineEnd + 1;
+        ++lineIndex;
+    }
+    return count;
+}
+
+/*! \brief Returns the number of the field at \a fieldIndex in the line at
+ *         \a lineIndex of a card, as in the small field format.
+ *
+ * The field 1 is the card name, 10 the continuation field, 11 the first field
+ * of the first continuation line, etc. The number is 0 if the field has no
+ * equivalent, i.e. the continuation fields between the two physical lines of
+ * a large field line.
+ */
+int Query::fieldNumber(const int lineIndex, const int fieldIndex, const bool isLargeField)
+{
+    if (!isLargeField) {
+        return lineIndex * 10 + fieldIndex + 1;
+    }
+    /* Two large field lines make one small field line */
+    const int line = lineIndex / 2;
+    const bool secondHalf = (lineIndex % 2) == 1;
+    if (fieldIndex == 0) {
+        return secondHalf ? 0 : line * 10 + 1;
+    }
+    if (fieldIndex >= 5) {
+        return secondHalf ? line * 10 + 10 : 0;
+    }
+    return line * 10 + fieldIndex + (secondHalf ? 5 : 1);
+}
+
+/*! \brief Parses the integer in \a text, made of an optional sign
+ *         and digits only, e.g. '1001', '+01001' or '-5'.
+ * Returns false if the text is not an integer, or if it overflows.
+ */
+bool Query::parseInteger(const char *text, const size_t length, long long *value)
+{
+    size_t i = 0;
+    bool negative = false;
+    if (i < length && (text[i] == '+' || text[i] == '-')) {
+        negative = (text[i] == '-');
+        ++i;
+    }
+    if (i == length) {
+        return false;
+    }
+    unsigned long long magnitude = 0;
+    for (; i < length; ++i) {
+        const char c = text[i];
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        if (magnitude > 922337203685477580ULL) { // (LLONG_MAX - 9) / 10
+            return false;
+        }
+        magnitude = magnitude * 10 + (unsigned long long)(c - '0');
+    }
+    if (magnitude > 9223372036854775807ULL) {
+        return false;
+    }
+    (*value) = negative ? -(long long)magnitude : (long long)magnitude;
+    return true;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns true if the \a line starts with the queried card name,
+ *         in any format, e.g. 'GRID', 'GRID*' or 'GRID,'.
+ */
+bool Query::matchesCard(const char *line, const size_t length) const
+{
+    const size_t n = m_card.size();
+    if (length < n) {
+        return false;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (Scanner::toUpper(line[i]) != m_card[i]) {
+            return false;
+        }
+    }
+    if (length == n) {
+        return true;
+    }
+    const char c = line[n];
+    return c == ' ' || c == '\t' || c == ',' || c == '*' || c == '\r';
+}
+
+bool Query::matchesValue(const char *text, const size_t length) const
+{
+    switch (m_comparison) {
+    case Comparison::INTEGER: {
+        long long value;
+        return parseInteger(text, length, &value) && value == m_integer;
+    }
+    case Comparison::REAL: {
+        double value;
+        return Tokenizer::kindOf(text, length) == Tokenizer::Kind::REAL
+                && Tokenizer::parseNumber(text, length, &value)
+                && fabs(value - m_real) <= m_tolerance;
+    }
+    case Comparison::RANGE: {
+        long long value;
+        return parseInteger(text, length, &value) && value >= m_minimum && value <= m_maximum;
+    }
+    case Comparison::TEXT:
+    default:
+        break;
+    }
+    return iequals(text, length, m_value);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the number of integer tokens equal to the queried integer
+ *         in the buffer [\a begin, \a end).
+ *
+ * The candidates are the occurrences of the digits, found by the scanner.
+ * Only their boundaries are checked, so it's as fast as Scanner::count().
+ *
+ * If \a lineCount is not null, it receives the number of lines
+ * that contain at least one token.
+ */
+size_t Query::countIntegers(const char *begin, const char *end, size_t *lineCount) const
+{
+    size_t count = 0;
+    size_t lines = 0;
+    const char *lineEnd = NULL;
+
+    const char *p = begin;
+    while ((p = Scanner::find(p, end, m_value.data(), m_value.size())) != NULL) {
+        if (isIntegerAt(begin, end, p)) {
+            ++count;
+            if (lineCount && (lineEnd == NULL || p > lineEnd)) {
+                ++lines;
+                lineEnd = Scanner::findLineEnd(p, end);
+            }
+        }
+        p += m_value.size();
+    }
+    if (lineCount) {
+        (*lineCount) = lines;
+    }
+    return count;
+}
+
+/*! \brief Returns true if the queried \a digits, found in the buffer
+ *         [\a begin, \a end), make a whole integer token.
+ *
+ * The digits can follow leading zeros and a sign. The token must not be
+ * preceded or followed by a letter, a digit, a dot or a sign, except on
+ * a field boundary of a fixed format line.
+ */
+bool Query::isIntegerAt(const char *begin, const char *end, const char *digits) const
+{
+    const char *first = digits;
+    while (first > begin && first[-1] == '0') {
+        --first;
+    }
+    if (m_integer < 0) {
+        if (first == begin || first[-1] != '-') {
+            return false;
+        }
+        --first;
+    } else if (first > begin && first[-1] == '+') {
+        --first;
+    }
+    const char *last = digits + m_value.size();
+
+    const bool isBeginning = first == begin || !isTokenChar(first[-1])
+            || isFieldBoundary(begin, end, first);
+    if (!isBeginning) {
+        return false;
+    }
+    return last == end || !isTokenChar(*last) || isFieldBoundary(begin, end, last);
+}
@@ -0,0 +1,86 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUERY_H
+#define QUERY_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class Tokenizer;
+
+class Query
+{
+public:
+    enum class Type {
+        TEXT,       ///< Case insensitive text, anywhere in the line
+        FIELD,      ///< Exact value of a field, e.g. 'CARD=CQUAD4 FIELD=2 VALUE=1001'
+        INTEGER     ///< Whole integer token, anywhere in the line, e.g. 'INT=1001'
+    };
+
+    enum class Comparison {
+        TEXT,       ///< Same text, case insensitive, e.g. 'VALUE=ALL'
+        INTEGER,    ///< Same integer, e.g. 'INT=1001'
+        REAL,       ///< Same real number, within a tolerance, e.g. 'REAL=1.0 TOL=1e-6'
+        RANGE       ///< Integer between two bounds, e.g. 'ID=2000000..2099999'
+    };
+
+    explicit Query();
+
+    void parse(const std::string &text);
+
+    Type type() const { return m_type; }
+    const std::string& text() const { return m_text; }
+
+    const std::string& card() const { return m_card; }
+    int field() const { return m_field; }
+    const std::string& value() const { return m_value; }
+    Comparison comparison() const { return m_comparison; }
+    long long integer() const { return m_integer; }
+    double real() const { return m_real; }
+    double tolerance() const { return m_tolerance; }
+    long long minimum() const { return m_minimum; }
+    long long maximum() const { return m_maximum; }
+
+    std::vector<std::string> terms() const;
+
+    std::size_t match(const char *begin, const char *end, Tokenizer &tokenizer) const;
+    std::size_t countIntegers(const char *begin, const char *end,
+                              std::size_t *lineCount = 0) const;
+
+    static int fieldNumber(const int lineIndex, const int fieldIndex, const bool isLargeField);
+    static bool parseInteger(const char *text, const std::size_t length, long long *value);
+
+private:
+    Type m_type;
+    std::string m_text;
+    std::string m_card;     ///< empty means any card
+    int m_field;            ///< 0 means any field
+    std::string m_value;    ///< for an integer, the digits without sign and leading zeros
+    Comparison m_comparison;
+    long long m_integer;
+    double m_real;
+    double m_tolerance;
+    long long m_minimum;
+    long long m_maximum;
+
+    bool matchesCard(const char *line, const std::size_t length) const;
+    bool matchesValue(const char *text, const std::size_t length) const;
+    bool isIntegerAt(const char *begin, const char *end, const char *digits) const;
+};
+
+#endif // QUERY_H
@@ -17,6 +17,9 @@
 
 #include <iostream>
 #include <fstream>
+#include "filecache.h"
+#include "fileinfo.h"
+#include "fingerprint.h"
 #include "systemdetection.h"
 
 #if defined(Q_OS_WIN)
@@ -66,6 +69,23 @@ using namespace std;
  */
 RecentFile::RecentFile()
     : m_configFullFilename(std::string())
+{
+    const std::string path = configPath();
+    if( !path.empty() ){
+#if defined(Q_OS_WIN)
+        m_configFullFilename = path + std::string("\\Recent.ini");
+#else
+        m_configFullFilename = path + std::string("/recent.ini");
+#endif
+    }
+
+    read();
+}
+
+/*! \brief Returns the user's preferences directory of the application,
+ *         created if needed, or an empty string if not supported.
+ */
+std::string RecentFile::configPath()
 {
 #if defined(Q_OS_WIN)
 
@@ -82,7 +102,6 @@ RecentFile::RecentFile()
         /* ANSI */
         PathAppendA(szPath, "NastranFind");
         std::string path(szPath);
-        m_configFullFilename = path + std::string("\\Recent.ini");
 
         if ( !(CreateDirectoryA(path.c_str(), NULL)
                || GetLastError() == ERROR_ALREADY_EXISTS) ) {
@@ -92,19 +111,22 @@ RecentFile::RecentFile()
         /// \todo /* UNICODE */
         /// \todo PathAppendW(szPath, "NastranFind");
         /// \todo std::wstring path(szPath);
-        /// \todo m_configFullFilename = path + std::string("\\Recent.ini");
         /// \todo if ( !(CreateDirectoryW(path.c_str(), NULL)
         /// \todo        || GetLastError() == ERROR_ALREADY_EXISTS) ) {
         /// \todo     std::cout << "Failed to create directory '" << path << "'." << std::endl;
         /// \todo }
 
+        return path;
+
     } else {
         std::cout << "SHGetFolderPath() failed for standard location '%APPDATA%'." << std::endl;
     }
+    return std::string();
 
 #elif defined(Q_OS_MAC)
 
     /// \todo  "$HOME/Library/Preferences/com.NastranFind.plist"
+    return std::string();
 
 #elif defined(Q_OS_UNIX)
 
@@ -121,11 +143,25 @@ RecentFile::RecentFile()
             std::cout << "Failed to create directory '" << configpath << "'." << std::endl;
         }
     }
-    m_configFullFilename = configpath + std::string("/recent.ini");
+    return configpath;
 
 #endif
+}
 
-    read();
+/*! \brief Returns the file of the model \a fullFileName in the user's
+ *         preferences directory, named after the \a prefix, or an empty
+ *         string if not supported.
+ */
+std::string RecentFile::configFileName(const std::string &prefix,
+                                       const std::string &fullFileName)
+{
+    const std::string path = configPath();
+    if( path.empty() ){
+        return std::string();
+    }
+    const uint64_t key = FileCache::hash( fullFileName.data(),
+                                          fullFileName.data() + fullFileName.size() );
+    return FileInfo::concat( path, prefix + Fingerprint::toHex(key) + ".txt" );
 }
 
 RecentFile::~RecentFile()
@@ -32,6 +32,10 @@ public:
     int count() const;
     std::string at(const int index) const;
 
+    static std::string configPath();
+    static std::string configFileName(const std::string &prefix,
+                                      const std::string &fullFileName);
+
 protected:
     bool read();
     bool write();
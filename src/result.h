@@ -18,6 +18,7 @@
 #define RESULT_H
 
 #include <string>
+#include <utility>
 #include <vector>
 #include <map>
 
@@ -25,10 +26,25 @@ typedef std::vector<std::string> stringlist;
 class Result
 {
 public:
-    explicit Result() : occurrenceCount(0) {}
+    explicit Result() : occurrenceCount(0), hitCount(0), lineCount(0), spilledFirst(0), spilledCount(0) {}
 
     stringlist::size_type occurrenceCount;
     stringlist occurrences;
+
+    /* cards found, including the ones not built in preview mode */
+    stringlist::size_type hitCount;
+
+    /* lines of text of the occurrences, i.e. the parent lines */
+    /* and the continuation lines of the cards found           */
+    stringlist::size_type lineCount;
+
+    /* index of each occurrence with continuation lines, and the number */
+    /* of continuation lines up to this occurrence, included            */
+    std::vector<std::pair<stringlist::size_type, stringlist::size_type> > continuations;
+
+    /* occurrences stored in the spill file, following the ones in memory */
+    stringlist::size_type spilledFirst;
+    stringlist::size_type spilledCount;
 };
 
 typedef std::map<std::string, Result> ResultMap;
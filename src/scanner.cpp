@@ -0,0 +1,192 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scanner.h"
+
+#include <string.h> // memchr()
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define NF_HAVE_SSE2
+#  include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#  include <intrin.h> // _BitScanForward()
+#endif
+
+/*! \class Scanner
+ *  \brief The class Scanner contains the low-level text search routines,
+ *         that work directly on a memory buffer.
+ *
+ * The routines don't allocate any memory. When SSE2 is available, they
+ * compare 16 bytes at once: the search for a pattern first looks for the
+ * candidate positions of its first character (in upper and lower case),
+ * then verifies the remaining characters.
+ *
+ * \remark The comparison is *case insensitive*, for ASCII characters only,
+ * like StringHelper::findNext() with the default "C" locale.
+ */
+
+/******************************************************************************
+ ******************************************************************************/
+static inline int firstBit(const unsigned int mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+static inline int bitCount(unsigned int mask)
+{
+#if defined(_MSC_VER)
+    int count = 0;
+    while (mask) { mask &= mask - 1; ++count; }
+    return count;
+#else
+    return __builtin_popcount(mask);
+#endif
+}
+
+/*! \brief Returns true if the characters following the first one
+ *         match the \a pattern.
+ */
+static inline bool matchesAt(const char *p, const char *pattern, const std::size_t length)
+{
+    for (std::size_t i = 1; i < length; ++i) {
+        if (Scanner::toUpper(p[i]) != Scanner::toUpper(pattern[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns a pointer to the first occurrence of the \a pattern
+ *         in the buffer [\a begin, \a end), or NULL if not found.
+ */
+const char* Scanner::find(const char *begin, const char *end,
+                          const char *pattern, const std::size_t length)
+{
+    if (length == 0 || begin >= end || (std::size_t)(end - begin) < length) {
+        return NULL;
+    }
+    const char *last = end - length; // last possible start
+    const char upper = toUpper(pattern[0]);
+    const char lower = (upper >= 'A' && upper <= 'Z') ? (char)(upper - 'A' + 'a') : upper;
+
+    const char *p = begin;
+
+#ifdef NF_HAVE_SSE2
+    const __m128i upperBlock = _mm_set1_epi8(upper);
+    const __m128i lowerBlock = _mm_set1_epi8(lower);
+    while (last - p >= 15) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(
+                    _mm_or_si128(_mm_cmpeq_epi8(block, upperBlock),
+                                 _mm_cmpeq_epi8(block, lowerBlock)));
+        while (mask) {
+            const char *candidate = p + firstBit(mask);
+            if (matchesAt(candidate, pattern, length)) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+        p += 16;
+    }
+#endif
+
+    for (; p <= last; ++p) {
+        if ((*p == upper || *p == lower) && matchesAt(p, pattern, length)) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+/*! \brief Returns the number of (*no* overlapping) occurrences of the
+ *         \a pattern in the buffer [\a begin, \a end).
+ *
+ * If \a lineCount is not null, it receives the number of lines
+ * that contain at least one occurrence.
+ *
+ * \remark The \a pattern is assumed to not contain any line break.
+ */
+std::size_t Scanner::count(const char *begin, const char *end,
+                           const char *pattern, const std::size_t length,
+                           std::size_t *lineCount)
+{
+    std::size_t occurrences = 0;
+    std::size_t lines = 0;
+    const char *lineEnd = NULL;
+
+    const char *p = begin;
+    while ((p = find(p, end, pattern, length)) != NULL) {
+        ++occurrences;
+        if (lineCount && (lineEnd == NULL || p > lineEnd)) {
+            ++lines;
+            lineEnd = findLineEnd(p, end);
+        }
+        p += length;
+    }
+    if (lineCount) {
+        (*lineCount) = lines;
+    }
+    return occurrences;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns a pointer to the next line feed character in the buffer
+ *         [\a begin, \a end), or \a end if the buffer has no line feed.
+ */
+const char* Scanner::findLineEnd(const char *begin, const char *end)
+{
+    if (begin >= end) {
+        return end;
+    }
+    const void *p = memchr(begin, '\n', (std::size_t)(end - begin));
+    return p ? static_cast<const char*>(p) : end;
+}
+
+/*! \brief Returns the number of line feed characters in the buffer [\a begin, \a end).
+ */
+std::size_t Scanner::countLines(const char *begin, const char *end)
+{
+    std::size_t count = 0;
+    const char *p = begin;
+
+#ifdef NF_HAVE_SSE2
+    const __m128i lineFeed = _mm_set1_epi8('\n');
+    while (end - p >= 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, lineFeed));
+        count += bitCount(mask);
+        p += 16;
+    }
+#endif
+
+    for (; p < end; ++p) {
+        if (*p == '\n') {
+            ++count;
+        }
+    }
+    return count;
+}
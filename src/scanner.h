@@ -0,0 +1,49 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include <cstddef>
+
+/*! \brief Range of a buffer to parse, e.g. a mapped file.
+ */
+struct TextBuffer
+{
+    const char *begin;
+    const char *end;
+};
+
+class Scanner
+{
+public:
+    static const char* find(const char *begin, const char *end,
+                            const char *pattern, const std::size_t length);
+
+    static std::size_t count(const char *begin, const char *end,
+                             const char *pattern, const std::size_t length,
+                             std::size_t *lineCount = 0);
+
+    static const char* findLineEnd(const char *begin, const char *end);
+    static std::size_t countLines(const char *begin, const char *end);
+
+    static inline char toUpper(const char c)
+    {
+        return (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+    }
+};
+
+#endif // SCANNER_H
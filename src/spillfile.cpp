@@ -0,0 +1,156 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spillfile.h"
+
+#include "systemdetection.h"
+
+#if defined(Q_OS_UNIX)
+#  include <sys/mman.h> // mmap(), munmap()
+#endif
+
+using namespace std;
+
+/*! \class SpillFile
+ *  \brief The class SpillFile stores text records in an anonymous temporary file.
+ *
+ * The Engine uses it when the results exceed the memory budget:
+ * the records are appended at the end of the file, and read back
+ * on demand, when the user scrolls through the results.
+ *
+ * On Unix, the file is read through a memory-mapped view, so that
+ * reading a record doesn't copy more than the record itself.
+ * On other platforms, the record is read with a plain seek + read.
+ *
+ * The temporary file is deleted automatically when the SpillFile
+ * is cleared or destroyed.
+ */
+
+/*! \brief Constructor.
+ */
+SpillFile::SpillFile()
+    : m_file(NULL)
+    , m_offsets(1, 0)
+    , m_mapped(NULL)
+    , m_mappedSize(0)
+{
+}
+
+SpillFile::~SpillFile()
+{
+    this->clear();
+}
+
+/*! \brief Removes all the records and deletes the temporary file.
+ */
+void SpillFile::clear()
+{
+    unmap();
+    if (m_file) {
+        fclose(m_file); // tmpfile() is removed when closed
+        m_file = NULL;
+    }
+    m_offsets.assign(1, 0);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Appends the given \a record at the end of the file.
+ * Returns false if the temporary file cannot be created or written.
+ */
+bool SpillFile::append(const string &record)
+{
+    if (!m_file) {
+        m_file = tmpfile();
+        if (!m_file) {
+            return false;
+        }
+    }
+    if (!record.empty()) {
+        if (fwrite(record.data(), 1, record.size(), m_file) != record.size()) {
+            return false;
+        }
+    }
+    m_offsets.push_back(m_offsets.back() + record.size());
+    return true;
+}
+
+/*! \brief Returns the record at the given \a index.
+ * Returns an empty string if the index is out of range.
+ */
+string SpillFile::at(const size_type index) const
+{
+    if (!m_file || index >= count()) {
+        return string();
+    }
+    const offset_type begin = m_offsets[index];
+    const offset_type end = m_offsets[index + 1];
+
+    if (end > m_mappedSize) {
+        remap();
+    }
+    if (m_mapped && end <= m_mappedSize) {
+        return string(m_mapped + begin, (string::size_type)(end - begin));
+    }
+
+    /* Fallback: seek and read */
+    string record((string::size_type)(end - begin), '\0');
+    fflush(m_file);
+#if defined(Q_OS_WIN)
+    _fseeki64(m_file, (__int64)begin, SEEK_SET);
+#else
+    fseeko(m_file, (off_t)begin, SEEK_SET);
+#endif
+    const size_t read = fread(&record[0], 1, record.size(), m_file);
+    record.resize(read);
+    fseek(m_file, 0, SEEK_END);
+    return record;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Maps the whole file in memory. Returns true on success.
+ * The records appended after this call are not visible until the next remap.
+ */
+bool SpillFile::remap() const
+{
+#if defined(Q_OS_UNIX)
+    unmap();
+    if (!m_file || fflush(m_file) != 0 || fileSize() == 0) {
+        return false;
+    }
+    void *address = mmap(NULL, (size_t)fileSize(), PROT_READ, MAP_SHARED, fileno(m_file), 0);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+    m_mapped = static_cast<char*>(address);
+    m_mappedSize = fileSize();
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SpillFile::unmap() const
+{
+#if defined(Q_OS_UNIX)
+    if (m_mapped) {
+        munmap(m_mapped, (size_t)m_mappedSize);
+    }
+#endif
+    m_mapped = NULL;
+    m_mappedSize = 0;
+}
@@ -0,0 +1,59 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPILL_FILE_H
+#define SPILL_FILE_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+class SpillFile
+{
+public:
+    typedef unsigned long long offset_type;
+    typedef std::vector<offset_type>::size_type size_type;
+
+    explicit SpillFile();
+    ~SpillFile();
+
+    void clear();
+
+    bool append(const std::string &record);
+
+    size_type count() const { return m_offsets.size() - 1; }
+    std::string at(const size_type index) const;
+
+    offset_type fileSize() const { return m_offsets.back(); }
+
+private:
+    FILE *m_file;
+
+    /* start offset of each record, followed by the end of the file */
+    std::vector<offset_type> m_offsets;
+
+    /* read-only view of the file, remapped when the file grows */
+    mutable char *m_mapped;
+    mutable offset_type m_mappedSize;
+
+    bool remap() const;
+    void unmap() const;
+
+    SpillFile(const SpillFile &);            // not copyable
+    SpillFile& operator=(const SpillFile &); // not copyable
+};
+
+#endif // SPILL_FILE_H
@@ -18,6 +18,7 @@ CONFIG -= incremental_off
 CONFIG -= depend_includepath
 CONFIG -= windows # BUG: 'windows' prevents std::cout to write in the console.
 CONFIG += c++11
+CONFIG += thread # std::thread
 
 #message($${CONFIG})
 
@@ -48,22 +49,63 @@ include($$PWD/../version.pri)
 HEADERS  += \
     $$PWD/global.h \
     $$PWD/application.h \
+    $$PWD/batch.h \
+    $$PWD/compression.h \
+    $$PWD/crossreference.h \
     $$PWD/engine.h \
+    $$PWD/entityindex.h \
+    $$PWD/filecache.h \
     $$PWD/fileinfo.h \
+    $$PWD/filestats.h \
+    $$PWD/filewatcher.h \
+    $$PWD/fingerprint.h \
+    $$PWD/includetree.h \
+    $$PWD/lineindex.h \
+    $$PWD/mappedfile.h \
+    $$PWD/memorystats.h \
+    $$PWD/modeldiff.h \
+    $$PWD/pager.h \
+    $$PWD/query.h \
     $$PWD/recentfile.h \
     $$PWD/result.h \
+    $$PWD/scanner.h \
+    $$PWD/spillfile.h \
     $$PWD/stringhelper.h \
     $$PWD/systemdetection.h \
-    $$PWD/version.h
+    $$PWD/termindex.h \
+    $$PWD/tokenizer.h \
+    $$PWD/version.h \
+    $$PWD/ziparchive.h \
+    $$PWD/zonemap.h
 
 SOURCES += \
     $$PWD/main.cpp\
     $$PWD/application.cpp \
+    $$PWD/batch.cpp \
+    $$PWD/compression.cpp \
+    $$PWD/crossreference.cpp \
     $$PWD/engine.cpp \
+    $$PWD/entityindex.cpp \
+    $$PWD/filecache.cpp \
     $$PWD/fileinfo.cpp \
+    $$PWD/filewatcher.cpp \
+    $$PWD/fingerprint.cpp \
+    $$PWD/includetree.cpp \
+    $$PWD/lineindex.cpp \
+    $$PWD/mappedfile.cpp \
+    $$PWD/memorystats.cpp \
+    $$PWD/modeldiff.cpp \
+    $$PWD/pager.cpp \
+    $$PWD/query.cpp \
     $$PWD/recentfile.cpp \
     $$PWD/result.cpp \
-    $$PWD/stringhelper.cpp
+    $$PWD/scanner.cpp \
+    $$PWD/spillfile.cpp \
+    $$PWD/stringhelper.cpp \
+    $$PWD/termindex.cpp \
+    $$PWD/tokenizer.cpp \
+    $$PWD/ziparchive.cpp \
+    $$PWD/zonemap.cpp
 
 OTHER_FILES += \
     $$PWD/../README.md \
@@ -84,6 +126,8 @@ win32 {
     # Windows 32
     #-------------------------------------------------
     LIBS += -lShlwapi # PathAppend()
+    LIBS += -lPsapi   # GetProcessMemoryInfo()
+    LIBS += -lz       # gzip decompression (zlib)
 
     #-------------------------------------------------
     # PDCurses
@@ -132,6 +176,11 @@ unix {
     #-------------------------------------------------
     LIBS += -lncurses
 
+    #-------------------------------------------------
+    # Zlib (gzip decompression)
+    #-------------------------------------------------
+    LIBS += -lz
+
 }
 
 
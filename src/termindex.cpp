@@ -0,0 +1,443 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "termindex.h"
+
+#include "fingerprint.h"
+#include "scanner.h"
+#include "systemdetection.h"
+
+#include <fstream>
+#include <set>
+#include <stdio.h>  // sscanf(), rename(), remove()
+#include <stdlib.h> // strtoull()
+
+#if defined(Q_OS_WIN)
+#  include <process.h> // _getpid()
+#elif defined(Q_OS_UNIX)
+#  include <unistd.h>  // getpid()
+#endif
+
+using namespace std;
+
+static const char STR_HEADER[] = "# NASTRANFIND term index 2";
+
+/* Size of the filters: about 8 bits per distinct trigram, */
+/* for 3 bits set per trigram, i.e. ~3% of false positives  */
+static const size_t C_FILTER_MINIMUM_BITS = 512;
+static const size_t C_FILTER_MAXIMUM_BITS = size_t(1) << 21;
+static const size_t C_FILTER_BITS_PER_TRIGRAM = 8;
+
+/*! \class TermIndex
+ *  \brief The class TermIndex tells, without reading a file, if a searched
+ *         text can appear in it.
+ *
+ * Each file has a record made of its size and modification time, the
+ * INCLUDE statements it contains, and a Bloom filter of the trigrams
+ * (3 consecutive characters, in upper case) of its lines. A text is in the
+ * file only if all its trigrams are in the filter: when one is missing,
+ * the file can't match, and the search doesn't load it. Its includes are
+ * taken from the record, so the files below it are still searched.
+ *
+ * An occurrence can also cross the boundary between a line and its
+ * continuation: the trigrams of these boundaries are added to the filter.
+ *
+ * The filter can answer 'maybe' for a file that doesn't match (the file is
+ * then scanned as usual), but never 'no' for a file that matches.
+ *
+ * The records are saved and loaded between two runs, like the ones of
+ * the Fingerprint. A record is valid as long as the size and the
+ * modification time of its file didn't change, or, once validate() has
+ * checked them against the records of the Fingerprint, as long as its
+ * content hash didn't change. The file is replaced at once when it's
+ * saved, so two runs on the same model never read a partial file.
+ */
+
+/*! \brief Constructor.
+ */
+TermIndex::TermIndex()
+    : m_modified(false)
+{
+}
+
+void TermIndex::clear()
+{
+    m_records.clear();
+    m_modified = false;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+static inline uint32_t trigramAt(const char *p)
+{
+    return ((uint32_t)(unsigned char)Scanner::toUpper(p[0]) << 16)
+            | ((uint32_t)(unsigned char)Scanner::toUpper(p[1]) << 8)
+            | (uint32_t)(unsigned char)Scanner::toUpper(p[2]);
+}
+
+static inline uint64_t mix(uint64_t h)
+{
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    return h ^ (h >> 31);
+}
+
+/* The 3 bits of the trigram, in a filter of (64 * words.size()) bits */
+static inline void setTrigram(vector<uint64_t> &words, const uint32_t trigram)
+{
+    const uint64_t mask = (uint64_t)words.size() * 64 - 1;
+    const uint64_t h = mix(trigram);
+    for (int shift = 0; shift < 63; shift += 21) {
+        const uint64_t bit = (h >> shift) & mask;
+        words[bit >> 6] |= (1ULL << (bit & 63));
+    }
+}
+
+static inline bool hasTrigram(const vector<uint64_t> &words, const uint32_t trigram)
+{
+    const uint64_t mask = (uint64_t)words.size() * 64 - 1;
+    const uint64_t h = mix(trigram);
+    for (int shift = 0; shift < 63; shift += 21) {
+        const uint64_t bit = (h >> shift) & mask;
+        if (!(words[bit >> 6] & (1ULL << (bit & 63)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*! \brief Returns false if the file of the \a filter can't contain the \a term.
+ */
+static bool mayContainTerm(const vector<uint64_t> &filter, const string &term)
+{
+    for (size_t i = 0; i + 3 <= term.size(); ++i) {
+        if (!hasTrigram(filter, trigramAt(term.data() + i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Appends the distinct trigrams of [begin, end), that are not 'seen' yet */
+static void collect(const char *begin, const char *end,
+                    vector<uint64_t> &seen, vector<uint32_t> *trigrams)
+{
+    uint32_t trigram = 0;
+    int length = 0; /* characters since the line break */
+    for (const char *p = begin; p < end; ++p) {
+        const char c = (*p);
+        if (c == '\n' || c == '\r') {
+            length = 0;
+            continue;
+        }
+        trigram = ((trigram << 8) | (unsigned char)Scanner::toUpper(c)) & 0xFFFFFF;
+        if (++length < 3) {
+            continue;
+        }
+        uint64_t& word = seen[trigram >> 6];
+        const uint64_t bit = 1ULL << (trigram & 63);
+        if (!(word & bit)) {
+            word |= bit;
+            trigrams->push_back(trigram);
+        }
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the record of the file \a fullFileName, if its \a size and
+ *         \a modificationTime didn't change since it was recorded.
+ *         Otherwise, returns NULL.
+ */
+const TermIndex::Record* TermIndex::find(const string &fullFileName,
+                                         const size_t size,
+                                         const long long modificationTime) const
+{
+    const map<string, Record>::const_iterator it = m_records.find(fullFileName);
+    if (it != m_records.end()
+            && it->second.size == size
+            && it->second.modificationTime == modificationTime) {
+        return &it->second;
+    }
+    return NULL;
+}
+
+/*! \brief Records the content [\a begin, \a end) of the file \a fullFileName,
+ *         its \a contentHash, its \a lineCount and its \a includes.
+ *
+ * The \a joins are the lines of text where an occurrence can cross the
+ * boundary between a line and its continuation (see Engine::scan()).
+ */
+void TermIndex::update(const string &fullFileName,
+                       const size_t size, const long long modificationTime,
+                       const uint64_t contentHash,
+                       const char *begin, const char *end, const string &joins,
+                       const size_t lineCount,
+                       const vector<pair<int, string> > &includes)
+{
+    Record& record = m_records[fullFileName];
+    record.size = size;
+    record.modificationTime = modificationTime;
+    record.contentHash = contentHash;
+    record.lineCount = lineCount;
+    record.includes = includes;
+    this->buildFilter(begin, end, joins, &record.filter);
+    m_modified = true;
+}
+
+/*! \brief Checks the records against the ones of the \a fingerprint, that
+ *         were just computed for the model.
+ *
+ * A file whose content hash changed is removed. A file whose size or
+ * modification time changed, but not its content hash, e.g. a file saved
+ * again without change, gets its new status: it's still skipped. The
+ * records of the files that are not in the fingerprint are kept.
+ */
+void TermIndex::validate(const Fingerprint &fingerprint)
+{
+    const map<string, Fingerprint::Record>& status = fingerprint.records();
+    map<string, Record>::iterator it = m_records.begin();
+    while (it != m_records.end()) {
+        const map<string, Fingerprint::Record>::const_iterator other = status.find(it->first);
+        if (other == status.end()) {
+            ++it;
+        } else if (other->second.contentHash != it->second.contentHash) {
+            it = m_records.erase(it);
+            m_modified = true;
+        } else {
+            if (other->second.size != it->second.size
+                    || other->second.modificationTime != it->second.modificationTime) {
+                it->second.size = other->second.size;
+                it->second.modificationTime = other->second.modificationTime;
+                m_modified = true;
+            }
+            ++it;
+        }
+    }
+}
+
+/*! \brief Removes the records of the files that are not in \a fullFileNames,
+ *         e.g. the files no longer included by the model.
+ */
+void TermIndex::prune(const vector<string> &fullFileNames)
+{
+    const set<string> kept(fullFileNames.begin(), fullFileNames.end());
+    map<string, Record>::iterator it = m_records.begin();
+    while (it != m_records.end()) {
+        if (kept.count(it->first) == 0) {
+            it = m_records.erase(it);
+            m_modified = true;
+        } else {
+            ++it;
+        }
+    }
+}
+
+/*! \brief Builds the \a filter of the distinct trigrams of [\a begin, \a end)
+ *         and of the \a joins.
+ *
+ * The trigrams are first collected in a bitmap of all the possible ones,
+ * so the filter is sized for the number of distinct trigrams. Only the bits
+ * set are cleared afterwards: the bitmap is allocated once.
+ */
+void TermIndex::buildFilter(const char *begin, const char *end, const string &joins,
+                            vector<uint64_t> *filter)
+{
+    if (m_seen.empty()) {
+        m_seen.assign(size_t(1) << (24 - 6), 0);
+    }
+    vector<uint32_t> trigrams;
+    collect(begin, end, m_seen, &trigrams);
+    collect(joins.data(), joins.data() + joins.size(), m_seen, &trigrams);
+    for (vector<uint32_t>::const_iterator it = trigrams.begin(); it != trigrams.end(); ++it) {
+        m_seen[(*it) >> 6] = 0;
+    }
+
+    size_t bits = C_FILTER_MINIMUM_BITS;
+    while (bits < trigrams.size() * C_FILTER_BITS_PER_TRIGRAM && bits < C_FILTER_MAXIMUM_BITS) {
+        bits <<= 1;
+    }
+    filter->assign(bits / 64, 0);
+    for (vector<uint32_t>::const_iterator it = trigrams.begin(); it != trigrams.end(); ++it) {
+        setTrigram(*filter, *it);
+    }
+}
+
+/*! \brief Returns false if the file of the \a record can't contain one
+ *         of the \a terms. The \a terms shorter than 3 characters are
+ *         not checked.
+ */
+bool TermIndex::mayContain(const Record &record, const vector<string> &terms)
+{
+    if (record.filter.empty()) {
+        return true;
+    }
+    for (vector<string>::const_iterator it = terms.begin(); it != terms.end(); ++it) {
+        if (!mayContainTerm(record.filter, *it)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Reads the records saved by save(). Returns false if the \a stream
+ *         doesn't contain records; then, the records are empty.
+ *
+ * Format: a header line, then for each file, its path, a line with its
+ * size, modification time, content hash, number of lines, number of words
+ * of the filter and number of includes, a line with the words of the
+ * filter, and one line per include, made of its line number and its name.
+ */
+bool TermIndex::load(istream &stream)
+{
+    this->clear();
+
+    string line;
+    if (!getline(stream, line) || line != STR_HEADER) {
+        return false;
+    }
+    string path;
+    while (getline(stream, path)) {
+        Record record;
+        unsigned long long size = 0;
+        long long modificationTime = 0;
+        unsigned long long contentHash = 0;
+        unsigned long long lineCount = 0;
+        unsigned int wordCount = 0;
+        unsigned int includeCount = 0;
+        if (!getline(stream, line)
+                || sscanf(line.c_str(), "%llu %lld %llx %llu %u %u",
+                          &size, &modificationTime, &contentHash, &lineCount,
+                          &wordCount, &includeCount) != 6
+                || (wordCount & (wordCount - 1)) != 0
+                || !getline(stream, line)) {
+            this->clear();
+            return false;
+        }
+        record.size = (size_t)size;
+        record.modificationTime = modificationTime;
+        record.contentHash = contentHash;
+        record.lineCount = (size_t)lineCount;
+
+        record.filter.reserve(wordCount);
+        const char *p = line.c_str();
+        for (unsigned int i = 0; i < wordCount; ++i) {
+            char *next = NULL;
+            record.filter.push_back(strtoull(p, &next, 16));
+            if (next == p) {
+                this->clear();
+                return false;
+            }
+            p = next;
+        }
+
+        for (unsigned int i = 0; i < includeCount; ++i) {
+            int lineNumber = 0;
+            int offset = 0;
+            if (!getline(stream, line)
+                    || sscanf(line.c_str(), "%d %n", &lineNumber, &offset) != 1) {
+                this->clear();
+                return false;
+            }
+            record.includes.push_back(make_pair(lineNumber, line.substr((size_t)offset)));
+        }
+        m_records[path] = record;
+    }
+    return true;
+}
+
+void TermIndex::save(ostream &stream) const
+{
+    stream << STR_HEADER << '\n';
+    for (map<string, Record>::const_iterator it = m_records.begin(); it != m_records.end(); ++it) {
+        const Record& record = it->second;
+        stream << it->first << '\n'
+               << (unsigned long long)record.size << ' '
+               << record.modificationTime << ' '
+               << Fingerprint::toHex(record.contentHash) << ' '
+               << (unsigned long long)record.lineCount << ' '
+               << record.filter.size() << ' '
+               << record.includes.size() << '\n';
+        char buffer[17];
+        for (vector<uint64_t>::const_iterator word = record.filter.begin();
+             word != record.filter.end(); ++word) {
+            snprintf(buffer, sizeof(buffer), "%llx", (unsigned long long)(*word));
+            stream << (word == record.filter.begin() ? "" : " ") << buffer;
+        }
+        stream << '\n';
+        for (vector<pair<int, string> >::const_iterator include = record.includes.begin();
+             include != record.includes.end(); ++include) {
+            stream << include->first << ' ' << include->second << '\n';
+        }
+    }
+}
+
+bool TermIndex::load(const string &fileName)
+{
+    ifstream stream(fileName.c_str());
+    if (!stream.is_open()) {
+        this->clear();
+        return false;
+    }
+    return load(stream);
+}
+
+/*! \brief Returns the name of the temporary file where the process writes
+ *         the file \a fileName, before replacing it.
+ */
+static string temporaryFileName(const string &fileName)
+{
+#if defined(Q_OS_WIN)
+    const long pid = (long)_getpid();
+#elif defined(Q_OS_UNIX)
+    const long pid = (long)getpid();
+#else
+    const long pid = 0;
+#endif
+    return fileName + "." + to_string(pid) + ".tmp";
+}
+
+/*! \brief Writes the records in the file \a fileName. Returns false if
+ *         the file can't be written.
+ *
+ * The records are written in a temporary file, that then replaces the file.
+ */
+bool TermIndex::save(const string &fileName)
+{
+    const string temporary = temporaryFileName(fileName);
+    ofstream stream(temporary.c_str());
+    if (!stream.is_open()) {
+        return false;
+    }
+    save(stream);
+    stream.close();
+    if (stream.fail()) {
+        remove(temporary.c_str());
+        return false;
+    }
+    if (rename(temporary.c_str(), fileName.c_str()) != 0) {
+        /* On Windows, rename() doesn't replace an existing file */
+        remove(fileName.c_str());
+        if (rename(temporary.c_str(), fileName.c_str()) != 0) {
+            remove(temporary.c_str());
+            return false;
+        }
+    }
+    m_modified = false;
+    return true;
+}
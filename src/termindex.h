@@ -0,0 +1,89 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TERM_INDEX_H
+#define TERM_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Fingerprint;
+
+class TermIndex
+{
+public:
+    /* Status and summary of a file, when it was scanned for the last time */
+    struct Record
+    {
+        std::size_t size;
+        long long modificationTime;
+        std::uint64_t contentHash;                          ///< See FileCache::hash()
+        std::size_t lineCount;
+        std::vector<std::uint64_t> filter;                  ///< Bloom filter of its trigrams
+        std::vector<std::pair<int, std::string> > includes; ///< Line and name of the INCLUDE statements
+    };
+
+    explicit TermIndex();
+
+    void clear();
+
+    /* Getters -> return the record of the file, if it's up to date, or NULL */
+    const Record* find(const std::string &fullFileName,
+                       const std::size_t size, const long long modificationTime) const;
+
+    /* Record the content [begin, end) of the file */
+    void update(const std::string &fullFileName,
+                const std::size_t size, const long long modificationTime,
+                const std::uint64_t contentHash,
+                const char *begin, const char *end, const std::string &joins,
+                const std::size_t lineCount,
+                const std::vector<std::pair<int, std::string> > &includes);
+
+    /* Check the records against the ones of the fingerprint of the model */
+    void validate(const Fingerprint &fingerprint);
+
+    /* Remove the records of the files that are not in the list */
+    void prune(const std::vector<std::string> &fullFileNames);
+
+    /* Returns false if the file can't contain all the terms */
+    static bool mayContain(const Record &record, const std::vector<std::string> &terms);
+
+    std::size_t recordCount() const { return m_records.size(); }
+    bool isModified() const { return m_modified; }
+
+    /* Records of the files, kept between two runs */
+    bool load(std::istream &stream);
+    void save(std::ostream &stream) const;
+    bool load(const std::string &fileName);
+    bool save(const std::string &fileName);
+
+private:
+    std::map<std::string, Record> m_records;
+    bool m_modified;
+
+    /* trigrams already found, while building a filter */
+    std::vector<std::uint64_t> m_seen;
+
+    void buildFilter(const char *begin, const char *end, const std::string &joins,
+                     std::vector<std::uint64_t> *filter);
+};
+
+#endif // TERM_INDEX_H
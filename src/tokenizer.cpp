@@ -0,0 +1,509 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tokenizer.h"
+
+#include "scanner.h"
+
+#include <math.h>   // pow()
+#include <string.h> // memchr(), strlen()
+
+/*! \class Tokenizer
+ *  \brief The class Tokenizer splits a line of a Nastran deck into fields.
+ *
+ * The three bulk data formats are supported:
+ *  \li Small field: 10 fields of 8 columns.
+ *  \li Large field: the card name ends with '*' (or the continuation line
+ *      starts with '*'); then 4 fields of 16 columns, between the name
+ *      and the continuation field of 8 columns.
+ *  \li Free field: the fields are separated by commas.
+ *
+ * In the fixed formats, a tab moves to the next multiple of 8 columns,
+ * and the columns beyond the 80th are ignored.
+ *
+ * The fields are stored as spans, i.e. positions in the given line,
+ * without the surrounding blanks. Hence tokenizing a line doesn't allocate
+ * any memory, and the same Tokenizer can be reused for every line.
+ *
+ * Example:
+ * \code
+ *   Tokenizer tokenizer;
+ *   tokenizer.tokenize("GRID*   1001            0               1.0", 41);
+ *   // tokenizer.format() == Tokenizer::Format::LARGE_FIELD
+ *   // tokenizer.fieldAt(1) == {8, 4}, i.e. "1001"
+ * \endcode
+ *
+ * \remark The line is not copied: it must remain valid while
+ * the spans are used.
+ */
+
+static const FieldSpan BLANK_FIELD = { 0, 0 };
+
+static const std::size_t C_FIXED_FORMAT_COLUMNS = 80;
+
+/* First words of the Executive and Case Control statements, */
+/* that can't be confused with a bulk data entry.            */
+static const char* const CONTROL_KEYWORDS[] = {
+    "ALTER", "APP", "ASSIGN", "CEND", "COMPILE", "COMPILER", "DIAG", "ECHO",
+    "ENDALTER", "ID", "INIT", "LABEL", "MAXLINES", "NASTRAN", "REPCASE",
+    "RESTART", "SOL", "SUBCASE", "SUBCOM", "SUBTITLE", "SYM", "SYMCOM",
+    "TIME", "TITLE"
+};
+
+static inline bool isBlank(const char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline bool isDigit(const char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline bool isLetter(const char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+/*! \brief Returns true if the first field \a text marks a large field line,
+ *         i.e. a card name with the '*' suffix, or a '*' continuation.
+ */
+static inline bool isLargeFieldMarker(const char *text, const std::size_t length)
+{
+    return length > 0 && (text[0] == '*' || text[length - 1] == '*');
+}
+
+/*! \brief Constructor.
+ */
+Tokenizer::Tokenizer()
+    : m_format(Format::EMPTY)
+    , m_isLargeField(false)
+    , m_fieldCount(0)
+    , m_commentPosition(0)
+{
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Splits the given \a line of \a length chars into fields,
+ *         and returns its format.
+ *
+ * The line may end with a CR or a LF. A '$' starts a comment,
+ * until the end of the line.
+ */
+Tokenizer::Format Tokenizer::tokenize(const char *line, const std::size_t length)
+{
+    m_fieldCount = 0;
+    m_isLargeField = false;
+
+    const void *dollar = memchr(line, '$', length);
+    m_commentPosition = dollar ? (std::size_t)(static_cast<const char*>(dollar) - line) : length;
+
+    std::size_t end = m_commentPosition;
+    while (end > 0 && isBlank(line[end - 1])) {
+        --end;
+    }
+    if (end == 0) {
+        m_format = (m_commentPosition < length) ? Format::COMMENT : Format::EMPTY;
+        return m_format;
+    }
+
+    if (memchr(line, ',', end)) {
+        tokenizeFree(line, end);
+    } else {
+        tokenizeFixed(line, end);
+    }
+    return m_format;
+}
+
+/*! \brief Returns the field at the given \a index, where the index 0 is
+ *         the card name (i.e. the field 1 of the Nastran documentation).
+ * Returns a blank field if the index is out of range.
+ */
+const FieldSpan& Tokenizer::fieldAt(const int index) const
+{
+    if (index >= 0 && index < m_fieldCount) {
+        return m_fields[index];
+    }
+    return BLANK_FIELD;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void Tokenizer::tokenizeFree(const char *line, const std::size_t length)
+{
+    std::size_t fieldBegin = 0;
+    for (std::size_t i = 0; i <= length; ++i) {
+        if (i == length || line[i] == ',') {
+            std::size_t first = fieldBegin;
+            std::size_t last = i;
+            while (first < last && isBlank(line[first])) {
+                ++first;
+            }
+            while (last > first && isBlank(line[last - 1])) {
+                --last;
+            }
+            appendField(first, last - first);
+            fieldBegin = i + 1;
+        }
+    }
+    const FieldSpan &name = fieldAt(0);
+    m_format = Format::FREE_FIELD;
+    m_isLargeField = isLargeFieldMarker(line + name.position, name.length);
+}
+
+void Tokenizer::tokenizeFixed(const char *line, const std::size_t length)
+{
+    /* The name (or continuation) field is 8 columns in both formats */
+    m_isLargeField = false;
+    for (int pass = 0; pass < 2; ++pass) {
+
+        m_fieldCount = 0;
+        const int maxFieldCount = m_isLargeField ? 6 : 10;
+
+        int field = 0;
+        std::size_t column = 0;
+        std::size_t fieldEnd = 8;
+        std::size_t fieldBegin = 0;
+        std::size_t first = 0;
+        std::size_t last = 0;
+        bool blank = true;
+
+        for (std::size_t i = 0; i < length && column < C_FIXED_FORMAT_COLUMNS; ++i) {
+            while (column >= fieldEnd) {
+                appendField(blank ? fieldBegin : first, blank ? 0 : last - first);
+                ++field;
+                fieldEnd += (m_isLargeField && field < maxFieldCount - 1) ? 16 : 8;
+                fieldBegin = i;
+                blank = true;
+            }
+            const char c = line[i];
+            if (c == '\t') {
+                column = (column / 8 + 1) * 8;
+                continue;
+            }
+            ++column;
+            if (isBlank(c)) {
+                continue;
+            }
+            if (blank) {
+                first = i;
+                blank = false;
+            }
+            last = i + 1;
+        }
+        if (field < maxFieldCount) {
+            appendField(blank ? fieldBegin : first, blank ? 0 : last - first);
+        }
+
+        if (m_isLargeField) {
+            break;
+        }
+        const FieldSpan &name = fieldAt(0);
+        if (!isLargeFieldMarker(line + name.position, name.length)) {
+            break;
+        }
+        m_isLargeField = true; // tokenize again with the large fields
+    }
+    m_format = m_isLargeField ? Format::LARGE_FIELD : Format::SMALL_FIELD;
+}
+
+void Tokenizer::appendField(const std::size_t position, const std::size_t length)
+{
+    if (m_fieldCount < MAX_FIELD_COUNT) {
+        m_fields[m_fieldCount].position = position;
+        m_fields[m_fieldCount].length = length;
+        ++m_fieldCount;
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the kind of the field \a text of \a length chars.
+ *
+ * The Nastran real numbers may have an exponent without 'E',
+ * e.g. "1.5-3" means 1.5E-3.
+ */
+Tokenizer::Kind Tokenizer::kindOf(const char *text, const std::size_t length)
+{
+    if (length == 0) {
+        return Kind::BLANK;
+    }
+    if (isLetter(text[0])) {
+        return Kind::WORD;
+    }
+
+    std::size_t i = 0;
+    if (text[i] == '+' || text[i] == '-') {
+        ++i;
+    }
+    std::size_t digits = 0;
+    while (i < length && isDigit(text[i])) {
+        ++i;
+        ++digits;
+    }
+    bool real = false;
+    if (i < length && text[i] == '.') {
+        real = true;
+        ++i;
+        while (i < length && isDigit(text[i])) {
+            ++i;
+            ++digits;
+        }
+    }
+    if (digits == 0) {
+        return Kind::OTHER;
+    }
+    if (i == length) {
+        return real ? Kind::REAL : Kind::INTEGER;
+    }
+
+    /* Exponent */
+    const char c = text[i];
+    if (c == 'E' || c == 'e' || c == 'D' || c == 'd') {
+        ++i;
+        if (i < length && (text[i] == '+' || text[i] == '-')) {
+            ++i;
+        }
+    } else if (c == '+' || c == '-') {
+        ++i;
+    } else {
+        return Kind::OTHER;
+    }
+    std::size_t exponentDigits = 0;
+    while (i < length && isDigit(text[i])) {
+        ++i;
+        ++exponentDigits;
+    }
+    return (exponentDigits > 0 && i == length) ? Kind::REAL : Kind::OTHER;
+}
+
+/*! \brief Parses the Nastran number in \a text, i.e. an integer or a real
+ *         in any of the formats accepted by kindOf().
+ * Returns false if the text is not a number.
+ *
+ * The parser doesn't depend on the locale. The digits are gathered into
+ * an integer mantissa, and the decimal point is moved into the exponent.
+ * Hence the equivalent notations, e.g. '1.0', '1.', '1.0E0', '1+0',
+ * '.1+1' and '1.0D0', give exactly the same value.
+ */
+bool Tokenizer::parseNumber(const char *text, const std::size_t length, double *value)
+{
+    static const double POWERS_OF_TEN[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    static const int MAX_EXACT_POWER = 22;
+    static const int MAX_EXPONENT = 9999;
+    static const unsigned long long MAX_MANTISSA = 100000000000000000ULL;
+
+    std::size_t i = 0;
+    bool negative = false;
+    if (i < length && (text[i] == '+' || text[i] == '-')) {
+        negative = (text[i] == '-');
+        ++i;
+    }
+
+    /* Mantissa, up to 18 significant digits */
+    unsigned long long mantissa = 0;
+    int exponent = 0;
+    std::size_t digits = 0;
+    bool point = false;
+    for (; i < length; ++i) {
+        const char c = text[i];
+        if (c == '.' && !point) {
+            point = true;
+            continue;
+        }
+        if (!isDigit(c)) {
+            break;
+        }
+        ++digits;
+        if (mantissa < MAX_MANTISSA) {
+            mantissa = mantissa * 10 + (unsigned long long)(c - '0');
+            if (point) {
+                --exponent;
+            }
+        } else if (!point) {
+            ++exponent; // the digit is dropped
+        }
+    }
+    if (digits == 0) {
+        return false;
+    }
+
+    /* Exponent */
+    if (i < length) {
+        const char c = text[i];
+        if (c == 'E' || c == 'e' || c == 'D' || c == 'd') {
+            ++i;
+        } else if (c != '+' && c != '-') {
+            return false;
+        }
+        bool negativeExponent = false;
+        if (i < length && (text[i] == '+' || text[i] == '-')) {
+            negativeExponent = (text[i] == '-');
+            ++i;
+        }
+        if (i == length) {
+            return false;
+        }
+        int e = 0;
+        for (; i < length; ++i) {
+            if (!isDigit(text[i])) {
+                return false;
+            }
+            if (e < MAX_EXPONENT) {
+                e = e * 10 + (text[i] - '0');
+            }
+        }
+        exponent += negativeExponent ? -e : e;
+    }
+
+    /* Same mantissa and exponent for the equivalent notations */
+    while (mantissa != 0 && mantissa % 10 == 0) {
+        mantissa /= 10;
+        ++exponent;
+    }
+
+    double result = (double)mantissa;
+    if (mantissa != 0 && exponent != 0) {
+        if (exponent > 0 && exponent <= MAX_EXACT_POWER) {
+            result *= POWERS_OF_TEN[exponent];
+        } else if (exponent < 0 && exponent >= -MAX_EXACT_POWER) {
+            result /= POWERS_OF_TEN[-exponent];
+        } else {
+            result *= pow(10.0, (double)exponent);
+        }
+    }
+    (*value) = negative ? -result : result;
+    return true;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns true if the given \a line continues the previous card,
+ *         i.e. it starts with a '+' or a '*', or its first field is blank.
+ *
+ * \remark This is only meaningful in the Bulk Data section.
+ */
+bool Tokenizer::isContinuation(const char *line, const std::size_t length)
+{
+    if (length == 0) {
+        return false;
+    }
+    if (line[0] == '+' || line[0] == '*') {
+        return true;
+    }
+    if (line[0] == ',') {
+        return true; /* free field with a blank first field */
+    }
+    if (!isBlank(line[0]) || line[0] == '\r' || line[0] == '\n') {
+        return false;
+    }
+
+    /* Blank first field, followed by some data (not a comment) */
+    const std::size_t dataBegin = columnOffset(line, length, 8);
+    std::size_t i = 0;
+    while (i < length && isBlank(line[i])) {
+        ++i;
+    }
+    return i < length && i >= dataBegin && line[i] != '$';
+}
+
+/*! \brief Returns true if the given \a line is an Executive Control
+ *         or a Case Control statement, e.g. 'SOL 101', 'CEND', 'DISP = ALL'.
+ */
+bool Tokenizer::isControlStatement(const char *line, const std::size_t length)
+{
+    std::size_t i = 0;
+    while (i < length && isBlank(line[i])) {
+        ++i;
+    }
+    const std::size_t wordBegin = i;
+    while (i < length && (isLetter(line[i]) || isDigit(line[i]))) {
+        ++i;
+    }
+    const std::size_t wordLength = i - wordBegin;
+    if (wordLength == 0) {
+        return false;
+    }
+
+    /* Case Control: 'KEYWORD = value' or 'KEYWORD(options) = value' */
+    std::size_t j = i;
+    while (j < length && isBlank(line[j])) {
+        ++j;
+    }
+    if (j < length && (line[j] == '=' || line[j] == '(')) {
+        return true;
+    }
+
+    const std::size_t count = sizeof(CONTROL_KEYWORDS) / sizeof(CONTROL_KEYWORDS[0]);
+    for (std::size_t k = 0; k < count; ++k) {
+        const char *keyword = CONTROL_KEYWORDS[k];
+        if (strlen(keyword) != wordLength) {
+            continue;
+        }
+        std::size_t n = 0;
+        while (n < wordLength && Scanner::toUpper(line[wordBegin + n]) == keyword[n]) {
+            ++n;
+        }
+        if (n == wordLength) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*! \brief Returns true if the given \a line starts the Bulk Data section,
+ *         e.g. 'BEGIN BULK' or 'BEGIN SUPER=2'.
+ */
+bool Tokenizer::isBeginBulk(const char *line, const std::size_t length)
+{
+    static const char keyword[] = "BEGIN";
+    static const std::size_t keywordLength = sizeof(keyword) - 1;
+    if (length <= keywordLength || !isBlank(line[keywordLength])) {
+        return false;
+    }
+    for (std::size_t n = 0; n < keywordLength; ++n) {
+        if (Scanner::toUpper(line[n]) != keyword[n]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*! \brief Returns the offset of the char at the given fixed format
+ *         \a column of the \a line, where a tab moves to the next
+ *         multiple of 8 columns.
+ * Returns \a length if the line is shorter.
+ */
+std::size_t Tokenizer::columnOffset(const char *line, const std::size_t length,
+                                    const std::size_t column)
+{
+    std::size_t current = 0;
+    for (std::size_t i = 0; i < length; ++i) {
+        if (current >= column) {
+            return i;
+        }
+        if (line[i] == '\t') {
+            current = (current / 8 + 1) * 8;
+        } else {
+            ++current;
+        }
+    }
+    return length;
+}
@@ -0,0 +1,88 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <cstddef>
+
+/*! \brief Position of a field in a line, without the surrounding blanks.
+ */
+struct FieldSpan
+{
+    std::size_t position;   ///< Offset of the first char, from the start of the line
+    std::size_t length;     ///< Number of chars, or 0 if the field is blank
+};
+
+class Tokenizer
+{
+public:
+    enum class Format {
+        EMPTY,          ///< Blank line
+        COMMENT,        ///< Line starting with a '$'
+        SMALL_FIELD,    ///< Fixed format, 10 fields of 8 chars
+        LARGE_FIELD,    ///< Fixed format, with fields of 16 chars ('*' suffix)
+        FREE_FIELD      ///< Fields separated by commas
+    };
+
+    enum class Kind {
+        BLANK,          ///< Empty field
+        INTEGER,        ///< e.g. 123, -5, +7
+        REAL,           ///< e.g. 1.0, 1., .5, 1.0E+3, 1.0D0, 1+3, -.5-2
+        WORD,           ///< Starts with a letter, e.g. GRID, CQUAD4
+        OTHER           ///< Anything else, e.g. continuation marker +A1, *
+    };
+
+    /* Maximum number of fields stored per line (the others are ignored) */
+    static const int MAX_FIELD_COUNT = 64;
+
+    explicit Tokenizer();
+
+    Format tokenize(const char *line, const std::size_t length);
+
+    Format format() const { return m_format; }
+    bool isLargeField() const { return m_isLargeField; }
+
+    int fieldCount() const { return m_fieldCount; }
+    const FieldSpan& fieldAt(const int index) const;
+
+    /* Offset of the '$' comment, or the length of the line if none */
+    std::size_t commentPosition() const { return m_commentPosition; }
+
+    static Kind kindOf(const char *text, const std::size_t length);
+    static bool parseNumber(const char *text, const std::size_t length, double *value);
+
+    /* Helpers to assemble the logical cards, i.e. a parent line */
+    /* followed by its continuation lines                        */
+    static bool isContinuation(const char *line, const std::size_t length);
+    static bool isControlStatement(const char *line, const std::size_t length);
+    static bool isBeginBulk(const char *line, const std::size_t length);
+    static std::size_t columnOffset(const char *line, const std::size_t length,
+                                    const std::size_t column);
+
+private:
+    Format m_format;
+    bool m_isLargeField;
+    int m_fieldCount;
+    std::size_t m_commentPosition;
+    FieldSpan m_fields[MAX_FIELD_COUNT];
+
+    void tokenizeFree(const char *line, const std::size_t length);
+    void tokenizeFixed(const char *line, const std::size_t length);
+    void appendField(const std::size_t position, const std::size_t length);
+};
+
+#endif // TOKENIZER_H
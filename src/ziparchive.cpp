@@ -0,0 +1,438 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ziparchive.h"
+
+#include "mappedfile.h"
+#include "systemdetection.h"
+
+#include <algorithm> // min()
+#include <ctype.h>   // tolower()
+#include <mutex>
+
+#include <zlib.h>
+
+using namespace std;
+
+/* Signatures of the records */
+static const unsigned long C_LOCAL_HEADER         = 0x04034b50;
+static const unsigned long C_CENTRAL_HEADER       = 0x02014b50;
+static const unsigned long C_END_OF_DIRECTORY     = 0x06054b50;
+static const unsigned long C_ZIP64_END_LOCATOR    = 0x07064b50;
+static const unsigned long C_ZIP64_END_OF_DIRECTORY = 0x06064b50;
+
+/* Sizes of the fixed parts of the records */
+static const size_t C_LOCAL_HEADER_SIZE       = 30;
+static const size_t C_CENTRAL_HEADER_SIZE     = 46;
+static const size_t C_END_OF_DIRECTORY_SIZE   = 22;
+static const size_t C_ZIP64_END_LOCATOR_SIZE  = 20;
+static const size_t C_ZIP64_END_OF_DIRECTORY_SIZE = 56;
+
+/* Size of the chunks decompressed at once */
+static const size_t C_CHUNK_SIZE = 256 * 1024;
+
+static inline unsigned long readUInt16(const unsigned char *p)
+{
+    return (unsigned long)p[0] | ((unsigned long)p[1] << 8);
+}
+
+static inline unsigned long readUInt32(const unsigned char *p)
+{
+    return readUInt16(p) | (readUInt16(p + 2) << 16);
+}
+
+static inline unsigned long long readUInt64(const unsigned char *p)
+{
+    return (unsigned long long)readUInt32(p) | ((unsigned long long)readUInt32(p + 4) << 32);
+}
+
+static bool seek(FILE *file, const unsigned long long offset)
+{
+#if defined(Q_OS_WIN)
+    return _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+static bool read(FILE *file, const unsigned long long offset, unsigned char *buffer, const size_t size)
+{
+    return seek(file, offset) && fread(buffer, 1, size, file) == size;
+}
+
+/*! \class ZipArchive
+ *  \brief The class ZipArchive reads the members of a zip archive,
+ *         without extracting them to the disk.
+ *
+ * open() reads the central directory only. extract() decompresses
+ * a member by chunks, and writes it to a stream, usually a temporary
+ * file that is then mapped: the member is never held in memory.
+ *
+ * The stored and deflated members are supported, as well as the
+ * archives and the members larger than 4 GB (Zip64).
+ * The encrypted members cannot be extracted.
+ *
+ * \remark The names of the members are normalized: the INCLUDE
+ * statements can name them with '\\' separators, "." and ".."
+ * elements, or another case.
+ */
+
+/*! \brief Constructor.
+ */
+ZipArchive::ZipArchive()
+    : m_fileSize(0)
+    , m_modificationTime(0)
+{
+}
+
+void ZipArchive::close()
+{
+    m_fileName.clear();
+    m_fileSize = 0;
+    m_modificationTime = 0;
+    m_members.clear();
+    m_names.clear();
+    m_lowerNames.clear();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Reads the central directory of the archive \a fullFileName.
+ * Returns false if the file cannot be read, or is not a zip archive.
+ */
+bool ZipArchive::open(const string &fullFileName)
+{
+    this->close();
+
+    size_t size = 0;
+    long long modificationTime = 0;
+    if (!MappedFile::status(fullFileName, &size, &modificationTime)) {
+        return false;
+    }
+    FILE *file = fopen(fullFileName.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    m_fileSize = size;
+    m_modificationTime = modificationTime;
+    const bool ok = this->readDirectory(file);
+    fclose(file);
+    if (!ok) {
+        this->close();
+        return false;
+    }
+    m_fileName = fullFileName;
+    return true;
+}
+
+bool ZipArchive::readDirectory(FILE *file)
+{
+    /* The end of central directory record is followed by a comment of 64 KB max */
+    const size_t tailSize = min(m_fileSize, (size_t)(C_END_OF_DIRECTORY_SIZE + 0xFFFF));
+    if (tailSize < C_END_OF_DIRECTORY_SIZE) {
+        return false;
+    }
+    const unsigned long long tailOffset = m_fileSize - tailSize;
+    vector<unsigned char> tail(tailSize);
+    if (!read(file, tailOffset, tail.data(), tailSize)) {
+        return false;
+    }
+    size_t end = tailSize - C_END_OF_DIRECTORY_SIZE + 1;
+    do {
+        --end;
+    } while (end > 0 && readUInt32(&tail[end]) != C_END_OF_DIRECTORY);
+    if (readUInt32(&tail[end]) != C_END_OF_DIRECTORY) {
+        return false;
+    }
+
+    unsigned long long count = readUInt16(&tail[end + 10]);
+    unsigned long long directorySize = readUInt32(&tail[end + 12]);
+    unsigned long long directoryOffset = readUInt32(&tail[end + 16]);
+
+    /* Zip64: the values are in the Zip64 end of central directory record */
+    if (count == 0xFFFF || directorySize == 0xFFFFFFFF || directoryOffset == 0xFFFFFFFF) {
+        unsigned char locator[C_ZIP64_END_LOCATOR_SIZE];
+        unsigned char record[C_ZIP64_END_OF_DIRECTORY_SIZE];
+        const unsigned long long locatorOffset = tailOffset + end;
+        if (locatorOffset < C_ZIP64_END_LOCATOR_SIZE
+                || !read(file, locatorOffset - C_ZIP64_END_LOCATOR_SIZE, locator, sizeof(locator))
+                || readUInt32(locator) != C_ZIP64_END_LOCATOR
+                || !read(file, readUInt64(locator + 8), record, sizeof(record))
+                || readUInt32(record) != C_ZIP64_END_OF_DIRECTORY) {
+            return false;
+        }
+        count = readUInt64(record + 32);
+        directorySize = readUInt64(record + 40);
+        directoryOffset = readUInt64(record + 48);
+    }
+    if (directoryOffset + directorySize > m_fileSize) {
+        return false;
+    }
+
+    vector<unsigned char> directory((size_t)directorySize);
+    if (directorySize > 0 && !read(file, directoryOffset, directory.data(), directory.size())) {
+        return false;
+    }
+
+    const unsigned char *p = directory.data();
+    const unsigned char *directoryEnd = p + directory.size();
+    for (unsigned long long i = 0; i < count; ++i) {
+        if (p + C_CENTRAL_HEADER_SIZE > directoryEnd || readUInt32(p) != C_CENTRAL_HEADER) {
+            return false;
+        }
+        const size_t nameLength = readUInt16(p + 28);
+        const size_t extraLength = readUInt16(p + 30);
+        const size_t commentLength = readUInt16(p + 32);
+        const unsigned char *name = p + C_CENTRAL_HEADER_SIZE;
+        const unsigned char *extra = name + nameLength;
+        const unsigned char *next = extra + extraLength + commentLength;
+        if (next > directoryEnd) {
+            return false;
+        }
+
+        Member member;
+        member.name.assign((const char*)name, nameLength);
+        member.flags = (unsigned int)readUInt16(p + 8);
+        member.method = (unsigned int)readUInt16(p + 10);
+        member.crc = readUInt32(p + 16);
+        member.compressedSize = readUInt32(p + 20);
+        member.size = readUInt32(p + 24);
+        member.offset = readUInt32(p + 42);
+
+        /* Zip64 extended information: only the values that overflow */
+        for (const unsigned char *e = extra; e + 4 <= extra + extraLength; ) {
+            const unsigned long id = readUInt16(e);
+            const size_t length = readUInt16(e + 2);
+            if (id == 0x0001) {
+                const unsigned char *v = e + 4;
+                const unsigned char *vEnd = min(v + length, extra + extraLength);
+                if (member.size == 0xFFFFFFFF && v + 8 <= vEnd) {
+                    member.size = readUInt64(v);
+                    v += 8;
+                }
+                if (member.compressedSize == 0xFFFFFFFF && v + 8 <= vEnd) {
+                    member.compressedSize = readUInt64(v);
+                    v += 8;
+                }
+                if (member.offset == 0xFFFFFFFF && v + 8 <= vEnd) {
+                    member.offset = readUInt64(v);
+                }
+            }
+            e += 4 + length;
+        }
+        p = next;
+
+        /* Directories */
+        if (member.name.empty() || member.name[member.name.size() - 1] == '/') {
+            continue;
+        }
+        const string normalized = normalize(member.name);
+        string lower = normalized;
+        for (string::size_type k = 0; k < lower.size(); ++k) {
+            lower[k] = (char)tolower(lower[k]);
+        }
+        m_names.insert(make_pair(normalized, m_members.size()));
+        m_lowerNames.insert(make_pair(lower, m_members.size()));
+        m_members.push_back(member);
+    }
+    return true;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the member named \a memberName, or NULL.
+ * If no member has exactly this name, the name is compared without
+ * regard to the case, as the INCLUDE statements of the decks written
+ * under Windows often do.
+ */
+const ZipArchive::Member* ZipArchive::find(const string &memberName) const
+{
+    const string normalized = normalize(memberName);
+    map<string, size_t>::const_iterator it = m_names.find(normalized);
+    if (it != m_names.end()) {
+        return &m_members[it->second];
+    }
+    string lower = normalized;
+    for (string::size_type i = 0; i < lower.size(); ++i) {
+        lower[i] = (char)tolower(lower[i]);
+    }
+    it = m_lowerNames.find(lower);
+    if (it != m_lowerNames.end()) {
+        return &m_members[it->second];
+    }
+    return NULL;
+}
+
+/*! \brief Returns the \a memberName with '/' separators, and without
+ *         the "." and ".." elements, nor the leading separators.
+ *
+ * The ".." elements that go above the root of the archive are ignored.
+ *
+ * Example:
+ * \code
+ *   ZipArchive::normalize("MODEL\\MAINS\\..\\MESH/./grid.bdf");
+ *   // "MODEL/MESH/grid.bdf"
+ * \endcode
+ */
+string ZipArchive::normalize(const string &memberName)
+{
+    vector<string> elements;
+    string element;
+    for (string::size_type i = 0; i <= memberName.size(); ++i) {
+        const char ch = (i < memberName.size()) ? memberName[i] : '/';
+        if (ch != '/' && ch != '\\') {
+            element += ch;
+            continue;
+        }
+        if (element == "..") {
+            if (!elements.empty()) {
+                elements.pop_back();
+            }
+        } else if (!element.empty() && element != ".") {
+            elements.push_back(element);
+        }
+        element.clear();
+    }
+    string ret;
+    for (vector<string>::const_iterator it = elements.begin(); it != elements.end(); ++it) {
+        if (!ret.empty()) {
+            ret += '/';
+        }
+        ret += *it;
+    }
+    return ret;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Decompresses the \a member, and appends it to the \a output stream.
+ * Returns false if the member cannot be read, is encrypted, compressed with
+ * an unsupported method, or corrupted (the CRC is checked).
+ */
+bool ZipArchive::extract(const Member &member, FILE *output) const
+{
+    if ((member.flags & 0x0001) || (member.method != 0 && member.method != 8)) {
+        return false; /* encrypted, or not deflated */
+    }
+    FILE *file = fopen(m_fileName.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    unsigned char header[C_LOCAL_HEADER_SIZE];
+    if (!read(file, member.offset, header, sizeof(header))
+            || readUInt32(header) != C_LOCAL_HEADER
+            || !seek(file, member.offset + C_LOCAL_HEADER_SIZE
+                     + readUInt16(header + 26) + readUInt16(header + 28))) {
+        fclose(file);
+        return false;
+    }
+
+    vector<unsigned char> input(C_CHUNK_SIZE);
+    vector<unsigned char> chunk(member.method == 8 ? C_CHUNK_SIZE : 0);
+    unsigned long long remaining = member.compressedSize;
+    unsigned long long written = 0;
+    uLong crc = crc32(0L, Z_NULL, 0);
+
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+    if (member.method == 8 && inflateInit2(&stream, -MAX_WBITS) != Z_OK) { // raw deflate
+        fclose(file);
+        return false;
+    }
+
+    bool ok = true;
+    int status = Z_OK;
+    while (ok && remaining > 0 && status != Z_STREAM_END) {
+        const size_t length = (size_t)min(remaining, (unsigned long long)input.size());
+        if (fread(input.data(), 1, length, file) != length) {
+            ok = false;
+            break;
+        }
+        remaining -= length;
+
+        if (member.method == 0) {
+            crc = crc32(crc, input.data(), (uInt)length);
+            written += length;
+            ok = fwrite(input.data(), 1, length, output) == length;
+            continue;
+        }
+
+        stream.next_in = input.data();
+        stream.avail_in = (uInt)length;
+        do {
+            stream.next_out = chunk.data();
+            stream.avail_out = (uInt)chunk.size();
+            status = inflate(&stream, Z_NO_FLUSH);
+            if (status == Z_BUF_ERROR) {
+                break; /* needs the next input chunk */
+            }
+            if (status != Z_OK && status != Z_STREAM_END) {
+                ok = false;
+                break;
+            }
+            const size_t produced = chunk.size() - stream.avail_out;
+            crc = crc32(crc, chunk.data(), (uInt)produced);
+            written += produced;
+            if (fwrite(chunk.data(), 1, produced, output) != produced) {
+                ok = false;
+                break;
+            }
+        } while (stream.avail_out == 0 && status != Z_STREAM_END);
+    }
+    if (member.method == 8) {
+        inflateEnd(&stream);
+    }
+    fclose(file);
+    return ok && written == member.size && crc == member.crc;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns the archive \a fullFileName, open, or NULL if it cannot be
+ *         read.
+ * The archive is read once, and kept while the size and the modification
+ * time of its file don't change. Several threads can call this function.
+ */
+shared_ptr<const ZipArchive> ZipArchive::cached(const string &fullFileName)
+{
+    static mutex guard;
+    static map<string, shared_ptr<const ZipArchive> > archives;
+
+    size_t size = 0;
+    long long modificationTime = 0;
+    if (!MappedFile::status(fullFileName, &size, &modificationTime)) {
+        return shared_ptr<const ZipArchive>();
+    }
+
+    lock_guard<mutex> lock(guard);
+    shared_ptr<const ZipArchive>& archive = archives[fullFileName];
+    if (archive
+            && archive->fileSize() == size
+            && archive->modificationTime() == modificationTime) {
+        return archive;
+    }
+    shared_ptr<ZipArchive> opened(new ZipArchive());
+    if (!opened->open(fullFileName)) {
+        archives.erase(fullFileName);
+        return shared_ptr<const ZipArchive>();
+    }
+    archive = opened;
+    return archive;
+}
@@ -0,0 +1,77 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ZIP_ARCHIVE_H
+#define ZIP_ARCHIVE_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+class ZipArchive
+{
+public:
+    /* File stored in the archive */
+    struct Member
+    {
+        std::string name;
+        unsigned long long offset;          ///< Offset of the local header
+        unsigned long long compressedSize;
+        unsigned long long size;
+        unsigned int method;                ///< 0: stored, 8: deflated
+        unsigned int flags;
+        unsigned long crc;
+    };
+
+    explicit ZipArchive();
+
+    bool open(const std::string &fullFileName);
+    void close();
+
+    bool isOpen() const { return !m_fileName.empty(); }
+
+    /* Status of the archive file, when it was open */
+    std::size_t fileSize() const { return m_fileSize; }
+    long long modificationTime() const { return m_modificationTime; }
+
+    const std::vector<Member>& members() const { return m_members; }
+    const Member* find(const std::string &memberName) const;
+
+    /* Decompress the member at the end of the stream 'output' */
+    bool extract(const Member &member, FILE *output) const;
+
+    /* Archive open once, and shared by the threads, while it doesn't change */
+    static std::shared_ptr<const ZipArchive> cached(const std::string &fullFileName);
+
+    static std::string normalize(const std::string &memberName);
+
+private:
+    std::string m_fileName;
+    std::size_t m_fileSize;
+    long long m_modificationTime;
+    std::vector<Member> m_members;
+
+    /* index of the members, by normalized name and by lowercase name */
+    std::map<std::string, std::size_t> m_names;
+    std::map<std::string, std::size_t> m_lowerNames;
+
+    bool readDirectory(FILE *file);
+};
+
+#endif // ZIP_ARCHIVE_H
@@ -0,0 +1,202 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "zonemap.h"
+
+#include <limits>
+
+using namespace std;
+
+static const long long NO_MINIMUM = numeric_limits<long long>::max();
+static const long long NO_MAXIMUM = numeric_limits<long long>::min();
+
+/*! \class ZoneMap
+ *  \brief The class ZoneMap summarizes the card IDs of a file, per block
+ *         of 64 KB, to skip the blocks that can't match an ID range query.
+ *
+ * Each zone stores the minimum and maximum IDs of the cards that start
+ * in its block, and the position of the first card that starts in it,
+ * with the state needed to resume the scan there: its line number and
+ * the section (Bulk Data or not). A card belongs to the block where its
+ * parent line starts, even if its continuation lines are in the next one.
+ *
+ * The map is built while the file is scanned, once for each version of
+ * the file, i.e. its size and modification time:
+ * \code
+ *   zoneMap.reset(file.size(), file.modificationTime());
+ *   // for each card: appendCard(offset, line, bulk), then appendId(id)
+ *   zoneMap.finish();
+ * \endcode
+ *
+ * \remark The blocks with an INCLUDE statement are never skipped, so that
+ * the include tree is always complete.
+ */
+
+/*! \brief Constructor.
+ */
+ZoneMap::ZoneMap()
+    : m_fileSize(0)
+    , m_modificationTime(0)
+    , m_minimum(NO_MINIMUM)
+    , m_maximum(NO_MAXIMUM)
+    , m_hasInclude(false)
+    , m_isBuilt(false)
+    , m_currentZone(-1)
+{
+}
+
+void ZoneMap::clear()
+{
+    m_zones.clear();
+    m_fileSize = 0;
+    m_modificationTime = 0;
+    m_minimum = NO_MINIMUM;
+    m_maximum = NO_MAXIMUM;
+    m_hasInclude = false;
+    m_isBuilt = false;
+    m_currentZone = -1;
+}
+
+/*! \brief Starts building the map of the file of the given \a fileSize
+ *         and \a modificationTime.
+ */
+void ZoneMap::reset(const size_t fileSize, const long long modificationTime)
+{
+    this->clear();
+    m_fileSize = fileSize;
+    m_modificationTime = modificationTime;
+
+    const Zone empty = { NO_MINIMUM, NO_MAXIMUM, NO_CARD, 0, false, false };
+    m_zones.assign((fileSize + BLOCK_SIZE - 1) / BLOCK_SIZE, empty);
+}
+
+/*! \brief Returns true if the map is built, and still describes the file
+ *         of the given \a fileSize and \a modificationTime.
+ */
+bool ZoneMap::isBuiltFor(const size_t fileSize, const long long modificationTime) const
+{
+    return m_isBuilt && m_fileSize == fileSize && m_modificationTime == modificationTime;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Appends the card whose parent line starts at \a offset.
+ *
+ * Every line that is not a continuation is a card, including the comments
+ * and the control statements: the scan can resume at any of them.
+ */
+void ZoneMap::appendCard(const size_t offset, const int lineNumber, const bool isBulk)
+{
+    const size_t index = offset / BLOCK_SIZE;
+    if (index >= m_zones.size()) {
+        m_currentZone = -1;
+        return;
+    }
+    Zone &zone = m_zones[index];
+    if (zone.offset == NO_CARD) {
+        zone.offset = offset;
+        zone.lineNumber = lineNumber;
+        zone.isBulk = isBulk;
+    }
+    m_currentZone = (int)index;
+}
+
+/*! \brief Appends the \a id of the last appended card.
+ */
+void ZoneMap::appendId(const long long id)
+{
+    if (m_currentZone < 0) {
+        return;
+    }
+    Zone &zone = m_zones[(size_t)m_currentZone];
+    if (id < zone.minimum) {
+        zone.minimum = id;
+    }
+    if (id > zone.maximum) {
+        zone.maximum = id;
+    }
+}
+
+/*! \brief Marks the block that contains the INCLUDE statement at \a offset.
+ */
+void ZoneMap::appendInclude(const size_t offset)
+{
+    const size_t index = offset / BLOCK_SIZE;
+    if (index < m_zones.size()) {
+        m_zones[index].hasInclude = true;
+    }
+}
+
+/*! \brief Ends the building, and computes the per-file summary.
+ */
+void ZoneMap::finish()
+{
+    for (vector<Zone>::const_iterator it = m_zones.begin(); it != m_zones.end(); ++it) {
+        if (it->minimum < m_minimum) {
+            m_minimum = it->minimum;
+        }
+        if (it->maximum > m_maximum) {
+            m_maximum = it->maximum;
+        }
+        m_hasInclude = m_hasInclude || it->hasInclude;
+    }
+    m_currentZone = -1;
+    m_isBuilt = true;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*! \brief Returns true if a card of the file can have an ID in the range
+ *         [\a minimum, \a maximum].
+ */
+bool ZoneMap::overlaps(const long long minimum, const long long maximum) const
+{
+    return m_minimum <= maximum && m_maximum >= minimum;
+}
+
+/*! \brief Returns the index of the first zone from \a index that has a card,
+ *         or zoneCount() if none.
+ */
+int ZoneMap::nextZone(const int index) const
+{
+    int i = index;
+    while (i < zoneCount() && m_zones[(size_t)i].offset == NO_CARD) {
+        ++i;
+    }
+    return i;
+}
+
+/*! \brief Returns the index of the first zone from \a index that can't be
+ *         skipped for the range [\a minimum, \a maximum], or zoneCount() if
+ *         the end of the file can be skipped.
+ */
+int ZoneMap::nextZone(const int index, const long long minimum, const long long maximum) const
+{
+    for (int i = nextZone(index); i < zoneCount(); i = nextZone(i + 1)) {
+        const Zone &zone = m_zones[(size_t)i];
+        if (zone.hasInclude || (zone.minimum <= maximum && zone.maximum >= minimum)) {
+            return i;
+        }
+    }
+    return zoneCount();
+}
+
+/*! \brief Returns the memory used by the map, in bytes.
+ */
+size_t ZoneMap::memoryUsage() const
+{
+    return sizeof(ZoneMap) + m_zones.capacity() * sizeof(Zone);
+}
@@ -0,0 +1,80 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ZONE_MAP_H
+#define ZONE_MAP_H
+
+#include <cstddef>
+#include <vector>
+
+/*! \brief Summary of the cards starting in a block of a file.
+ */
+struct Zone
+{
+    long long minimum;      ///< Smallest card ID, or greater than maximum if none
+    long long maximum;      ///< Greatest card ID
+    std::size_t offset;     ///< Offset of the first card, or ZoneMap::NO_CARD
+    int lineNumber;         ///< Line number of the first card
+    bool isBulk;            ///< True if the first card is in the Bulk Data section
+    bool hasInclude;        ///< True if the block contains an INCLUDE statement
+};
+
+class ZoneMap
+{
+public:
+    static const std::size_t BLOCK_SIZE = 64 * 1024;
+    static const std::size_t NO_CARD = static_cast<std::size_t>(-1);
+
+    explicit ZoneMap();
+
+    void clear();
+    void reset(const std::size_t fileSize, const long long modificationTime);
+
+    bool isBuilt() const { return m_isBuilt; }
+    bool isBuiltFor(const std::size_t fileSize, const long long modificationTime) const;
+
+    /* Building, while the file is scanned */
+    void appendCard(const std::size_t offset, const int lineNumber, const bool isBulk);
+    void appendId(const long long id);
+    void appendInclude(const std::size_t offset);
+    void finish();
+
+    /* Per-file summary */
+    long long minimum() const { return m_minimum; }
+    long long maximum() const { return m_maximum; }
+    bool hasInclude() const { return m_hasInclude; }
+    bool overlaps(const long long minimum, const long long maximum) const;
+
+    /* Per-block summaries */
+    int zoneCount() const { return (int)m_zones.size(); }
+    const Zone& zoneAt(const int index) const { return m_zones.at(index); }
+    int nextZone(const int index) const;
+    int nextZone(const int index, const long long minimum, const long long maximum) const;
+
+    std::size_t memoryUsage() const;
+
+private:
+    std::vector<Zone> m_zones;
+    std::size_t m_fileSize;
+    long long m_modificationTime;
+    long long m_minimum;
+    long long m_maximum;
+    bool m_hasInclude;
+    bool m_isBuilt;
+    int m_currentZone;
+};
+
+#endif // ZONE_MAP_H
@@ -1,7 +1,23 @@
 TEMPLATE=subdirs
 
+SUBDIRS += crossreference
 SUBDIRS += engine
 SUBDIRS += engine_include
+SUBDIRS += entityindex
 SUBDIRS += fileinfo
+SUBDIRS += filewatcher
+SUBDIRS += fingerprint
+SUBDIRS += includetree
+SUBDIRS += lineindex
+SUBDIRS += memorystats
+SUBDIRS += modeldiff
+SUBDIRS += pager
+SUBDIRS += query
+SUBDIRS += scanner
 SUBDIRS += search
+SUBDIRS += spillfile
 SUBDIRS += stringhelper
+SUBDIRS += termindex
+SUBDIRS += tokenizer
+SUBDIRS += ziparchive
+SUBDIRS += zonemap
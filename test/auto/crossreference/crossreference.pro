@@ -0,0 +1,20 @@
+#isEmpty(TEMPLATE):TEMPLATE=app
+TARGET       = tst_crossreference
+CONFIG      += testcase
+QT           = core testlib
+SOURCES     += tst_crossreference.cpp
+
+# Include:
+INCLUDEPATH += $$PWD/../../../include
+
+# Dependancies:
+HEADERS += $$PWD/../../../src/crossreference.h
+SOURCES += $$PWD/../../../src/crossreference.cpp
+HEADERS += $$PWD/../../../src/entityindex.h
+HEADERS += $$PWD/../../../src/query.h
+SOURCES += $$PWD/../../../src/query.cpp
+HEADERS += $$PWD/../../../src/scanner.h
+SOURCES += $$PWD/../../../src/scanner.cpp
+HEADERS += $$PWD/../../../src/systemdetection.h
+HEADERS += $$PWD/../../../src/tokenizer.h
+SOURCES += $$PWD/../../../src/tokenizer.cpp
@@ -0,0 +1,276 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QtTest/QtTest>
+#include <QtCore/QDebug>
+
+#include <CrossReference>
+
+#include <sstream>
+
+class tst_CrossReference : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_grid_elements();
+    void test_property_elements();
+    void test_material_properties();
+    void test_continuation();
+    void test_parallel();
+    void test_undefined();
+    void test_scalar_points();
+    void test_relation();
+};
+
+/******************************************************************************
+ ******************************************************************************/
+static std::vector<long long> referencesOf(const std::string &deck,
+                                           const CrossReference::Relation relation,
+                                           const long long id,
+                                           const int threadCount = 1)
+{
+    CrossReference xref;
+    std::vector<TextBuffer> buffers;
+    TextBuffer buffer = { deck.data(), deck.data() + deck.size() };
+    buffers.push_back(buffer);
+    xref.build(buffers, threadCount);
+    return xref.referencesOf(relation, id);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_CrossReference::test_grid_elements()
+{
+    // Given
+    const std::string deck =
+            "$ Comment CQUAD4  99      1       1001\n"
+            "GRID    1001            0.      0.      0.\n"
+            "CQUAD4  12      20      1001    1002    1003    1004\n"
+            "CTRIA3  13      20      1003    1001    1005\n"
+            "CBAR    14      30      1006    1007    1001\n"  /* orientation node */
+            "CONM2   15      1001    0       1.0\n"
+            "cquad4,16,20,1002,1001,1008,1009\n"
+            "CQUAD4* 17              20              1001            1010\n"
+            "*       1011            1012\n";
+
+    // When
+    const std::vector<long long> elements =
+            referencesOf(deck, CrossReference::Relation::GRID_ELEMENTS, 1001);
+
+    // Then
+    std::vector<long long> expected;
+    expected.push_back(12);
+    expected.push_back(13);
+    expected.push_back(15);
+    expected.push_back(16);
+    expected.push_back(17);
+    QCOMPARE( elements, expected );
+}
+
+void tst_CrossReference::test_property_elements()
+{
+    // Given
+    const std::string deck =
+            "CQUAD4  12      20      1001    1002    1003    1004\n"
+            "CTRIA3  13      21      1003    1001    1005\n"
+            "CQUAD4  14      20      1005    1006    1007    1008\n"
+            "CONROD  15      1001    1002    20\n"  /* MID, not PID */
+            "PSHELL  20      3       1.0\n";
+
+    // When
+    const std::vector<long long> elements =
+            referencesOf(deck, CrossReference::Relation::PROPERTY_ELEMENTS, 20);
+
+    // Then
+    std::vector<long long> expected;
+    expected.push_back(12);
+    expected.push_back(14);
+    QCOMPARE( elements, expected );
+}
+
+void tst_CrossReference::test_material_properties()
+{
+    // Given
+    const std::string deck =
+            "PSHELL  20      3       1.0     3\n"
+            "PSHELL  21      4       1.0     4               3\n"
+            "PBARL   22      3               BAR\n"
+            "PCOMP   23\n"
+            "        4       0.1     0.      YES     3       0.1     45.     YES\n"
+            "        5       0.1     90.     YES     3       0.1     0.      YES\n"
+            "MAT1    3       70000.          0.3\n";
+
+    // When
+    const std::vector<long long> properties =
+            referencesOf(deck, CrossReference::Relation::MATERIAL_PROPERTIES, 3);
+
+    // Then
+    std::vector<long long> expected;
+    expected.push_back(20);
+    expected.push_back(21);
+    expected.push_back(22);
+    expected.push_back(23);
+    QCOMPARE( properties, expected );
+}
+
+void tst_CrossReference::test_continuation()
+{
+    // Given
+    const std::string deck =
+            "CHEXA   100     5       1       2       3       4       5       6       +\n"
+            "+       7       8       9       10      11      12      13      14      +\n"
+            "+       15      16      17      18      19      20\n"
+            "CHEXA   101     5       21      22      23      24      25      26\n"
+            "        27      28\n";
+
+    // When
+    CrossReference xref;
+    std::vector<TextBuffer> buffers;
+    TextBuffer buffer = { deck.data(), deck.data() + deck.size() };
+    buffers.push_back(buffer);
+    xref.build(buffers, 1);
+
+    // Then
+    QCOMPARE( (int)xref.referenceCount(CrossReference::Relation::GRID_ELEMENTS, 20), 1 );
+    QCOMPARE( (int)xref.referenceCount(CrossReference::Relation::GRID_ELEMENTS, 28), 1 );
+    QCOMPARE( (int)xref.referenceCount(CrossReference::Relation::GRID_ELEMENTS, 29), 0 );
+    QCOMPARE( (int)xref.edgeCount(CrossReference::Relation::GRID_ELEMENTS), 28 );
+    QCOMPARE( (int)xref.referenceCount(CrossReference::Relation::PROPERTY_ELEMENTS, 5), 2 );
+}
+
+void tst_CrossReference::test_parallel()
+{
+    // Given
+    /* Several chunks, each shared grid used by 4 elements */
+    std::ostringstream stream;
+    const int count = 60000;
+    for (int i = 0; i < count; ++i) {
+        const int g = i + 1;
+        stream << "CQUAD4,"  << (i + 1) << "," << (i % 7 + 1) << ","
+               << g << "," << (g + 1) << "," << (g + count + 1) << "," << (g + count)
+               << "\n";
+    }
+    const std::string deck = stream.str();
+    QVERIFY( deck.size() > 2 * 1024 * 1024 );
+
+    // When
+    const std::vector<long long> serial =
+            referencesOf(deck, CrossReference::Relation::GRID_ELEMENTS, 30001, 1);
+    const std::vector<long long> parallel =
+            referencesOf(deck, CrossReference::Relation::GRID_ELEMENTS, 30001, 4);
+    const std::vector<long long> property =
+            referencesOf(deck, CrossReference::Relation::PROPERTY_ELEMENTS, 3, 4);
+
+    // Then
+    std::vector<long long> expected;
+    expected.push_back(30000);
+    expected.push_back(30001);
+    QCOMPARE( serial, expected );
+    QCOMPARE( parallel, expected );
+    QCOMPARE( (int)property.size(), count / 7 + 1 );
+    QCOMPARE( property.front(), 3LL );
+    QCOMPARE( property.back(), (long long)(count - (count - 3) % 7) );
+}
+
+void tst_CrossReference::test_undefined()
+{
+    // Given
+    std::ostringstream stream;
+    const int count = 10000;
+    for (int i = 0; i < count; ++i) {
+        stream << "CBAR," << (i + 1) << ",1," << (i + 1) << "," << (i + 2) << "\n";
+    }
+    const std::string deck = stream.str();
+    CrossReference xref;
+    std::vector<TextBuffer> buffers;
+    TextBuffer buffer = { deck.data(), deck.data() + deck.size() };
+    buffers.push_back(buffer);
+    xref.build(buffers, 1);
+
+    /* Every 1000th grid is missing */
+    auto isDefined = [](long long id) { return id % 1000 != 0; };
+
+    // When
+    const std::vector<CrossReference::Reference> serial =
+            xref.findUndefined(CrossReference::Relation::GRID_ELEMENTS, isDefined, 1);
+    const std::vector<CrossReference::Reference> parallel =
+            xref.findUndefined(CrossReference::Relation::GRID_ELEMENTS, isDefined, 4);
+
+    // Then
+    QCOMPARE( (int)serial.size(), 2 * (count / 1000) );
+    QCOMPARE( serial.at(0).target, 1000LL );
+    QCOMPARE( serial.at(0).source, 999LL );
+    QCOMPARE( serial.at(1).target, 1000LL );
+    QCOMPARE( serial.at(1).source, 1000LL );
+    QCOMPARE( (int)parallel.size(), (int)serial.size() );
+    for (std::size_t i = 0; i < serial.size(); ++i) {
+        QCOMPARE( parallel.at(i).target, serial.at(i).target );
+        QCOMPARE( parallel.at(i).source, serial.at(i).source );
+    }
+    QVERIFY( xref.findUndefined(CrossReference::Relation::MATERIAL_PROPERTIES, isDefined).empty() );
+}
+
+void tst_CrossReference::test_scalar_points()
+{
+    // Given
+    const std::string deck =
+            "SPOINT  101     THRU    110\n"
+            "SPOINT,120,130,125\n"
+            "spoint  111     112\n"
+            "EPOINT  200     THRU    210     300\n"
+            "        301\n"
+            "CELAS2  1       1.E3    105             200\n";
+    CrossReference xref;
+    std::vector<TextBuffer> buffers;
+    TextBuffer buffer = { deck.data(), deck.data() + deck.size() };
+    buffers.push_back(buffer);
+
+    // When
+    xref.build(buffers, 1);
+
+    // Then
+    QVERIFY( !xref.isScalarPoint(100) );
+    QVERIFY( xref.isScalarPoint(101) );
+    QVERIFY( xref.isScalarPoint(110) );
+    QVERIFY( xref.isScalarPoint(112) );
+    QVERIFY( !xref.isScalarPoint(113) );
+    QVERIFY( xref.isScalarPoint(125) );
+    QVERIFY( !xref.isScalarPoint(126) );
+    QVERIFY( xref.isScalarPoint(205) );
+    QVERIFY( !xref.isScalarPoint(211) );
+    QVERIFY( xref.isScalarPoint(301) );
+    QVERIFY( !xref.isScalarPoint(1) );
+    QCOMPARE( (int)xref.referenceCount(CrossReference::Relation::GRID_ELEMENTS, 105), 1 );
+}
+
+void tst_CrossReference::test_relation()
+{
+    CrossReference::Relation relation;
+    QVERIFY( CrossReference::relationOf("grid", &relation) );
+    QCOMPARE( (int)relation, (int)CrossReference::Relation::GRID_ELEMENTS );
+    QVERIFY( CrossReference::relationOf("PID", &relation) );
+    QCOMPARE( (int)relation, (int)CrossReference::Relation::PROPERTY_ELEMENTS );
+    QVERIFY( CrossReference::relationOf("MID", &relation) );
+    QCOMPARE( (int)relation, (int)CrossReference::Relation::MATERIAL_PROPERTIES );
+    QVERIFY( !CrossReference::relationOf("EID", &relation) );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+
+QTEST_APPLESS_MAIN(tst_CrossReference)
+
+#include "tst_crossreference.moc"
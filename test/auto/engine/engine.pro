@@ -12,10 +12,43 @@ SOURCES     += tst_engine.cpp
 INCLUDEPATH += $$PWD/../../../include
 
 # Dependancies:
+HEADERS += $$PWD/../../../src/compression.h
+SOURCES += $$PWD/../../../src/compression.cpp
+HEADERS += $$PWD/../../../src/crossreference.h
+SOURCES += $$PWD/../../../src/crossreference.cpp
 HEADERS += $$PWD/../../../src/engine.h
 SOURCES += $$PWD/../../../src/engine.cpp
+HEADERS += $$PWD/../../../src/entityindex.h
+SOURCES += $$PWD/../../../src/entityindex.cpp
+HEADERS += $$PWD/../../../src/filecache.h
+SOURCES += $$PWD/../../../src/filecache.cpp
 HEADERS += $$PWD/../../../src/fileinfo.h
 SOURCES += $$PWD/../../../src/fileinfo.cpp
+HEADERS += $$PWD/../../../src/fingerprint.h
+SOURCES += $$PWD/../../../src/fingerprint.cpp
+HEADERS += $$PWD/../../../src/lineindex.h
+SOURCES += $$PWD/../../../src/lineindex.cpp
+HEADERS += $$PWD/../../../src/mappedfile.h
+SOURCES += $$PWD/../../../src/mappedfile.cpp
+HEADERS += $$PWD/../../../src/memorystats.h
+SOURCES += $$PWD/../../../src/memorystats.cpp
+HEADERS += $$PWD/../../../src/query.h
+SOURCES += $$PWD/../../../src/query.cpp
+HEADERS += $$PWD/../../../src/scanner.h
+SOURCES += $$PWD/../../../src/scanner.cpp
+HEADERS += $$PWD/../../../src/spillfile.h
+SOURCES += $$PWD/../../../src/spillfile.cpp
 HEADERS += $$PWD/../../../src/stringhelper.h
 SOURCES += $$PWD/../../../src/stringhelper.cpp
 HEADERS += $$PWD/../../../src/systemdetection.h
+HEADERS += $$PWD/../../../src/termindex.h
+SOURCES += $$PWD/../../../src/termindex.cpp
+HEADERS += $$PWD/../../../src/tokenizer.h
+SOURCES += $$PWD/../../../src/tokenizer.cpp
+HEADERS += $$PWD/../../../src/ziparchive.h
+SOURCES += $$PWD/../../../src/ziparchive.cpp
+HEADERS += $$PWD/../../../src/zonemap.h
+SOURCES += $$PWD/../../../src/zonemap.cpp
+
+# Libraries:
+LIBS += -lz
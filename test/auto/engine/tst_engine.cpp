@@ -17,6 +17,10 @@
 #include <QtCore/QDebug>
 
 #include <Engine>
+#include <FileInfo>
+
+#include <cstdio>
+#include <fstream>
 
 class tst_Engine : public QObject
 {
@@ -32,6 +36,21 @@ private slots:
     void test_cyclic_complex();
     void test_duplicate_1();
     void test_duplicate_2();
+    void test_locate();
+    void test_cross_reference();
+    void test_duplicate_ids();
+    void test_undefined_references();
+    void test_shared_file_cache();
+    void test_same_content();
+    void test_fingerprint();
+    void test_refresh();
+    void test_changed_original();
+    void test_compressed();
+    void test_zip_archive();
+    void test_line_index();
+    void test_file_stats();
+    void test_term_index();
+    void test_validate_term_index();
     void test_first_last_line();
     void test_multiline();
     void test_quotes();
@@ -255,6 +274,482 @@ void tst_Engine::test_duplicate_2()
     QCOMPARE( engine.errorAt(0), error_msg);
 }
 
+/******************************************************************************
+ ******************************************************************************/
+void tst_Engine::test_locate()
+{
+    // Given
+    Engine engine;
+    std::string filename = QFINDTESTDATA("share/entities/test.dat").toLatin1().data();
+    std::string file;
+    EntityLocation location;
+
+    // When
+    engine.find(filename, "");
+
+    // Then
+    QCOMPARE( (int)engine.errorCount(), 0);
+
+    QVERIFY( engine.locate("GRID", 2, &file, &location) );
+    QCOMPARE( file, std::string("test.dat") );
+    QCOMPARE( location.lineNumber, 8 );
+
+    QVERIFY( engine.locate("GRID", 3, &file, &location) );
+    QCOMPARE( file, std::string("include.dat") );
+    QCOMPARE( location.lineNumber, 4 );
+    QCOMPARE( (int)location.offset, 24 );
+
+    QVERIFY( engine.locate("CQUAD4", 1002, &file, &location) ); /* any element */
+    QCOMPARE( location.lineNumber, 5 );
+
+    QVERIFY( engine.locate("PCOMP", 10, &file, &location) );    /* any property */
+    QCOMPARE( file, std::string("test.dat") );
+    QCOMPARE( location.lineNumber, 10 );
+
+    QVERIFY( engine.locate("MAT1", 100, &file, &location) );
+    QVERIFY( engine.locate("RBE3", 5000, &file, &location) );
+
+    QVERIFY( !engine.locate("GRID", 1001, &file, &location) );
+    QVERIFY( !engine.locate("SOL", 101, &file, &location) );
+}
+
+void tst_Engine::test_cross_reference()
+{
+    // Given
+    Engine engine;
+    std::string filename = QFINDTESTDATA("share/entities/test.dat").toLatin1().data();
+    engine.find(filename, "");
+
+    // When
+    engine.buildCrossReference();
+
+    // Then
+    const CrossReference& xref = engine.crossReference();
+    QVERIFY( xref.isBuilt() );
+
+    /* The elements of both files */
+    const std::vector<long long> elements =
+            xref.referencesOf(CrossReference::Relation::GRID_ELEMENTS, 3);
+    QCOMPARE( (int)elements.size(), 2 );
+    QCOMPARE( elements.at(0), 1001LL );
+    QCOMPARE( elements.at(1), 1002LL );
+    QCOMPARE( (int)xref.referenceCount(CrossReference::Relation::GRID_ELEMENTS, 4), 1 );
+    QCOMPARE( (int)xref.referenceCount(CrossReference::Relation::PROPERTY_ELEMENTS, 10), 2 );
+    QCOMPARE( (int)xref.referenceCount(CrossReference::Relation::MATERIAL_PROPERTIES, 100), 1 );
+    QCOMPARE( (int)xref.referenceCount(CrossReference::Relation::GRID_ELEMENTS, 123456), 0 );
+}
+
+void tst_Engine::test_duplicate_ids()
+{
+    // Given
+    Engine engine;
+    std::string filename = QFINDTESTDATA("share/duplicate_ids/test.dat").toLatin1().data();
+    engine.find(filename, "");
+
+    // When
+    const std::vector<EntityIndex::Duplicate> duplicates = engine.findDuplicates();
+
+    // Then
+    QCOMPARE( (int)engine.errorCount(), 0);
+    QCOMPARE( (int)duplicates.size(), 4 );
+
+    /* In the same file */
+    QCOMPARE( (int)duplicates.at(0).family, (int)EntityIndex::Family::GRID );
+    QCOMPARE( duplicates.at(0).id, 1LL );
+    QCOMPARE( engine.files().at(duplicates.at(0).secondIndex), std::string("test.dat") );
+    QCOMPARE( duplicates.at(0).first.lineNumber, 5 );
+    QCOMPARE( duplicates.at(0).second.lineNumber, 7 );
+
+    /* In two files, whatever the format */
+    QCOMPARE( duplicates.at(1).id, 2LL );
+    QCOMPARE( engine.files().at(duplicates.at(1).firstIndex), std::string("test.dat") );
+    QCOMPARE( engine.files().at(duplicates.at(1).secondIndex), std::string("include.dat") );
+    QCOMPARE( duplicates.at(1).second.lineNumber, 2 );
+
+    /* CQUAD4 10 and CTRIA3 10, PSHELL 10 and PCOMP 10 */
+    QCOMPARE( (int)duplicates.at(2).family, (int)EntityIndex::Family::ELEMENT );
+    QCOMPARE( (int)duplicates.at(3).family, (int)EntityIndex::Family::PROPERTY );
+}
+
+void tst_Engine::test_undefined_references()
+{
+    // Given
+    Engine engine;
+    std::string filename = QFINDTESTDATA("share/entities/test.dat").toLatin1().data();
+    engine.find(filename, "");
+    engine.buildCrossReference();
+
+    // When
+    const std::vector<CrossReference::Reference> grids =
+            engine.findUndefinedReferences(CrossReference::Relation::GRID_ELEMENTS);
+    const std::vector<CrossReference::Reference> properties =
+            engine.findUndefinedReferences(CrossReference::Relation::PROPERTY_ELEMENTS);
+    const std::vector<CrossReference::Reference> materials =
+            engine.findUndefinedReferences(CrossReference::Relation::MATERIAL_PROPERTIES);
+
+    // Then
+    /* The grids 1 to 3 are defined in both files, but not the grid 4 */
+    QCOMPARE( (int)grids.size(), 1 );
+    QCOMPARE( grids.at(0).target, 4LL );
+    QCOMPARE( grids.at(0).source, 1001LL );
+    QVERIFY( properties.empty() );
+    QVERIFY( materials.empty() );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Engine::test_shared_file_cache()
+{
+    // Given
+    Engine engine;
+    Engine other;
+    other.setFileCache(engine.fileCache());
+    std::string filename = QFINDTESTDATA("share/duplicate_ids/test.dat").toLatin1().data();
+
+    // When
+    engine.find(filename, "");
+    other.find(filename, "GRID");
+
+    // Then
+    QCOMPARE( (int)engine.fileCache()->fileCount(), 2 );
+    QVERIFY( engine.fileCache()->find(engine.filePaths().at(1))
+             == other.fileCache()->find(other.filePaths().at(1)) );
+
+    std::string file;
+    EntityLocation location;
+    QVERIFY( other.locate("GRID", 2, &file, &location) );
+    QCOMPARE( file, std::string("test.dat") );
+    QVERIFY( other.resultCountAll() > 0 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Engine::test_same_content()
+{
+    // Given
+    Engine engine;
+    std::string filename = QFINDTESTDATA("share/same_content/test.dat").toLatin1().data();
+
+    // When
+    engine.find(filename, "GRID");
+    engine.find(filename, "GRID"); /* the second time, the copy isn't scanned */
+
+    // Then
+    QCOMPARE( (int)engine.errorCount(), 0);
+    QCOMPARE( (int)engine.linkCount(), 3);
+    QCOMPARE( engine.files().at(1), std::string("a/part.dat") );
+    QCOMPARE( engine.files().at(2), std::string("b/part.dat") );
+
+    /* The content is stored once */
+    const FileCache& cache = *engine.fileCache();
+    QCOMPARE( (int)cache.fileCount(), 3 );
+    QCOMPARE( (int)cache.contentCount(), 2 );
+    QVERIFY( cache.find(engine.filePaths().at(2))->original
+             == cache.find(engine.filePaths().at(1)) );
+
+    /* The results are attributed to both files */
+    QCOMPARE( (int)engine.resultCount("a/part.dat"), 3 );
+    QCOMPARE( (int)engine.resultCount("b/part.dat"), 3 );
+    QCOMPARE( engine.resultAt("b/part.dat", 2), engine.resultAt("a/part.dat", 2) );
+    QCOMPARE( (int)engine.occurrenceCountAll(), 7 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Engine::test_fingerprint()
+{
+    // Given
+    Engine engine;
+    Fingerprint fingerprint;
+    std::string filename = QFINDTESTDATA("share/subdirectory/test/test.dat").toLatin1().data();
+    engine.find(filename, "");
+
+    // When
+    const std::uint64_t first = engine.fingerprint(filename, &fingerprint);
+    const std::uint64_t second = engine.fingerprint(filename, &fingerprint);
+
+    // Then
+    QCOMPARE( first, second );
+    QCOMPARE( fingerprint.fileCount(), (std::size_t)engine.linkCount() );
+    QCOMPARE( (int)fingerprint.readCount(), 0 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+static void writeFile(const char *fileName, const char *text)
+{
+    std::ofstream file(fileName, std::ios::out | std::ios::trunc);
+    file << text;
+}
+
+void tst_Engine::test_refresh()
+{
+    // Given
+    writeFile("tst_refresh.dat", "GRID,1\nINCLUDE 'tst_refresh_a.dat'\n");
+    writeFile("tst_refresh_a.dat", "GRID,2\n");
+    writeFile("tst_refresh_b.dat", "GRID,3\nGRID,4\n");
+    Engine engine;
+    engine.find(FileInfo::absoluteFilePath("tst_refresh.dat"), "GRID");
+    QCOMPARE( (int)engine.linkCount(), 2);
+    QCOMPARE( (int)engine.occurrenceCountAll(), 2 );
+
+    // When
+    writeFile("tst_refresh_a.dat", "GRID,2\nINCLUDE 'tst_refresh_b.dat'\n");
+    const int scannedCount = (int)engine.refresh();
+
+    // Then
+    QCOMPARE( scannedCount, 2 ); /* the modified file, and the new one */
+    QCOMPARE( (int)engine.errorCount(), 0);
+    QCOMPARE( (int)engine.linkCount(), 3);
+    QCOMPARE( engine.files().at(2), std::string("tst_refresh_b.dat") );
+    QCOMPARE( (int)engine.resultCount("tst_refresh.dat"), 1 );
+    QCOMPARE( (int)engine.resultCount("tst_refresh_b.dat"), 2 );
+    QCOMPARE( (int)engine.occurrenceCountAll(), 4 );
+
+    /* Nothing changed: the results are kept */
+    QCOMPARE( (int)engine.refresh(), 0 );
+    QCOMPARE( (int)engine.linkCount(), 3);
+    QCOMPARE( (int)engine.occurrenceCountAll(), 4 );
+
+    std::remove("tst_refresh.dat");
+    std::remove("tst_refresh_a.dat");
+    std::remove("tst_refresh_b.dat");
+}
+
+void tst_Engine::test_changed_original()
+{
+    // Given
+    writeFile("tst_original_a.dat", "GRID,2\n");
+    writeFile("tst_original_b.dat", "GRID,2\n");
+    const std::string a = FileInfo::absoluteFilePath("tst_original_a.dat");
+    const std::string b = FileInfo::absoluteFilePath("tst_original_b.dat");
+    FileCache cache;
+    cache.open(a);
+    QVERIFY( cache.open(b)->original == cache.find(a) );
+
+    // When
+    /* The copy is open before the original, that changed */
+    writeFile("tst_original_a.dat", "GRID,2\nGRID,3\n");
+    FileCache::Entry *entry = cache.open(b);
+
+    // Then
+    QVERIFY( entry != NULL );
+    QVERIFY( entry->original == NULL );
+    QCOMPARE( std::string(entry->content().file.begin(), entry->content().file.end()),
+              std::string("GRID,2\n") );
+    QCOMPARE( (int)cache.open(a)->file.size(), 14 );
+    QCOMPARE( (int)cache.contentCount(), 2 );
+
+    std::remove("tst_original_a.dat");
+    std::remove("tst_original_b.dat");
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Engine::test_compressed()
+{
+    // Given
+    Engine engine;
+    std::string filename = QFINDTESTDATA("share/compressed/test.dat.gz").toLatin1().data();
+
+    // When
+    engine.find(filename, "GRID");
+
+    // Then
+    QCOMPARE( (int)engine.errorCount(), 0);
+    QCOMPARE( (int)engine.linkCount(), 3);
+    QCOMPARE( engine.files().at(1), std::string("part_a.dat.gz") );
+    QCOMPARE( engine.files().at(2), std::string("part_b.dat") ); /* part_b.dat.gz */
+    QCOMPARE( (int)engine.resultCount("test.dat.gz"), 1 );
+    QCOMPARE( (int)engine.resultCount("part_a.dat.gz"), 2 );
+    QCOMPARE( (int)engine.resultCount("part_b.dat"), 1 );
+    QCOMPARE( (int)engine.occurrenceCountAll(), 4 );
+
+    /* The decompressed files are kept in the cache */
+    engine.find(filename, "GRID");
+    QCOMPARE( (int)engine.occurrenceCountAll(), 4 );
+    QCOMPARE( (int)engine.fileCache()->fileCount(), 3 );
+}
+
+void tst_Engine::test_zip_archive()
+{
+    // Given
+    Engine engine;
+    std::string filename = QFINDTESTDATA("share/archive/model.zip").toLatin1().data();
+    filename += ":main.dat";
+
+    // When
+    engine.find(filename, "GRID");
+
+    // Then
+    QCOMPARE( (int)engine.errorCount(), 0);
+    QCOMPARE( (int)engine.linkCount(), 3);
+    QCOMPARE( engine.files().at(0), std::string("main.dat") );
+    QCOMPARE( (int)engine.resultCount("main.dat"), 2 ); /* and its INCLUDE */
+    QCOMPARE( (int)engine.resultCount("bulk\\grid.dat"), 2 );
+    QCOMPARE( (int)engine.resultCount("bulk/../PROPS.DAT"), 0 );
+    QCOMPARE( (int)engine.occurrenceCountAll(), 4 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Engine::test_line_index()
+{
+    // Given
+    Engine engine;
+    std::string filename = QFINDTESTDATA("share/duplicate_ids/test.dat").toLatin1().data();
+
+    // When
+    engine.find(filename, "GRID");
+
+    // Then
+    for (std::size_t i = 0; i < engine.filePaths().size(); ++i) {
+        const FileCache::Entry *entry = engine.fileCache()->find(engine.filePaths().at(i));
+        QVERIFY( entry != NULL );
+        const MappedFile& file = entry->content().file;
+        const LineIndex& index = entry->content().index.lineIndex;
+
+        /* Built during the scan, as in one pass */
+        LineIndex expected;
+        expected.build(file.begin(), file.end());
+        QVERIFY( index.lineCount() > 0 );
+        QCOMPARE( index.lineCount(), expected.lineCount() );
+        for (std::size_t line = 1; line <= index.lineCount(); ++line) {
+            const std::size_t offset = index.lineOffset(file.begin(), file.end(), line);
+            QCOMPARE( offset, expected.lineOffset(file.begin(), file.end(), line) );
+            QCOMPARE( index.lineAt(file.begin(), file.end(), offset), line );
+        }
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Engine::test_file_stats()
+{
+    // Given
+    Engine engine;
+    std::string filename = QFINDTESTDATA("share/cyclic/test_complex.dat").toLatin1().data();
+
+    // When
+    engine.find(filename, "INCLUDE");
+
+    // Then
+    /* test_complex.dat > included_A > included_B > included_C */
+    const std::vector<FileStats>& stats = engine.fileStats();
+    QCOMPARE( stats.size(), engine.files().size() );
+    QCOMPARE( (int)stats.size(), 4 );
+    QCOMPARE( stats.at(0).parent, -1 );
+    QCOMPARE( stats.at(1).parent, 0 );
+    QCOMPARE( stats.at(1).lineNumber, 6 );
+    QCOMPARE( stats.at(2).parent, 1 );
+    QCOMPARE( stats.at(3).parent, 2 );
+    QCOMPARE( stats.at(3).lineNumber, 2 );
+
+    QCOMPARE( (int)stats.at(0).size, 125 );
+    QCOMPARE( (int)stats.at(0).lineCount, 6 );
+    QCOMPARE( (int)stats.at(1).size, 27 );
+    QCOMPARE( (int)stats.at(1).lineCount, 3 );
+    for (std::size_t i = 0; i < stats.size(); ++i) {
+        QVERIFY( stats.at(i).loadTime >= 0. );
+        QVERIFY( stats.at(i).scanTime >= 0. );
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Engine::test_term_index()
+{
+    // Given
+    writeFile("tst_term.dat", "$ main\nINCLUDE 'tst_term_a.dat'\nINCLUDE 'tst_term_b.dat'\n");
+    writeFile("tst_term_a.dat",
+              "CBAR    1       1       1       2       0.      1.      0.              +CB1\n"
+              "+CB1    2\n"
+              "INCLUDE 'tst_term_c.dat'\n");
+    writeFile("tst_term_b.dat", "GRID    1\n");
+    writeFile("tst_term_c.dat", "CQUAD4  1001    1       1       2       3       4\n");
+    const std::string filename = FileInfo::absoluteFilePath("tst_term.dat");
+
+    std::shared_ptr<TermIndex> index(new TermIndex());
+    Engine engine;
+    engine.setTermIndex(index);
+    engine.find(filename, "CQUAD4");
+    QCOMPARE( (int)index->recordCount(), 4 );
+    QCOMPARE( (int)engine.skippedCount(), 0 );
+
+    // When
+    Engine other;
+    other.setTermIndex(index);
+    other.find(filename, "CQUAD4");
+
+    // Then
+    /* Only the file that contains the text is loaded */
+    QCOMPARE( (int)other.skippedCount(), 3 );
+    QCOMPARE( other.files(), engine.files() );
+    QCOMPARE( (int)other.errorCount(), 0 );
+    QCOMPARE( (int)other.occurrenceCountAll(), 1 );
+    QCOMPARE( (int)other.resultCount("tst_term_c.dat"), 1 );
+    QVERIFY( other.fileCache()->find(other.filePaths().at(1)) == NULL );
+    QVERIFY( other.fileCache()->find(other.filePaths().at(3)) != NULL );
+    QVERIFY( other.fileStats().at(1).isSkipped );
+    QCOMPARE( (int)other.fileStats().at(1).lineCount, 3 );
+    QVERIFY( !other.fileStats().at(3).isSkipped );
+
+    /* Across the boundary of a continuation line */
+    other.find(filename, "0.              2");
+    QCOMPARE( (int)other.skippedCount(), 3 );
+    QCOMPARE( (int)other.resultCount("tst_term_a.dat"), 1 );
+
+    /* A file that changed is scanned again */
+    writeFile("tst_term_b.dat", "GRID    1\nCQUAD4  1002    1       1       2       3       4\n");
+    other.find(filename, "CQUAD4");
+    QCOMPARE( (int)other.skippedCount(), 2 );
+    QCOMPARE( (int)other.occurrenceCountAll(), 2 );
+
+    std::remove("tst_term.dat");
+    std::remove("tst_term_a.dat");
+    std::remove("tst_term_b.dat");
+    std::remove("tst_term_c.dat");
+}
+
+void tst_Engine::test_validate_term_index()
+{
+    // Given
+    writeFile("tst_valid.dat", "GRID    1\nINCLUDE 'tst_valid_a.dat'\n");
+    writeFile("tst_valid_a.dat", "CQUAD4  1001    1       1       2       3       4\n");
+    const std::string filename = FileInfo::absoluteFilePath("tst_valid.dat");
+    std::shared_ptr<TermIndex> index(new TermIndex());
+    Engine engine;
+    engine.setTermIndex(index);
+    engine.find(filename, "CQUAD4");
+    QVERIFY( engine.validateTermIndex(filename, "tst_valid.txt") );
+
+    /* The include is saved again without change */
+    std::size_t size = 0;
+    long long before = 0;
+    long long after = 0;
+    MappedFile::status("tst_valid_a.dat", &size, &before);
+    for (int i = 0; i < 1000 && after <= before; ++i) {
+        writeFile("tst_valid_a.dat", "CQUAD4  1001    1       1       2       3       4\n");
+        MappedFile::status("tst_valid_a.dat", &size, &after);
+    }
+    QVERIFY( after > before );
+
+    // When
+    Engine other;
+    other.setTermIndex(index);
+    const bool saved = other.validateTermIndex(filename, "tst_valid.txt");
+    other.find(filename, "GRID");
+
+    // Then
+    QVERIFY( saved );
+    QCOMPARE( (int)other.skippedCount(), 1 );
+    QCOMPARE( (int)other.occurrenceCountAll(), 1 );
+
+    std::remove("tst_valid.dat");
+    std::remove("tst_valid_a.dat");
+    std::remove("tst_valid.txt");
+}
+
 /******************************************************************************
  ******************************************************************************/
 void tst_Engine::test_first_last_line()
@@ -0,0 +1,15 @@
+#isEmpty(TEMPLATE):TEMPLATE=app
+TARGET       = tst_entityindex
+CONFIG      += testcase
+QT           = core testlib
+SOURCES     += tst_entityindex.cpp
+
+# Include:
+INCLUDEPATH += $$PWD/../../../include
+
+# Dependancies:
+HEADERS += $$PWD/../../../src/entityindex.h
+SOURCES += $$PWD/../../../src/entityindex.cpp
+HEADERS += $$PWD/../../../src/scanner.h
+SOURCES += $$PWD/../../../src/scanner.cpp
+HEADERS += $$PWD/../../../src/systemdetection.h
@@ -0,0 +1,260 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QtTest/QtTest>
+#include <QtCore/QDebug>
+
+#include <EntityIndex>
+
+class tst_EntityIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_family();
+    void test_family_data();
+    void test_insert_find();
+    void test_duplicate();
+    void test_find_duplicates();
+    void test_find_duplicates_parallel();
+    void test_set();
+    void test_merge();
+    void test_many_ids();
+};
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_EntityIndex::test_family_data()
+{
+    QTest::addColumn<QString>("name");
+    QTest::addColumn<int>("expected");
+
+    QTest::newRow("grid")       << "GRID"    << (int)EntityIndex::Family::GRID;
+    QTest::newRow("large")      << "GRID*"   << (int)EntityIndex::Family::GRID;
+    QTest::newRow("lower case") << "cquad4"  << (int)EntityIndex::Family::ELEMENT;
+    QTest::newRow("mass")       << "CONM2"   << (int)EntityIndex::Family::ELEMENT;
+    QTest::newRow("property")   << "PBEAML"  << (int)EntityIndex::Family::PROPERTY;
+    QTest::newRow("material")   << "MAT10"   << (int)EntityIndex::Family::MATERIAL;
+    QTest::newRow("coordinate") << "CORD2R"  << (int)EntityIndex::Family::COORDINATE_SYSTEM;
+    QTest::newRow("rigid")      << "RBE3"    << (int)EntityIndex::Family::CONSTRAINT;
+    QTest::newRow("mpc")        << "MPC"     << (int)EntityIndex::Family::SET;
+    QTest::newRow("param")      << "PARAM"   << (int)EntityIndex::Family::UNKNOWN;
+    QTest::newRow("prefix")     << "CQUAD44" << (int)EntityIndex::Family::UNKNOWN;
+    QTest::newRow("empty")      << ""        << (int)EntityIndex::Family::UNKNOWN;
+}
+
+void tst_EntityIndex::test_family()
+{
+    QFETCH(QString, name);
+    QFETCH(int, expected);
+
+    // Given
+    const std::string str = name.toStdString();
+
+    // When
+    const int actual = (int)EntityIndex::familyOf(str.data(), str.size());
+
+    // Then
+    QCOMPARE( actual, expected );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_EntityIndex::test_insert_find()
+{
+    // Given
+    EntityIndex index;
+    EntityLocation location;
+
+    // When
+    QVERIFY( index.insert(EntityIndex::Family::GRID, 123456, 1000, 42) );
+    QVERIFY( index.insert(EntityIndex::Family::ELEMENT, 123456, 2000, 84) );
+
+    // Then
+    QCOMPARE( (int)index.size(), 2 );
+    QVERIFY( index.find(EntityIndex::Family::GRID, 123456, &location) );
+    QCOMPARE( (int)location.offset, 1000 );
+    QCOMPARE( location.lineNumber, 42 );
+    QVERIFY( index.find(EntityIndex::Family::ELEMENT, 123456, &location) );
+    QCOMPARE( (int)location.offset, 2000 );
+    QVERIFY( !index.find(EntityIndex::Family::PROPERTY, 123456, &location) );
+    QVERIFY( !index.find(EntityIndex::Family::GRID, 123457, &location) );
+    QVERIFY( !index.insert(EntityIndex::Family::GRID, -1, 0, 1) );
+}
+
+void tst_EntityIndex::test_duplicate()
+{
+    // Given
+    EntityIndex index;
+    EntityLocation location;
+    index.insert(EntityIndex::Family::GRID, 7, 10, 1);
+
+    // When
+    const bool inserted = index.insert(EntityIndex::Family::GRID, 7, 20, 2);
+
+    // Then
+    QVERIFY( !inserted );
+    QCOMPARE( (int)index.size(), 1 );
+    QVERIFY( index.find(EntityIndex::Family::GRID, 7, &location) );
+    QCOMPARE( location.lineNumber, 1 ); /* the first definition is kept */
+}
+
+void tst_EntityIndex::test_find_duplicates()
+{
+    // Given
+    EntityIndex first;
+    first.insert(EntityIndex::Family::GRID, 1, 0, 1);
+    first.insert(EntityIndex::Family::GRID, 2, 10, 2);
+    first.insert(EntityIndex::Family::ELEMENT, 2, 20, 3);
+    first.insert(EntityIndex::Family::GRID, 1, 30, 4);       /* same file */
+    EntityIndex second;
+    second.insert(EntityIndex::Family::PROPERTY, 2, 0, 1);
+    second.insert(EntityIndex::Family::GRID, 2, 10, 2);      /* other file */
+    std::vector<const EntityIndex*> indexes;
+    indexes.push_back(&first);
+    indexes.push_back(&second);
+
+    // When
+    const std::vector<EntityIndex::Duplicate> duplicates = EntityIndex::findDuplicates(indexes, 1);
+
+    // Then
+    QCOMPARE( (int)duplicates.size(), 2 );
+    QCOMPARE( duplicates.at(0).id, 1LL );
+    QCOMPARE( duplicates.at(0).firstIndex, 0 );
+    QCOMPARE( duplicates.at(0).first.lineNumber, 1 );
+    QCOMPARE( duplicates.at(0).secondIndex, 0 );
+    QCOMPARE( duplicates.at(0).second.lineNumber, 4 );
+    QCOMPARE( (int)duplicates.at(1).family, (int)EntityIndex::Family::GRID );
+    QCOMPARE( duplicates.at(1).id, 2LL );
+    QCOMPARE( duplicates.at(1).firstIndex, 0 );
+    QCOMPARE( duplicates.at(1).first.lineNumber, 2 );
+    QCOMPARE( duplicates.at(1).secondIndex, 1 );
+    QCOMPARE( (int)duplicates.at(1).second.offset, 10 );
+}
+
+void tst_EntityIndex::test_set()
+{
+    // Given
+    /* The MPC 10 is made of several cards, and the RBE2 10 is another entity */
+    EntityIndex first;
+    first.insert(EntityIndex::Family::SET, 10, 0, 1);
+    first.insert(EntityIndex::Family::SET, 10, 10, 2);
+    first.insert(EntityIndex::Family::CONSTRAINT, 10, 20, 3);
+    EntityIndex second;
+    second.insert(EntityIndex::Family::SET, 10, 0, 1);
+    std::vector<const EntityIndex*> indexes;
+    indexes.push_back(&first);
+    indexes.push_back(&second);
+
+    // When
+    const std::vector<EntityIndex::Duplicate> duplicates = EntityIndex::findDuplicates(indexes, 2);
+
+    // Then
+    QCOMPARE( (int)duplicates.size(), 0 );
+    EntityLocation location;
+    QVERIFY( first.find(EntityIndex::Family::SET, 10, &location) );
+    QCOMPARE( location.lineNumber, 1 );
+    QVERIFY( first.find(EntityIndex::Family::CONSTRAINT, 10, &location) );
+    QCOMPARE( location.lineNumber, 3 );
+}
+
+void tst_EntityIndex::test_merge()
+{
+    // Given
+    EntityIndex first;
+    first.insert(EntityIndex::Family::GRID, 1, 0, 1);
+    first.insert(EntityIndex::Family::ELEMENT, 2, 10, 2);
+    EntityIndex second;
+    for (int i = 1; i <= 2000; ++i) {
+        second.insert(EntityIndex::Family::GRID, i, (std::size_t)i * 80, i);
+    }
+
+    // When
+    EntityIndex merged;
+    merged.merge(first, EntityIndex::Family::GRID);
+    merged.merge(second, EntityIndex::Family::GRID);
+
+    // Then
+    /* The first location is kept, and the other families are ignored */
+    QCOMPARE( (int)merged.size(), 2000 );
+    QVERIFY( merged.duplicates().empty() );
+    EntityLocation location;
+    QVERIFY( merged.find(EntityIndex::Family::GRID, 1, &location) );
+    QCOMPARE( location.offset, (std::size_t)0 );
+    QVERIFY( merged.find(EntityIndex::Family::GRID, 2000, &location) );
+    QCOMPARE( location.lineNumber, 2000 );
+    QVERIFY( !merged.find(EntityIndex::Family::ELEMENT, 2, &location) );
+}
+
+void tst_EntityIndex::test_find_duplicates_parallel()
+{
+    // Given
+    /* Three files, every 10th ID of the last one is a duplicate */
+    std::vector<EntityIndex> files(3);
+    const int count = 100000;
+    for (int f = 0; f < 3; ++f) {
+        for (int i = 0; i < count; ++i) {
+            const long long id = (f < 2 || i % 10 != 0) ? f * count + i + 1 : i + 1;
+            files[f].insert(EntityIndex::Family::GRID, id, (std::size_t)i * 80, i + 1);
+        }
+    }
+    std::vector<const EntityIndex*> indexes;
+    for (int f = 0; f < 3; ++f) {
+        indexes.push_back(&files[f]);
+    }
+
+    // When
+    const std::vector<EntityIndex::Duplicate> serial = EntityIndex::findDuplicates(indexes, 1);
+    const std::vector<EntityIndex::Duplicate> parallel = EntityIndex::findDuplicates(indexes, 4);
+
+    // Then
+    QCOMPARE( (int)serial.size(), count / 10 );
+    QCOMPARE( (int)parallel.size(), count / 10 );
+    for (int i = 0; i < count / 10; ++i) {
+        QCOMPARE( parallel.at(i).id, serial.at(i).id );
+        QCOMPARE( parallel.at(i).firstIndex, 0 );
+        QCOMPARE( parallel.at(i).secondIndex, 2 );
+        QCOMPARE( parallel.at(i).first.lineNumber, parallel.at(i).second.lineNumber );
+    }
+}
+
+void tst_EntityIndex::test_many_ids()
+{
+    // Given
+    EntityIndex index;
+    const int count = 200000;
+
+    // When
+    for (int i = 0; i < count; ++i) {
+        index.insert(EntityIndex::Family::ELEMENT, 1000000 + 7 * i, (std::size_t)i * 80, i + 1);
+    }
+
+    // Then
+    QCOMPARE( (int)index.size(), count );
+    QVERIFY( index.capacity() * 3 >= index.size() * 4 );
+    for (int i = 0; i < count; i += 997) {
+        EntityLocation location;
+        QVERIFY( index.find(EntityIndex::Family::ELEMENT, 1000000 + 7 * i, &location) );
+        QCOMPARE( location.lineNumber, i + 1 );
+        QVERIFY( !index.find(EntityIndex::Family::ELEMENT, 1000000 + 7 * i + 1, &location) );
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+
+QTEST_APPLESS_MAIN(tst_EntityIndex)
+
+#include "tst_entityindex.moc"
@@ -29,6 +29,7 @@ private slots:
     void test_wrong_path();
     void test_separator();
     void test_resolve_path();
+    void test_archive_path();
     void test_symlink();
 
 };
@@ -127,6 +128,25 @@ void tst_FileInfo::test_resolve_path()
     QCOMPARE( actual3, expected );
 }
 
+void tst_FileInfo::test_archive_path()
+{
+    // Given
+    std::string archive;
+    std::string member;
+
+    // When
+    const bool ok = FileInfo::splitArchivePath("/home/model.ZIP:bulk/grid.dat", &archive, &member);
+
+    // Then
+    QVERIFY( ok );
+    QCOMPARE( archive, std::string("/home/model.ZIP") );
+    QCOMPARE( member, std::string("bulk/grid.dat") );
+    QVERIFY( !FileInfo::splitArchivePath("/home/model.zip", &archive, &member) );
+    QCOMPARE( FileInfo::canonicalFilePath("/home/./model.zip:bulk/grid.dat"), std::string("/home/model.zip:bulk") );
+    QCOMPARE( FileInfo::canonicalFilePath("/home/model.zip:main.dat"), std::string("/home/model.zip:") );
+    QCOMPARE( FileInfo::fileName("/home/model.zip:bulk/grid.dat"), std::string("grid.dat") );
+}
+
 /******************************************************************************
  ******************************************************************************/
 void tst_FileInfo::test_symlink()
@@ -0,0 +1,24 @@
+#isEmpty(TEMPLATE):TEMPLATE=app
+TARGET       = tst_filewatcher
+CONFIG      += testcase
+QT           = core testlib
+SOURCES     += tst_filewatcher.cpp
+
+# Include:
+INCLUDEPATH += $$PWD/../../../include
+
+# Dependancies:
+HEADERS += $$PWD/../../../src/compression.h
+SOURCES += $$PWD/../../../src/compression.cpp
+HEADERS += $$PWD/../../../src/fileinfo.h
+SOURCES += $$PWD/../../../src/fileinfo.cpp
+HEADERS += $$PWD/../../../src/filewatcher.h
+SOURCES += $$PWD/../../../src/filewatcher.cpp
+HEADERS += $$PWD/../../../src/mappedfile.h
+SOURCES += $$PWD/../../../src/mappedfile.cpp
+HEADERS += $$PWD/../../../src/systemdetection.h
+HEADERS += $$PWD/../../../src/ziparchive.h
+SOURCES += $$PWD/../../../src/ziparchive.cpp
+
+# Libraries:
+LIBS += -lz
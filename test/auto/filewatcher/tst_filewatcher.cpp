@@ -0,0 +1,121 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest/QtTest>
+#include <QtCore/QDebug>
+
+#include <FileWatcher>
+
+#include <cstdio>
+#include <fstream>
+
+class tst_FileWatcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void cleanup();
+
+    void test_unchanged();
+    void test_modified();
+    void test_removed();
+    void test_created();
+
+private:
+    static const char *fileName() { return "tst_filewatcher.dat"; }
+    static void write(const char *text);
+};
+
+void tst_FileWatcher::cleanup()
+{
+    std::remove(fileName());
+}
+
+void tst_FileWatcher::write(const char *text)
+{
+    std::ofstream file(fileName(), std::ios::out | std::ios::trunc);
+    file << text;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_FileWatcher::test_unchanged()
+{
+    // Given
+    write("GRID,1\n");
+    FileWatcher watcher;
+    watcher.watch(std::vector<std::string>(1, fileName()));
+
+    // When
+    const std::vector<std::string> changed = watcher.changedFiles();
+
+    // Then
+    QVERIFY( changed.empty() );
+}
+
+void tst_FileWatcher::test_modified()
+{
+    // Given
+    write("GRID,1\n");
+    FileWatcher watcher;
+    watcher.watch(std::vector<std::string>(1, fileName()));
+
+    // When
+    write("GRID,1\nGRID,2\n");
+    const std::vector<std::string> changed = watcher.changedFiles();
+
+    // Then
+    QCOMPARE( (int)changed.size(), 1 );
+    QCOMPARE( changed.front(), std::string(fileName()) );
+    QVERIFY( watcher.changedFiles().empty() );
+}
+
+void tst_FileWatcher::test_removed()
+{
+    // Given
+    write("GRID,1\n");
+    FileWatcher watcher;
+    watcher.watch(std::vector<std::string>(1, fileName()));
+
+    // When
+    std::remove(fileName());
+    const std::vector<std::string> changed = watcher.changedFiles();
+
+    // Then
+    QCOMPARE( (int)changed.size(), 1 );
+}
+
+void tst_FileWatcher::test_created()
+{
+    // Given
+    std::remove(fileName());
+    FileWatcher watcher;
+    watcher.watch(std::vector<std::string>(1, fileName()));
+
+    // When
+    write("GRID,1\n");
+    const std::vector<std::string> changed = watcher.changedFiles();
+
+    // Then
+    QCOMPARE( (int)changed.size(), 1 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+
+QTEST_APPLESS_MAIN(tst_FileWatcher)
+
+#include "tst_filewatcher.moc"
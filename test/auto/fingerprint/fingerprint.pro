@@ -0,0 +1,36 @@
+include(../../shared/static.pro)
+
+#isEmpty(TEMPLATE):TEMPLATE=app
+TARGET       = tst_fingerprint
+CONFIG      += testcase
+QT           = core testlib
+SOURCES     += tst_fingerprint.cpp
+
+# Include:
+INCLUDEPATH += $$PWD/../../../include
+
+# Dependancies:
+HEADERS += $$PWD/../../../src/compression.h
+SOURCES += $$PWD/../../../src/compression.cpp
+HEADERS += $$PWD/../../../src/entityindex.h
+SOURCES += $$PWD/../../../src/entityindex.cpp
+HEADERS += $$PWD/../../../src/filecache.h
+SOURCES += $$PWD/../../../src/filecache.cpp
+HEADERS += $$PWD/../../../src/fileinfo.h
+SOURCES += $$PWD/../../../src/fileinfo.cpp
+HEADERS += $$PWD/../../../src/fingerprint.h
+SOURCES += $$PWD/../../../src/fingerprint.cpp
+HEADERS += $$PWD/../../../src/lineindex.h
+SOURCES += $$PWD/../../../src/lineindex.cpp
+HEADERS += $$PWD/../../../src/mappedfile.h
+SOURCES += $$PWD/../../../src/mappedfile.cpp
+HEADERS += $$PWD/../../../src/scanner.h
+SOURCES += $$PWD/../../../src/scanner.cpp
+HEADERS += $$PWD/../../../src/systemdetection.h
+HEADERS += $$PWD/../../../src/ziparchive.h
+SOURCES += $$PWD/../../../src/ziparchive.cpp
+HEADERS += $$PWD/../../../src/zonemap.h
+SOURCES += $$PWD/../../../src/zonemap.cpp
+
+# Libraries:
+LIBS += -lz
@@ -0,0 +1,171 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QtTest/QtTest>
+#include <QtCore/QDebug>
+
+#include <Fingerprint>
+
+#include <sstream>
+
+class tst_Fingerprint : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_compute();
+    void test_stat_only();
+    void test_save_load();
+    void test_changed_file();
+    void test_different_trees();
+    void test_missing_file();
+
+private:
+    static void parse(const char *begin, const char *end, std::vector<std::string> *includes);
+    static std::string path(const char *fileName);
+};
+
+/*! \brief Minimal parser: the lines that start with INCLUDE 'name'.
+ */
+void tst_Fingerprint::parse(const char *begin, const char *end, std::vector<std::string> *includes)
+{
+    std::istringstream stream(std::string(begin, end));
+    std::string line;
+    while (std::getline(stream, line)) {
+        if (line.compare(0, 9, "INCLUDE '") == 0) {
+            const std::string::size_type quote = line.find('\'', 9);
+            includes->push_back(line.substr(9, quote - 9));
+        }
+    }
+}
+
+std::string tst_Fingerprint::path(const char *fileName)
+{
+    return QFINDTESTDATA(fileName).toLatin1().data();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Fingerprint::test_compute()
+{
+    // Given
+    Fingerprint fingerprint;
+
+    // When
+    const std::uint64_t value = fingerprint.compute(path("share/duplicate_ids/test.dat"), parse);
+
+    // Then
+    QVERIFY( value != 0 );
+    QCOMPARE( fingerprint.value(), value );
+    QCOMPARE( (int)fingerprint.fileCount(), 2 );
+    QCOMPARE( (int)fingerprint.readCount(), 2 );
+    QCOMPARE( (int)fingerprint.records().size(), 2 );
+}
+
+void tst_Fingerprint::test_stat_only()
+{
+    // Given
+    Fingerprint fingerprint;
+    const std::uint64_t expected = fingerprint.compute(path("share/duplicate_ids/test.dat"), parse);
+
+    // When
+    const std::uint64_t actual = fingerprint.compute(path("share/duplicate_ids/test.dat"), parse);
+
+    // Then
+    QCOMPARE( actual, expected );
+    QCOMPARE( (int)fingerprint.fileCount(), 2 );
+    QCOMPARE( (int)fingerprint.readCount(), 0 );
+}
+
+void tst_Fingerprint::test_save_load()
+{
+    // Given
+    Fingerprint fingerprint;
+    const std::uint64_t expected = fingerprint.compute(path("share/duplicate_ids/test.dat"), parse);
+    std::stringstream stream;
+    fingerprint.save(stream);
+
+    // When
+    Fingerprint loaded;
+    QVERIFY( loaded.load(stream) );
+    const std::uint64_t previous = loaded.value();
+    const std::uint64_t actual = loaded.compute(path("share/duplicate_ids/test.dat"), parse);
+
+    // Then
+    QCOMPARE( previous, expected );
+    QCOMPARE( actual, expected );
+    QCOMPARE( (int)loaded.readCount(), 0 );
+}
+
+void tst_Fingerprint::test_changed_file()
+{
+    // Given
+    Fingerprint fingerprint;
+    const std::uint64_t expected = fingerprint.compute(path("share/duplicate_ids/test.dat"), parse);
+    std::stringstream stream;
+    fingerprint.save(stream);
+
+    /* Another modification time for the first file */
+    std::string text = stream.str();
+    std::string::size_type pos = text.find('\n', text.find('\n', text.find('\n') + 1) + 1);
+    const std::string::size_type space = text.find(' ', pos);
+    text.replace(space + 1, text.find(' ', space + 1) - space - 1, "0");
+
+    // When
+    Fingerprint loaded;
+    std::istringstream modified(text);
+    QVERIFY( loaded.load(modified) );
+    const std::uint64_t actual = loaded.compute(path("share/duplicate_ids/test.dat"), parse);
+
+    // Then
+    QCOMPARE( actual, expected ); /* same content */
+    QCOMPARE( (int)loaded.readCount(), 1 );
+}
+
+void tst_Fingerprint::test_different_trees()
+{
+    // Given
+    Fingerprint fingerprint;
+
+    // When
+    const std::uint64_t first = fingerprint.compute(path("share/duplicate_ids/test.dat"), parse);
+    const std::uint64_t second = fingerprint.compute(path("share/entities/test.dat"), parse);
+
+    // Then
+    QVERIFY( first != second );
+    QCOMPARE( (int)fingerprint.records().size(), 2 ); /* the files of the first tree are removed */
+    QVERIFY( fingerprint.records().count(path("share/duplicate_ids/test.dat")) == 0 );
+}
+
+void tst_Fingerprint::test_missing_file()
+{
+    // Given
+    Fingerprint fingerprint;
+
+    // When
+    const std::uint64_t value = fingerprint.compute(path("share/broken/test.dat"), parse);
+
+    // Then
+    QVERIFY( value != 0 );
+    QCOMPARE( (int)fingerprint.fileCount(), 2 ); /* not_existing_file.dat is missing */
+    QCOMPARE( (int)fingerprint.records().size(), 2 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+
+QTEST_APPLESS_MAIN(tst_Fingerprint)
+
+#include "tst_fingerprint.moc"
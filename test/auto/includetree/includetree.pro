@@ -0,0 +1,13 @@
+#isEmpty(TEMPLATE):TEMPLATE=app
+TARGET       = tst_includetree
+CONFIG      += testcase
+QT           = core testlib
+SOURCES     += tst_includetree.cpp
+
+# Include:
+INCLUDEPATH += $$PWD/../../../include
+
+# Dependancies:
+HEADERS += $$PWD/../../../src/filestats.h
+HEADERS += $$PWD/../../../src/includetree.h
+SOURCES += $$PWD/../../../src/includetree.cpp
@@ -0,0 +1,198 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QtTest/QtTest>
+#include <QtCore/QDebug>
+
+#include <IncludeTree>
+
+#include <vector>
+
+class tst_IncludeTree : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_empty();
+    void test_collapsed();
+    void test_expanded();
+    void test_total();
+    void test_rebuild();
+
+private:
+    static void build(IncludeTree &tree);
+};
+
+/*! \brief Builds the tree:
+ * \code
+ *  main.dat
+ *   +- a.dat
+ *   |   +- a1.dat
+ *   |       +- a11.dat
+ *   +- b.dat
+ * \endcode
+ */
+void tst_IncludeTree::build(IncludeTree &tree)
+{
+    std::vector<FileStats> stats;
+    const FileStats main = { -1, -1, 1000, 10, 0.5, 0.25, false };
+    const FileStats a    = {  0,  2, 2000, 20, 1.0, 0.5 , false };
+    const FileStats b    = {  0,  3,  100,  1, 0.5, 0.25, false };
+    const FileStats a1   = {  1,  5, 4000, 40, 2.0, 1.0 , true  };
+    const FileStats a11  = {  3,  1, 8000, 80, 4.0, 2.0 , false };
+    stats.push_back(main);
+    stats.push_back(a);
+    stats.push_back(b);
+    stats.push_back(a1);
+    stats.push_back(a11);
+
+    std::vector<std::size_t> hitCounts;
+    hitCounts.push_back(1);
+    hitCounts.push_back(0);
+    hitCounts.push_back(2);
+    hitCounts.push_back(0);
+    hitCounts.push_back(3);
+
+    tree.build(stats, hitCounts);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_IncludeTree::test_empty()
+{
+    // Given
+    IncludeTree tree;
+
+    // When
+    tree.build(std::vector<FileStats>(), std::vector<std::size_t>());
+
+    // Then
+    QCOMPARE( tree.fileCount(), 0 );
+    QVERIFY( tree.rows().empty() );
+    QCOMPARE( tree.total().fileCount, 0 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_IncludeTree::test_collapsed()
+{
+    // Given
+    IncludeTree tree;
+
+    // When
+    build(tree);
+    const std::vector<IncludeTree::Row> rows = tree.rows();
+
+    // Then
+    QCOMPARE( (int)rows.size(), 3 ); /* the main file is expanded */
+    QCOMPARE( rows.at(0).file, 0 );
+    QVERIFY( rows.at(0).isExpanded );
+    QCOMPARE( rows.at(0).stats.size, (std::size_t)1000 );
+
+    /* a.dat shows its subtree */
+    QCOMPARE( rows.at(1).file, 1 );
+    QCOMPARE( rows.at(1).depth, 1 );
+    QVERIFY( rows.at(1).hasChildren );
+    QVERIFY( !rows.at(1).isExpanded );
+    QCOMPARE( rows.at(1).fileCount, 3 );
+    QCOMPARE( rows.at(1).stats.size, (std::size_t)14000 );
+    QCOMPARE( rows.at(1).stats.lineCount, (std::size_t)140 );
+    QCOMPARE( rows.at(1).stats.loadTime, 7.0 );
+    QCOMPARE( rows.at(1).stats.lineNumber, 2 );
+    QCOMPARE( (int)rows.at(1).hitCount, 3 );
+    QCOMPARE( rows.at(1).skippedCount, 1 );
+
+    QCOMPARE( rows.at(2).file, 2 );
+    QVERIFY( !rows.at(2).hasChildren );
+    QCOMPARE( rows.at(2).fileCount, 1 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_IncludeTree::test_expanded()
+{
+    // Given
+    IncludeTree tree;
+    build(tree);
+
+    // When
+    tree.toggle(1);
+    tree.setExpanded(3, true);
+    const std::vector<IncludeTree::Row> rows = tree.rows();
+
+    // Then
+    QCOMPARE( (int)rows.size(), 5 );
+    QCOMPARE( rows.at(1).file, 1 );
+    QCOMPARE( rows.at(1).stats.size, (std::size_t)2000 );
+    QCOMPARE( rows.at(2).file, 3 );
+    QCOMPARE( rows.at(3).file, 4 );
+    QCOMPARE( rows.at(3).depth, 3 );
+    QCOMPARE( rows.at(4).file, 2 ); /* depth first */
+
+    /* Collapsing the main file hides everything */
+    tree.toggle(0);
+    QCOMPARE( (int)tree.rows().size(), 1 );
+    QCOMPARE( tree.rows().at(0).fileCount, 5 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_IncludeTree::test_total()
+{
+    // Given
+    IncludeTree tree;
+    build(tree);
+
+    // When
+    const IncludeTree::Row total = tree.total();
+
+    // Then
+    QCOMPARE( total.fileCount, 5 );
+    QCOMPARE( total.stats.size, (std::size_t)15100 );
+    QCOMPARE( total.stats.scanTime, 4.0 );
+    QCOMPARE( (int)total.hitCount, 6 );
+    QCOMPARE( total.skippedCount, 1 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_IncludeTree::test_rebuild()
+{
+    // Given
+    IncludeTree tree;
+    build(tree);
+    tree.setExpanded(1, true);
+
+    // When
+    build(tree); /* e.g. refreshed */
+
+    // Then
+    QVERIFY( tree.isExpanded(1) );
+
+    // When
+    tree.build(std::vector<FileStats>(1), std::vector<std::size_t>());
+
+    // Then
+    QCOMPARE( tree.fileCount(), 1 );
+    QVERIFY( tree.isExpanded(0) );
+    QVERIFY( !tree.isExpanded(1) );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+
+QTEST_APPLESS_MAIN(tst_IncludeTree)
+
+#include "tst_includetree.moc"
@@ -0,0 +1,15 @@
+#isEmpty(TEMPLATE):TEMPLATE=app
+TARGET       = tst_lineindex
+CONFIG      += testcase
+QT           = core testlib
+SOURCES     += tst_lineindex.cpp
+
+# Include:
+INCLUDEPATH += $$PWD/../../../include
+
+# Dependancies:
+HEADERS += $$PWD/../../../src/lineindex.h
+SOURCES += $$PWD/../../../src/lineindex.cpp
+HEADERS += $$PWD/../../../src/scanner.h
+SOURCES += $$PWD/../../../src/scanner.cpp
+HEADERS += $$PWD/../../../src/systemdetection.h
@@ -0,0 +1,190 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QtTest/QtTest>
+#include <QtCore/QDebug>
+
+#include <LineIndex>
+
+#include <string>
+#include <vector>
+
+class tst_LineIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_empty();
+    void test_build();
+    void test_append();
+    void test_trailing_line_feed();
+    void test_line_at();
+    void test_many_lines();
+};
+
+/*! \brief Returns lines of different lengths: "1\n22\n333\n...".
+ */
+static std::string text(const std::size_t lineCount, std::vector<std::size_t> *offsets)
+{
+    std::string text;
+    for (std::size_t i = 0; i < lineCount; ++i) {
+        offsets->push_back(text.size());
+        text += std::string(1 + i % 13, (char)('a' + i % 26));
+        text += '\n';
+    }
+    return text;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_LineIndex::test_empty()
+{
+    // Given
+    LineIndex index;
+    const char *begin = "";
+
+    // When
+    index.build(begin, begin);
+
+    // Then
+    QCOMPARE( (int)index.lineCount(), 0 );
+    QCOMPARE( (int)index.lineOffset(begin, begin, 1), 0 );
+    QCOMPARE( (int)index.lineAt(begin, begin, 0), 0 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_LineIndex::test_build()
+{
+    // Given
+    LineIndex index;
+    const std::string content = "SOL 101\nCEND\nBEGIN BULK\nGRID,1\nENDDATA";
+    const char *begin = content.data();
+    const char *end = begin + content.size();
+
+    // When
+    index.build(begin, end);
+
+    // Then
+    QCOMPARE( (int)index.lineCount(), 5 );
+    QCOMPARE( (int)index.lineOffset(begin, end, 1), 0 );
+    QCOMPARE( (int)index.lineOffset(begin, end, 2), 8 );
+    QCOMPARE( (int)index.lineOffset(begin, end, 5), 31 );
+    QCOMPARE( (int)index.lineOffset(begin, end, 6), (int)content.size() );
+    QCOMPARE( (int)index.lineOffset(begin, end, 0), (int)content.size() );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_LineIndex::test_append()
+{
+    // Given
+    LineIndex built;
+    LineIndex appended;
+    std::vector<std::size_t> offsets;
+    const std::string content = text(100, &offsets);
+    const char *begin = content.data();
+    const char *end = begin + content.size();
+
+    // When
+    built.build(begin, end);
+    for (std::size_t i = 0; i < offsets.size(); ++i) {
+        appended.append(offsets[i]);
+    }
+
+    // Then
+    QCOMPARE( built.lineCount(), appended.lineCount() );
+    QCOMPARE( built.memoryUsage(), appended.memoryUsage() );
+    for (std::size_t i = 0; i < offsets.size(); ++i) {
+        QCOMPARE( appended.lineOffset(begin, end, i + 1), offsets[i] );
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_LineIndex::test_trailing_line_feed()
+{
+    // Given
+    LineIndex index;
+    const std::string content = "CEND\n\nBEGIN BULK\n";
+    const char *begin = content.data();
+    const char *end = begin + content.size();
+
+    // When
+    index.build(begin, end);
+
+    // Then
+    QCOMPARE( (int)index.lineCount(), 3 ); /* the empty line counts */
+    QCOMPARE( (int)index.lineOffset(begin, end, 2), 5 );
+    QCOMPARE( (int)index.lineOffset(begin, end, 3), 6 );
+    QCOMPARE( (int)index.lineAt(begin, end, 5), 2 );
+    QCOMPARE( (int)index.lineAt(begin, end, content.size() - 1), 3 );
+    QCOMPARE( (int)index.lineAt(begin, end, content.size()), 3 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_LineIndex::test_line_at()
+{
+    // Given
+    LineIndex index;
+    const std::string content = "SOL 101\nCEND\nBEGIN BULK\nGRID,1\nENDDATA";
+    const char *begin = content.data();
+    const char *end = begin + content.size();
+
+    // When
+    index.build(begin, end);
+
+    // Then
+    QCOMPARE( (int)index.lineAt(begin, end, 0), 1 );
+    QCOMPARE( (int)index.lineAt(begin, end, 7), 1 ); /* the line feed */
+    QCOMPARE( (int)index.lineAt(begin, end, 8), 2 );
+    QCOMPARE( (int)index.lineAt(begin, end, 35), 5 );
+    QCOMPARE( (int)index.lineAt(begin, end, 1000), 5 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_LineIndex::test_many_lines()
+{
+    // Given
+    LineIndex index;
+    std::vector<std::size_t> offsets;
+    const std::size_t lineCount = 5 * LineIndex::SUPERBLOCK_LINES + 3;
+    const std::string content = text(lineCount, &offsets);
+    const char *begin = content.data();
+    const char *end = begin + content.size();
+
+    // When
+    index.build(begin, end);
+
+    // Then
+    QCOMPARE( index.lineCount(), lineCount );
+    for (std::size_t i = 0; i < lineCount; ++i) {
+        QCOMPARE( index.lineOffset(begin, end, i + 1), offsets[i] );
+        QCOMPARE( index.lineAt(begin, end, offsets[i]), i + 1 );
+        QCOMPARE( index.lineAt(begin, end, offsets[i] + i % 13), i + 1 );
+    }
+
+    /* about half a byte per line */
+    QVERIFY( index.memoryUsage() < lineCount );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+
+QTEST_APPLESS_MAIN(tst_LineIndex)
+
+#include "tst_lineindex.moc"
@@ -0,0 +1,13 @@
+#isEmpty(TEMPLATE):TEMPLATE=app
+TARGET       = tst_memorystats
+CONFIG      += testcase
+QT           = core testlib
+SOURCES     += tst_memorystats.cpp
+
+# Include:
+INCLUDEPATH += $$PWD/../../../include
+
+# Dependancies:
+HEADERS += $$PWD/../../../src/memorystats.h
+SOURCES += $$PWD/../../../src/memorystats.cpp
+HEADERS += $$PWD/../../../src/systemdetection.h
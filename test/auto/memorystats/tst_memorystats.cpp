@@ -0,0 +1,127 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QtTest/QtTest>
+#include <QtCore/QDebug>
+
+#include <MemoryStats>
+
+class tst_MemoryStats : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_allocate_release();
+    void test_peak();
+    void test_reset();
+    void test_report();
+    void test_formatBytes();
+
+};
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_MemoryStats::test_allocate_release()
+{
+    // Given
+    MemoryStats stats;
+
+    // When
+    stats.allocate(MemoryStats::Subsystem::LOADED_TEXT, 1000);
+    stats.allocate(MemoryStats::Subsystem::RESULT_STORAGE, 200);
+    stats.release(MemoryStats::Subsystem::LOADED_TEXT, 400);
+
+    // Then
+    QCOMPARE( (int)stats.current(MemoryStats::Subsystem::LOADED_TEXT), 600);
+    QCOMPARE( (int)stats.current(MemoryStats::Subsystem::RESULT_STORAGE), 200);
+    QCOMPARE( (int)stats.current(MemoryStats::Subsystem::INDEXES), 0);
+    QCOMPARE( (int)stats.currentTotal(), 800);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_MemoryStats::test_peak()
+{
+    // Given
+    MemoryStats stats;
+
+    // When
+    stats.allocate(MemoryStats::Subsystem::LOADED_TEXT, 1000);
+    stats.release(MemoryStats::Subsystem::LOADED_TEXT, 1000);
+    stats.allocate(MemoryStats::Subsystem::RESULT_STORAGE, 300);
+
+    // Then
+    QCOMPARE( (int)stats.current(MemoryStats::Subsystem::LOADED_TEXT), 0);
+    QCOMPARE( (int)stats.peak(MemoryStats::Subsystem::LOADED_TEXT), 1000);
+    QCOMPARE( (int)stats.peak(MemoryStats::Subsystem::RESULT_STORAGE), 300);
+    QCOMPARE( (int)stats.peakTotal(), 1000); /* not the sum of the peaks */
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_MemoryStats::test_reset()
+{
+    // Given
+    MemoryStats stats;
+    stats.allocate(MemoryStats::Subsystem::UI_CACHES, 50);
+
+    // When
+    stats.release(MemoryStats::Subsystem::UI_CACHES, 100); /* more than allocated */
+    stats.allocate(MemoryStats::Subsystem::INDEXES, 70);
+    stats.reset(MemoryStats::Subsystem::INDEXES);
+
+    // Then
+    QCOMPARE( (int)stats.current(MemoryStats::Subsystem::UI_CACHES), 0);
+    QCOMPARE( (int)stats.current(MemoryStats::Subsystem::INDEXES), 0);
+    QCOMPARE( (int)stats.peak(MemoryStats::Subsystem::INDEXES), 70);
+
+    stats.clear();
+    QCOMPARE( (int)stats.peak(MemoryStats::Subsystem::INDEXES), 0);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_MemoryStats::test_report()
+{
+    // Given
+    MemoryStats stats;
+
+    // When
+    std::vector<std::string> lines = stats.report();
+
+    // Then
+    /* header + 4 subsystems + total + process */
+    QCOMPARE( (int)lines.size(), 7);
+    QCOMPARE( lines.at(1).substr(0, 11), std::string("loaded text"));
+    QCOMPARE( lines.at(6).substr(0, 13), std::string("process (RSS)"));
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_MemoryStats::test_formatBytes()
+{
+    QCOMPARE( MemoryStats::formatBytes(0), std::string("0 B"));
+    QCOMPARE( MemoryStats::formatBytes(1023), std::string("1023 B"));
+    QCOMPARE( MemoryStats::formatBytes(1536), std::string("1.5 KB"));
+    QCOMPARE( MemoryStats::formatBytes(5 * 1024 * 1024), std::string("5.0 MB"));
+    QCOMPARE( MemoryStats::formatBytes(3221225472u), std::string("3.0 GB"));
+}
+
+/******************************************************************************
+ ******************************************************************************/
+
+QTEST_APPLESS_MAIN(tst_MemoryStats)
+
+#include "tst_memorystats.moc"
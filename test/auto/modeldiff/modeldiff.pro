@@ -0,0 +1,31 @@
+#isEmpty(TEMPLATE):TEMPLATE=app
+TARGET       = tst_modeldiff
+CONFIG      += testcase
+QT           = core testlib
+SOURCES     += tst_modeldiff.cpp
+
+# Include:
+INCLUDEPATH += $$PWD/../../../include
+
+# Dependancies:
+HEADERS += $$PWD/../../../src/compression.h
+SOURCES += $$PWD/../../../src/compression.cpp
+HEADERS += $$PWD/../../../src/entityindex.h
+HEADERS += $$PWD/../../../src/fileinfo.h
+SOURCES += $$PWD/../../../src/fileinfo.cpp
+HEADERS += $$PWD/../../../src/mappedfile.h
+SOURCES += $$PWD/../../../src/mappedfile.cpp
+HEADERS += $$PWD/../../../src/modeldiff.h
+SOURCES += $$PWD/../../../src/modeldiff.cpp
+HEADERS += $$PWD/../../../src/query.h
+SOURCES += $$PWD/../../../src/query.cpp
+HEADERS += $$PWD/../../../src/scanner.h
+SOURCES += $$PWD/../../../src/scanner.cpp
+HEADERS += $$PWD/../../../src/systemdetection.h
+HEADERS += $$PWD/../../../src/tokenizer.h
+SOURCES += $$PWD/../../../src/tokenizer.cpp
+HEADERS += $$PWD/../../../src/ziparchive.h
+SOURCES += $$PWD/../../../src/ziparchive.cpp
+
+# Libraries:
+LIBS += -lz
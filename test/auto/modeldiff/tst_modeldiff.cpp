@@ -0,0 +1,245 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QtTest/QtTest>
+#include <QtCore/QDebug>
+
+#include <ModelDiff>
+
+#include <sstream>
+
+class tst_ModelDiff : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_equivalent_formats();
+    void test_added_removed_changed();
+    void test_field_changes();
+    void test_control_section();
+    void test_several_buffers();
+    void test_reordered_set();
+};
+
+/******************************************************************************
+ ******************************************************************************/
+static std::vector<TextBuffer> buffersOf(const std::string &text)
+{
+    std::vector<TextBuffer> buffers;
+    TextBuffer buffer = { text.data(), text.data() + text.size() };
+    buffers.push_back(buffer);
+    return buffers;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_ModelDiff::test_equivalent_formats()
+{
+    // Given
+    const std::string first =
+            "GRID    1               0.      0.      0.\n"
+            "GRID    2               1.      0.      0.\n"
+            "MAT1    100     2.1+5           0.3\n"
+            "PBARL   20      100             BAR\n";
+    const std::string second =
+            "$ Same model, other formats\n"
+            "GRID*   1                               0.0             0.0\n"
+            "*       0.0\n"
+            "grid,2,,1.0,-0.,0.0\n"
+            "MAT1    100     210000.         .3\n"
+            "PBARL,20,100,,bar\n";
+
+    // When
+    ModelDiff diff;
+    diff.compare(buffersOf(first), buffersOf(second), 1);
+
+    // Then
+    QCOMPARE( (int)diff.entries().size(), 0 );
+    QCOMPARE( (int)diff.cardCount(0), 4 );
+    QCOMPARE( (int)diff.cardCount(1), 4 );
+}
+
+void tst_ModelDiff::test_added_removed_changed()
+{
+    // Given
+    const std::string first =
+            "GRID    1               0.      0.      0.\n"
+            "GRID    2               1.      0.      0.\n"
+            "CQUAD4  12      10      1       2       3       4\n"
+            "PSHELL  10      100     1.5\n";
+    const std::string second =
+            "GRID    1               0.      0.      0.\n"
+            "GRID    3               1.      1.      0.\n"
+            "CQUAD4  12      10      1       3       4       5\n"
+            "PSHELL  10      100     1.5\n";
+
+    // When
+    ModelDiff diff;
+    diff.compare(buffersOf(first), buffersOf(second), 1);
+
+    // Then
+    /* Sorted by card name, then ID */
+    const std::vector<ModelDiff::Entry> &entries = diff.entries();
+    QCOMPARE( (int)entries.size(), 3 );
+
+    QCOMPARE( entries.at(0).card, std::string("CQUAD4") );
+    QCOMPARE( entries.at(0).id, 12LL );
+    QCOMPARE( (int)entries.at(0).change, (int)ModelDiff::Change::CHANGED );
+    QCOMPARE( entries.at(0).first.lineNumber, 3 );
+    QCOMPARE( entries.at(0).second.lineNumber, 3 );
+
+    QCOMPARE( entries.at(1).card, std::string("GRID") );
+    QCOMPARE( entries.at(1).id, 2LL );
+    QCOMPARE( (int)entries.at(1).change, (int)ModelDiff::Change::REMOVED );
+    QCOMPARE( entries.at(1).firstFile, 0 );
+    QCOMPARE( entries.at(1).secondFile, -1 );
+
+    QCOMPARE( entries.at(2).id, 3LL );
+    QCOMPARE( (int)entries.at(2).change, (int)ModelDiff::Change::ADDED );
+    QCOMPARE( entries.at(2).firstFile, -1 );
+    QCOMPARE( entries.at(2).second.lineNumber, 2 );
+
+    QCOMPARE( (int)diff.count(ModelDiff::Change::CHANGED), 1 );
+    QCOMPARE( (int)diff.count(ModelDiff::Change::ADDED), 1 );
+    QCOMPARE( (int)diff.count(ModelDiff::Change::REMOVED), 1 );
+}
+
+void tst_ModelDiff::test_field_changes()
+{
+    // Given
+    const std::string first =
+            "PSHELL  10      100     1.5     100             100\n"
+            "        0.1     -0.1\n";
+    const std::string second =
+            "PSHELL,10,100,1.50,200,,100\n";
+
+    // When
+    const std::vector<ModelDiff::FieldChange> changes = ModelDiff::fieldChanges(
+                first.data(), first.data() + first.size(),
+                second.data(), second.data() + second.size());
+
+    // Then
+    QCOMPARE( (int)changes.size(), 3 );
+    QCOMPARE( changes.at(0).number, 5 );
+    QCOMPARE( changes.at(0).before, std::string("100") );
+    QCOMPARE( changes.at(0).after, std::string("200") );
+    QCOMPARE( changes.at(1).number, 12 );
+    QCOMPARE( changes.at(1).before, std::string("0.1") );
+    QCOMPARE( changes.at(1).after, std::string() );
+    QCOMPARE( changes.at(2).number, 13 );
+}
+
+void tst_ModelDiff::test_control_section()
+{
+    // Given
+    const std::string first =
+            "SOL 101\n"
+            "CEND\n"
+            "SUBCASE 1\n"
+            "BEGIN BULK\n"
+            "PARAM   POST    -1\n"
+            "GRID    1               0.      0.      0.\n"
+            "ENDDATA\n";
+    const std::string second =
+            "SOL 103\n"
+            "CEND\n"
+            "SUBCASE 2\n"
+            "BEGIN BULK\n"
+            "PARAM   POST    0\n"
+            "GRID    1               0.      0.      0.\n"
+            "ENDDATA\n";
+
+    // When
+    ModelDiff diff;
+    diff.compare(buffersOf(first), buffersOf(second), 1);
+
+    // Then
+    /* Only the Bulk Data entries with an ID are compared */
+    QCOMPARE( (int)diff.entries().size(), 0 );
+    QCOMPARE( (int)diff.cardCount(0), 1 );
+}
+
+void tst_ModelDiff::test_several_buffers()
+{
+    // Given
+    /* The same grids, split differently between the files */
+    std::ostringstream a1, a2, b1, b2;
+    const int count = 20000;
+    for (int i = 1; i <= count; ++i) {
+        const char *x = (i == 7777) ? "1." : "0.";
+        (i <= count / 2 ? a1 : a2) << "GRID," << i << ",,0.,0.,0.\n";
+        (i <= count / 4 ? b1 : b2) << "GRID," << i << ",," << x << ",0.,0.\n";
+    }
+    const std::string sa1 = a1.str(), sa2 = a2.str(), sb1 = b1.str(), sb2 = b2.str();
+    std::vector<TextBuffer> first = buffersOf(sa1);
+    first.push_back(buffersOf(sa2).front());
+    std::vector<TextBuffer> second = buffersOf(sb1);
+    second.push_back(buffersOf(sb2).front());
+
+    // When
+    ModelDiff diff;
+    diff.compare(first, second, 4);
+
+    // Then
+    QCOMPARE( (int)diff.cardCount(0), count );
+    QCOMPARE( (int)diff.cardCount(1), count );
+    QCOMPARE( (int)diff.entries().size(), 1 );
+    QCOMPARE( diff.entries().at(0).id, 7777LL );
+    QCOMPARE( diff.entries().at(0).firstFile, 0 );
+    QCOMPARE( diff.entries().at(0).secondFile, 1 );
+    QCOMPARE( diff.entries().at(0).second.lineNumber, 7777 - count / 4 );
+}
+
+void tst_ModelDiff::test_reordered_set()
+{
+    // Given
+    /* The cards of the SPC1 10 are reordered, and one of them changed */
+    const std::string first =
+            "SPC1    10      123     1       2\n"
+            "SPC1    10      456     3\n"
+            "SPC1    10      123456  4\n"
+            "FORCE   5       1       0       1.      1.      0.      0.\n"
+            "FORCE   5       2       0       1.      0.      1.      0.\n";
+    const std::string second =
+            "FORCE   5       2       0       1.      0.      1.      0.\n"
+            "FORCE   5       1       0       1.      1.      0.      0.\n"
+            "SPC1    10      123456  4\n"
+            "SPC1    10      123     1       2\n"
+            "SPC1    10      456     5\n"
+            "SPC1    10      456     6\n";
+
+    // When
+    ModelDiff diff;
+    diff.compare(buffersOf(first), buffersOf(second), 1);
+
+    // Then
+    const std::vector<ModelDiff::Entry> &entries = diff.entries();
+    QCOMPARE( (int)entries.size(), 2 );
+
+    QCOMPARE( entries.at(0).card, std::string("SPC1") );
+    QCOMPARE( (int)entries.at(0).change, (int)ModelDiff::Change::CHANGED );
+    QCOMPARE( entries.at(0).first.lineNumber, 2 );
+    QCOMPARE( entries.at(0).second.lineNumber, 5 );
+
+    QCOMPARE( (int)entries.at(1).change, (int)ModelDiff::Change::ADDED );
+    QCOMPARE( entries.at(1).second.lineNumber, 6 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+
+QTEST_APPLESS_MAIN(tst_ModelDiff)
+
+#include "tst_modeldiff.moc"
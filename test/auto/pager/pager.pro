@@ -0,0 +1,19 @@
+#isEmpty(TEMPLATE):TEMPLATE=app
+TARGET       = tst_pager
+CONFIG      += testcase
+QT           = core testlib
+SOURCES     += tst_pager.cpp
+
+# Include:
+INCLUDEPATH += $$PWD/../../../include
+
+# Dependancies:
+HEADERS += $$PWD/../../../src/lineindex.h
+SOURCES += $$PWD/../../../src/lineindex.cpp
+HEADERS += $$PWD/../../../src/pager.h
+SOURCES += $$PWD/../../../src/pager.cpp
+HEADERS += $$PWD/../../../src/scanner.h
+SOURCES += $$PWD/../../../src/scanner.cpp
+HEADERS += $$PWD/../../../src/systemdetection.h
+HEADERS += $$PWD/../../../src/tokenizer.h
+SOURCES += $$PWD/../../../src/tokenizer.cpp
@@ -0,0 +1,179 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QtTest/QtTest>
+#include <QtCore/QDebug>
+
+#include <LineIndex>
+#include <Pager>
+
+#include <string>
+#include <vector>
+
+class tst_Pager : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_card();
+    void test_card_windows();
+    void test_comment();
+    void test_first_line();
+    void test_lines();
+    void test_lines_out_of_range();
+};
+
+static const char MODEL[] =
+        "BEGIN BULK\n"                                           /* 1 */
+        "$ Elements\n"                                           /* 2 */
+        "CQUAD4  1       1       1       2       3       4\n"   /* 3 */
+        "CBEAM   2       2       1       2       0.      1.\n"  /* 4 */
+        "+       0.      0.\n"                                   /* 5 */
+        "        1.      0.      0.\n"                           /* 6 */
+        "$ end of the beam\n"                                    /* 7 */
+        "        1.      0.      0.\n"                           /* 8 */
+        "ENDDATA";                                               /* 9 */
+
+static std::string toString(const TextBuffer &line)
+{
+    return std::string(line.begin, line.end);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Pager::test_card()
+{
+    // Given
+    const std::string content = MODEL;
+    const TextBuffer buffer = { content.data(), content.data() + content.size() };
+    LineIndex index;
+    index.build(buffer.begin, buffer.end);
+    Pager pager;
+
+    // When
+    pager.open("/path/to/model.dat", "model.dat", buffer, index, 4);
+
+    // Then
+    QVERIFY( pager.isOpen() );
+    QCOMPARE( pager.fileName(), std::string("model.dat") );
+    QCOMPARE( (int)pager.cardFirstLine(), 4 );
+    QCOMPARE( (int)pager.cardLastLine(), 6 ); /* the comment ends the card */
+    QVERIFY( !pager.isCardLine(3) );
+    QVERIFY( pager.isCardLine(5) );
+    QVERIFY( !pager.isCardLine(8) );
+
+    pager.close();
+    QVERIFY( !pager.isOpen() );
+}
+
+void tst_Pager::test_card_windows()
+{
+    // Given
+    const std::string content = "CBEAM   2\r\n+       0.\r\nENDDATA\r\n";
+    const TextBuffer buffer = { content.data(), content.data() + content.size() };
+    LineIndex index;
+    index.build(buffer.begin, buffer.end);
+    Pager pager;
+
+    // When
+    pager.open("model.dat", "model.dat", buffer, index, 1);
+    const std::vector<TextBuffer> lines = Pager::lines(buffer, index, 1, 10);
+
+    // Then
+    QCOMPARE( (int)pager.cardLastLine(), 2 );
+    QCOMPARE( (int)lines.size(), 3 );
+    QCOMPARE( toString(lines.at(1)), std::string("+       0.") );
+}
+
+void tst_Pager::test_comment()
+{
+    // Given
+    const std::string content = MODEL;
+    const TextBuffer buffer = { content.data(), content.data() + content.size() };
+    LineIndex index;
+    index.build(buffer.begin, buffer.end);
+    Pager pager;
+
+    // When
+    pager.open("model.dat", "model.dat", buffer, index, 7);
+
+    // Then
+    QCOMPARE( (int)pager.cardFirstLine(), 7 );
+    QCOMPARE( (int)pager.cardLastLine(), 7 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Pager::test_first_line()
+{
+    // Given
+    const std::string content = MODEL;
+    const TextBuffer buffer = { content.data(), content.data() + content.size() };
+    LineIndex index;
+    index.build(buffer.begin, buffer.end);
+    Pager pager;
+
+    // When
+    pager.open("model.dat", "model.dat", buffer, index, 4);
+
+    // Then
+    QCOMPARE( (int)pager.firstLine(0), 4 );
+    QCOMPARE( (int)pager.firstLine(2), 2 );
+    QCOMPARE( (int)pager.firstLine(10), 1 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Pager::test_lines()
+{
+    // Given
+    const std::string content = MODEL;
+    const TextBuffer buffer = { content.data(), content.data() + content.size() };
+    LineIndex index;
+    index.build(buffer.begin, buffer.end);
+
+    // When
+    const std::vector<TextBuffer> lines = Pager::lines(buffer, index, 7, 5);
+
+    // Then
+    QCOMPARE( (int)lines.size(), 3 );
+    QCOMPARE( toString(lines.at(0)), std::string("$ end of the beam") );
+    QCOMPARE( toString(lines.at(2)), std::string("ENDDATA") );
+
+    /* Not copied */
+    QVERIFY( lines.at(0).begin >= buffer.begin );
+    QVERIFY( lines.at(2).end == buffer.end );
+}
+
+void tst_Pager::test_lines_out_of_range()
+{
+    // Given
+    const std::string content = MODEL;
+    const TextBuffer buffer = { content.data(), content.data() + content.size() };
+    LineIndex index;
+    index.build(buffer.begin, buffer.end);
+
+    // When, Then
+    QVERIFY( Pager::lines(buffer, index, 0, 5).empty() );
+    QVERIFY( Pager::lines(buffer, index, 10, 5).empty() );
+    QVERIFY( Pager::lines(buffer, index, 1, 0).empty() );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+
+QTEST_APPLESS_MAIN(tst_Pager)
+
+#include "tst_pager.moc"
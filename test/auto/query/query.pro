@@ -0,0 +1,17 @@
+#isEmpty(TEMPLATE):TEMPLATE=app
+TARGET       = tst_query
+CONFIG      += testcase
+QT           = core testlib
+SOURCES     += tst_query.cpp
+
+# Include:
+INCLUDEPATH += $$PWD/../../../include
+
+# Dependancies:
+HEADERS += $$PWD/../../../src/query.h
+SOURCES += $$PWD/../../../src/query.cpp
+HEADERS += $$PWD/../../../src/scanner.h
+SOURCES += $$PWD/../../../src/scanner.cpp
+HEADERS += $$PWD/../../../src/systemdetection.h
+HEADERS += $$PWD/../../../src/tokenizer.h
+SOURCES += $$PWD/../../../src/tokenizer.cpp
@@ -0,0 +1,366 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QtTest/QtTest>
+#include <QtCore/QDebug>
+
+#include <Query>
+#include <Tokenizer>
+
+#include <string>
+#include <vector>
+
+class tst_Query : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_parse_text();
+    void test_parse_field();
+    void test_parse_integer();
+    void test_parse_integer_data();
+    void test_field_number();
+    void test_match_small_field();
+    void test_match_large_field();
+    void test_match_any_field();
+    void test_match_integer_field();
+    void test_match_integer();
+    void test_match_integer_data();
+    void test_match_real();
+    void test_match_real_tolerance();
+    void test_match_range();
+    void test_terms();
+
+private:
+    static std::size_t match(const Query &query, const std::string &card);
+};
+
+std::size_t tst_Query::match(const Query &query, const std::string &card)
+{
+    Tokenizer tokenizer;
+    return query.match(card.data(), card.data() + card.size(), tokenizer);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Query::test_parse_text()
+{
+    // Given
+    Query query;
+    QCOMPARE( query.type(), Query::Type::TEXT );
+    QCOMPARE( query.minimum(), 0LL );
+    QCOMPARE( query.maximum(), 0LL );
+
+    // When, Then
+    query.parse("CQUAD4");
+    QCOMPARE( query.type(), Query::Type::TEXT );
+    QCOMPARE( query.text(), std::string("CQUAD4") );
+
+    query.parse("DISP = ALL");
+    QCOMPARE( query.type(), Query::Type::TEXT );
+
+    query.parse("ECHO=NONE");
+    QCOMPARE( query.type(), Query::Type::TEXT );
+
+    query.parse("FIELD=2"); /* needs a value */
+    QCOMPARE( query.type(), Query::Type::TEXT );
+
+    query.parse("FIELD=two VALUE=1");
+    QCOMPARE( query.type(), Query::Type::TEXT );
+
+    query.parse("INT=1.5");
+    QCOMPARE( query.type(), Query::Type::TEXT );
+
+    query.parse("VALUE=1 INT=1"); /* ambiguous */
+    QCOMPARE( query.type(), Query::Type::TEXT );
+
+    query.parse("REAL=1.0 TOL=-1");
+    QCOMPARE( query.type(), Query::Type::TEXT );
+
+    query.parse("TOL=0.1"); /* needs a real */
+    QCOMPARE( query.type(), Query::Type::TEXT );
+
+    query.parse("ID=20..10");
+    QCOMPARE( query.type(), Query::Type::TEXT );
+
+    query.parse("FIELD=3 ID=10..20"); /* the ID is the field 2 */
+    QCOMPARE( query.type(), Query::Type::TEXT );
+}
+
+void tst_Query::test_parse_field()
+{
+    // Given
+    Query query;
+
+    // When
+    query.parse("card=cquad4  FIELD=2 Value=123456");
+
+    // Then
+    QCOMPARE( query.type(), Query::Type::FIELD );
+    QCOMPARE( query.card(), std::string("CQUAD4") );
+    QCOMPARE( query.field(), 2 );
+    QCOMPARE( query.value(), std::string("123456") );
+}
+
+void tst_Query::test_parse_integer_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<bool>("expectedValid");
+    QTest::addColumn<qlonglong>("expectedValue");
+
+    QTest::newRow("simple") << "1001" << true << 1001LL;
+    QTest::newRow("leading zeros") << "0001001" << true << 1001LL;
+    QTest::newRow("plus") << "+1001" << true << 1001LL;
+    QTest::newRow("minus") << "-12" << true << -12LL;
+    QTest::newRow("zero") << "000" << true << 0LL;
+    QTest::newRow("real") << "1001." << false << 0LL;
+    QTest::newRow("exponent") << "1-3" << false << 0LL;
+    QTest::newRow("sign only") << "-" << false << 0LL;
+    QTest::newRow("empty") << "" << false << 0LL;
+    QTest::newRow("overflow") << "99999999999999999999" << false << 0LL;
+}
+
+void tst_Query::test_parse_integer()
+{
+    QFETCH(QString, text);
+    QFETCH(bool, expectedValid);
+    QFETCH(qlonglong, expectedValue);
+
+    // Given
+    const std::string str = text.toStdString();
+    long long value = 0;
+
+    // When
+    const bool valid = Query::parseInteger(str.data(), str.size(), &value);
+
+    // Then
+    QCOMPARE( valid, expectedValid );
+    if (valid) {
+        QCOMPARE( (qlonglong)value, expectedValue );
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Query::test_field_number()
+{
+    /* Small field */
+    QCOMPARE( Query::fieldNumber(0, 0, false), 1 );
+    QCOMPARE( Query::fieldNumber(0, 9, false), 10 );
+    QCOMPARE( Query::fieldNumber(1, 1, false), 12 );
+
+    /* Large field: two physical lines make one logical line */
+    QCOMPARE( Query::fieldNumber(0, 0, true), 1 );
+    QCOMPARE( Query::fieldNumber(0, 1, true), 2 );
+    QCOMPARE( Query::fieldNumber(0, 4, true), 5 );
+    QCOMPARE( Query::fieldNumber(0, 5, true), 0 );
+    QCOMPARE( Query::fieldNumber(1, 0, true), 0 );
+    QCOMPARE( Query::fieldNumber(1, 1, true), 6 );
+    QCOMPARE( Query::fieldNumber(1, 4, true), 9 );
+    QCOMPARE( Query::fieldNumber(1, 5, true), 10 );
+    QCOMPARE( Query::fieldNumber(2, 1, true), 12 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Query::test_match_small_field()
+{
+    // Given
+    Query query;
+    query.parse("CARD=CQUAD4 FIELD=2 VALUE=1001");
+
+    // When, Then
+    QCOMPARE( (int)match(query, "CQUAD4  1001    1       1       2       3       4"), 1 );
+    QCOMPARE( (int)match(query, "CQUAD4  10010   1       1       2       3       4"), 0 );
+    QCOMPARE( (int)match(query, "CQUAD4  2       1       1001    2       3       4"), 0 );
+    QCOMPARE( (int)match(query, "CTRIA3  1001    1       1       2       3"), 0 );
+    QCOMPARE( (int)match(query, "CQUAD4,1001,1,1,2,3,4"), 1 );
+    QCOMPARE( (int)match(query, "$ CQUAD4 1001"), 0 );
+}
+
+void tst_Query::test_match_large_field()
+{
+    // Given
+    Query query;
+    query.parse("CARD=GRID FIELD=6 VALUE=3.0");
+    const std::string card =
+            "GRID*   1001            0               1.0             2.0             *G1\n"
+            "*G1     3.0";
+
+    // When, Then
+    QCOMPARE( (int)match(query, card), 1 );
+}
+
+void tst_Query::test_match_any_field()
+{
+    // Given
+    Query query;
+    query.parse("VALUE=1001");
+    const std::string card =
+            "CBAR    1001    1       1001    2       0.      1.      0.              +\n"
+            "+               1001.   1001";
+
+    // When, Then
+    QCOMPARE( (int)match(query, card), 3 );
+    QCOMPARE( (int)match(query, "CBAR    2       1       10010   21001   0.      1.      0."), 0 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Query::test_match_integer_field()
+{
+    // Given
+    Query query;
+    query.parse("CARD=CQUAD4 FIELD=2 INT=1001");
+
+    // When, Then
+    QCOMPARE( query.type(), Query::Type::FIELD );
+    QCOMPARE( query.value(), std::string("1001") );
+    QCOMPARE( (int)match(query, "CQUAD4  01001   1       1       2       3       4"), 1 );
+    QCOMPARE( (int)match(query, "CQUAD4  +1001   1       1       2       3       4"), 1 );
+    QCOMPARE( (int)match(query, "CQUAD4  1001.   1       1       2       3       4"), 0 );
+    QCOMPARE( (int)match(query, "CQUAD4  10010   1       1       2       3       4"), 0 );
+}
+
+void tst_Query::test_match_integer_data()
+{
+    QTest::addColumn<QString>("card");
+    QTest::addColumn<int>("expected");
+
+    QTest::newRow("token") << "CQUAD4  1001    1       1       2       3       4" << 1;
+    QTest::newRow("longer") << "CQUAD4  10010   21001   1       2       3       4" << 0;
+    QTest::newRow("leading zeros") << "CQUAD4  001001  1       1       2       3       4" << 1;
+    QTest::newRow("real") << "GRID    1       0       1001.   1.001+3 0." << 0;
+    QTest::newRow("exponent") << "GRID    1       0       1001-3  0.      0." << 0;
+    QTest::newRow("negative") << "GRID    1       0       -1001   0.      0." << 0;
+    QTest::newRow("word") << "$ PART1001 or 1001A" << 0;
+    QTest::newRow("free field") << "CQUAD4,1001,1,1001,2,3,4" << 2;
+    QTest::newRow("tab") << "CQUAD4\t1001\t1" << 1;
+    QTest::newRow("field boundary") << "CQUAD4      10011001    2       3       4" << 2;
+    QTest::newRow("large field boundary") << "GRID*                  1               0            1001-1.5" << 1;
+    QTest::newRow("continuation") << "CBAR    1       1       2       3       0.      1.      0.  1001+CB1\n+CB1    1001" << 2;
+}
+
+void tst_Query::test_match_integer()
+{
+    QFETCH(QString, card);
+    QFETCH(int, expected);
+
+    // Given
+    Query query;
+    query.parse("INT=1001");
+
+    // When
+    const int count = (int)match(query, card.toStdString());
+
+    // Then
+    QCOMPARE( query.type(), Query::Type::INTEGER );
+    QCOMPARE( count, expected );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Query::test_match_real()
+{
+    // Given
+    Query query;
+    query.parse("REAL=1.0");
+    const std::string card =
+            "GRID,1,0,1.,1.0E0,1+0\n"
+            "GRID    2       0       .1+1    1.0D0   10.-1\n"
+            "GRID*   3               0               +1.000          1.0000001\n"
+            "GRID    4       1       1       1.01    0.1";
+
+    // When
+    const int count = (int)match(query, card);
+
+    // Then
+    QCOMPARE( query.type(), Query::Type::FIELD );
+    QCOMPARE( query.comparison(), Query::Comparison::REAL );
+    QCOMPARE( count, 7 ); /* but not the integers 1 */
+}
+
+void tst_Query::test_match_real_tolerance()
+{
+    // Given
+    Query query;
+    query.parse("CARD=MAT1 FIELD=2 REAL=2.1E5 TOL=100.");
+
+    // When, Then
+    QCOMPARE( (int)match(query, "MAT1    1       2.1+5           0.3"), 0 ); /* field 2 is the ID */
+    query.parse("CARD=MAT1 FIELD=3 REAL=2.1E5 TOL=100.");
+    QCOMPARE( (int)match(query, "MAT1    1       2.1+5           0.3"), 1 );
+    QCOMPARE( (int)match(query, "MAT1    1       210050.         0.3"), 1 );
+    QCOMPARE( (int)match(query, "MAT1    1       2.2+5           0.3"), 0 );
+}
+
+void tst_Query::test_match_range()
+{
+    // Given
+    Query query;
+    query.parse("ID=2000000..2099999");
+
+    // When, Then
+    QCOMPARE( query.type(), Query::Type::FIELD );
+    QCOMPARE( query.comparison(), Query::Comparison::RANGE );
+    QCOMPARE( query.field(), 2 );
+    QCOMPARE( query.minimum(), 2000000LL );
+    QCOMPARE( query.maximum(), 2099999LL );
+
+    QCOMPARE( (int)match(query, "CQUAD4  2000000 1       1       2       3       4"), 1 );
+    QCOMPARE( (int)match(query, "GRID*   2099999         0               1.0             2.0\n*       3.0"), 1 );
+    QCOMPARE( (int)match(query, "CQUAD4,2100000,1,1,2,3,4"), 0 );
+    QCOMPARE( (int)match(query, "CQUAD4  1       2000000 1       2       3       4"), 0 );
+    QCOMPARE( (int)match(query, "PARAM   POST    -1"), 0 );
+
+    query.parse("CARD=GRID ID=5");
+    QCOMPARE( (int)match(query, "GRID    5       0       1.0     2.0     3.0"), 1 );
+    QCOMPARE( (int)match(query, "CBAR    5       1       1       2"), 0 );
+}
+
+void tst_Query::test_terms()
+{
+    // Given
+    Query query;
+
+    // When, Then
+    query.parse("cquad4");
+    QCOMPARE( query.terms(), std::vector<std::string>(1, "CQUAD4") );
+
+    query.parse("   ");
+    QVERIFY( query.terms().empty() );
+
+    query.parse("INT=-01001");
+    QCOMPARE( query.terms(), std::vector<std::string>(1, "1001") );
+
+    query.parse("CARD=cbar FIELD=3 VALUE=abc");
+    std::vector<std::string> expected;
+    expected.push_back("CBAR");
+    expected.push_back("ABC");
+    QCOMPARE( query.terms(), expected );
+
+    query.parse("CARD=GRID REAL=1.0");
+    QCOMPARE( query.terms(), std::vector<std::string>(1, "GRID") );
+
+    query.parse("ID=2000000..2099999");
+    QVERIFY( query.terms().empty() );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+
+QTEST_APPLESS_MAIN(tst_Query)
+
+#include "tst_query.moc"
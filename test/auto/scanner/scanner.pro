@@ -0,0 +1,13 @@
+#isEmpty(TEMPLATE):TEMPLATE=app
+TARGET       = tst_scanner
+CONFIG      += testcase
+QT           = core testlib
+SOURCES     += tst_scanner.cpp
+
+# Include:
+INCLUDEPATH += $$PWD/../../../include
+
+# Dependancies:
+HEADERS += $$PWD/../../../src/scanner.h
+SOURCES += $$PWD/../../../src/scanner.cpp
+HEADERS += $$PWD/../../../src/systemdetection.h
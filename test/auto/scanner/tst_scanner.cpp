@@ -0,0 +1,149 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QtTest/QtTest>
+#include <QtCore/QDebug>
+
+#include <Scanner>
+
+#include <string>
+
+class tst_Scanner : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_find();
+    void test_find_data();
+    void test_count();
+    void test_count_lines();
+    void test_long_buffer();
+
+};
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Scanner::test_find_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<int>("expected");
+
+    QTest::newRow("empty text")     << ""                 << "GRID"  << -1;
+    QTest::newRow("empty pattern")  << "GRID"             << ""      << -1;
+    QTest::newRow("too long")       << "GRI"              << "GRID"  << -1;
+    QTest::newRow("start")          << "GRID, 1"          << "GRID"  << 0;
+    QTest::newRow("end")            << "CBAR, GRID"       << "GRID"  << 6;
+    QTest::newRow("case")           << "CBAR, gRiD"       << "GrId"  << 6;
+    QTest::newRow("partial")        << "GRIGRID"          << "GRID"  << 3;
+    QTest::newRow("no alpha")       << "1.0 1.2 +1.2"     << "+1.2"  << 8;
+    QTest::newRow("not found")      << "CBAR, 1, 2, 3"    << "GRID"  << -1;
+
+    /* Crosses the 16-byte blocks */
+    QTest::newRow("block 1") << "0123456789ABCDEGRID" << "GRID" << 15;
+    QTest::newRow("block 2") << "0123456789ABCDEFGRID" << "GRID" << 16;
+    QTest::newRow("block 3") << "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ.grid" << "GRID" << 37;
+}
+
+void tst_Scanner::test_find()
+{
+    QFETCH(QString, text);
+    QFETCH(QString, pattern);
+    QFETCH(int, expected);
+
+    // Given
+    const std::string str = text.toStdString();
+    const std::string pat = pattern.toStdString();
+    const char *begin = str.data();
+    const char *end = str.data() + str.size();
+
+    // When
+    const char *p = Scanner::find(begin, end, pat.data(), pat.size());
+
+    // Then
+    const int actual = p ? (int)(p - begin) : -1;
+    QCOMPARE( actual, expected );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Scanner::test_count()
+{
+    // Given
+    const std::string str =
+            "CBAR, 1, 1, 1, 2\n"
+            "GRID, 1\n"
+            "CBAR, 2, 1, 2, 3\n"
+            "aaaa\n";
+    const char *begin = str.data();
+    const char *end = str.data() + str.size();
+
+    // When
+    std::size_t lines = 0;
+    const std::size_t occurrences = Scanner::count(begin, end, "1", 1, &lines);
+    std::size_t linesA = 0;
+    const std::size_t occurrencesA = Scanner::count(begin, end, "aa", 2, &linesA);
+
+    // Then
+    QCOMPARE( (int)occurrences, 5 );
+    QCOMPARE( (int)lines, 3 );
+    QCOMPARE( (int)occurrencesA, 2 ); /* no overlapping */
+    QCOMPARE( (int)linesA, 1 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Scanner::test_count_lines()
+{
+    // Given
+    const std::string str = "SOL 101\nCEND\n\nBEGIN BULK\r\nENDDATA";
+
+    // When, Then
+    QCOMPARE( (int)Scanner::countLines(str.data(), str.data() + str.size()), 4 );
+    QCOMPARE( (int)Scanner::countLines(str.data(), str.data()), 0 );
+    QCOMPARE( Scanner::findLineEnd(str.data(), str.data() + str.size()), str.data() + 7 );
+    QCOMPARE( Scanner::findLineEnd(str.data() + 26, str.data() + str.size()), str.data() + str.size() );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Scanner::test_long_buffer()
+{
+    // Given
+    std::string str;
+    for (int i = 1; i <= 1000; ++i) {
+        str += "GRID    " + std::to_string(i) + "       0       1.0     2.0     3.0\n";
+    }
+    const char *begin = str.data();
+    const char *end = str.data() + str.size();
+
+    // When
+    std::size_t lines = 0;
+    const std::size_t occurrences = Scanner::count(begin, end, "grid", 4, &lines);
+    const std::size_t ones = Scanner::count(begin, end, "1.0", 3);
+
+    // Then
+    QCOMPARE( (int)occurrences, 1000 );
+    QCOMPARE( (int)lines, 1000 );
+    QCOMPARE( (int)ones, 1000 );
+    QCOMPARE( (int)Scanner::countLines(begin, end), 1000 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+
+QTEST_APPLESS_MAIN(tst_Scanner)
+
+#include "tst_scanner.moc"
@@ -30,7 +30,17 @@ private slots:
     void test_find_injection_regexp();
     void test_find_whitespace();
     void test_find_multiline_deck();
+    void test_find_across_continuation();
+    void test_find_field();
+    void test_find_integer();
+    void test_find_id_range();
     void test_find_two_occurences_on_same_line();
+    void test_find_memory_budget();
+    void test_find_result_lines();
+    void test_find_preview();
+    void test_find_preview_count_limit();
+    void test_count();
+    void test_count_integer();
 
 };
 
@@ -211,15 +221,132 @@ void tst_Search::test_find_multiline_deck()
 
     // Then
     QCOMPARE( (int)engine.resultCount(filename), 1);
-    /// \todo   QCOMPARE( engine.resultAt(filename, 0), std::string(
-    /// \todo               "line      28: DMI     MYDOF   1       1       -1.0    1.0     1.0     -1.0    1.0     +\n"
-    /// \todo               "            : +       2.0     -1.0    1.0     3.0     -1.0    1.0     4.0     -1.0    +\n"
-    /// \todo               "            : +       1.0     5.0     -1.0    1.0     6.0     -1.0    2.0     1.0     +\n"
-    /// \todo               "            : +       -1.0    2.0     2.0     -1.0    2.0     3.0     -1.0    2.0     +\n"
-    /// \todo               "            : +       4.0     -1.0    2.0     5.0     -1.0    2.0     6.0" ));
+    QCOMPARE( (int)engine.resultCountLines(filename), 5);
+    QCOMPARE( engine.resultAt(filename, 0), std::string(
+                  "line      28: DMI     MYDOF   1       1       -1.0    1.0     1.0     -1.0    1.0     +\n"
+                  "            : +       2.0     -1.0    1.0     3.0     -1.0    1.0     4.0     -1.0    +\n"
+                  "            : +       1.0     5.0     -1.0    1.0     6.0     -1.0    2.0     1.0     +\n"
+                  "            : +       -1.0    2.0     2.0     -1.0    2.0     3.0     -1.0    2.0     +\n"
+                  "            : +       4.0     -1.0    2.0     5.0     -1.0    2.0     6.0" ));
 
 }
 
+/******************************************************************************
+ ******************************************************************************/
+void tst_Search::test_find_across_continuation()
+{
+    /* ***************************************************************** */
+    /* Match the text across the boundary of a continuation line,        */
+    /* i.e. without the continuation fields.                             */
+    /* ***************************************************************** */
+    // Given
+    Engine engine;
+    std::string filename("dummy.dat");
+    std::istringstream buffer(
+                /* 1*/  "CBAR    1       1       1       2       0.      1.      0.              +CB1\n"
+                /* 2*/  "+CB1    2\n"
+                /* 3*/  "CBAR    2       1       2       3       0.      1.      0.\n"
+                /* 4*/  "        2\n"
+                /* 5*/  "$ comment\n"
+                /* 6*/  "        2\n" );
+
+    // When
+    engine.find( &buffer, "0.              2", filename);
+
+    // Then
+    QCOMPARE( (int)engine.resultCount(filename), 2);
+    QCOMPARE( (int)engine.occurrenceCount(filename), 2);
+    QCOMPARE( engine.resultAt(filename, 1), std::string(
+                  "line       3: CBAR    2       1       2       3       0.      1.      0.\n"
+                  "            :         2" ));
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Search::test_find_field()
+{
+    /* ***************************************************************** */
+    /* Find the value only in the given field of the given card.         */
+    /* ***************************************************************** */
+    // Given
+    Engine engine;
+    std::string filename("dummy.dat");
+    std::istringstream buffer(
+                /* 1*/  "$ CQUAD4  1001\n"
+                /* 2*/  "CQUAD4  1001    1       1       2       3       4\n"
+                /* 3*/  "CQUAD4  10010   1       1       2       3       4\n"
+                /* 4*/  "CQUAD4  2       1       1001    2       3       4\n"
+                /* 5*/  "CTRIA3  1001    1       1       2       3\n"
+                /* 6*/  "CQUAD4,1001,1,5,6,7,8\n" );
+
+    // When
+    engine.find( &buffer, "CARD=CQUAD4 FIELD=2 VALUE=1001", filename);
+
+    // Then
+    QCOMPARE( (int)engine.resultCount(filename), 2);
+    QCOMPARE( (int)engine.occurrenceCount(filename), 2);
+    QCOMPARE( engine.resultAt(filename, 0), std::string(
+                  "line       2: CQUAD4  1001    1       1       2       3       4" ));
+    QCOMPARE( engine.resultAt(filename, 1), std::string(
+                  "line       6: CQUAD4,1001,1,5,6,7,8" ));
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Search::test_find_integer()
+{
+    /* ***************************************************************** */
+    /* Find the integer as a whole token, not inside a longer number.    */
+    /* ***************************************************************** */
+    // Given
+    Engine engine;
+    std::string filename("dummy.dat");
+    std::istringstream buffer(
+                /* 1*/  "CQUAD4  10010   1       21001   2       3       4\n"
+                /* 2*/  "CQUAD4  1001    1       1       2       3       4\n"
+                /* 3*/  "GRID    1       0       1001.   0.      0.\n"
+                /* 4*/  "CBAR    7       1       01001   2       0.      1.      0.\n" );
+
+    // When
+    engine.find( &buffer, "INT=1001", filename);
+
+    // Then
+    QCOMPARE( (int)engine.resultCount(filename), 2);
+    QCOMPARE( (int)engine.occurrenceCount(filename), 2);
+    QCOMPARE( engine.resultAt(filename, 0), std::string(
+                  "line       2: CQUAD4  1001    1       1       2       3       4" ));
+    QCOMPARE( engine.resultAt(filename, 1), std::string(
+                  "line       4: CBAR    7       1       01001   2       0.      1.      0." ));
+}
+
+void tst_Search::test_find_id_range()
+{
+    /* ***************************************************************** */
+    /* Find the cards whose ID is in the range.                          */
+    /* ***************************************************************** */
+    // Given
+    Engine engine;
+    std::string filename("dummy.dat");
+    std::istringstream buffer(
+                /* 1*/  "SOL 101\n"
+                /* 2*/  "CEND\n"
+                /* 3*/  "BEGIN BULK\n"
+                /* 4*/  "CQUAD4  1999999 1       2000000 2       3       4\n"
+                /* 5*/  "CQUAD4  2000000 1       1       2       3       4\n"
+                /* 6*/  "CBAR    2050000 1       1       2       0.      1.      0.      +\n"
+                /* 7*/  "+       2\n"
+                /* 8*/  "GRID    2100000 0       0.      0.      0.\n" );
+
+    // When
+    engine.find( &buffer, "ID=2000000..2099999", filename);
+
+    // Then
+    QCOMPARE( (int)engine.resultCount(filename), 2);
+    QCOMPARE( (int)engine.occurrenceCount(filename), 2);
+    QCOMPARE( engine.resultAt(filename, 0), std::string(
+                  "line       5: CQUAD4  2000000 1       1       2       3       4" ));
+}
+
 /******************************************************************************
  ******************************************************************************/
 void tst_Search::test_find_two_occurences_on_same_line()
@@ -241,6 +368,184 @@ void tst_Search::test_find_two_occurences_on_same_line()
     QCOMPARE( engine.resultAt(filename, 0), std::string("line       1: CBAR         123     456 123.456   "));
 }
 
+/******************************************************************************
+ ******************************************************************************/
+void tst_Search::test_find_memory_budget()
+{
+    /* ************************************************************* */
+    /* Beyond the memory budget, the results are stored on disk,     */
+    /* but they are returned in the same order.                      */
+    /* ************************************************************* */
+    // Given
+    Engine engine;
+    engine.setMemoryBudget(100); // bytes
+    std::string filename("dummy.dat");
+    std::istringstream buffer(
+                "GRID, 1,  0, 0., 0., 0.\n"
+                "GRID, 2,  0, 1., 0., 0.\n"
+                "GRID, 3,  0, 2., 0., 0.\n"
+                "GRID, 4,  0, 3., 0., 0.\n" );
+
+    // When
+    engine.find( &buffer, "GRID", filename);
+
+    // Then
+    QCOMPARE( (int)engine.resultCount(filename), 4);
+    QCOMPARE( (int)engine.occurrenceCount(filename), 4);
+    QCOMPARE( engine.resultAt(filename, 0), std::string("line       1: GRID, 1,  0, 0., 0., 0."));
+    QCOMPARE( engine.resultAt(filename, 1), std::string("line       2: GRID, 2,  0, 1., 0., 0."));
+    QCOMPARE( engine.resultAt(filename, 2), std::string("line       3: GRID, 3,  0, 2., 0., 0."));
+    QCOMPARE( engine.resultAt(filename, 3), std::string("line       4: GRID, 4,  0, 3., 0., 0."));
+    QCOMPARE( engine.resultAt(filename, 4), std::string());
+}
+
+void tst_Search::test_find_result_lines()
+{
+    /* ************************************************************* */
+    /* The lines of the results are known without reading them,      */
+    /* even when they are stored on disk.                            */
+    /* ************************************************************* */
+    // Given
+    Engine engine;
+    engine.setMemoryBudget(100); // bytes
+    std::string filename("dummy.dat");
+    std::istringstream buffer(
+                "GRID    1       0       0.      0.      0.\n"
+                "CBAR    2       1       1       2       0.      1.      0.      +\n"
+                "+       0.\n"
+                "GRID    3       0       1.      0.      0.\n"
+                "CBAR    4       1       1       2       0.      1.      0.      +\n"
+                "+       0.                                                      +\n"
+                "+       0.\n"
+                "GRID    5       0       2.      0.      0.\n" );
+
+    // When
+    engine.find( &buffer, "0.", filename);
+
+    // Then
+    QCOMPARE( (int)engine.resultCount(filename), 5);
+    QCOMPARE( (int)engine.resultCountLines(filename), 8);
+    QCOMPARE( (int)engine.resultLine(filename, 0), 0);
+    QCOMPARE( (int)engine.resultLine(filename, 1), 1);
+    QCOMPARE( (int)engine.resultLine(filename, 2), 3);
+    QCOMPARE( (int)engine.resultLine(filename, 3), 4);
+    QCOMPARE( (int)engine.resultLine(filename, 4), 7);
+    QCOMPARE( (int)engine.resultAtLine(filename, 0), 0);
+    QCOMPARE( (int)engine.resultAtLine(filename, 1), 1);
+    QCOMPARE( (int)engine.resultAtLine(filename, 2), 1);
+    QCOMPARE( (int)engine.resultAtLine(filename, 3), 2);
+    QCOMPARE( (int)engine.resultAtLine(filename, 4), 3);
+    QCOMPARE( (int)engine.resultAtLine(filename, 6), 3);
+    QCOMPARE( (int)engine.resultAtLine(filename, 7), 4);
+    QCOMPARE( engine.resultAt(filename, 4), std::string("line       8: GRID    5       0       2.      0.      0."));
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Search::test_find_preview()
+{
+    /* ************************************************************* */
+    /* Build the first N results only, but count all of them.        */
+    /* ************************************************************* */
+    // Given
+    Engine engine;
+    engine.setResultLimit(2);
+    std::string filename("dummy.dat");
+    std::istringstream buffer(
+                "GRID, 1,  0, 0., 0., 0.\n"
+                "GRID, 2,  0, 1., 0., 0.\n"
+                "GRID, 3,  0, 2., 0., 0.\n"
+                "GRID, 4,  0, 3., 0., 0.\n" );
+
+    // When
+    engine.find( &buffer, "GRID", filename);
+
+    // Then
+    QCOMPARE( (int)engine.resultCount(filename), 2);
+    QCOMPARE( (int)engine.hitCount(filename), 4);
+    QCOMPARE( (int)engine.occurrenceCount(filename), 4);
+    QCOMPARE( engine.isResultTruncated(), true);
+    QCOMPARE( engine.isCountTruncated(), false);
+    QCOMPARE( engine.resultAt(filename, 1), std::string("line       2: GRID, 2,  0, 1., 0., 0."));
+}
+
+void tst_Search::test_find_preview_count_limit()
+{
+    /* ************************************************************* */
+    /* Stop counting once the threshold is reached.                  */
+    /* ************************************************************* */
+    // Given
+    Engine engine;
+    engine.setCountLimit(3);
+    std::string filename("dummy.dat");
+    std::istringstream buffer(
+                "CBAR, 1, 7, 1, 2\n"
+                "CBAR, 2, 7, 2, 3\n"
+                "CBAR, 3, 7, 3, 4\n"
+                "CBAR, 4, 7, 4, 5\n" );
+
+    // When
+    engine.find( &buffer, ", 7,", filename);
+
+    // Then
+    QCOMPARE( engine.isCountTruncated(), true);
+    QCOMPARE( engine.isResultTruncated(), false);
+    QCOMPARE( (int)engine.occurrenceCount(filename), 3); /* >= 3 */
+    QCOMPARE( (int)engine.resultCount(filename), 3);
+    QCOMPARE( engine.resultAt(filename, 2), std::string("line       3: CBAR, 3, 7, 3, 4"));
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Search::test_count()
+{
+    /* ************************************************************* */
+    /* Count only: same counts as find(), but no result is built.    */
+    /* ************************************************************* */
+    // Given
+    Engine engine;
+    Engine reference;
+    std::string filename("dummy.dat");
+    const std::string text =
+            "CBAR, 1, 1, 1, 2\n"
+            "GRID, 1,  0, 0., 0., 0.\n"
+            "CBAR, 2, 1, 2, 3\n"
+            "cbar, 3, 1, 3, 1";
+    std::istringstream buffer(text);
+    std::istringstream referenceBuffer(text);
+
+    // When
+    engine.count( &buffer, "CBAR", filename);
+    reference.find( &referenceBuffer, "CBAR", filename);
+
+    // Then
+    QCOMPARE( (int)engine.resultCount(filename), 0);
+    QCOMPARE( (int)engine.occurrenceCount(filename), 3);
+    QCOMPARE( (int)engine.hitCount(filename), 3);
+    QCOMPARE( engine.occurrenceCount(filename), reference.occurrenceCount(filename));
+    QCOMPARE( engine.hitCount(filename), reference.hitCount(filename));
+}
+
+/* *****************************************************************************
+ ***************************************************************************** */
+void tst_Search::test_count_integer()
+{
+    // Given
+    Engine engine;
+    std::string filename("dummy.dat");
+    std::istringstream buffer(
+                /* 1*/  "CQUAD4  10010   1       21001   2       3       4\n"
+                /* 2*/  "CQUAD4  1001    1       1001    2       3       4\n"
+                /* 3*/  "GRID    1001    0       1001.   0.      0.\n" );
+
+    // When
+    engine.count( &buffer, "INT=1001", filename);
+
+    // Then
+    QCOMPARE( (int)engine.occurrenceCount(filename), 3);
+    QCOMPARE( (int)engine.hitCount(filename), 2);
+}
+
 /* *****************************************************************************
  ***************************************************************************** */
 
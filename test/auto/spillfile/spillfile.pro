@@ -0,0 +1,13 @@
+#isEmpty(TEMPLATE):TEMPLATE=app
+TARGET       = tst_spillfile
+CONFIG      += testcase
+QT           = core testlib
+SOURCES     += tst_spillfile.cpp
+
+# Include:
+INCLUDEPATH += $$PWD/../../../include
+
+# Dependancies:
+HEADERS += $$PWD/../../../src/spillfile.h
+SOURCES += $$PWD/../../../src/spillfile.cpp
+HEADERS += $$PWD/../../../src/systemdetection.h
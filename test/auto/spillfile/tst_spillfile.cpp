@@ -0,0 +1,110 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QtTest/QtTest>
+#include <QtCore/QDebug>
+
+#include <SpillFile>
+
+class tst_SpillFile : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_empty();
+    void test_append();
+    void test_append_after_read();
+    void test_clear();
+
+};
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_SpillFile::test_empty()
+{
+    // Given, When
+    SpillFile file;
+
+    // Then
+    QCOMPARE( (int)file.count(), 0);
+    QCOMPARE( (int)file.fileSize(), 0);
+    QCOMPARE( file.at(0), std::string());
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_SpillFile::test_append()
+{
+    // Given
+    SpillFile file;
+
+    // When
+    QVERIFY( file.append("line       1: SOL 101") );
+    QVERIFY( file.append("") );
+    QVERIFY( file.append("line       3: CEND") );
+
+    // Then
+    QCOMPARE( (int)file.count(), 3);
+    QCOMPARE( file.at(0), std::string("line       1: SOL 101"));
+    QCOMPARE( file.at(1), std::string());
+    QCOMPARE( file.at(2), std::string("line       3: CEND"));
+    QCOMPARE( file.at(3), std::string());
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_SpillFile::test_append_after_read()
+{
+    /* The records appended after a read must be visible too */
+    // Given
+    SpillFile file;
+    file.append("GRID, 1");
+    QCOMPARE( file.at(0), std::string("GRID, 1"));
+
+    // When
+    for (int i = 2; i <= 1000; ++i) {
+        file.append("GRID, " + std::to_string(i));
+    }
+
+    // Then
+    QCOMPARE( (int)file.count(), 1000);
+    QCOMPARE( file.at(0), std::string("GRID, 1"));
+    QCOMPARE( file.at(499), std::string("GRID, 500"));
+    QCOMPARE( file.at(999), std::string("GRID, 1000"));
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_SpillFile::test_clear()
+{
+    // Given
+    SpillFile file;
+    file.append("CQUAD4, 100, 1000, 1, 2, 7, 6");
+
+    // When
+    file.clear();
+    file.append("CBAR, 1");
+
+    // Then
+    QCOMPARE( (int)file.count(), 1);
+    QCOMPARE( file.at(0), std::string("CBAR, 1"));
+}
+
+/******************************************************************************
+ ******************************************************************************/
+
+QTEST_APPLESS_MAIN(tst_SpillFile)
+
+#include "tst_spillfile.moc"
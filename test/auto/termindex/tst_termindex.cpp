@@ -0,0 +1,308 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QtTest/QtTest>
+#include <QtCore/QDebug>
+
+#include <Fingerprint>
+#include <TermIndex>
+
+#include <sstream>
+#include <stdio.h> // remove()
+#include <string>
+#include <utility>
+#include <vector>
+
+class tst_TermIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_empty();
+    void test_may_contain();
+    void test_case_insensitive();
+    void test_continuation();
+    void test_out_of_date();
+    void test_many_trigrams();
+    void test_save_load();
+    void test_save_file();
+    void test_prune();
+    void test_validate();
+
+private:
+    static void update(TermIndex &index, const std::string &text);
+    static bool mayContain(const TermIndex &index, const std::string &term);
+};
+
+void tst_TermIndex::update(TermIndex &index, const std::string &text)
+{
+    std::vector<std::pair<int, std::string> > includes;
+    includes.push_back(std::make_pair(3, std::string("sub/mesh.bdf")));
+    index.update("/model/main.dat", 0, 1234, 0xABCD,
+                 text.data(), text.data() + text.size(), std::string(), 4, includes);
+}
+
+bool tst_TermIndex::mayContain(const TermIndex &index, const std::string &term)
+{
+    const TermIndex::Record *record = index.find("/model/main.dat", 0, 1234);
+    if (!record) {
+        return true;
+    }
+    return TermIndex::mayContain(*record, std::vector<std::string>(1, term));
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_TermIndex::test_empty()
+{
+    // Given
+    TermIndex index;
+
+    // When, Then
+    QCOMPARE( (int)index.recordCount(), 0 );
+    QVERIFY( !index.isModified() );
+    QVERIFY( index.find("/model/main.dat", 0, 1234) == NULL );
+
+    /* A file too short to contain any term */
+    index.update("/model/main.dat", 0, 1234, 0xABCD, "", "", std::string(), 0,
+                 std::vector<std::pair<int, std::string> >());
+    QVERIFY( index.isModified() );
+    QVERIFY( index.find("/model/main.dat", 0, 1234) != NULL );
+    QVERIFY( !mayContain(index, "GRID") );
+    QVERIFY( mayContain(index, "AB") );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_TermIndex::test_may_contain()
+{
+    // Given
+    TermIndex index;
+    const std::string text = "$ Mesh\nGRID    1       0       1.0     2.0     3.0\nINCLUDE 'sub/mesh.bdf'\n";
+
+    // When
+    index.update("/model/main.dat", 0, 1234, 0xABCD, text.data(), text.data() + text.size(),
+                 std::string(), 4, std::vector<std::pair<int, std::string> >());
+
+    // Then
+    QVERIFY( mayContain(index, "GRID") );
+    QVERIFY( mayContain(index, "GRID    1") );
+    QVERIFY( mayContain(index, "mesh.bdf") );
+    QVERIFY( !mayContain(index, "CQUAD4") );
+    QVERIFY( !mayContain(index, "GRID    7") );
+
+    /* All the terms must be found */
+    std::vector<std::string> terms;
+    terms.push_back("GRID");
+    terms.push_back("CQUAD4");
+    QVERIFY( !TermIndex::mayContain(*index.find("/model/main.dat", 0, 1234), terms) );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_TermIndex::test_case_insensitive()
+{
+    // Given
+    TermIndex index;
+    update(index, "param   post    -1\n");
+
+    // When, Then
+    QVERIFY( mayContain(index, "PARAM") );
+    QVERIFY( mayContain(index, "Post") );
+    QVERIFY( !mayContain(index, "POSTS") );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_TermIndex::test_continuation()
+{
+    // Given
+    TermIndex index;
+    const std::string text = "CBAR    1       1       1       2       1.0     0.0     ABCD\n"
+                             "+       EFGH\n";
+
+    // When
+    /* The data of the two lines, joined with the blanks up to the column 72 */
+    index.update("/model/main.dat", 0, 1234, 0xABCD, text.data(), text.data() + text.size(),
+                 "CD EF\n", 2, std::vector<std::pair<int, std::string> >());
+
+    // Then
+    QVERIFY( mayContain(index, "ABCD EFGH") );
+    QVERIFY( mayContain(index, "0.0     ABCD") );
+    QVERIFY( !mayContain(index, "ABCDEFGH") );
+    QVERIFY( !mayContain(index, "EFGHABCD") );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_TermIndex::test_out_of_date()
+{
+    // Given
+    TermIndex index;
+    update(index, "GRID    1\n");
+
+    // When, Then
+    QVERIFY( index.find("/model/main.dat", 0, 1234) != NULL );
+    QVERIFY( index.find("/model/main.dat", 10, 1234) == NULL );
+    QVERIFY( index.find("/model/main.dat", 0, 1235) == NULL );
+    QVERIFY( index.find("/model/other.dat", 0, 1234) == NULL );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_TermIndex::test_many_trigrams()
+{
+    // Given
+    TermIndex index;
+    std::string text;
+    for (int i = 0; i < 20000; ++i) {
+        text += "GRID    " + std::to_string(100000 + i) + "\n";
+    }
+
+    // When
+    update(index, text);
+    const TermIndex::Record *record = index.find("/model/main.dat", 0, 1234);
+
+    // Then
+    QVERIFY( record != NULL );
+    QVERIFY( record->filter.size() * 64 >= 512 );
+    for (int i = 0; i < 20000; i += 997) {
+        QVERIFY( mayContain(index, std::to_string(100000 + i)) );
+    }
+    QVERIFY( !mayContain(index, "CQUAD4") );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_TermIndex::test_save_load()
+{
+    // Given
+    TermIndex index;
+    update(index, "GRID    1\n");
+    std::stringstream stream;
+
+    // When
+    index.save(stream);
+    TermIndex loaded;
+    const bool ok = loaded.load(stream);
+
+    // Then
+    QVERIFY( ok );
+    QVERIFY( !loaded.isModified() );
+    QCOMPARE( (int)loaded.recordCount(), 1 );
+    const TermIndex::Record *record = loaded.find("/model/main.dat", 0, 1234);
+    QVERIFY( record != NULL );
+    QCOMPARE( (int)record->lineCount, 4 );
+    QCOMPARE( record->filter, index.find("/model/main.dat", 0, 1234)->filter );
+    QCOMPARE( (int)record->includes.size(), 1 );
+    QCOMPARE( record->includes.at(0).first, 3 );
+    QCOMPARE( record->includes.at(0).second, std::string("sub/mesh.bdf") );
+
+    /* Not an index */
+    std::stringstream other("# NASTRANFIND fingerprints 1\n");
+    QVERIFY( !loaded.load(other) );
+    QCOMPARE( (int)loaded.recordCount(), 0 );
+}
+
+void tst_TermIndex::test_save_file()
+{
+    // Given
+    const std::string fileName = "tst_termindex.txt";
+    TermIndex index;
+    update(index, "GRID    1\n");
+    QVERIFY( index.save(fileName) );
+    index.update("/model/other.dat", 0, 1234, 0, "", "", std::string(), 0,
+                 std::vector<std::pair<int, std::string> >());
+
+    // When
+    /* The existing file is replaced */
+    const bool saved = index.save(fileName);
+    TermIndex loaded;
+    const bool ok = loaded.load(fileName);
+    remove(fileName.c_str());
+
+    // Then
+    QVERIFY( saved );
+    QVERIFY( !index.isModified() );
+    QVERIFY( ok );
+    QCOMPARE( (int)loaded.recordCount(), 2 );
+    QVERIFY( !index.save("no_such_directory/tst_termindex.txt") );
+}
+
+void tst_TermIndex::test_prune()
+{
+    // Given
+    TermIndex index;
+    update(index, "GRID    1\n");
+    index.update("/model/removed.dat", 0, 1234, 0, "", "", std::string(), 0,
+                 std::vector<std::pair<int, std::string> >());
+    std::stringstream stream;
+    index.save(stream);
+    TermIndex loaded;
+    loaded.load(stream);
+
+    // When
+    loaded.prune(std::vector<std::string>(1, "/model/main.dat"));
+
+    // Then
+    QCOMPARE( (int)loaded.recordCount(), 1 );
+    QVERIFY( loaded.isModified() );
+    QVERIFY( loaded.find("/model/main.dat", 0, 1234) != NULL );
+    QVERIFY( loaded.find("/model/removed.dat", 0, 1234) == NULL );
+}
+
+void tst_TermIndex::test_validate()
+{
+    // Given
+    TermIndex index;
+    update(index, "GRID    1\n");
+    index.update("/model/changed.dat", 0, 1234, 0x1111, "", "", std::string(), 0,
+                 std::vector<std::pair<int, std::string> >());
+    index.update("/model/other.dat", 0, 1234, 0x2222, "", "", std::string(), 0,
+                 std::vector<std::pair<int, std::string> >());
+    std::stringstream stream;
+    index.save(stream);
+    TermIndex loaded;
+    loaded.load(stream);
+
+    /* main.dat saved again without change, changed.dat edited, other.dat not in the tree */
+    std::istringstream records(
+                "# NASTRANFIND fingerprints 1\n"
+                "0\n"
+                "/model/main.dat\n"
+                "0 5678 abcd 0\n"
+                "/model/changed.dat\n"
+                "0 5678 3333 0\n");
+    Fingerprint fingerprint;
+    QVERIFY( fingerprint.load(records) );
+
+    // When
+    loaded.validate(fingerprint);
+
+    // Then
+    QVERIFY( loaded.isModified() );
+    QCOMPARE( (int)loaded.recordCount(), 2 );
+    QVERIFY( loaded.find("/model/main.dat", 0, 1234) == NULL );
+    QVERIFY( loaded.find("/model/main.dat", 0, 5678) != NULL );
+    QVERIFY( loaded.find("/model/changed.dat", 0, 5678) == NULL );
+    QVERIFY( loaded.find("/model/other.dat", 0, 1234) != NULL );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+
+QTEST_APPLESS_MAIN(tst_TermIndex)
+
+#include "tst_termindex.moc"
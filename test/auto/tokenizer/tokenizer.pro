@@ -0,0 +1,15 @@
+#isEmpty(TEMPLATE):TEMPLATE=app
+TARGET       = tst_tokenizer
+CONFIG      += testcase
+QT           = core testlib
+SOURCES     += tst_tokenizer.cpp
+
+# Include:
+INCLUDEPATH += $$PWD/../../../include
+
+# Dependancies:
+HEADERS += $$PWD/../../../src/scanner.h
+SOURCES += $$PWD/../../../src/scanner.cpp
+HEADERS += $$PWD/../../../src/systemdetection.h
+HEADERS += $$PWD/../../../src/tokenizer.h
+SOURCES += $$PWD/../../../src/tokenizer.cpp
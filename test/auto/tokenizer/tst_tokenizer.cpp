@@ -0,0 +1,285 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QtTest/QtTest>
+#include <QtCore/QDebug>
+
+#include <Tokenizer>
+
+#include <string>
+#include <string.h> // strlen()
+
+class tst_Tokenizer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_small_field();
+    void test_large_field();
+    void test_free_field();
+    void test_tabs();
+    void test_comment();
+    void test_kind();
+    void test_kind_data();
+    void test_parse_number();
+    void test_parse_number_data();
+    void test_parse_number_equivalence();
+
+private:
+    static std::string field(const std::string &line, const Tokenizer &tokenizer, const int index);
+};
+
+std::string tst_Tokenizer::field(const std::string &line, const Tokenizer &tokenizer, const int index)
+{
+    const FieldSpan &span = tokenizer.fieldAt(index);
+    return line.substr(span.position, span.length);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Tokenizer::test_small_field()
+{
+    // Given
+    Tokenizer tokenizer;
+    const std::string line = "CQUAD4  1001    1       100000011000002 1000003 1000004                 +A1\r\n";
+
+    // When
+    Tokenizer::Format format = tokenizer.tokenize(line.data(), line.size());
+
+    // Then
+    QCOMPARE( format, Tokenizer::Format::SMALL_FIELD );
+    QCOMPARE( tokenizer.fieldCount(), 10 );
+    QCOMPARE( field(line, tokenizer, 0), std::string("CQUAD4") );
+    QCOMPARE( field(line, tokenizer, 1), std::string("1001") );
+    QCOMPARE( field(line, tokenizer, 3), std::string("10000001") );
+    QCOMPARE( field(line, tokenizer, 4), std::string("1000002") );
+    QCOMPARE( field(line, tokenizer, 7), std::string() );
+    QCOMPARE( (int)tokenizer.fieldAt(7).length, 0 );
+    QCOMPARE( field(line, tokenizer, 9), std::string("+A1") );
+    QCOMPARE( (int)tokenizer.fieldAt(10).length, 0 ); /* out of range */
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Tokenizer::test_large_field()
+{
+    // Given
+    Tokenizer tokenizer;
+    const std::string line = "GRID*   1001            0               1.0             2.0             *G1";
+    const std::string next = "*G1     3.0";
+
+    // When
+    Tokenizer::Format format = tokenizer.tokenize(line.data(), line.size());
+
+    // Then
+    QCOMPARE( format, Tokenizer::Format::LARGE_FIELD );
+    QCOMPARE( tokenizer.isLargeField(), true );
+    QCOMPARE( tokenizer.fieldCount(), 6 );
+    QCOMPARE( field(line, tokenizer, 0), std::string("GRID*") );
+    QCOMPARE( field(line, tokenizer, 1), std::string("1001") );
+    QCOMPARE( field(line, tokenizer, 2), std::string("0") );
+    QCOMPARE( field(line, tokenizer, 3), std::string("1.0") );
+    QCOMPARE( field(line, tokenizer, 4), std::string("2.0") );
+    QCOMPARE( field(line, tokenizer, 5), std::string("*G1") );
+
+    // When
+    format = tokenizer.tokenize(next.data(), next.size());
+
+    // Then
+    QCOMPARE( format, Tokenizer::Format::LARGE_FIELD );
+    QCOMPARE( tokenizer.fieldCount(), 2 );
+    QCOMPARE( field(next, tokenizer, 1), std::string("3.0") );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Tokenizer::test_free_field()
+{
+    // Given
+    Tokenizer tokenizer;
+    const std::string line = "GRID, 1001,, 1.0 ,2.0,3.0";
+
+    // When
+    Tokenizer::Format format = tokenizer.tokenize(line.data(), line.size());
+
+    // Then
+    QCOMPARE( format, Tokenizer::Format::FREE_FIELD );
+    QCOMPARE( tokenizer.isLargeField(), false );
+    QCOMPARE( tokenizer.fieldCount(), 6 );
+    QCOMPARE( field(line, tokenizer, 0), std::string("GRID") );
+    QCOMPARE( field(line, tokenizer, 1), std::string("1001") );
+    QCOMPARE( field(line, tokenizer, 2), std::string() );
+    QCOMPARE( field(line, tokenizer, 3), std::string("1.0") );
+    QCOMPARE( field(line, tokenizer, 5), std::string("3.0") );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Tokenizer::test_tabs()
+{
+    /* A tab moves to the next multiple of 8 columns */
+    // Given
+    Tokenizer tokenizer;
+    const std::string line = "GRID\t1001\t\t1.0\t2.0";
+
+    // When
+    Tokenizer::Format format = tokenizer.tokenize(line.data(), line.size());
+
+    // Then
+    QCOMPARE( format, Tokenizer::Format::SMALL_FIELD );
+    QCOMPARE( tokenizer.fieldCount(), 5 );
+    QCOMPARE( field(line, tokenizer, 1), std::string("1001") );
+    QCOMPARE( field(line, tokenizer, 2), std::string() );
+    QCOMPARE( field(line, tokenizer, 3), std::string("1.0") );
+    QCOMPARE( field(line, tokenizer, 4), std::string("2.0") );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Tokenizer::test_comment()
+{
+    // Given
+    Tokenizer tokenizer;
+    const std::string comment = "$ GRID  1";
+    const std::string line = "GRID    1       $ node";
+    const std::string empty = "   \r\n";
+
+    // When, Then
+    QCOMPARE( tokenizer.tokenize(comment.data(), comment.size()), Tokenizer::Format::COMMENT );
+    QCOMPARE( tokenizer.fieldCount(), 0 );
+    QCOMPARE( (int)tokenizer.commentPosition(), 0 );
+
+    QCOMPARE( tokenizer.tokenize(line.data(), line.size()), Tokenizer::Format::SMALL_FIELD );
+    QCOMPARE( tokenizer.fieldCount(), 2 );
+    QCOMPARE( (int)tokenizer.commentPosition(), 16 );
+
+    QCOMPARE( tokenizer.tokenize(empty.data(), empty.size()), Tokenizer::Format::EMPTY );
+    QCOMPARE( tokenizer.fieldCount(), 0 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Tokenizer::test_kind_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<int>("expected");
+
+    const int BLANK   = (int)Tokenizer::Kind::BLANK;
+    const int INTEGER = (int)Tokenizer::Kind::INTEGER;
+    const int REAL    = (int)Tokenizer::Kind::REAL;
+    const int WORD    = (int)Tokenizer::Kind::WORD;
+    const int OTHER   = (int)Tokenizer::Kind::OTHER;
+
+    QTest::newRow("blank")      << ""         << BLANK;
+    QTest::newRow("integer")    << "123"      << INTEGER;
+    QTest::newRow("negative")   << "-5"       << INTEGER;
+    QTest::newRow("real")       << "1.0"      << REAL;
+    QTest::newRow("real dot")   << "1."       << REAL;
+    QTest::newRow("real lead")  << ".5"       << REAL;
+    QTest::newRow("exponent")   << "1.0E+3"   << REAL;
+    QTest::newRow("double")     << "1.0D0"    << REAL;
+    QTest::newRow("nastran")    << "1.5-3"    << REAL;
+    QTest::newRow("nastran 2")  << "-.5+2"    << REAL;
+    QTest::newRow("word")       << "CQUAD4"   << WORD;
+    QTest::newRow("marker")     << "+A1"      << OTHER;
+    QTest::newRow("star")       << "*"        << OTHER;
+    QTest::newRow("bad exp")    << "1.0E"     << OTHER;
+    QTest::newRow("sign")       << "-"        << OTHER;
+}
+
+void tst_Tokenizer::test_kind()
+{
+    QFETCH(QString, text);
+    QFETCH(int, expected);
+
+    // Given
+    const std::string str = text.toStdString();
+
+    // When
+    const int actual = (int)Tokenizer::kindOf(str.data(), str.size());
+
+    // Then
+    QCOMPARE( actual, expected );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Tokenizer::test_parse_number_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<bool>("expectedValid");
+    QTest::addColumn<double>("expected");
+
+    QTest::newRow("integer")    << "123"      << true  << 123.;
+    QTest::newRow("real")       << "1.5"      << true  << 1.5;
+    QTest::newRow("real lead")  << "-.5"      << true  << -0.5;
+    QTest::newRow("exponent")   << "2.1E+5"   << true  << 210000.;
+    QTest::newRow("double")     << "1.0D-3"   << true  << 0.001;
+    QTest::newRow("nastran")    << "7.-3"     << true  << 0.007;
+    QTest::newRow("zero")       << "0.0"      << true  << 0.;
+    QTest::newRow("huge")       << "1.E300"   << true  << 1e300;
+    QTest::newRow("word")       << "GRID"     << false << 0.;
+    QTest::newRow("bad exp")    << "1.0E"     << false << 0.;
+    QTest::newRow("dot")        << "."        << false << 0.;
+    QTest::newRow("two dots")   << "1.0.0"    << false << 0.;
+}
+
+void tst_Tokenizer::test_parse_number()
+{
+    QFETCH(QString, text);
+    QFETCH(bool, expectedValid);
+    QFETCH(double, expected);
+
+    // Given
+    const std::string str = text.toStdString();
+    double value = 0.;
+
+    // When
+    const bool valid = Tokenizer::parseNumber(str.data(), str.size(), &value);
+
+    // Then
+    QCOMPARE( valid, expectedValid );
+    if (valid) {
+        QCOMPARE( value, expected );
+    }
+}
+
+void tst_Tokenizer::test_parse_number_equivalence()
+{
+    /* The equivalent notations give exactly the same value */
+    const char* const notations[] = {
+        "1.0", "1.", "1.0E0", "1+0", ".1+1", "1.0D0", "10.-1", "0.001E3", "+1.000"
+    };
+    double reference = 0.;
+    QVERIFY( Tokenizer::parseNumber("1", 1, &reference) );
+
+    for (const char *notation : notations) {
+        double value = 0.;
+        QVERIFY( Tokenizer::parseNumber(notation, strlen(notation), &value) );
+        QVERIFY( value == reference );
+    }
+
+    double a = 0., b = 0.;
+    QVERIFY( Tokenizer::parseNumber("0.1", 3, &a) );
+    QVERIFY( Tokenizer::parseNumber("1.-1", 4, &b) );
+    QVERIFY( a == b );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+
+QTEST_APPLESS_MAIN(tst_Tokenizer)
+
+#include "tst_tokenizer.moc"
@@ -0,0 +1,158 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest/QtTest>
+#include <QtCore/QDebug>
+
+#include <ZipArchive>
+
+#include <stdio.h>
+
+class tst_ZipArchive : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_open();
+    void test_not_an_archive();
+    void test_find();
+    void test_normalize();
+    void test_extract_deflated();
+    void test_extract_stored();
+
+private:
+    static std::string path(const char *fileName);
+    static std::string extract(const ZipArchive &archive, const char *memberName);
+};
+
+std::string tst_ZipArchive::path(const char *fileName)
+{
+    return QFINDTESTDATA(fileName).toLatin1().data();
+}
+
+std::string tst_ZipArchive::extract(const ZipArchive &archive, const char *memberName)
+{
+    const ZipArchive::Member *member = archive.find(memberName);
+    if (!member) {
+        return std::string();
+    }
+    FILE *file = tmpfile();
+    if (!archive.extract(*member, file)) {
+        fclose(file);
+        return std::string();
+    }
+    std::string content;
+    rewind(file);
+    char buffer[256];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        content.append(buffer, length);
+    }
+    fclose(file);
+    return content;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_ZipArchive::test_open()
+{
+    // Given
+    ZipArchive archive;
+
+    // When
+    const bool ok = archive.open(path("share/archive/model.zip"));
+
+    // Then
+    QVERIFY( ok );
+    QVERIFY( archive.isOpen() );
+    QCOMPARE( (int)archive.members().size(), 3 ); /* not the directory */
+    QCOMPARE( archive.members().front().name, std::string("main.dat") );
+}
+
+void tst_ZipArchive::test_not_an_archive()
+{
+    // Given
+    ZipArchive archive;
+
+    // When
+    const bool ok = archive.open(path("share/comment/test.dat"));
+
+    // Then
+    QVERIFY( !ok );
+    QVERIFY( !archive.isOpen() );
+    QVERIFY( archive.members().empty() );
+}
+
+void tst_ZipArchive::test_find()
+{
+    // Given
+    ZipArchive archive;
+    archive.open(path("share/archive/model.zip"));
+
+    // When, Then
+    QVERIFY( archive.find("main.dat") != NULL );
+    QVERIFY( archive.find("bulk\\grid.dat") != NULL );
+    QVERIFY( archive.find("bulk/../PROPS.DAT") != NULL );
+    QVERIFY( archive.find("./bulk/./grid.dat") != NULL );
+    QVERIFY( archive.find("bulk") == NULL );
+    QVERIFY( archive.find("missing.dat") == NULL );
+}
+
+void tst_ZipArchive::test_normalize()
+{
+    QCOMPARE( ZipArchive::normalize("main.dat"), std::string("main.dat") );
+    QCOMPARE( ZipArchive::normalize("/main.dat"), std::string("main.dat") );
+    QCOMPARE( ZipArchive::normalize("MODEL\\MAINS\\..\\MESH/./grid.bdf"), std::string("MODEL/MESH/grid.bdf") );
+    QCOMPARE( ZipArchive::normalize("a//b/"), std::string("a/b") );
+    QCOMPARE( ZipArchive::normalize("../../a/b.dat"), std::string("a/b.dat") );
+}
+
+void tst_ZipArchive::test_extract_deflated()
+{
+    // Given
+    ZipArchive archive;
+    archive.open(path("share/archive/model.zip"));
+
+    // When
+    const std::string content = extract(archive, "bulk/grid.dat");
+
+    // Then
+    QCOMPARE( content.size(), (size_t)archive.find("bulk/grid.dat")->size );
+    QCOMPARE( content.substr(0, 2), std::string("$\n") );
+    QVERIFY( content.find("GRID    3") != std::string::npos );
+}
+
+void tst_ZipArchive::test_extract_stored()
+{
+    // Given
+    ZipArchive archive;
+    archive.open(path("share/archive/model.zip"));
+
+    // When
+    const std::string content = extract(archive, "props.dat");
+
+    // Then
+    QCOMPARE( archive.find("props.dat")->method, 0u );
+    QCOMPARE( content.size(), (size_t)archive.find("props.dat")->size );
+    QVERIFY( content.find("PSHELL") != std::string::npos );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+
+QTEST_APPLESS_MAIN(tst_ZipArchive)
+
+#include "tst_ziparchive.moc"
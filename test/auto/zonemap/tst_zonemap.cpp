@@ -0,0 +1,157 @@
+/* - NASTRANFIND - Copyright (C) 2016-2017 Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QtTest/QtTest>
+#include <QtCore/QDebug>
+
+#include <ZoneMap>
+
+class tst_ZoneMap : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_build();
+    void test_rebuild();
+    void test_next_zone();
+    void test_include_not_skipped();
+
+private:
+    static void build(ZoneMap &zoneMap);
+};
+
+/*! \brief Builds a map of 4 blocks:
+ * block 0: IDs 1..100, block 1: a single card spanning the whole block,
+ * block 2: IDs 2000000..2000500, block 3: IDs 300..310.
+ */
+void tst_ZoneMap::build(ZoneMap &zoneMap)
+{
+    const std::size_t B = ZoneMap::BLOCK_SIZE;
+    zoneMap.reset(4 * B - 10, 42);
+
+    zoneMap.appendCard(0, 1, false); /* SOL 101 */
+    zoneMap.appendCard(10, 2, true);
+    zoneMap.appendId(1);
+    zoneMap.appendCard(100, 3, true);
+    zoneMap.appendId(100);
+    zoneMap.appendCard(B - 20, 1000, true); /* continued in the block 1 */
+    zoneMap.appendId(50);
+
+    zoneMap.appendCard(2 * B + 30, 3000, true);
+    zoneMap.appendId(2000500);
+    zoneMap.appendCard(2 * B + 100, 3001, true);
+    zoneMap.appendId(2000000);
+
+    zoneMap.appendCard(3 * B, 4000, true);
+    zoneMap.appendId(310);
+    zoneMap.appendCard(3 * B + 50, 4001, true);
+    zoneMap.appendId(300);
+
+    zoneMap.finish();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_ZoneMap::test_build()
+{
+    // Given
+    ZoneMap zoneMap;
+
+    // When
+    build(zoneMap);
+
+    // Then
+    QVERIFY( zoneMap.isBuilt() );
+    QVERIFY( zoneMap.isBuiltFor(4 * ZoneMap::BLOCK_SIZE - 10, 42) );
+    QVERIFY( !zoneMap.isBuiltFor(4 * ZoneMap::BLOCK_SIZE - 10, 43) );
+    QCOMPARE( zoneMap.zoneCount(), 4 );
+    QCOMPARE( zoneMap.minimum(), 1LL );
+    QCOMPARE( zoneMap.maximum(), 2000500LL );
+
+    QCOMPARE( zoneMap.zoneAt(0).minimum, 1LL );
+    QCOMPARE( zoneMap.zoneAt(0).maximum, 100LL );
+    QCOMPARE( (int)zoneMap.zoneAt(0).offset, 0 );
+    QCOMPARE( zoneMap.zoneAt(0).isBulk, false );
+
+    QVERIFY( zoneMap.zoneAt(1).offset == ZoneMap::NO_CARD );
+
+    QCOMPARE( zoneMap.zoneAt(2).minimum, 2000000LL );
+    QCOMPARE( zoneMap.zoneAt(2).maximum, 2000500LL );
+    QCOMPARE( zoneMap.zoneAt(2).lineNumber, 3000 );
+    QCOMPARE( zoneMap.zoneAt(2).isBulk, true );
+}
+
+void tst_ZoneMap::test_rebuild()
+{
+    // Given
+    ZoneMap zoneMap;
+    build(zoneMap);
+
+    // When
+    zoneMap.reset(10, 43);
+
+    // Then
+    QVERIFY( !zoneMap.isBuilt() );
+    QCOMPARE( zoneMap.zoneCount(), 1 );
+    QVERIFY( !zoneMap.overlaps(1, 2000500) );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_ZoneMap::test_next_zone()
+{
+    // Given
+    ZoneMap zoneMap;
+    build(zoneMap);
+
+    // When, Then
+    QVERIFY( zoneMap.overlaps(2000000, 2099999) );
+    QVERIFY( !zoneMap.overlaps(3000000, 3099999) );
+
+    QCOMPARE( zoneMap.nextZone(1), 2 );
+    QCOMPARE( zoneMap.nextZone(0, 2000000, 2099999), 2 );
+    QCOMPARE( zoneMap.nextZone(3, 2000000, 2099999), 4 ); /* end of file */
+    QCOMPARE( zoneMap.nextZone(0, 305, 305), 3 );
+    QCOMPARE( zoneMap.nextZone(0, 50, 60), 0 );
+    QCOMPARE( zoneMap.nextZone(0, 101, 299), 4 );
+}
+
+void tst_ZoneMap::test_include_not_skipped()
+{
+    // Given
+    ZoneMap zoneMap;
+    zoneMap.reset(3 * ZoneMap::BLOCK_SIZE, 0);
+    zoneMap.appendCard(0, 1, true);
+    zoneMap.appendId(1);
+    zoneMap.appendCard(ZoneMap::BLOCK_SIZE, 900, true);
+    zoneMap.appendInclude(ZoneMap::BLOCK_SIZE);
+    zoneMap.appendCard(2 * ZoneMap::BLOCK_SIZE, 1800, true);
+    zoneMap.appendId(2);
+
+    // When
+    zoneMap.finish();
+
+    // Then
+    QVERIFY( zoneMap.hasInclude() );
+    QCOMPARE( zoneMap.nextZone(0, 1000, 2000), 1 );
+    QCOMPARE( zoneMap.nextZone(2, 1000, 2000), 3 );
+}
+
+/******************************************************************************
+ ******************************************************************************/
+
+QTEST_APPLESS_MAIN(tst_ZoneMap)
+
+#include "tst_zonemap.moc"
@@ -0,0 +1,13 @@
+#isEmpty(TEMPLATE):TEMPLATE=app
+TARGET       = tst_zonemap
+CONFIG      += testcase
+QT           = core testlib
+SOURCES     += tst_zonemap.cpp
+
+# Include:
+INCLUDEPATH += $$PWD/../../../include
+
+# Dependancies:
+HEADERS += $$PWD/../../../src/systemdetection.h
+HEADERS += $$PWD/../../../src/zonemap.h
+SOURCES += $$PWD/../../../src/zonemap.cpp
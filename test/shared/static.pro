@@ -8,13 +8,18 @@
 include(../../nastranfind.pri)
 
 DATA_DIRS = \
+    archive \
     broken \
     comment \
+    compressed \
     cyclic \
     duplicate \
+    duplicate_ids \
+    entities \
     first_last \
     multiline \
     quotes \
+    same_content \
     singleline \
     subdirectory \
     symbolic_link